@@ -38,7 +38,6 @@
 
 #ifndef CO_USE_GLOBALS
     #include <stdlib.h> /*  for malloc, free */
-    static uint32_t CO_memoryUsed = 0; /* informative */
 #endif
 
 
@@ -47,13 +46,16 @@
     static CO_t COO;
     CO_t *CO = NULL;
 
-    static CO_CANrx_t          *CO_CANmodule_rxArray0;
-    static CO_CANtx_t          *CO_CANmodule_txArray0;
-    static CO_OD_extension_t   *CO_SDO_ODExtensions;
-    static CO_HBconsNode_t     *CO_HBcons_monitoredNodes;
+/* Value and address of Object Dictionary variable (OD_xxx from CO_OD.h) inside
+ * CANopen object co. */
+#define CO_OD_VAR(co, type, var)    (*(type*)CO_ODrelocate(co, &(var)))
+#define CO_OD_PTR(co, var)          CO_ODrelocate(co, &(var))
+
+/* Value of timeProcess_us, timeSYNC_us and timeTPDO_us inside CANopen object
+ * before the first call of the process function. */
+#define CO_TIME_US_UNKNOWN          ((CO_time_us_t)0xFFFFFFFFFFFFFFFFULL)
+
 #if CO_NO_TRACE > 0
-    static uint32_t            *CO_traceTimeBuffers[CO_NO_TRACE];
-    static int32_t             *CO_traceValueBuffers[CO_NO_TRACE];
   #ifdef CO_USE_GLOBALS
   #ifndef CO_TRACE_BUFFER_SIZE_FIXED
     #define CO_TRACE_BUFFER_SIZE_FIXED 100
@@ -63,6 +65,14 @@
 
 
 /* Verify features from CO_OD *************************************************/
+    /* optional features, which are not in all CO_OD.h files */
+    #ifndef CO_NO_NG_SLAVE
+        #define CO_NO_NG_SLAVE  0
+    #endif
+    #ifndef CO_NO_NG_MASTER
+        #define CO_NO_NG_MASTER 0
+    #endif
+
     /* generate error, if features are not correctly configured for this project */
     #if        CO_NO_NMT_MASTER                           >  1     \
             || CO_NO_SYNC                                 >  1     \
@@ -76,9 +86,15 @@
             || ODL_errorStatusBits_stringLength           < 10     \
             || CO_NO_LSS_SERVER                           >  1     \
             || CO_NO_LSS_CLIENT                           >  1     \
-            || (CO_NO_LSS_SERVER > 0 && CO_NO_LSS_CLIENT > 0)
+            || (CO_NO_LSS_SERVER > 0 && CO_NO_LSS_CLIENT > 0)       \
+            || CO_NO_NG_SLAVE                             >  1     \
+            || CO_NO_NG_MASTER                            >  1
         #error Features from CO_OD.h file are not corectly configured for this project!
     #endif
+    #if CO_NO_NG_MASTER == 1 && defined(CO_HBCONSUMER_SCALABLE)
+        /* masked heartbeat buffer would receive all guarding responses */
+        #error Node guarding master can not be used with CO_HBCONSUMER_SCALABLE!
+    #endif
 
 
 /* Indexes for CANopenNode message objects ************************************/
@@ -88,6 +104,11 @@
         #define CO_NO_HB_CONS   0
     #endif
     #define CO_NO_HB_PROD      1                                      /*  Producer Heartbeat Cont */
+    #if defined(CO_HBCONSUMER_SCALABLE) && CO_NO_HB_CONS > 0
+        #define CO_NO_HB_CONS_RX   1                                  /*  one masked buffer for all heartbeats */
+    #else
+        #define CO_NO_HB_CONS_RX   CO_NO_HB_CONS
+    #endif
 
     #define CO_RXCAN_NMT       0                                      /*  index for NMT message */
     #define CO_RXCAN_SYNC      1                                      /*  index for SYNC message */
@@ -97,7 +118,9 @@
     #define CO_RXCAN_SDO_SRV  (CO_RXCAN_RPDO+CO_NO_RPDO)              /*  start index for SDO server message (request) */
     #define CO_RXCAN_SDO_CLI  (CO_RXCAN_SDO_SRV+CO_NO_SDO_SERVER)     /*  start index for SDO client message (response) */
     #define CO_RXCAN_CONS_HB  (CO_RXCAN_SDO_CLI+CO_NO_SDO_CLIENT)     /*  start index for Heartbeat Consumer messages */
-    #define CO_RXCAN_LSS      (CO_RXCAN_CONS_HB+CO_NO_HB_CONS)        /*  index for LSS rx message */
+    #define CO_RXCAN_NG_MST   (CO_RXCAN_CONS_HB+CO_NO_HB_CONS_RX)     /*  index for Node guarding master message (response) */
+    #define CO_RXCAN_NG_SLV   (CO_RXCAN_NG_MST+CO_NO_NG_MASTER)       /*  index for Node guarding slave message (request) */
+    #define CO_RXCAN_LSS      (CO_RXCAN_NG_SLV+CO_NO_NG_SLAVE)        /*  index for LSS rx message */
     /* total number of received CAN messages */
     #define CO_RXCAN_NO_MSGS (\
         1 + \
@@ -107,7 +130,9 @@
         CO_NO_RPDO + \
         CO_NO_SDO_SERVER + \
         CO_NO_SDO_CLIENT + \
-        CO_NO_HB_CONS + \
+        CO_NO_HB_CONS_RX + \
+        CO_NO_NG_MASTER + \
+        CO_NO_NG_SLAVE + \
         CO_NO_LSS_SERVER + \
         CO_NO_LSS_CLIENT + \
         0 \
@@ -122,6 +147,7 @@
     #define CO_TXCAN_SDO_CLI  (CO_TXCAN_SDO_SRV+CO_NO_SDO_SERVER)     /*  start index for SDO client message (request) */
     #define CO_TXCAN_HB       (CO_TXCAN_SDO_CLI+CO_NO_SDO_CLIENT)     /*  index for Heartbeat message */
     #define CO_TXCAN_LSS      (CO_TXCAN_HB+CO_NO_HB_PROD)             /*  index for LSS tx message */
+    #define CO_TXCAN_NG_MST   (CO_TXCAN_LSS+CO_NO_LSS_SERVER+CO_NO_LSS_CLIENT) /*  index for Node guarding master message (request) */
     /* total number of transmitted CAN messages */
     #define CO_TXCAN_NO_MSGS ( \
         CO_NO_NMT_MASTER + \
@@ -134,6 +160,7 @@
         CO_NO_HB_PROD + \
         CO_NO_LSS_SERVER + \
         CO_NO_LSS_CLIENT + \
+        CO_NO_NG_MASTER + \
         0\
     )
 
@@ -146,6 +173,9 @@
     static CO_OD_extension_t    COO_SDO_ODExtensions[CO_OD_NoOfElements];
     static CO_EM_t              COO_EM;
     static CO_EMpr_t            COO_EMpr;
+#ifdef CO_EM_CONSUMER
+    static CO_EMcons_t          COO_EMcons;
+#endif
     static CO_NMT_t             COO_NMT;
 #if CO_NO_SYNC == 1
     static CO_SYNC_t            COO_SYNC;
@@ -157,6 +187,15 @@
     static CO_TPDO_t            COO_TPDO[CO_NO_TPDO];
     static CO_HBconsumer_t      COO_HBcons;
     static CO_HBconsNode_t      COO_HBcons_monitoredNodes[CO_NO_HB_CONS];
+#if CO_NO_NMT_MASTER == 1
+    static CO_NMTmaster_t       COO_NMTmaster;
+#endif
+#if CO_NO_NG_SLAVE == 1
+    static CO_NGslave_t         COO_NGslave;
+#endif
+#if CO_NO_NG_MASTER == 1
+    static CO_NGmaster_t        COO_NGmaster;
+#endif
 #if CO_NO_LSS_SERVER == 1
     static CO_LSSslave_t        CO0_LSSslave;
 #endif
@@ -203,69 +242,51 @@ CO_ReturnError_t CO_init(
 
 /* Helper function for NMT master *********************************************/
 #if CO_NO_NMT_MASTER == 1
-    CO_CANtx_t *NMTM_txBuff = 0;
-
     CO_ReturnError_t CO_sendNMTcommand(CO_t *co, uint8_t command, uint8_t nodeID){
-        if(NMTM_txBuff == 0){
-            /* error, CO_CANtxBufferInit() was not called for this buffer. */
-            return CO_ERROR_TX_UNCONFIGURED; /* -11 */
-        }
-        NMTM_txBuff->data[0] = command;
-        NMTM_txBuff->data[1] = nodeID;
-
-        CO_ReturnError_t error = CO_ERROR_NO;
-
-        /* Apply NMT command also to this node, if set so. */
-        if(nodeID == 0 || nodeID == co->NMT->nodeId){
-            switch(command){
-                case CO_NMT_ENTER_OPERATIONAL:
-                    if((*co->NMT->emPr->errorRegister) == 0) {
-                        co->NMT->operatingState = CO_NMT_OPERATIONAL;
-                    }
-                    break;
-                case CO_NMT_ENTER_STOPPED:
-                    co->NMT->operatingState = CO_NMT_STOPPED;
-                    break;
-                case CO_NMT_ENTER_PRE_OPERATIONAL:
-                    co->NMT->operatingState = CO_NMT_PRE_OPERATIONAL;
-                    break;
-                case CO_NMT_RESET_NODE:
-                    co->NMT->resetCommand = CO_RESET_APP;
-                    break;
-                case CO_NMT_RESET_COMMUNICATION:
-                    co->NMT->resetCommand = CO_RESET_COMM;
-                    break;
-                default:
-                    error = CO_ERROR_ILLEGAL_ARGUMENT;
-                    break;
+        return CO_NMTmaster_sendCommand(co->NMTmaster, (CO_NMT_command_t)command, nodeID); /* 0 = success */
+    }
+#endif
 
-            }
-        }
 
-        if(error == CO_ERROR_NO)
-            return CO_CANsend(co->CANmodule[0], NMTM_txBuff); /* 0 = success */
-        else
-        {
-            return error;
-        }
+/******************************************************************************/
+void *CO_ODrelocate(const CO_t *co, const void *ptr)
+{
+    uintptr_t p = (uintptr_t)ptr;
 
+    if(co->OD == &CO_OD[0]) {
+        return (void*)ptr;
     }
-#endif
-
+    if(p >= (uintptr_t)&CO_OD_RAM && p < (uintptr_t)&CO_OD_RAM + sizeof(CO_OD_RAM)) {
+        return (uint8_t*)co->OD_RAM + (p - (uintptr_t)&CO_OD_RAM);
+    }
+    if(p >= (uintptr_t)&CO_OD_EEPROM && p < (uintptr_t)&CO_OD_EEPROM + sizeof(CO_OD_EEPROM)) {
+        return (uint8_t*)co->OD_EEPROM + (p - (uintptr_t)&CO_OD_EEPROM);
+    }
+    if(p >= (uintptr_t)&CO_OD_ROM && p < (uintptr_t)&CO_OD_ROM + sizeof(CO_OD_ROM)) {
+        return (uint8_t*)co->OD_ROM + (p - (uintptr_t)&CO_OD_ROM);
+    }
+    return (void*)ptr;
+}
 
-#if CO_NO_TRACE > 0
-static uint32_t CO_traceBufferSize[CO_NO_TRACE];
-#endif
 
-/******************************************************************************/
-CO_ReturnError_t CO_new(void)
+/* Initialize time source of CANopen object to driver default and profiler **/
+static void CO_timeSourceInit(CO_t *co)
 {
-    int16_t i;
-#ifndef CO_USE_GLOBALS
-    uint16_t errCnt;
+#ifdef CO_TIMEBASE_US
+    co->timeSource = CO_timebase_us;
+#else
+    co->timeSource = NULL;
 #endif
+    co->timeSourceObject = NULL;
+#ifdef CO_USE_PROFILER
+    CO_profiler_init(&co->profiler);
+#endif
+}
 
-    /* Verify parameters from CO_OD */
+
+/* Verify parameters from CO_OD ***********************************************/
+static CO_ReturnError_t CO_verifyOD(void)
+{
     if(   sizeof(OD_TPDOCommunicationParameter_t) != sizeof(CO_TPDOCommPar_t)
        || sizeof(OD_TPDOMappingParameter_t) != sizeof(CO_TPDOMapPar_t)
        || sizeof(OD_RPDOCommunicationParameter_t) != sizeof(CO_RPDOCommPar_t)
@@ -280,203 +301,473 @@ CO_ReturnError_t CO_new(void)
     }
     #endif
 
+    return CO_ERROR_NO;
+}
 
-    /* Initialize CANopen object */
-#ifdef CO_USE_GLOBALS
-    CO = &COO;
 
-    CO_memset((uint8_t*)CO, 0, sizeof(CO_t));
-    CO->CANmodule[0]                    = &COO_CANmodule;
-    CO_CANmodule_rxArray0               = &COO_CANmodule_rxArray0[0];
-    CO_CANmodule_txArray0               = &COO_CANmodule_txArray0[0];
-    for(i=0; i<CO_NO_SDO_SERVER; i++)
-        CO->SDO[i]                      = &COO_SDO[i];
-    CO_SDO_ODExtensions                 = &COO_SDO_ODExtensions[0];
-    CO->em                              = &COO_EM;
-    CO->emPr                            = &COO_EMpr;
-    CO->NMT                             = &COO_NMT;
+#ifndef CO_USE_GLOBALS
+/* Object Dictionary of the instance *******************************************
+ * Copy OD variables, OD entries and arrays for record type objects from CO_OD.c.
+ * Data pointers inside copied entries are relocated into copied variables. */
+static CO_ReturnError_t CO_ODcopy(CO_t *co)
+{
+    uint16_t i;
+    uint16_t noOfRecords = 0;
+    CO_OD_entry_t *OD;
+    CO_OD_entryRecord_t *record;
+
+    for(i=0; i<CO_OD_NoOfElements; i++){
+        const CO_OD_entry_t *object = &CO_OD[i];
+
+        if(object->maxSubIndex != 0U && object->attribute == 0U && object->pData != NULL){
+            noOfRecords += object->maxSubIndex + 1U;
+        }
+    }
+
+    co->OD_RAM      = (struct sCO_OD_RAM *)     malloc(sizeof(CO_OD_RAM));
+    co->OD_EEPROM   = (struct sCO_OD_EEPROM *)  malloc(sizeof(CO_OD_EEPROM));
+    co->OD_ROM      = (struct sCO_OD_ROM *)     malloc(sizeof(CO_OD_ROM));
+    OD              = (CO_OD_entry_t *)         malloc(sizeof(CO_OD_entry_t) * CO_OD_NoOfElements
+                                                     + sizeof(CO_OD_entryRecord_t) * noOfRecords);
+    if(co->OD_RAM == NULL || co->OD_EEPROM == NULL || co->OD_ROM == NULL || OD == NULL){
+        free(OD);
+        return CO_ERROR_OUT_OF_MEMORY;
+    }
+    co->memoryUsed += sizeof(CO_OD_RAM) + sizeof(CO_OD_EEPROM) + sizeof(CO_OD_ROM)
+                    + sizeof(CO_OD_entry_t) * CO_OD_NoOfElements
+                    + sizeof(CO_OD_entryRecord_t) * noOfRecords;
+
+    CO_memcpy((uint8_t*)co->OD_RAM, (const uint8_t*)&CO_OD_RAM, sizeof(CO_OD_RAM));
+    CO_memcpy((uint8_t*)co->OD_EEPROM, (const uint8_t*)&CO_OD_EEPROM, sizeof(CO_OD_EEPROM));
+    CO_memcpy((uint8_t*)co->OD_ROM, (const uint8_t*)&CO_OD_ROM, sizeof(CO_OD_ROM));
+    /* co->OD must differ from CO_OD before CO_ODrelocate() is used. */
+    co->OD = OD;
+
+    record = (CO_OD_entryRecord_t *)&OD[CO_OD_NoOfElements];
+    for(i=0; i<CO_OD_NoOfElements; i++){
+        OD[i] = CO_OD[i];
+
+        if(OD[i].maxSubIndex != 0U && OD[i].attribute == 0U && OD[i].pData != NULL){
+            /* Object type is Record */
+            const CO_OD_entryRecord_t *src = (const CO_OD_entryRecord_t *)CO_OD[i].pData;
+            uint16_t j;
+
+            for(j=0; j<=OD[i].maxSubIndex; j++){
+                record[j] = src[j];
+                record[j].pData = CO_ODrelocate(co, src[j].pData);
+            }
+            OD[i].pData = (void*)record;
+            record += OD[i].maxSubIndex + 1U;
+        }
+        else{
+            OD[i].pData = CO_ODrelocate(co, CO_OD[i].pData);
+        }
+    }
+
+    return CO_ERROR_NO;
+}
+
+
+/* Allocate CANopen objects ****************************************************
+ * Heap memory for all objects of co is allocated. If privateOD is false,
+ * Object Dictionary from CO_OD.c is used, otherwise a copy is made. */
+static CO_ReturnError_t CO_allocate(CO_t *co, bool_t privateOD)
+{
+    int16_t i;
+    uint16_t errCnt;
+
+    co->CANmodule[0]                    = (CO_CANmodule_t *)    calloc(1, sizeof(CO_CANmodule_t));
+    co->CANmodule_rxArray0              = (CO_CANrx_t *)        calloc(CO_RXCAN_NO_MSGS, sizeof(CO_CANrx_t));
+    co->CANmodule_txArray0              = (CO_CANtx_t *)        calloc(CO_TXCAN_NO_MSGS, sizeof(CO_CANtx_t));
+    for(i=0; i<CO_NO_SDO_SERVER; i++){
+        co->SDO[i]                      = (CO_SDO_t *)          calloc(1, sizeof(CO_SDO_t));
+    }
+    co->SDO_ODExtensions                = (CO_OD_extension_t*)  calloc(CO_OD_NoOfElements, sizeof(CO_OD_extension_t));
+    co->em                              = (CO_EM_t *)           calloc(1, sizeof(CO_EM_t));
+    co->emPr                            = (CO_EMpr_t *)         calloc(1, sizeof(CO_EMpr_t));
+  #ifdef CO_EM_CONSUMER
+    co->emCons                          = (CO_EMcons_t *)       calloc(1, sizeof(CO_EMcons_t));
+  #endif
+    co->NMT                             = (CO_NMT_t *)          calloc(1, sizeof(CO_NMT_t));
   #if CO_NO_SYNC == 1
-    CO->SYNC                            = &COO_SYNC;
+    co->SYNC                            = (CO_SYNC_t *)         calloc(1, sizeof(CO_SYNC_t));
   #endif
   #if CO_NO_TIME == 1
-    CO->TIME                            = &COO_TIME;
+    co->TIME                            = (CO_TIME_t *)         calloc(1, sizeof(CO_TIME_t));
+  #endif
+    for(i=0; i<CO_NO_RPDO; i++){
+        co->RPDO[i]                     = (CO_RPDO_t *)         calloc(1, sizeof(CO_RPDO_t));
+    }
+    for(i=0; i<CO_NO_TPDO; i++){
+        co->TPDO[i]                     = (CO_TPDO_t *)         calloc(1, sizeof(CO_TPDO_t));
+    }
+    co->HBcons                          = (CO_HBconsumer_t *)   calloc(1, sizeof(CO_HBconsumer_t));
+    co->HBcons_monitoredNodes           = (CO_HBconsNode_t *)   calloc(CO_NO_HB_CONS, sizeof(CO_HBconsNode_t));
+  #if CO_NO_NMT_MASTER == 1
+    co->NMTmaster                       = (CO_NMTmaster_t *)    calloc(1, sizeof(CO_NMTmaster_t));
+  #endif
+  #if CO_NO_NG_SLAVE == 1
+    co->NGslave                         = (CO_NGslave_t *)      calloc(1, sizeof(CO_NGslave_t));
+  #endif
+  #if CO_NO_NG_MASTER == 1
+    co->NGmaster                        = (CO_NGmaster_t *)     calloc(1, sizeof(CO_NGmaster_t));
   #endif
-    for(i=0; i<CO_NO_RPDO; i++)
-        CO->RPDO[i]                     = &COO_RPDO[i];
-    for(i=0; i<CO_NO_TPDO; i++)
-        CO->TPDO[i]                     = &COO_TPDO[i];
-    CO->HBcons                          = &COO_HBcons;
-    CO_HBcons_monitoredNodes            = &COO_HBcons_monitoredNodes[0];
   #if CO_NO_LSS_SERVER == 1
-    CO->LSSslave                        = &CO0_LSSslave;
+    co->LSSslave                        = (CO_LSSslave_t *)     calloc(1, sizeof(CO_LSSslave_t));
   #endif
   #if CO_NO_LSS_CLIENT == 1
-    CO->LSSmaster                       = &CO0_LSSmaster;
+    co->LSSmaster                       = (CO_LSSmaster_t *)    calloc(1, sizeof(CO_LSSmaster_t));
   #endif
   #if CO_NO_SDO_CLIENT != 0
-    for(i=0; i<CO_NO_SDO_CLIENT; i++) {
-      CO->SDOclient[i]                  = &COO_SDOclient[i];
+    for(i=0; i<CO_NO_SDO_CLIENT; i++){
+        co->SDOclient[i]                = (CO_SDOclient_t *)    calloc(1, sizeof(CO_SDOclient_t));
     }
   #endif
   #if CO_NO_TRACE > 0
     for(i=0; i<CO_NO_TRACE; i++) {
-        CO->trace[i]                    = &COO_trace[i];
-        CO_traceTimeBuffers[i]          = &COO_traceTimeBuffers[i][0];
-        CO_traceValueBuffers[i]         = &COO_traceValueBuffers[i][0];
-        CO_traceBufferSize[i]           = CO_TRACE_BUFFER_SIZE_FIXED;
-    }
-  #endif
-#else
-    if(CO == NULL){    /* Use malloc only once */
-        CO = &COO;
-        CO->CANmodule[0]                    = (CO_CANmodule_t *)    calloc(1, sizeof(CO_CANmodule_t));
-        CO_CANmodule_rxArray0               = (CO_CANrx_t *)        calloc(CO_RXCAN_NO_MSGS, sizeof(CO_CANrx_t));
-        CO_CANmodule_txArray0               = (CO_CANtx_t *)        calloc(CO_TXCAN_NO_MSGS, sizeof(CO_CANtx_t));
-        for(i=0; i<CO_NO_SDO_SERVER; i++){
-            CO->SDO[i]                      = (CO_SDO_t *)          calloc(1, sizeof(CO_SDO_t));
+        co->trace[i]                    = (CO_trace_t *)        calloc(1, sizeof(CO_trace_t));
+        co->traceTimeBuffers[i]         = (uint32_t *)          calloc(OD_traceConfig[i].size, sizeof(uint32_t));
+        co->traceValueBuffers[i]        = (int32_t *)           calloc(OD_traceConfig[i].size, sizeof(int32_t));
+        if(co->traceTimeBuffers[i] != NULL && co->traceValueBuffers[i] != NULL) {
+            co->traceBufferSize[i] = OD_traceConfig[i].size;
+        } else {
+            co->traceBufferSize[i] = 0;
         }
-        CO_SDO_ODExtensions                 = (CO_OD_extension_t*)  calloc(CO_OD_NoOfElements, sizeof(CO_OD_extension_t));
-        CO->em                              = (CO_EM_t *)           calloc(1, sizeof(CO_EM_t));
-        CO->emPr                            = (CO_EMpr_t *)         calloc(1, sizeof(CO_EMpr_t));
-        CO->NMT                             = (CO_NMT_t *)          calloc(1, sizeof(CO_NMT_t));
-      #if CO_NO_SYNC == 1
-        CO->SYNC                            = (CO_SYNC_t *)         calloc(1, sizeof(CO_SYNC_t));
-      #endif
-      #if CO_NO_TIME == 1
-        CO->TIME                            = (CO_TIME_t *)         calloc(1, sizeof(CO_TIME_t));
-      #endif
-        for(i=0; i<CO_NO_RPDO; i++){
-            CO->RPDO[i]                     = (CO_RPDO_t *)         calloc(1, sizeof(CO_RPDO_t));
-        }
-        for(i=0; i<CO_NO_TPDO; i++){
-            CO->TPDO[i]                     = (CO_TPDO_t *)         calloc(1, sizeof(CO_TPDO_t));
-        }
-        CO->HBcons                          = (CO_HBconsumer_t *)   calloc(1, sizeof(CO_HBconsumer_t));
-        CO_HBcons_monitoredNodes            = (CO_HBconsNode_t *)   calloc(CO_NO_HB_CONS, sizeof(CO_HBconsNode_t));
-      #if CO_NO_LSS_SERVER == 1
-        CO->LSSslave                        = (CO_LSSslave_t *)     calloc(1, sizeof(CO_LSSslave_t));
-      #endif
-      #if CO_NO_LSS_CLIENT == 1
-        CO->LSSmaster                       = (CO_LSSmaster_t *)    calloc(1, sizeof(CO_LSSmaster_t));
-      #endif
-      #if CO_NO_SDO_CLIENT != 0
-        for(i=0; i<CO_NO_SDO_CLIENT; i++){
-            CO->SDOclient[i]                = (CO_SDOclient_t *)    calloc(1, sizeof(CO_SDOclient_t));
-        }
-      #endif
-      #if CO_NO_TRACE > 0
-        for(i=0; i<CO_NO_TRACE; i++) {
-            CO->trace[i]                    = (CO_trace_t *)        calloc(1, sizeof(CO_trace_t));
-            CO_traceTimeBuffers[i]          = (uint32_t *)          calloc(OD_traceConfig[i].size, sizeof(uint32_t));
-            CO_traceValueBuffers[i]         = (int32_t *)           calloc(OD_traceConfig[i].size, sizeof(int32_t));
-            if(CO_traceTimeBuffers[i] != NULL && CO_traceValueBuffers[i] != NULL) {
-                CO_traceBufferSize[i] = OD_traceConfig[i].size;
-            } else {
-                CO_traceBufferSize[i] = 0;
-            }
-        }
-      #endif
     }
+  #endif
 
-    CO_memoryUsed = sizeof(CO_CANmodule_t)
-                  + sizeof(CO_CANrx_t) * CO_RXCAN_NO_MSGS
-                  + sizeof(CO_CANtx_t) * CO_TXCAN_NO_MSGS
-                  + sizeof(CO_SDO_t) * CO_NO_SDO_SERVER
-                  + sizeof(CO_OD_extension_t) * CO_OD_NoOfElements
-                  + sizeof(CO_EM_t)
-                  + sizeof(CO_EMpr_t)
-                  + sizeof(CO_NMT_t)
+    co->memoryUsed = sizeof(CO_CANmodule_t)
+                   + sizeof(CO_CANrx_t) * CO_RXCAN_NO_MSGS
+                   + sizeof(CO_CANtx_t) * CO_TXCAN_NO_MSGS
+                   + sizeof(CO_SDO_t) * CO_NO_SDO_SERVER
+                   + sizeof(CO_OD_extension_t) * CO_OD_NoOfElements
+                   + sizeof(CO_EM_t)
+                   + sizeof(CO_EMpr_t)
+  #ifdef CO_EM_CONSUMER
+                   + sizeof(CO_EMcons_t)
+  #endif
+                   + sizeof(CO_NMT_t)
   #if CO_NO_SYNC == 1
-                  + sizeof(CO_SYNC_t)
+                   + sizeof(CO_SYNC_t)
   #endif
   #if CO_NO_TIME == 1
-                  + sizeof(CO_TIME_t)
+                   + sizeof(CO_TIME_t)
+  #endif
+                   + sizeof(CO_RPDO_t) * CO_NO_RPDO
+                   + sizeof(CO_TPDO_t) * CO_NO_TPDO
+                   + sizeof(CO_HBconsumer_t)
+                   + sizeof(CO_HBconsNode_t) * CO_NO_HB_CONS
+  #if CO_NO_NMT_MASTER == 1
+                   + sizeof(CO_NMTmaster_t)
+  #endif
+  #if CO_NO_NG_SLAVE == 1
+                   + sizeof(CO_NGslave_t)
+  #endif
+  #if CO_NO_NG_MASTER == 1
+                   + sizeof(CO_NGmaster_t)
   #endif
-                  + sizeof(CO_RPDO_t) * CO_NO_RPDO
-                  + sizeof(CO_TPDO_t) * CO_NO_TPDO
-                  + sizeof(CO_HBconsumer_t)
-                  + sizeof(CO_HBconsNode_t) * CO_NO_HB_CONS
   #if CO_NO_LSS_SERVER == 1
-                  + sizeof(CO_LSSslave_t)
+                   + sizeof(CO_LSSslave_t)
   #endif
   #if CO_NO_LSS_CLIENT == 1
-                  + sizeof(CO_LSSmaster_t)
+                   + sizeof(CO_LSSmaster_t)
   #endif
   #if CO_NO_SDO_CLIENT != 0
-                  + sizeof(CO_SDOclient_t) * CO_NO_SDO_CLIENT
+                   + sizeof(CO_SDOclient_t) * CO_NO_SDO_CLIENT
   #endif
-                  + 0;
+                   + 0;
   #if CO_NO_TRACE > 0
-    CO_memoryUsed += sizeof(CO_trace_t) * CO_NO_TRACE;
+    co->memoryUsed += sizeof(CO_trace_t) * CO_NO_TRACE;
     for(i=0; i<CO_NO_TRACE; i++) {
-        CO_memoryUsed += CO_traceBufferSize[i] * 8;
+        co->memoryUsed += co->traceBufferSize[i] * 8;
     }
   #endif
 
     errCnt = 0;
-    if(CO->CANmodule[0]                 == NULL) errCnt++;
-    if(CO_CANmodule_rxArray0            == NULL) errCnt++;
-    if(CO_CANmodule_txArray0            == NULL) errCnt++;
+    if(co->CANmodule[0]                 == NULL) errCnt++;
+    if(co->CANmodule_rxArray0           == NULL) errCnt++;
+    if(co->CANmodule_txArray0           == NULL) errCnt++;
     for(i=0; i<CO_NO_SDO_SERVER; i++){
-        if(CO->SDO[i]                   == NULL) errCnt++;
+        if(co->SDO[i]                   == NULL) errCnt++;
     }
-    if(CO_SDO_ODExtensions              == NULL) errCnt++;
-    if(CO->em                           == NULL) errCnt++;
-    if(CO->emPr                         == NULL) errCnt++;
-    if(CO->NMT                          == NULL) errCnt++;
+    if(co->SDO_ODExtensions             == NULL) errCnt++;
+    if(co->em                           == NULL) errCnt++;
+    if(co->emPr                         == NULL) errCnt++;
+  #ifdef CO_EM_CONSUMER
+    if(co->emCons                       == NULL) errCnt++;
+  #endif
+    if(co->NMT                          == NULL) errCnt++;
   #if CO_NO_SYNC == 1
-    if(CO->SYNC                         == NULL) errCnt++;
+    if(co->SYNC                         == NULL) errCnt++;
   #endif
   #if CO_NO_TIME == 1
-    if(CO->TIME                     	== NULL) errCnt++;
+    if(co->TIME                         == NULL) errCnt++;
   #endif
     for(i=0; i<CO_NO_RPDO; i++){
-        if(CO->RPDO[i]                  == NULL) errCnt++;
+        if(co->RPDO[i]                  == NULL) errCnt++;
     }
     for(i=0; i<CO_NO_TPDO; i++){
-        if(CO->TPDO[i]                  == NULL) errCnt++;
+        if(co->TPDO[i]                  == NULL) errCnt++;
     }
-    if(CO->HBcons                       == NULL) errCnt++;
-    if(CO_HBcons_monitoredNodes         == NULL) errCnt++;
+    if(co->HBcons                       == NULL) errCnt++;
+    if(co->HBcons_monitoredNodes        == NULL) errCnt++;
+  #if CO_NO_NMT_MASTER == 1
+    if(co->NMTmaster                    == NULL) errCnt++;
+  #endif
+  #if CO_NO_NG_SLAVE == 1
+    if(co->NGslave                      == NULL) errCnt++;
+  #endif
+  #if CO_NO_NG_MASTER == 1
+    if(co->NGmaster                     == NULL) errCnt++;
+  #endif
   #if CO_NO_LSS_SERVER == 1
-    if(CO->LSSslave                     == NULL) errCnt++;
+    if(co->LSSslave                     == NULL) errCnt++;
   #endif
   #if CO_NO_LSS_CLIENT == 1
-    if(CO->LSSmaster                    == NULL) errCnt++;
+    if(co->LSSmaster                    == NULL) errCnt++;
   #endif
   #if CO_NO_SDO_CLIENT != 0
     for(i=0; i<CO_NO_SDO_CLIENT; i++){
-        if(CO->SDOclient[i]             == NULL) errCnt++;
+        if(co->SDOclient[i]             == NULL) errCnt++;
     }
   #endif
   #if CO_NO_TRACE > 0
     for(i=0; i<CO_NO_TRACE; i++) {
-        if(CO->trace[i]                 == NULL) errCnt++;
+        if(co->trace[i]                 == NULL) errCnt++;
     }
   #endif
 
     if(errCnt != 0) return CO_ERROR_OUT_OF_MEMORY;
+
+    if(privateOD){
+        return CO_ODcopy(co);
+    }
+
+    co->OD          = &CO_OD[0];
+    co->OD_RAM      = &CO_OD_RAM;
+    co->OD_EEPROM   = &CO_OD_EEPROM;
+    co->OD_ROM      = &CO_OD_ROM;
+
+    return CO_ERROR_NO;
+}
+
+
+/* Free memory from CO_allocate() *********************************************/
+static void CO_free(CO_t *co)
+{
+    int16_t i;
+
+  #if CO_NO_TRACE > 0
+      for(i=0; i<CO_NO_TRACE; i++) {
+          free(co->trace[i]);
+          free(co->traceTimeBuffers[i]);
+          free(co->traceValueBuffers[i]);
+      }
+  #endif
+  #if CO_NO_SDO_CLIENT != 0
+      for(i=0; i<CO_NO_SDO_CLIENT; i++) {
+          free(co->SDOclient[i]);
+      }
+  #endif
+  #if CO_NO_LSS_SERVER == 1
+    free(co->LSSslave);
+  #endif
+  #if CO_NO_LSS_CLIENT == 1
+    free(co->LSSmaster);
+  #endif
+  #if CO_NO_NG_MASTER == 1
+    free(co->NGmaster);
+  #endif
+  #if CO_NO_NG_SLAVE == 1
+    free(co->NGslave);
+  #endif
+  #if CO_NO_NMT_MASTER == 1
+    free(co->NMTmaster);
+  #endif
+    free(co->HBcons_monitoredNodes);
+    free(co->HBcons);
+    for(i=0; i<CO_NO_RPDO; i++){
+        free(co->RPDO[i]);
+    }
+    for(i=0; i<CO_NO_TPDO; i++){
+        free(co->TPDO[i]);
+    }
+  #if CO_NO_SYNC == 1
+    free(co->SYNC);
+  #endif
+  #if CO_NO_TIME == 1
+    free(co->TIME);
+  #endif
+    free(co->NMT);
+  #ifdef CO_EM_CONSUMER
+    free(co->emCons);
+  #endif
+    free(co->emPr);
+    free(co->em);
+    free(co->SDO_ODExtensions);
+    for(i=0; i<CO_NO_SDO_SERVER; i++){
+        free(co->SDO[i]);
+    }
+    free(co->CANmodule_txArray0);
+    free(co->CANmodule_rxArray0);
+    free(co->CANmodule[0]);
+
+    if(co->OD_RAM != &CO_OD_RAM){
+        free(co->OD_RAM);
+        free(co->OD_EEPROM);
+        free(co->OD_ROM);
+        if(co->OD != &CO_OD[0]){
+            free((void*)co->OD);
+        }
+    }
+}
+#endif /* CO_USE_GLOBALS */
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_new(void)
+{
+#ifdef CO_USE_GLOBALS
+    int16_t i;
+#endif
+    CO_ReturnError_t err;
+
+    err = CO_verifyOD();
+    if(err){
+        return err;
+    }
+
+    /* Initialize CANopen object */
+#ifdef CO_USE_GLOBALS
+    CO = &COO;
+
+    CO_memset((uint8_t*)CO, 0, sizeof(CO_t));
+    CO->CANmodule[0]                    = &COO_CANmodule;
+    CO->CANmodule_rxArray0              = &COO_CANmodule_rxArray0[0];
+    CO->CANmodule_txArray0              = &COO_CANmodule_txArray0[0];
+    for(i=0; i<CO_NO_SDO_SERVER; i++)
+        CO->SDO[i]                      = &COO_SDO[i];
+    CO->SDO_ODExtensions                = &COO_SDO_ODExtensions[0];
+    CO->em                              = &COO_EM;
+    CO->emPr                            = &COO_EMpr;
+  #ifdef CO_EM_CONSUMER
+    CO->emCons                          = &COO_EMcons;
+  #endif
+    CO->NMT                             = &COO_NMT;
+  #if CO_NO_SYNC == 1
+    CO->SYNC                            = &COO_SYNC;
+  #endif
+  #if CO_NO_TIME == 1
+    CO->TIME                            = &COO_TIME;
+  #endif
+    for(i=0; i<CO_NO_RPDO; i++)
+        CO->RPDO[i]                     = &COO_RPDO[i];
+    for(i=0; i<CO_NO_TPDO; i++)
+        CO->TPDO[i]                     = &COO_TPDO[i];
+    CO->HBcons                          = &COO_HBcons;
+    CO->HBcons_monitoredNodes           = &COO_HBcons_monitoredNodes[0];
+  #if CO_NO_NMT_MASTER == 1
+    CO->NMTmaster                       = &COO_NMTmaster;
+  #endif
+  #if CO_NO_NG_SLAVE == 1
+    CO->NGslave                         = &COO_NGslave;
+  #endif
+  #if CO_NO_NG_MASTER == 1
+    CO->NGmaster                        = &COO_NGmaster;
+  #endif
+  #if CO_NO_LSS_SERVER == 1
+    CO->LSSslave                        = &CO0_LSSslave;
+  #endif
+  #if CO_NO_LSS_CLIENT == 1
+    CO->LSSmaster                       = &CO0_LSSmaster;
+  #endif
+  #if CO_NO_SDO_CLIENT != 0
+    for(i=0; i<CO_NO_SDO_CLIENT; i++) {
+      CO->SDOclient[i]                  = &COO_SDOclient[i];
+    }
+  #endif
+  #if CO_NO_TRACE > 0
+    for(i=0; i<CO_NO_TRACE; i++) {
+        CO->trace[i]                    = &COO_trace[i];
+        CO->traceTimeBuffers[i]         = &COO_traceTimeBuffers[i][0];
+        CO->traceValueBuffers[i]        = &COO_traceValueBuffers[i][0];
+        CO->traceBufferSize[i]          = CO_TRACE_BUFFER_SIZE_FIXED;
+    }
+  #endif
+    CO->OD                              = &CO_OD[0];
+    CO->OD_RAM                          = &CO_OD_RAM;
+    CO->OD_EEPROM                       = &CO_OD_EEPROM;
+    CO->OD_ROM                          = &CO_OD_ROM;
+    CO_timeSourceInit(CO);
+#else
+    if(CO == NULL){    /* Use malloc only once */
+        CO = &COO;
+        CO_memset((uint8_t*)CO, 0, sizeof(CO_t));
+        CO_timeSourceInit(CO);
+        return CO_allocate(CO, false);
+    }
 #endif
     return CO_ERROR_NO;
 }
 
 
 /******************************************************************************/
-CO_ReturnError_t CO_CANinit(
+CO_ReturnError_t CO_newInstance(CO_t **pCO)
+{
+#ifdef CO_USE_GLOBALS
+    (void)pCO;
+    return CO_ERROR_ILLEGAL_ARGUMENT;
+#else
+    CO_t *co;
+    CO_ReturnError_t err;
+
+    if(pCO == NULL){
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    err = CO_verifyOD();
+    if(err){
+        return err;
+    }
+
+    co = (CO_t *) calloc(1, sizeof(CO_t));
+    if(co == NULL){
+        return CO_ERROR_OUT_OF_MEMORY;
+    }
+
+    err = CO_allocate(co, true);
+    if(err){
+        CO_free(co);
+        free(co);
+        return err;
+    }
+    co->memoryUsed += sizeof(CO_t);
+    CO_timeSourceInit(co);
+
+    *pCO = co;
+    return CO_ERROR_NO;
+#endif
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_CANinitInstance(
+        CO_t                   *co,
         void                   *CANdriverState,
         uint16_t                bitRate)
 {
     CO_ReturnError_t err;
 
-    CO->CANmodule[0]->CANnormal = false;
+    co->CANmodule[0]->CANnormal = false;
+    co->CANbitRate = bitRate;
     CO_CANsetConfigurationMode(CANdriverState);
 
     err = CO_CANmodule_init(
-            CO->CANmodule[0],
+            co->CANmodule[0],
             CANdriverState,
-            CO_CANmodule_rxArray0,
+            co->CANmodule_rxArray0,
             CO_RXCAN_NO_MSGS,
-            CO_CANmodule_txArray0,
+            co->CANmodule_txArray0,
             CO_TXCAN_NO_MSGS,
             bitRate);
 
@@ -484,38 +775,59 @@ CO_ReturnError_t CO_CANinit(
 }
 
 
+/******************************************************************************/
+CO_ReturnError_t CO_CANinit(
+        void                   *CANdriverState,
+        uint16_t                bitRate)
+{
+    return CO_CANinitInstance(CO, CANdriverState, bitRate);
+}
+
+
 /******************************************************************************/
 #if CO_NO_LSS_SERVER == 1
-CO_ReturnError_t CO_LSSinit(
+CO_ReturnError_t CO_LSSinitInstance(
+        CO_t                   *co,
         uint8_t                 nodeId,
         uint16_t                bitRate)
 {
     CO_LSS_address_t lssAddress;
     CO_ReturnError_t err;
+    const OD_identity_t *identity = (const OD_identity_t*)CO_OD_PTR(co, OD_identity);
 
-    lssAddress.identity.productCode = OD_identity.productCode;
-    lssAddress.identity.revisionNumber = OD_identity.revisionNumber;
-    lssAddress.identity.serialNumber = OD_identity.serialNumber;
-    lssAddress.identity.vendorID = OD_identity.vendorID;
+    lssAddress.identity.productCode = identity->productCode;
+    lssAddress.identity.revisionNumber = identity->revisionNumber;
+    lssAddress.identity.serialNumber = identity->serialNumber;
+    lssAddress.identity.vendorID = identity->vendorID;
     err = CO_LSSslave_init(
-            CO->LSSslave,
+            co->LSSslave,
             lssAddress,
             bitRate,
             nodeId,
-            CO->CANmodule[0],
+            co->CANmodule[0],
             CO_RXCAN_LSS,
             CO_CAN_ID_LSS_SRV,
-            CO->CANmodule[0],
+            co->CANmodule[0],
             CO_TXCAN_LSS,
             CO_CAN_ID_LSS_CLI);
 
     return err;
 }
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_LSSinit(
+        uint8_t                 nodeId,
+        uint16_t                bitRate)
+{
+    return CO_LSSinitInstance(CO, nodeId, bitRate);
+}
 #endif /* CO_NO_LSS_SERVER == 1 */
 
 
 /******************************************************************************/
-CO_ReturnError_t CO_CANopenInit(
+CO_ReturnError_t CO_CANopenInitInstance(
+        CO_t                   *co,
         uint8_t                 nodeId)
 {
     int16_t i;
@@ -526,6 +838,10 @@ CO_ReturnError_t CO_CANopenInit(
         return CO_ERROR_PARAMETERS;
     }
 
+    co->timeProcess_us = CO_TIME_US_UNKNOWN;
+    co->timeSYNC_us = CO_TIME_US_UNKNOWN;
+    co->timeTPDO_us = CO_TIME_US_UNKNOWN;
+
     for (i=0; i<CO_NO_SDO_SERVER; i++)
     {
         uint32_t COB_IDClientToServer;
@@ -535,23 +851,23 @@ CO_ReturnError_t CO_CANopenInit(
             COB_IDClientToServer = CO_CAN_ID_RSDO + nodeId;
             COB_IDServerToClient = CO_CAN_ID_TSDO + nodeId;
         }else{
-            COB_IDClientToServer = OD_SDOServerParameter[i].COB_IDClientToServer;
-            COB_IDServerToClient = OD_SDOServerParameter[i].COB_IDServerToClient;
+            COB_IDClientToServer = CO_OD_VAR(co, uint32_t, OD_SDOServerParameter[i].COB_IDClientToServer);
+            COB_IDServerToClient = CO_OD_VAR(co, uint32_t, OD_SDOServerParameter[i].COB_IDServerToClient);
         }
 
         err = CO_SDO_init(
-                CO->SDO[i],
+                co->SDO[i],
                 COB_IDClientToServer,
                 COB_IDServerToClient,
                 OD_H1200_SDO_SERVER_PARAM+i,
-                i==0 ? 0 : CO->SDO[0],
-               &CO_OD[0],
+                i==0 ? 0 : co->SDO[0],
+                co->OD,
                 CO_OD_NoOfElements,
-                CO_SDO_ODExtensions,
+                co->SDO_ODExtensions,
                 nodeId,
-                CO->CANmodule[0],
+                co->CANmodule[0],
                 CO_RXCAN_SDO_SRV+i,
-                CO->CANmodule[0],
+                co->CANmodule[0],
                 CO_TXCAN_SDO_SRV+i);
     }
 
@@ -559,55 +875,67 @@ CO_ReturnError_t CO_CANopenInit(
 
 
     err = CO_EM_init(
-            CO->em,
-            CO->emPr,
-            CO->SDO[0],
-           &OD_errorStatusBits[0],
+            co->em,
+            co->emPr,
+            co->SDO[0],
+            CO_OD_PTR(co, OD_errorStatusBits[0]),
             ODL_errorStatusBits_stringLength,
-           &OD_errorRegister,
-           &OD_preDefinedErrorField[0],
+            CO_OD_PTR(co, OD_errorRegister),
+            CO_OD_PTR(co, OD_preDefinedErrorField[0]),
             ODL_preDefinedErrorField_arrayLength,
-            CO->CANmodule[0],
+            co->CANmodule[0],
             CO_RXCAN_EMERG,
-            CO->CANmodule[0],
+            co->CANmodule[0],
             CO_TXCAN_EMERG,
             (uint16_t)CO_CAN_ID_EMERGENCY + nodeId);
 
     if(err){return err;}
 
+#ifdef CO_EM_CONSUMER
+    err = CO_EMcons_init(co->emCons, co->em);
+
+    if(err){return err;}
+#endif
+
 
     err = CO_NMT_init(
-            CO->NMT,
-            CO->emPr,
+            co->NMT,
+            co->emPr,
             nodeId,
             500,
-            CO->CANmodule[0],
+            co->CANmodule[0],
             CO_RXCAN_NMT,
             CO_CAN_ID_NMT_SERVICE,
-            CO->CANmodule[0],
+            co->CANmodule[0],
             CO_TXCAN_HB,
             CO_CAN_ID_HEARTBEAT + nodeId);
 
     if(err){return err;}
 
 
-#if CO_NO_NMT_MASTER == 1
-    NMTM_txBuff = CO_CANtxBufferInit(/* return pointer to 8-byte CAN data buffer, which should be populated */
-            CO->CANmodule[0], /* pointer to CAN module used for sending this message */
-            CO_TXCAN_NMT,     /* index of specific buffer inside CAN module */
-            0x0000,           /* CAN identifier */
-            0,                /* rtr */
-            2,                /* number of data bytes */
-            0);               /* synchronous message flag bit */
+#if CO_NO_NG_SLAVE == 1
+    /* response shares transmit buffer with heartbeat producer */
+    err = CO_NGslave_init(
+            co->NGslave,
+            co->em,
+            co->NMT,
+            co->CANmodule[0],
+            CO_RXCAN_NG_SLV,
+            co->CANmodule[0],
+            CO_TXCAN_HB);
+
+    if(err){return err;}
 #endif
+
+
 #if CO_NO_LSS_CLIENT == 1
     err = CO_LSSmaster_init(
-            CO->LSSmaster,
+            co->LSSmaster,
             CO_LSSmaster_DEFAULT_TIMEOUT,
-            CO->CANmodule[0],
+            co->CANmodule[0],
             CO_RXCAN_LSS,
             CO_CAN_ID_LSS_CLI,
-            CO->CANmodule[0],
+            co->CANmodule[0],
             CO_TXCAN_LSS,
             CO_CAN_ID_LSS_SRV);
 
@@ -617,16 +945,16 @@ CO_ReturnError_t CO_CANopenInit(
 
 #if CO_NO_SYNC == 1
     err = CO_SYNC_init(
-            CO->SYNC,
-            CO->em,
-            CO->SDO[0],
-           &CO->NMT->operatingState,
-            OD_COB_ID_SYNCMessage,
-            OD_communicationCyclePeriod,
-            OD_synchronousCounterOverflowValue,
-            CO->CANmodule[0],
+            co->SYNC,
+            co->em,
+            co->SDO[0],
+           &co->NMT->operatingState,
+            CO_OD_VAR(co, uint32_t, OD_COB_ID_SYNCMessage),
+            CO_OD_VAR(co, uint32_t, OD_communicationCyclePeriod),
+            CO_OD_VAR(co, uint8_t, OD_synchronousCounterOverflowValue),
+            co->CANmodule[0],
             CO_RXCAN_SYNC,
-            CO->CANmodule[0],
+            co->CANmodule[0],
             CO_TXCAN_SYNC);
 
     if(err){return err;}
@@ -634,35 +962,37 @@ CO_ReturnError_t CO_CANopenInit(
 
 #if CO_NO_TIME == 1
     err = CO_TIME_init(
-            CO->TIME,
-            CO->em,
-            CO->SDO[0],
-            &CO->NMT->operatingState,
-            OD_COB_ID_TIME,
+            co->TIME,
+            co->em,
+            co->SDO[0],
+            &co->NMT->operatingState,
+            CO_OD_VAR(co, uint32_t, OD_COB_ID_TIME),
             0,
-            CO->CANmodule[0],
+            co->CANmodule[0],
             CO_RXCAN_TIME,
-            CO->CANmodule[0],
+            co->CANmodule[0],
             CO_TXCAN_TIME);
 
     if(err){return err;}
+
+    CO_TIME_setTimeSource(co->TIME, co->timeSource, co->timeSourceObject);
 #endif
 
     for(i=0; i<CO_NO_RPDO; i++){
-        CO_CANmodule_t *CANdevRx = CO->CANmodule[0];
+        CO_CANmodule_t *CANdevRx = co->CANmodule[0];
         uint16_t CANdevRxIdx = CO_RXCAN_RPDO + i;
 
         err = CO_RPDO_init(
-                CO->RPDO[i],
-                CO->em,
-                CO->SDO[0],
-                CO->SYNC,
-               &CO->NMT->operatingState,
+                co->RPDO[i],
+                co->em,
+                co->SDO[0],
+                co->SYNC,
+               &co->NMT->operatingState,
                 nodeId,
                 ((i<4) ? (CO_CAN_ID_RPDO_1+i*0x100) : 0),
                 0,
-                (CO_RPDOCommPar_t*) &OD_RPDOCommunicationParameter[i],
-                (CO_RPDOMapPar_t*) &OD_RPDOMappingParameter[i],
+                (CO_RPDOCommPar_t*) CO_OD_PTR(co, OD_RPDOCommunicationParameter[i]),
+                (CO_RPDOMapPar_t*) CO_OD_PTR(co, OD_RPDOMappingParameter[i]),
                 OD_H1400_RXPDO_1_PARAM+i,
                 OD_H1600_RXPDO_1_MAPPING+i,
                 CANdevRx,
@@ -673,49 +1003,86 @@ CO_ReturnError_t CO_CANopenInit(
 
     for(i=0; i<CO_NO_TPDO; i++){
         err = CO_TPDO_init(
-                CO->TPDO[i],
-                CO->em,
-                CO->SDO[0],
-                CO->SYNC,
-               &CO->NMT->operatingState,
+                co->TPDO[i],
+                co->em,
+                co->SDO[0],
+                co->SYNC,
+               &co->NMT->operatingState,
                 nodeId,
                 ((i<4) ? (CO_CAN_ID_TPDO_1+i*0x100) : 0),
                 0,
-                (CO_TPDOCommPar_t*) &OD_TPDOCommunicationParameter[i],
-                (CO_TPDOMapPar_t*) &OD_TPDOMappingParameter[i],
+                (CO_TPDOCommPar_t*) CO_OD_PTR(co, OD_TPDOCommunicationParameter[i]),
+                (CO_TPDOMapPar_t*) CO_OD_PTR(co, OD_TPDOMappingParameter[i]),
                 OD_H1800_TXPDO_1_PARAM+i,
                 OD_H1A00_TXPDO_1_MAPPING+i,
-                CO->CANmodule[0],
+                co->CANmodule[0],
                 CO_TXCAN_TPDO+i);
 
         if(err){return err;}
     }
 
+#if CO_NO_SYNC == 1 && defined(CO_TPDO_SCHEDULER)
+    /* Synchronous TPDOs are sent inside synchronous window */
+    err = CO_TPDOsched_init(
+            &co->TPDOsched,
+            co->TPDO,
+            CO_NO_TPDO,
+            co->SYNC,
+            co->CANbitRate);
+
+    if(err){return err;}
+#endif
+
 
     err = CO_HBconsumer_init(
-            CO->HBcons,
-            CO->em,
-            CO->SDO[0],
-           &OD_consumerHeartbeatTime[0],
-            CO_HBcons_monitoredNodes,
+            co->HBcons,
+            co->em,
+            co->SDO[0],
+            CO_OD_PTR(co, OD_consumerHeartbeatTime[0]),
+            co->HBcons_monitoredNodes,
             CO_NO_HB_CONS,
-            CO->CANmodule[0],
+            co->CANmodule[0],
             CO_RXCAN_CONS_HB);
 
     if(err){return err;}
 
 
+#if CO_NO_NG_MASTER == 1
+    err = CO_NGmaster_init(
+            co->NGmaster,
+            co->em,
+            co->CANmodule[0],
+            CO_RXCAN_NG_MST,
+            co->CANmodule[0],
+            CO_TXCAN_NG_MST);
+
+    if(err){return err;}
+#endif
+
+
+#if CO_NO_NMT_MASTER == 1
+    err = CO_NMTmaster_init(
+            co->NMTmaster,
+            co->NMT,
+            co->HBcons,
+            co->CANmodule[0],
+            CO_TXCAN_NMT);
+
+    if(err){return err;}
+#endif
+
+
 #if CO_NO_SDO_CLIENT != 0
 
     for(i=0; i<CO_NO_SDO_CLIENT; i++){
 
         err = CO_SDOclient_init(
-                CO->SDOclient[i],
-                CO->SDO[0],
-                (CO_SDOclientPar_t*) &OD_SDOClientParameter[i],
-                CO->CANmodule[0],
+                co->SDOclient[i],
+                co->SDO[0],
+                (CO_SDOclientPar_t*) CO_OD_PTR(co, OD_SDOClientParameter[i]),
+                co->CANmodule[0],
                 CO_RXCAN_SDO_CLI+i,
-                CO->CANmodule[0],
+                co->CANmodule[0],
                 CO_TXCAN_SDO_CLI+i);
 
         if(err){return err;}
@@ -726,21 +1093,24 @@ CO_ReturnError_t CO_CANopenInit(
 
 #if CO_NO_TRACE > 0
     for(i=0; i<CO_NO_TRACE; i++) {
+        OD_traceConfig_t *traceConfig = (OD_traceConfig_t*)CO_OD_PTR(co, OD_traceConfig[i]);
+        OD_trace_t *trace = (OD_trace_t*)CO_OD_PTR(co, OD_trace[i]);
+
         CO_trace_init(
-            CO->trace[i],
-            CO->SDO[0],
-            OD_traceConfig[i].axisNo,
-            CO_traceTimeBuffers[i],
-            CO_traceValueBuffers[i],
-            CO_traceBufferSize[i],
-            &OD_traceConfig[i].map,
-            &OD_traceConfig[i].format,
-            &OD_traceConfig[i].trigger,
-            &OD_traceConfig[i].threshold,
-            &OD_trace[i].value,
-            &OD_trace[i].min,
-            &OD_trace[i].max,
-            &OD_trace[i].triggerTime,
+            co->trace[i],
+            co->SDO[0],
+            traceConfig->axisNo,
+            co->traceTimeBuffers[i],
+            co->traceValueBuffers[i],
+            co->traceBufferSize[i],
+            &traceConfig->map,
+            &traceConfig->format,
+            &traceConfig->trigger,
+            &traceConfig->threshold,
+            &trace->value,
+            &trace->min,
+            &trace->max,
+            &trace->triggerTime,
             OD_INDEX_TRACE_CONFIG + i,
             OD_INDEX_TRACE + i);
     }
@@ -750,6 +1120,14 @@ CO_ReturnError_t CO_CANopenInit(
 }
 
 
+/******************************************************************************/
+CO_ReturnError_t CO_CANopenInit(
+        uint8_t                 nodeId)
+{
+    return CO_CANopenInitInstance(CO, nodeId);
+}
+
+
 /******************************************************************************/
 CO_ReturnError_t CO_init(
         void                   *CANdriverState,
@@ -781,61 +1159,72 @@ CO_ReturnError_t CO_init(
 
 /******************************************************************************/
 void CO_delete(void *CANdriverState){
-#ifndef CO_USE_GLOBALS
-    int16_t i;
-#endif
-
     CO_CANsetConfigurationMode(CANdriverState);
     CO_CANmodule_disable(CO->CANmodule[0]);
 
 #ifndef CO_USE_GLOBALS
-  #if CO_NO_TRACE > 0
-      for(i=0; i<CO_NO_TRACE; i++) {
-          free(CO->trace[i]);
-          free(CO_traceTimeBuffers[i]);
-          free(CO_traceValueBuffers[i]);
-      }
-  #endif
-  #if CO_NO_SDO_CLIENT != 0
-      for(i=0; i<CO_NO_SDO_CLIENT; i++) {
-          free(CO->SDOclient[i]);
-      }
-  #endif
-  #if CO_NO_LSS_SERVER == 1
-    free(CO->LSSslave);
-  #endif
-  #if CO_NO_LSS_CLIENT == 1
-    free(CO->LSSmaster);
-  #endif
-    free(CO_HBcons_monitoredNodes);
-    free(CO->HBcons);
-    for(i=0; i<CO_NO_RPDO; i++){
-        free(CO->RPDO[i]);
-    }
-    for(i=0; i<CO_NO_TPDO; i++){
-        free(CO->TPDO[i]);
+    CO_free(CO);
+    CO = NULL;
+#endif
+}
+
+
+/******************************************************************************/
+void CO_deleteInstance(CO_t *co, void *CANdriverState){
+    if(co == NULL){
+        return;
     }
-  #if CO_NO_SYNC == 1
-    free(CO->SYNC);
-  #endif
-  #if CO_NO_TIME == 1
-    free(CO->TIME);
-  #endif
-    free(CO->NMT);
-    free(CO->emPr);
-    free(CO->em);
-    free(CO_SDO_ODExtensions);
-    for(i=0; i<CO_NO_SDO_SERVER; i++){
-        free(CO->SDO[i]);
+    if(co == CO){
+        CO_delete(CANdriverState);
+        return;
     }
-    free(CO_CANmodule_txArray0);
-    free(CO_CANmodule_rxArray0);
-    free(CO->CANmodule[0]);
-    CO = NULL;
+
+    CO_CANsetConfigurationMode(CANdriverState);
+    CO_CANmodule_disable(co->CANmodule[0]);
+
+#ifndef CO_USE_GLOBALS
+    CO_free(co);
+    free(co);
 #endif
 }
 
 
+/******************************************************************************/
+void CO_setTimeSource(CO_t *co, CO_timeSource_t timeSource, void *object)
+{
+    co->timeSource = timeSource;
+    co->timeSourceObject = object;
+#if CO_NO_TIME == 1
+    CO_TIME_setTimeSource(co->TIME, timeSource, object);
+#endif
+}
+
+
+/******************************************************************************/
+CO_time_us_t CO_timeNow(const CO_t *co)
+{
+    return (co->timeSource != NULL) ? co->timeSource(co->timeSourceObject) : 0;
+}
+
+
+/* Microseconds elapsed since *time_us, limited to 32 bits; *time_us is set to
+ * now_us. Returns zero on the first call or if time source went backwards. */
+static uint32_t CO_timeDiff_us(CO_time_us_t *time_us, CO_time_us_t now_us)
+{
+    CO_time_us_t diff = 0;
+
+    if(now_us > *time_us){
+        diff = now_us - *time_us;
+        if(diff > 0xFFFFFFFFUL){
+            diff = 0xFFFFFFFFUL;
+        }
+    }
+    *time_us = now_us;
+
+    return (uint32_t)diff;
+}
+
+
 /******************************************************************************/
 CO_NMT_reset_cmd_t CO_process(
         CO_t                   *co,
@@ -845,21 +1234,24 @@ CO_NMT_reset_cmd_t CO_process(
     uint8_t i;
     bool_t NMTisPreOrOperational = false;
     CO_NMT_reset_cmd_t reset = CO_RESET_NOT;
-#ifdef CO_USE_LEDS
-    static uint16_t ms50 = 0;
-#endif /* CO_USE_LEDS */
+
+    CO_PROFILE_BEGIN(&co->profiler, CO_PROF_PROCESS);
 
     if(co->NMT->operatingState == CO_NMT_PRE_OPERATIONAL || co->NMT->operatingState == CO_NMT_OPERATIONAL)
         NMTisPreOrOperational = true;
 
 #ifdef CO_USE_LEDS
-    ms50 += timeDifference_ms;
-    if(ms50 >= 50){
-        ms50 -= 50;
+    co->ms50 += timeDifference_ms;
+    if(co->ms50 >= 50){
+        co->ms50 -= 50;
         CO_NMT_blinkingProcess50ms(co->NMT);
     }
+    if(timerNext_ms != NULL && *timerNext_ms > (50 - co->ms50)){
+        *timerNext_ms = 50 - co->ms50;
+    }
 #endif /* CO_USE_LEDS */
 
+    CO_PROFILE_BEGIN(&co->profiler, CO_PROF_SDO);
     for(i=0; i<CO_NO_SDO_SERVER; i++){
         CO_SDO_process(
                 co->SDO[i],
@@ -868,36 +1260,127 @@ CO_NMT_reset_cmd_t CO_process(
                 1000,
                 timerNext_ms);
     }
+    CO_PROFILE_END(&co->profiler, CO_PROF_SDO);
 
+    CO_PROFILE_BEGIN(&co->profiler, CO_PROF_EM);
     CO_EM_process(
             co->emPr,
             NMTisPreOrOperational,
-            timeDifference_ms * 10,
-            OD_inhibitTimeEMCY,
+            (timeDifference_ms < 6553U) ? (timeDifference_ms * 10U) : 0xFFFFU,
+            CO_OD_VAR(co, uint16_t, OD_inhibitTimeEMCY),
+            timerNext_ms);
+#ifdef CO_EM_CONSUMER
+    CO_EMcons_process(
+            co->emCons,
+            timeDifference_ms,
             timerNext_ms);
+#endif
+    CO_PROFILE_END(&co->profiler, CO_PROF_EM);
 
 
+    CO_PROFILE_BEGIN(&co->profiler, CO_PROF_NMT);
     reset = CO_NMT_process(
             co->NMT,
             timeDifference_ms,
-            OD_producerHeartbeatTime,
-            OD_NMTStartup,
-            OD_errorRegister,
-            OD_errorBehavior,
+            CO_OD_VAR(co, uint16_t, OD_producerHeartbeatTime),
+            CO_OD_VAR(co, uint32_t, OD_NMTStartup),
+            CO_OD_VAR(co, uint8_t, OD_errorRegister),
+            (const uint8_t*)CO_OD_PTR(co, OD_errorBehavior[0]),
             timerNext_ms);
+    CO_PROFILE_END(&co->profiler, CO_PROF_NMT);
 
 
+    CO_PROFILE_BEGIN(&co->profiler, CO_PROF_HB);
     CO_HBconsumer_process(
             co->HBcons,
             NMTisPreOrOperational,
-            timeDifference_ms);
+            timeDifference_ms,
+            timerNext_ms);
+    CO_PROFILE_END(&co->profiler, CO_PROF_HB);
+
+#if CO_NO_NG_SLAVE == 1
+    CO_NGslave_process(
+            co->NGslave,
+            CO_OD_VAR(co, uint16_t, OD_guardTime),
+            CO_OD_VAR(co, uint8_t, OD_lifeTimeFactor),
+            CO_OD_VAR(co, uint16_t, OD_producerHeartbeatTime),
+            timeDifference_ms,
+            timerNext_ms);
+#endif
+
+#if CO_NO_NG_MASTER == 1
+    CO_NGmaster_process(
+            co->NGmaster,
+            timeDifference_ms,
+            timerNext_ms);
+#endif
+
+#if CO_NO_NMT_MASTER == 1
+    CO_NMTmaster_process(
+            co->NMTmaster,
+            timeDifference_ms,
+            timerNext_ms);
+#endif
 
 #if CO_NO_TIME == 1
+    CO_PROFILE_BEGIN(&co->profiler, CO_PROF_TIME);
     CO_TIME_process(
             co->TIME,
-            timeDifference_ms);
+            timeDifference_ms,
+            timerNext_ms);
+    CO_PROFILE_END(&co->profiler, CO_PROF_TIME);
+#endif
+
+#if CO_NO_LSS_CLIENT == 1
+    CO_LSSmaster_timerNext(
+            co->LSSmaster,
+            timerNext_ms);
 #endif
 
+    CO_PROFILE_END(&co->profiler, CO_PROF_PROCESS);
+
+    return reset;
+}
+
+
+/******************************************************************************/
+CO_NMT_reset_cmd_t CO_process_us(
+        CO_t                   *co,
+        CO_time_us_t            now_us,
+        CO_time_us_t           *deadline_us)
+{
+    uint16_t timeDifference_ms = 0;
+    uint16_t timerNext_ms = 0xFFFF;
+    CO_NMT_reset_cmd_t reset;
+
+    /* First call (timeProcess_us is CO_TIME_US_UNKNOWN) or time went backwards */
+    if(now_us < co->timeProcess_us){
+        co->timeProcess_us = now_us;
+    }
+    else{
+        CO_time_us_t diff_ms = (now_us - co->timeProcess_us) / 1000U;
+
+        if(diff_ms > 0xFFFFU){
+            timeDifference_ms = 0xFFFF;
+            co->timeProcess_us = now_us;
+        }
+        else{
+            /* Keep fraction of millisecond for the next call */
+            timeDifference_ms = (uint16_t)diff_ms;
+            co->timeProcess_us += diff_ms * 1000U;
+        }
+    }
+
+    reset = CO_process(co, timeDifference_ms, &timerNext_ms);
+
+    /* Objects have advanced their timers up to timeProcess_us */
+    if(deadline_us != NULL){
+        CO_time_us_t deadline = co->timeProcess_us + (CO_time_us_t)timerNext_ms * 1000U;
+        if(deadline < *deadline_us){
+            *deadline_us = deadline;
+        }
+    }
+
     return reset;
 }
 
@@ -910,7 +1393,31 @@ bool_t CO_process_SYNC(
 {
     bool_t syncWas = false;
 
-    switch(CO_SYNC_process(co->SYNC, timeDifference_us, OD_synchronousWindowLength)){
+    CO_PROFILE_BEGIN(&co->profiler, CO_PROF_SYNC);
+    switch(CO_SYNC_process(co->SYNC, timeDifference_us, CO_OD_VAR(co, uint32_t, OD_synchronousWindowLength))){
+        case 1:     //immediately after the SYNC message
+            syncWas = true;
+            break;
+        case 2:     //outside SYNC window
+            CO_CANclearPendingSyncPDOs(co->CANmodule[0]);
+            break;
+    }
+    CO_PROFILE_END(&co->profiler, CO_PROF_SYNC);
+
+    return syncWas;
+}
+
+
+/******************************************************************************/
+bool_t CO_process_SYNC_us(
+        CO_t                   *co,
+        CO_time_us_t            now_us)
+{
+    bool_t syncWas = false;
+    uint32_t timeDifference_us = CO_timeDiff_us(&co->timeSYNC_us, now_us);
+
+    CO_PROFILE_BEGIN(&co->profiler, CO_PROF_SYNC);
+    switch(CO_SYNC_process_us(co->SYNC, timeDifference_us, now_us, CO_OD_VAR(co, uint32_t, OD_synchronousWindowLength))){
         case 1:     //immediately after the SYNC message
             syncWas = true;
             break;
@@ -918,6 +1425,7 @@ bool_t CO_process_SYNC(
             CO_CANclearPendingSyncPDOs(co->CANmodule[0]);
             break;
     }
+    CO_PROFILE_END(&co->profiler, CO_PROF_SYNC);
 
     return syncWas;
 }
@@ -930,9 +1438,11 @@ void CO_process_RPDO(
 {
     int16_t i;
 
+    CO_PROFILE_BEGIN(&co->profiler, CO_PROF_RPDO);
     for(i=0; i<CO_NO_RPDO; i++){
         CO_RPDO_process(co->RPDO[i], syncWas);
     }
+    CO_PROFILE_END(&co->profiler, CO_PROF_RPDO);
 }
 
 
@@ -945,9 +1455,24 @@ void CO_process_TPDO(
     int16_t i;
 
     /* Verify PDO Change Of State and process PDOs */
+    CO_PROFILE_BEGIN(&co->profiler, CO_PROF_TPDO);
     for(i=0; i<CO_NO_TPDO; i++){
         if(!co->TPDO[i]->sendRequest)
             co->TPDO[i]->sendRequest = CO_TPDOisCOS(co->TPDO[i]);
         CO_TPDO_process(co->TPDO[i], syncWas, timeDifference_us);
     }
+#if CO_NO_SYNC == 1 && defined(CO_TPDO_SCHEDULER)
+    CO_TPDOsched_process(&co->TPDOsched, syncWas, CO_OD_VAR(co, uint32_t, OD_synchronousWindowLength));
+#endif
+    CO_PROFILE_END(&co->profiler, CO_PROF_TPDO);
+}
+
+
+/******************************************************************************/
+void CO_process_TPDO_us(
+        CO_t                   *co,
+        bool_t                  syncWas,
+        CO_time_us_t            now_us)
+{
+    CO_process_TPDO(co, syncWas, CO_timeDiff_us(&co->timeTPDO_us, now_us));
 }
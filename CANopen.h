@@ -85,6 +85,13 @@ extern "C" {
 #if CO_NO_LSS_CLIENT == 1
     #include "CO_LSSmaster.h"
 #endif
+#if CO_NO_NMT_MASTER == 1
+    #include "CO_NMTmaster.h"
+#endif
+#if CO_NO_NG_SLAVE == 1 || CO_NO_NG_MASTER == 1
+    #include "CO_NodeGuarding.h"
+#endif
+    #include "CO_profiler.h"
 
 /**
  * Default CANopen identifiers.
@@ -123,6 +130,9 @@ typedef struct{
     CO_SDO_t           *SDO[CO_NO_SDO_SERVER]; /**< SDO object */
     CO_EM_t            *em;             /**< Emergency report object */
     CO_EMpr_t          *emPr;           /**< Emergency process object */
+#ifdef CO_EM_CONSUMER
+    CO_EMcons_t        *emCons;         /**< Emergency consumer object */
+#endif
     CO_NMT_t           *NMT;            /**< NMT object */
     CO_SYNC_t          *SYNC;           /**< SYNC object */
     CO_TIME_t          *TIME;           /**< TIME object */
@@ -141,18 +151,61 @@ typedef struct{
 #if CO_NO_TRACE > 0
     CO_trace_t         *trace[CO_NO_TRACE]; /**< Trace object for monitoring variables */
 #endif
+    /** Object Dictionary used by this instance. Either CO_OD from CO_OD.c or
+     * private copy with pointers relocated into OD_RAM, OD_EEPROM, OD_ROM. */
+    const CO_OD_entry_t *OD;
+    struct sCO_OD_RAM  *OD_RAM;         /**< Object Dictionary RAM variables */
+    struct sCO_OD_EEPROM *OD_EEPROM;    /**< Object Dictionary EEPROM variables */
+    struct sCO_OD_ROM  *OD_ROM;         /**< Object Dictionary ROM variables */
+    CO_CANrx_t         *CANmodule_rxArray0; /**< Receive buffers of CANmodule[0] */
+    CO_CANtx_t         *CANmodule_txArray0; /**< Transmit buffers of CANmodule[0] */
+    CO_OD_extension_t  *SDO_ODExtensions; /**< OD extensions for SDO[0] */
+    CO_HBconsNode_t    *HBcons_monitoredNodes; /**< Nodes for HBcons */
+#if CO_NO_NMT_MASTER == 1
+    CO_NMTmaster_t     *NMTmaster;      /**< NMT master object, see @ref CO_NMTmaster */
+#endif
+#if CO_NO_NG_SLAVE == 1
+    CO_NGslave_t       *NGslave;        /**< Node guarding slave object, see @ref CO_NodeGuarding */
+#endif
+#if CO_NO_NG_MASTER == 1
+    CO_NGmaster_t      *NGmaster;       /**< Node guarding master object, see @ref CO_NodeGuarding */
+#endif
+#if CO_NO_TRACE > 0
+    uint32_t           *traceTimeBuffers[CO_NO_TRACE]; /**< Buffers for trace */
+    int32_t            *traceValueBuffers[CO_NO_TRACE]; /**< Buffers for trace */
+    uint32_t            traceBufferSize[CO_NO_TRACE]; /**< Size of trace buffers */
+#endif
+    uint16_t            ms50;           /**< Internal timer for LED processing */
+    CO_timeSource_t     timeSource;     /**< Time source, see CO_setTimeSource() */
+    void               *timeSourceObject; /**< Object passed to timeSource */
+    CO_time_us_t        timeProcess_us; /**< Time consumed by last CO_process_us() */
+    CO_time_us_t        timeSYNC_us;    /**< Time of last CO_process_SYNC_us() */
+    CO_time_us_t        timeTPDO_us;    /**< Time of last CO_process_TPDO_us() */
+    uint16_t            CANbitRate;     /**< From CO_CANinitInstance(), in [kbit/s] */
+#if CO_NO_SYNC == 1 && defined(CO_TPDO_SCHEDULER)
+    CO_TPDOsched_t      TPDOsched;      /**< Scheduler for synchronous TPDOs, see CO_TPDOsched_init() */
+#endif
+#ifdef CO_USE_PROFILER
+    CO_profiler_t       profiler;       /**< Cycle time statistics, see @ref CO_profiler */
+#endif
+    uint32_t            memoryUsed;     /**< Heap memory used by this instance (informative) */
 }CO_t;
 
 
-/** CANopen object */
+/**
+ * CANopen object
+ *
+ * Default instance, used by CO_new(), CO_CANinit(), CO_CANopenInit(), CO_init()
+ * and CO_delete(). It uses Object Dictionary variables from CO_OD.c directly,
+ * so application may access them with OD_xxx macros from CO_OD.h.
+ */
     extern CO_t *CO;
 
 
 /**
- * Function CO_sendNMTcommand() is simple function, which sends CANopen message.
- * This part of code is an example of custom definition of simple CANopen
- * object. Follow the code in CANopen.c file. If macro CO_NO_NMT_MASTER is 1,
- * function CO_sendNMTcommand can be used to send NMT master message.
+ * Function CO_sendNMTcommand() sends NMT master message immediately. It is
+ * available, if macro CO_NO_NMT_MASTER is 1, see CO_NMTmaster_sendCommand().
+ * For verified and batched commands to many nodes use CO_NMTmaster_request().
  *
  * @param co CANopen object.
  * @param command NMT command.
@@ -248,6 +301,135 @@ CO_ReturnError_t CO_init(
 void CO_delete(void *CANdriverState);
 
 
+/**
+ * Allocate new, independent CANopen object.
+ *
+ * Unlike CO_new(), which works on global #CO, this function allocates a new
+ * instance with all CANopen objects, CAN buffers and its own copy of Object
+ * Dictionary variables (initialized from the current values of CO_OD_RAM,
+ * CO_OD_EEPROM and CO_OD_ROM). Many instances may coexist in one process,
+ * each connected to its own CAN module. Object Dictionary variables of the
+ * instance must be accessed through co->OD_RAM, co->OD_EEPROM, co->OD_ROM or
+ * CO_ODrelocate(), not through OD_xxx macros.
+ *
+ * Functions of different instances may be called from different threads.
+ * Functions of the same instance must be called as for global #CO. Note,
+ * CO_LOCK_xxx() macros from CO_driver_target.h are common to all instances.
+ *
+ * Not available if CO_USE_GLOBALS is defined.
+ *
+ * @param [out] pCO Pointer to the new CANopen object is written here.
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO, CO_ERROR_ILLEGAL_ARGUMENT,
+ * CO_ERROR_PARAMETERS, CO_ERROR_OUT_OF_MEMORY.
+ */
+CO_ReturnError_t CO_newInstance(CO_t **pCO);
+
+
+/**
+ * Initialize CAN driver of the CANopen object.
+ *
+ * Same as CO_CANinit(), but for specific instance.
+ *
+ * @param co CANopen object from CO_newInstance().
+ * @param CANdriverState Pointer to the CAN module, passed to CO_CANmodule_init().
+ * @param bitRate CAN bit rate.
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO, CO_ERROR_ILLEGAL_ARGUMENT,
+ * CO_ERROR_ILLEGAL_BAUDRATE, CO_ERROR_OUT_OF_MEMORY
+ */
+CO_ReturnError_t CO_CANinitInstance(
+        CO_t                   *co,
+        void                   *CANdriverState,
+        uint16_t                bitRate);
+
+
+#if CO_NO_LSS_SERVER == 1
+/**
+ * Initialize CANopen LSS slave of the CANopen object.
+ *
+ * Same as CO_LSSinit(), but for specific instance.
+ *
+ * @param co CANopen object from CO_newInstance().
+ * @param nodeId Node ID of the CANopen device (1 ... 127) or CO_LSS_NODE_ID_ASSIGNMENT
+ * @param bitRate CAN bit rate.
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO, CO_ERROR_ILLEGAL_ARGUMENT
+ */
+CO_ReturnError_t CO_LSSinitInstance(
+        CO_t                   *co,
+        uint8_t                 nodeId,
+        uint16_t                bitRate);
+#endif
+
+
+/**
+ * Initialize CANopen stack of the CANopen object.
+ *
+ * Same as CO_CANopenInit(), but for specific instance.
+ *
+ * @param co CANopen object from CO_newInstance().
+ * @param nodeId Node ID of the CANopen device (1 ... 127).
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO, CO_ERROR_ILLEGAL_ARGUMENT
+ */
+CO_ReturnError_t CO_CANopenInitInstance(
+        CO_t                   *co,
+        uint8_t                 nodeId);
+
+
+/**
+ * Delete CANopen object from CO_newInstance() and free its memory.
+ *
+ * @param co CANopen object.
+ * @param CANdriverState Pointer to the user-defined CAN base structure, passed to CO_CANmodule_init().
+ */
+void CO_deleteInstance(CO_t *co, void *CANdriverState);
+
+
+/**
+ * Get address of Object Dictionary variable inside specific instance.
+ *
+ * OD_xxx macros from CO_OD.h address global CO_OD_RAM, CO_OD_EEPROM and
+ * CO_OD_ROM. This function translates such address into the storage of the
+ * CANopen object. Other addresses are returned unchanged.
+ *
+ * Example: `uint8_t *errReg = (uint8_t*)CO_ODrelocate(co, &OD_errorRegister);`
+ *
+ * @param co CANopen object.
+ * @param ptr Address of Object Dictionary variable from CO_OD.h.
+ *
+ * @return Address of the same variable in co.
+ */
+void *CO_ODrelocate(const CO_t *co, const void *ptr);
+
+
+/**
+ * Register time source for CANopen object.
+ *
+ * Time source is used by CO_timeNow(). It is initialized to CO_timebase_us(),
+ * if driver defines CO_TIMEBASE_US, or to NULL otherwise. Function may be
+ * called after CO_new() or CO_newInstance().
+ *
+ * @param co CANopen object.
+ * @param timeSource Function, which returns monotonic time in
+ * [microseconds]. For example CLOCK_MONOTONIC on Linux or free running
+ * hardware timer, extended to 64 bits, on microcontroller.
+ * @param object Pointer to object, which will be passed to timeSource. May be NULL.
+ */
+void CO_setTimeSource(CO_t *co, CO_timeSource_t timeSource, void *object);
+
+
+/**
+ * Get current time from time source of the CANopen object.
+ *
+ * @param co CANopen object.
+ *
+ * @return Monotonic time in [microseconds] or 0, if there is no time source.
+ */
+CO_time_us_t CO_timeNow(const CO_t *co);
+
+
 /**
  * Process CANopen objects.
  *
@@ -258,10 +440,16 @@ void CO_delete(void *CANdriverState);
  * @param timeDifference_ms Time difference from previous function call in [milliseconds].
  * @param timerNext_ms Return value - info to OS - maximum delay after function
  *        should be called next time in [milliseconds]. Value can be used for OS
- *        sleep time. Initial value must be set to something, 50ms typically.
- *        Output will be equal or lower to initial value. If there is new object
- *        to process, delay should be suspended and this function should be
- *        called immediately. Parameter is ignored if NULL.
+ *        sleep time. Initial value must be set to the longest acceptable sleep
+ *        time (up to 0xFFFF). Output will be equal or lower to initial value:
+ *        every object with pending timer (SDO server, Emergency, NMT and
+ *        Heartbeat producer, Heartbeat consumer, TIME, LSS master, LEDs) lowers
+ *        it to its own deadline. If there is new object to process, delay
+ *        should be suspended and this function should be called immediately;
+ *        see CO_SDO_initCallback(), CO_EM_initCallback(),
+ *        CO_NMT_initCallbackSignal(), CO_HBconsumer_initCallbackSignal(),
+ *        CO_TIME_initCallback() and CO_LSSmaster_initCallback().
+ *        Parameter is ignored if NULL.
  *
  * @return #CO_NMT_reset_cmd_t from CO_NMT_process().
  */
@@ -271,6 +459,31 @@ CO_NMT_reset_cmd_t CO_process(
         uint16_t               *timerNext_ms);
 
 
+/**
+ * Process CANopen objects at absolute time.
+ *
+ * Same as CO_process(), but takes monotonic time instead of time difference.
+ * Time difference is calculated from the time of the previous call, so it
+ * does not alias, if 16-bit millisecond counter would overflow. Fraction of
+ * millisecond is retained for the next call, so timers don't drift, even if
+ * function is called in irregular intervals. Interval longer than 0xFFFF
+ * milliseconds is limited to 0xFFFF milliseconds, which expires all timers.
+ *
+ * @param co CANopen object.
+ * @param now_us Current time in [microseconds], for example from CO_timeNow().
+ * @param deadline_us Return value - absolute time in [microseconds], when
+ *        function should be called next time. Initial value must be set to
+ *        the latest acceptable time. Output will be equal or lower to initial
+ *        value, see timerNext_ms in CO_process(). Parameter is ignored if NULL.
+ *
+ * @return #CO_NMT_reset_cmd_t from CO_NMT_process().
+ */
+CO_NMT_reset_cmd_t CO_process_us(
+        CO_t                   *co,
+        CO_time_us_t            now_us,
+        CO_time_us_t           *deadline_us);
+
+
 #if CO_NO_SYNC == 1
 /**
  * Process CANopen SYNC objects.
@@ -286,6 +499,25 @@ CO_NMT_reset_cmd_t CO_process(
 bool_t CO_process_SYNC(
         CO_t                   *co,
         uint32_t                timeDifference_us);
+
+
+/**
+ * Process CANopen SYNC objects at absolute time.
+ *
+ * Same as CO_process_SYNC(), but takes monotonic time instead of time
+ * difference. Function may be called in irregular intervals, time between
+ * calls is measured, not assumed. SYNC producer sends SYNC messages on
+ * absolute deadlines, see CO_SYNC_process_us(). To send SYNC exactly on time,
+ * caller should wake at CO_SYNC_getProducerDeadline().
+ *
+ * @param co CANopen object.
+ * @param now_us Current time in [microseconds], for example from CO_timeNow().
+ *
+ * @return True, if CANopen SYNC message was just received or transmitted.
+ */
+bool_t CO_process_SYNC_us(
+        CO_t                   *co,
+        CO_time_us_t            now_us);
 #endif
 
 /**
@@ -316,6 +548,22 @@ void CO_process_TPDO(
         bool_t                  syncWas,
         uint32_t                timeDifference_us);
 
+
+/**
+ * Process CANopen TPDO objects at absolute time.
+ *
+ * Same as CO_process_TPDO(), but takes monotonic time instead of time
+ * difference.
+ *
+ * @param co CANopen object.
+ * @param syncWas True, if CANopen SYNC message was just received or transmitted.
+ * @param now_us Current time in [microseconds], for example from CO_timeNow().
+ */
+void CO_process_TPDO_us(
+        CO_t                   *co,
+        bool_t                  syncWas,
+        CO_time_us_t            now_us);
+
 #ifdef __cplusplus
 }
 #endif /*__cplusplus*/
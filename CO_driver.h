@@ -174,6 +174,68 @@ void CO_CANmodule_disable(CO_CANmodule_t *CANmodule);
 uint16_t CO_CANrxMsg_readIdent(const CO_CANrxMsg_t *rxMsg);
 
 
+#if defined(CO_CAN_RX_TIMESTAMP) || defined(CO_DOXYGEN)
+/**
+ * Read reception time of the received message.
+ *
+ * Available, if driver defines CO_CAN_RX_TIMESTAMP in CO_driver_target.h.
+ * Time is captured by CAN hardware or kernel, when message arrives from CAN
+ * bus, so it does not depend on when the message is processed by the stack.
+ * It is used by SYNC, TIME and RPDO objects.
+ *
+ * @param rxMsg Pointer to received message
+ * @return Reception time in [microseconds], same time base as CO_CANtimestampNow().
+ */
+uint32_t CO_CANrxMsg_readTimestamp(const CO_CANrxMsg_t *rxMsg);
+
+
+/**
+ * Get current time in the time base of CO_CANrxMsg_readTimestamp().
+ *
+ * @return Current time in [microseconds]. Value overflows, so only differences
+ * between two values are meaningful.
+ */
+uint32_t CO_CANtimestampNow(void);
+#endif
+
+
+/**
+ * Monotonic time in [microseconds].
+ *
+ * 64-bit value practically never overflows, so two time values may be
+ * compared directly and stored as absolute deadlines.
+ */
+typedef uint64_t CO_time_us_t;
+
+
+/**
+ * Time source function, see CO_setTimeSource().
+ *
+ * Function must be fast and reentrant. It may be called from mainline and
+ * from realtime thread.
+ *
+ * @param object Object registered together with the function.
+ * @return Current monotonic time in [microseconds].
+ */
+typedef CO_time_us_t (*CO_timeSource_t)(void *object);
+
+
+#if defined(CO_TIMEBASE_US) || defined(CO_DOXYGEN)
+/**
+ * Default time source of the target.
+ *
+ * Available, if driver defines CO_TIMEBASE_US in CO_driver_target.h. It is
+ * used by CANopen objects, if application does not register other time source
+ * with CO_setTimeSource(). On Linux it reads CLOCK_MONOTONIC, on
+ * microcontrollers it typically extends free running hardware timer to 64 bits.
+ *
+ * @param object Ignored, may be NULL.
+ * @return Current monotonic time in [microseconds].
+ */
+CO_time_us_t CO_timebase_us(void *object);
+#endif
+
+
 /**
  * Configure CAN message receive buffer.
  *
@@ -30,6 +30,177 @@
 #include "CANopen.h"
 
 
+#if (CO_EM_INTERNAL_BUFFER_SIZE < 2) || ((CO_EM_INTERNAL_BUFFER_SIZE & (CO_EM_INTERNAL_BUFFER_SIZE - 1)) != 0)
+    #error CO_EM_INTERNAL_BUFFER_SIZE must be power of two
+#endif
+#if defined(CO_EM_CONSUMER) && ((CO_EM_CONS_RX_QUEUE_SIZE < 2) || ((CO_EM_CONS_RX_QUEUE_SIZE & (CO_EM_CONS_RX_QUEUE_SIZE - 1)) != 0))
+    #error CO_EM_CONS_RX_QUEUE_SIZE must be power of two
+#endif
+
+
+/*
+ * Atomic operations used by emergency buffer and error status bits.
+ */
+#ifdef CO_USE_GCC_ATOMICS
+#define CO_EM_CAS32(ptr, exp, des) \
+    __atomic_compare_exchange_n((ptr), &(exp), (des), false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)
+#define CO_EM_FETCH_OR8(ptr, val)   __atomic_fetch_or((ptr), (val), __ATOMIC_ACQ_REL)
+#define CO_EM_FETCH_AND8(ptr, val)  __atomic_fetch_and((ptr), (val), __ATOMIC_ACQ_REL)
+#define CO_EM_INC32(ptr)            (void)__atomic_fetch_add((ptr), 1U, __ATOMIC_RELAXED)
+#define CO_EM_DEC32(ptr)            (void)__atomic_fetch_sub((ptr), 1U, __ATOMIC_RELAXED)
+#define CO_EM_LOAD32(ptr)           __atomic_load_n((ptr), __ATOMIC_ACQUIRE)
+#define CO_EM_STORE32(ptr, val)     __atomic_store_n((ptr), (val), __ATOMIC_RELEASE)
+#else
+/* On failure exp is updated with actual value, as with GCC builtin. */
+static bool_t CO_EM_cas32(volatile uint32_t *ptr, uint32_t *exp, uint32_t des){
+    bool_t ret;
+
+    CO_LOCK_EMCY();
+    ret = (*ptr == *exp) ? true : false;
+    if(ret){
+        *ptr = des;
+    }
+    else{
+        *exp = *ptr;
+    }
+    CO_UNLOCK_EMCY();
+    return ret;
+}
+
+static uint8_t CO_EM_fetchOr8(uint8_t *ptr, uint8_t val){
+    uint8_t old;
+
+    CO_LOCK_EMCY();
+    old = *ptr;
+    *ptr = old | val;
+    CO_UNLOCK_EMCY();
+    return old;
+}
+
+static uint8_t CO_EM_fetchAnd8(uint8_t *ptr, uint8_t val){
+    uint8_t old;
+
+    CO_LOCK_EMCY();
+    old = *ptr;
+    *ptr = old & val;
+    CO_UNLOCK_EMCY();
+    return old;
+}
+
+static void CO_EM_inc32(volatile uint32_t *ptr){
+    CO_LOCK_EMCY();
+    (*ptr)++;
+    CO_UNLOCK_EMCY();
+}
+
+static void CO_EM_dec32(volatile uint32_t *ptr){
+    CO_LOCK_EMCY();
+    (*ptr)--;
+    CO_UNLOCK_EMCY();
+}
+
+static uint32_t CO_EM_load32(volatile uint32_t *ptr){
+    uint32_t val = *ptr;
+
+    CANrxMemoryBarrier();
+    return val;
+}
+
+#define CO_EM_CAS32(ptr, exp, des)  CO_EM_cas32((ptr), &(exp), (des))
+#define CO_EM_FETCH_OR8(ptr, val)   CO_EM_fetchOr8((ptr), (val))
+#define CO_EM_FETCH_AND8(ptr, val)  CO_EM_fetchAnd8((ptr), (val))
+#define CO_EM_INC32(ptr)            CO_EM_inc32(ptr)
+#define CO_EM_DEC32(ptr)            CO_EM_dec32(ptr)
+#define CO_EM_LOAD32(ptr)           CO_EM_load32(ptr)
+#define CO_EM_STORE32(ptr, val)     {CANrxMemoryBarrier(); *(ptr) = (val);}
+#endif
+
+
+/*
+ * Get counter of active errors for byte of error status bits.
+ *
+ * @return Pointer to counter or NULL, if errors in this byte do not affect
+ * error register.
+ */
+static volatile uint32_t *CO_EM_errorCnt(CO_EM_t *em, uint8_t index){
+    if(index == 5U){
+        return &em->errorCntGeneric;
+    }
+    else if(index == 2U || index == 3U){
+        return &em->errorCntComm;
+    }
+    else if(index >= 6U){
+        return &em->errorCntManufacturer;
+    }
+    return NULL;
+}
+
+
+/*
+ * Put emergency message into buffer. Called from multiple threads.
+ *
+ * @return false, if buffer was full. Overflow is counted then.
+ */
+static bool_t CO_EM_bufPush(CO_EM_t *em, const uint8_t data[]){
+    uint32_t pos = CO_EM_LOAD32(&em->bufWriteCnt);
+    CO_EM_bufSlot_t *slot;
+
+    for(;;){
+        int32_t dif;
+
+        slot = &em->buf[pos & (CO_EM_INTERNAL_BUFFER_SIZE - 1U)];
+        dif = (int32_t)(CO_EM_LOAD32(&slot->seq) - pos);
+        if(dif == 0){
+            /* slot is free, try to reserve it */
+            if(CO_EM_CAS32(&em->bufWriteCnt, pos, pos + 1U)){
+                break;
+            }
+            /* other writer was faster, pos was updated */
+        }
+        else if(dif < 0){
+            /* slot still contains unread message, buffer is full */
+            CO_EM_INC32(&em->bufOverflowCnt);
+            return false;
+        }
+        else{
+            /* other writer already reserved this slot */
+            pos = CO_EM_LOAD32(&em->bufWriteCnt);
+        }
+    }
+
+    CO_memcpy(slot->data, data, 8U);
+    /* publish message to consumer */
+    CO_EM_STORE32(&slot->seq, pos + 1U);
+
+    return true;
+}
+
+
+/*
+ * Get the oldest emergency message from buffer. Called only from CO_EM_process().
+ *
+ * @return Pointer to message data or NULL, if buffer is empty. Slot is
+ * released with CO_EM_bufRelease().
+ */
+static uint8_t *CO_EM_bufPeek(CO_EM_t *em){
+    CO_EM_bufSlot_t *slot = &em->buf[em->bufReadCnt & (CO_EM_INTERNAL_BUFFER_SIZE - 1U)];
+
+    if(CO_EM_LOAD32(&slot->seq) != (em->bufReadCnt + 1U)){
+        return NULL;
+    }
+    return slot->data;
+}
+
+
+static void CO_EM_bufRelease(CO_EM_t *em){
+    CO_EM_bufSlot_t *slot = &em->buf[em->bufReadCnt & (CO_EM_INTERNAL_BUFFER_SIZE - 1U)];
+
+    /* slot will be free for writer, which comes one round later */
+    CO_EM_STORE32(&slot->seq, em->bufReadCnt + CO_EM_INTERNAL_BUFFER_SIZE);
+    em->bufReadCnt++;
+}
+
+
 /*
  * Read received message from CAN module.
  *
@@ -44,6 +215,37 @@ static void CO_EM_receive(void *object, const CO_CANrxMsg_t *msg){
 
     em = (CO_EM_t*)object;
 
+#ifdef CO_EM_CONSUMER
+    /* only queue the message, it is processed by CO_EMcons_process() */
+    if(em!=NULL && em->emCons!=NULL){
+        CO_EMcons_t *emCons = em->emCons;
+        uint8_t nodeId = (uint8_t)(CO_CANrxMsg_readIdent(msg) & 0x7FU);
+        uint16_t head = emCons->queueHead;
+        CO_EMconsFrame_t *frame;
+
+        if(nodeId == 0U || msg->DLC != 8U){
+            return;
+        }
+        if((uint16_t)(head - emCons->queueTail) >= CO_EM_CONS_RX_QUEUE_SIZE){
+            emCons->queueOverflow++;
+            return;
+        }
+        frame = &emCons->queue[head & (CO_EM_CONS_RX_QUEUE_SIZE - 1U)];
+        frame->nodeId = nodeId;
+        CO_memcpy(frame->data, msg->data, 8U);
+        CANrxMemoryBarrier();
+        emCons->queueHead = (uint16_t)(head + 1U);
+
+        /* Wake up mainline only, if it has processed all previous messages.
+         * During emergency storm mainline is busy and is not signalled. */
+        CANrxMemoryBarrier();
+        if(emCons->queueTail == head && emCons->pFunctSignalWakeup != NULL){
+            emCons->pFunctSignalWakeup();
+        }
+        return;
+    }
+#endif
+
     if(em!=NULL && em->pFunctSignalRx!=NULL){
         CO_memcpySwap2(&errorCode, &msg->data[0]);
         CO_memcpySwap4(&infoCode, &msg->data[4]);
@@ -80,6 +282,9 @@ static CO_SDO_abortCode_t CO_ODF_1003(CO_ODF_arg_t *ODF_arg){
             ret = CO_SDO_AB_NO_DATA;
         }
         else{
+            /* translate sub-index to position in ring */
+            uint32_t preDEF = CO_EM_getPreDefErr(emPr, ODF_arg->subIndex);
+            CO_memcpy(ODF_arg->data, (const uint8_t*)&preDEF, 4U);
             ret = CO_SDO_AB_NONE;
         }
     }
@@ -141,7 +346,7 @@ CO_ReturnError_t CO_EM_init(
         uint16_t                CANdevTxIdx,
         uint16_t                CANidTxEM)
 {
-    uint8_t i;
+    uint16_t i;
 
     /* verify arguments */
     if(em==NULL || emPr==NULL || SDO==NULL || errorStatusBits==NULL || errorStatusBitsSize<6U ||
@@ -152,19 +357,31 @@ CO_ReturnError_t CO_EM_init(
     /* Configure object variables */
     em->errorStatusBits         = errorStatusBits;
     em->errorStatusBitsSize     = errorStatusBitsSize;
-    em->bufEnd                  = em->buf + (CO_EM_INTERNAL_BUFFER_SIZE * 8);
-    em->bufWritePtr             = em->buf;
-    em->bufReadPtr              = em->buf;
-    em->bufFull                 = 0U;
+    for(i=0U; i<CO_EM_INTERNAL_BUFFER_SIZE; i++){
+        em->buf[i].seq          = i;
+    }
+    em->bufWriteCnt             = 0U;
+    em->bufReadCnt              = 0U;
+    em->bufOverflowCnt          = 0U;
+    em->bufOverflowReported     = 0U;
     em->wrongErrorReport        = 0U;
+    em->errorCntGeneric         = 0U;
+    em->errorCntComm            = 0U;
+    em->errorCntManufacturer    = 0U;
+    em->verifyErrorsRequest     = 1U;
     em->pFunctSignal            = NULL;
     em->pFunctSignalRx          = NULL;
+#ifdef CO_EM_CONSUMER
+    em->emCons                  = NULL;
+#endif
     emPr->em                    = em;
     emPr->errorRegister         = errorRegister;
     emPr->preDefErr             = preDefErr;
-    emPr->preDefErrSize         = preDefErrSize;
+    emPr->preDefErrSize         = (preDefErrSize > 254U) ? 254U : preDefErrSize;
     emPr->preDefErrNoOfErrors   = 0U;
+    emPr->preDefErrHead         = 0U;
     emPr->inhibitEmTimer        = 0U;
+    emPr->verifyErrorsTimer     = 0U;
 
     /* clear error status bits */
     for(i=0U; i<errorStatusBitsSize; i++){
@@ -200,6 +417,24 @@ CO_ReturnError_t CO_EM_init(
 }
 
 
+/******************************************************************************/
+uint32_t CO_EM_getPreDefErr(const CO_EMpr_t *emPr, uint8_t subIndex){
+    uint8_t pos;
+
+    if(emPr == NULL || emPr->preDefErr == NULL ||
+       subIndex == 0U || subIndex > emPr->preDefErrNoOfErrors){
+        return 0U;
+    }
+
+    /* sub-index 1 is at head, older errors are before it */
+    pos = subIndex - 1U;
+    pos = (pos <= emPr->preDefErrHead) ?
+          (uint8_t)(emPr->preDefErrHead - pos) :
+          (uint8_t)(emPr->preDefErrSize - (pos - emPr->preDefErrHead));
+    return emPr->preDefErr[pos];
+}
+
+
 /******************************************************************************/
 void CO_EM_initCallback(
         CO_EM_t                *em,
@@ -238,32 +473,37 @@ void CO_EM_process(
     CO_EM_t *em = emPr->em;
     uint8_t errorRegister;
     uint8_t errorMask;
-    uint8_t i;
+    uint8_t *bufData;
 
-    /* verify errors from driver and other */
-    CO_CANverifyErrors(emPr->CANdev);
+    /* verify errors from driver, on request or when interval elapsed */
+    if(emPr->verifyErrorsTimer < CO_EM_VERIFY_ERRORS_INTERVAL){
+        emPr->verifyErrorsTimer += timeDifference_100us;
+    }
+    if(em->verifyErrorsRequest != 0U || emPr->verifyErrorsTimer >= CO_EM_VERIFY_ERRORS_INTERVAL){
+        em->verifyErrorsRequest = 0U;
+        emPr->verifyErrorsTimer = 0U;
+        CO_CANverifyErrors(emPr->CANdev);
+    }
     if(em->wrongErrorReport != 0U){
         CO_errorReport(em, CO_EM_WRONG_ERROR_REPORT, CO_EMC_SOFTWARE_INTERNAL, (uint32_t)em->wrongErrorReport);
         em->wrongErrorReport = 0U;
     }
 
 
-    /* calculate Error register */
+    /* calculate Error register from counters of active errors */
     errorRegister = 0U;
     errorMask = (uint8_t)~(CO_ERR_REG_GENERIC_ERR | CO_ERR_REG_COMM_ERR | CO_ERR_REG_MANUFACTURER);
     /* generic error */
-    if(em->errorStatusBits[5]){
+    if(em->errorCntGeneric != 0U){
         errorRegister |= CO_ERR_REG_GENERIC_ERR;
     }
     /* communication error (overrun, error state) */
-    if(em->errorStatusBits[2] || em->errorStatusBits[3]){
+    if(em->errorCntComm != 0U){
         errorRegister |= CO_ERR_REG_COMM_ERR;
     }
     /* Manufacturer */
-    for(i=6; i<em->errorStatusBitsSize; i++) {
-        if (em->errorStatusBits[i]) {
-            errorRegister |= CO_ERR_REG_MANUFACTURER;
-        }
+    if(em->errorCntManufacturer != 0U){
+        errorRegister |= CO_ERR_REG_MANUFACTURER;
     }
     *emPr->errorRegister = (*emPr->errorRegister & errorMask) | errorRegister;
 
@@ -273,49 +513,48 @@ void CO_EM_process(
     }
 
     /* send Emergency message. */
+    bufData = CO_EM_bufPeek(em);
     if(     NMTisPreOrOperational &&
             !emPr->CANtxBuff->bufferFull &&
-            (em->bufReadPtr != em->bufWritePtr || em->bufFull))
+            bufData != NULL)
     {
         uint32_t preDEF;    /* preDefinedErrorField */
         uint16_t diff;
 
         if (emPr->inhibitEmTimer >= emInhTime) {
-            /* inhibit time elapsed, send message */
+            uint32_t overflowCnt;
 
-            /* add error register */
-            em->bufReadPtr[2] = *emPr->errorRegister;
+            /* inhibit time elapsed, send message */
 
-            /* copy data to CAN emergency message */
-            CO_memcpy(emPr->CANtxBuff->data, em->bufReadPtr, 8U);
-            CO_memcpy((uint8_t*)&preDEF, em->bufReadPtr, 4U);
-            em->bufReadPtr += 8;
+            /* copy data to CAN emergency message and add error register */
+            CO_memcpy(emPr->CANtxBuff->data, bufData, 8U);
+            emPr->CANtxBuff->data[2] = *emPr->errorRegister;
+            CO_memcpy((uint8_t*)&preDEF, emPr->CANtxBuff->data, 4U);
 
-            /* Update read buffer pointer and reset inhibit timer */
-            if(em->bufReadPtr == em->bufEnd){
-                em->bufReadPtr = em->buf;
-            }
+            /* Release buffer slot and reset inhibit timer */
+            CO_EM_bufRelease(em);
             emPr->inhibitEmTimer = 0U;
 
-            /* verify message buffer overflow, then clear full flag */
-            if(em->bufFull == 2U){
-                em->bufFull = 0U;    /* will be updated below */
-                CO_errorReport(em, CO_EM_EMERGENCY_BUFFER_FULL, CO_EMC_GENERIC, 0U);
+            /* verify, if messages were lost since last check */
+            overflowCnt = CO_EM_LOAD32(&em->bufOverflowCnt);
+            if(overflowCnt != em->bufOverflowReported){
+                em->bufOverflowReported = overflowCnt;
+                CO_errorReport(em, CO_EM_EMERGENCY_BUFFER_FULL, CO_EMC_GENERIC, overflowCnt);
             }
             else{
-                em->bufFull = 0;
                 CO_errorReset(em, CO_EM_EMERGENCY_BUFFER_FULL, 0);
             }
 
             /* write to 'pre-defined error field' (object dictionary, index 0x1003) */
-            if(emPr->preDefErr){
-                uint8_t j;
+            if(emPr->preDefErr && emPr->preDefErrSize > 0U){
+                uint8_t head = emPr->preDefErrHead + 1U;
 
+                if(head >= emPr->preDefErrSize)
+                    head = 0U;
+                emPr->preDefErr[head] = preDEF;
+                emPr->preDefErrHead = head;
                 if(emPr->preDefErrNoOfErrors < emPr->preDefErrSize)
                     emPr->preDefErrNoOfErrors++;
-                for(j=emPr->preDefErrNoOfErrors-1; j>0; j--)
-                    emPr->preDefErr[j] = emPr->preDefErr[j-1];
-                emPr->preDefErr[0] = preDEF;
             }
 
             /* send CAN message */
@@ -337,7 +576,6 @@ void CO_EM_process(
 void CO_errorReport(CO_EM_t *em, const uint8_t errorBit, const uint16_t errorCode, const uint32_t infoCode){
     uint8_t index = errorBit >> 3;
     uint8_t bitmask = 1 << (errorBit & 0x7);
-    uint8_t *errorStatusBits = 0;
     bool_t sendEmergency = true;
 
     if(em == NULL){
@@ -348,47 +586,39 @@ void CO_errorReport(CO_EM_t *em, const uint8_t errorBit, const uint16_t errorCod
         em->wrongErrorReport = errorBit;
         sendEmergency = false;
     }
-    else{
-        errorStatusBits = &em->errorStatusBits[index];
-        /* if error was already reported, do nothing */
-        if((*errorStatusBits & bitmask) != 0){
-            sendEmergency = false;
-        }
-    }
-
-    if(sendEmergency){
-        /* set error bit */
-        if(errorBit){
-            /* any error except NO_ERROR */
-            *errorStatusBits |= bitmask;
-        }
+    else if(errorBit){
+        /* set error bit (any error except NO_ERROR). If error was already
+         * reported, do nothing. */
+        uint8_t old = CO_EM_FETCH_OR8(&em->errorStatusBits[index], bitmask);
 
-        /* verify buffer full, set overflow */
-        if(em->bufFull){
-            em->bufFull = 2;
+        if((old & bitmask) != 0){
+            sendEmergency = false;
         }
         else{
-            uint8_t bufCopy[8];
+            volatile uint32_t *cnt = CO_EM_errorCnt(em, index);
 
-            /* prepare data for emergency message */
-            CO_memcpySwap2(&bufCopy[0], &errorCode);
-            bufCopy[2] = 0; /* error register will be set later */
-            bufCopy[3] = errorBit;
-            CO_memcpySwap4(&bufCopy[4], &infoCode);
+            if(cnt != NULL){
+                CO_EM_INC32(cnt);
+            }
+        }
+    }
+    else if((em->errorStatusBits[index] & bitmask) != 0){
+        sendEmergency = false;
+    }
 
-            /* copy data to the buffer, increment writePtr and verify buffer full */
-            CO_LOCK_EMCY();
-            CO_memcpy(em->bufWritePtr, &bufCopy[0], 8);
-            em->bufWritePtr += 8;
+    if(sendEmergency){
+        uint8_t bufCopy[8];
 
-            if(em->bufWritePtr == em->bufEnd) em->bufWritePtr = em->buf;
-            if(em->bufWritePtr == em->bufReadPtr) em->bufFull = 1;
-            CO_UNLOCK_EMCY();
+        /* prepare data for emergency message */
+        CO_memcpySwap2(&bufCopy[0], &errorCode);
+        bufCopy[2] = 0; /* error register will be set later */
+        bufCopy[3] = errorBit;
+        CO_memcpySwap4(&bufCopy[4], &infoCode);
 
+        /* copy data to the buffer, overflow is counted, if it is full */
+        if(CO_EM_bufPush(em, bufCopy) && em->pFunctSignal != NULL) {
             /* Optional signal to RTOS, which can resume task, which handles CO_EM_process */
-            if(em->pFunctSignal != NULL) {
-                em->pFunctSignal();
-            }
+            em->pFunctSignal();
         }
     }
 }
@@ -398,7 +628,6 @@ void CO_errorReport(CO_EM_t *em, const uint8_t errorBit, const uint16_t errorCod
 void CO_errorReset(CO_EM_t *em, const uint8_t errorBit, const uint32_t infoCode){
     uint8_t index = errorBit >> 3;
     uint8_t bitmask = 1 << (errorBit & 0x7);
-    uint8_t *errorStatusBits = 0;
     bool_t sendEmergency = true;
 
     if(em == NULL){
@@ -410,49 +639,48 @@ void CO_errorReset(CO_EM_t *em, const uint8_t errorBit, const uint32_t infoCode)
         sendEmergency = false;
     }
     else{
-        errorStatusBits = &em->errorStatusBits[index];
-        /* if error was allready cleared, do nothing */
-        if((*errorStatusBits & bitmask) == 0){
-            sendEmergency = false;
-        }
-    }
-
-    if(sendEmergency){
-        /* erase error bit */
-        *errorStatusBits &= ~bitmask;
+        /* erase error bit. If error was allready cleared, do nothing */
+        uint8_t old = CO_EM_FETCH_AND8(&em->errorStatusBits[index], (uint8_t)~bitmask);
 
-        /* verify buffer full */
-        if(em->bufFull){
-            em->bufFull = 2;
+        if((old & bitmask) == 0){
+            sendEmergency = false;
         }
         else{
-            uint8_t bufCopy[8];
+            volatile uint32_t *cnt = CO_EM_errorCnt(em, index);
 
-            /* prepare data for emergency message */
-            bufCopy[0] = 0;
-            bufCopy[1] = 0;
-            bufCopy[2] = 0; /* error register will be set later */
-            bufCopy[3] = errorBit;
-            CO_memcpySwap4(&bufCopy[4], &infoCode);
+            if(cnt != NULL){
+                CO_EM_DEC32(cnt);
+            }
+        }
+    }
 
-            /* copy data to the buffer, increment writePtr and verify buffer full */
-            CO_LOCK_EMCY();
-            CO_memcpy(em->bufWritePtr, &bufCopy[0], 8);
-            em->bufWritePtr += 8;
+    if(sendEmergency){
+        uint8_t bufCopy[8];
 
-            if(em->bufWritePtr == em->bufEnd) em->bufWritePtr = em->buf;
-            if(em->bufWritePtr == em->bufReadPtr) em->bufFull = 1;
-            CO_UNLOCK_EMCY();
+        /* prepare data for emergency message */
+        bufCopy[0] = 0;
+        bufCopy[1] = 0;
+        bufCopy[2] = 0; /* error register will be set later */
+        bufCopy[3] = errorBit;
+        CO_memcpySwap4(&bufCopy[4], &infoCode);
 
+        /* copy data to the buffer, overflow is counted, if it is full */
+        if(CO_EM_bufPush(em, bufCopy) && em->pFunctSignal != NULL) {
             /* Optional signal to RTOS, which can resume task, which handles CO_EM_process */
-            if(em->pFunctSignal != NULL) {
-                em->pFunctSignal();
-            }
+            em->pFunctSignal();
         }
     }
 }
 
 
+/******************************************************************************/
+void CO_EM_requestVerifyErrors(CO_EM_t *em){
+    if(em != NULL){
+        em->verifyErrorsRequest = 1U;
+    }
+}
+
+
 /******************************************************************************/
 bool_t CO_isError(CO_EM_t *em, const uint8_t errorBit){
     uint8_t index = errorBit >> 3;
@@ -467,3 +695,239 @@ bool_t CO_isError(CO_EM_t *em, const uint8_t errorBit){
 
     return ret;
 }
+
+
+#ifdef CO_EM_CONSUMER
+/******************************************************************************/
+CO_ReturnError_t CO_EMcons_init(CO_EMcons_t *emCons, CO_EM_t *em){
+    uint8_t i;
+
+    /* verify arguments */
+    if(emCons==NULL || em==NULL){
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    /* disconnect from receive function during initialization */
+    em->emCons = NULL;
+
+    emCons->queueHead = 0U;
+    emCons->queueTail = 0U;
+    emCons->queueOverflow = 0U;
+    emCons->now_ms = 0U;
+    emCons->interval_ms = CO_EM_CONS_DEFAULT_INTERVAL;
+    emCons->errorNodesCount = 0U;
+    for(i=0U; i<CO_EM_CONS_NODE_ID_COUNT / 32U; i++){
+        emCons->errorNodes[i] = 0U;
+        emCons->pendingNodes[i] = 0U;
+    }
+    for(i=0U; i<CO_EM_CONS_NODE_ID_COUNT; i++){
+        emCons->nodes[i].historyHead = 0U;
+        emCons->nodes[i].historyCount = 0U;
+        emCons->nodes[i].skipped = 0U;
+        emCons->nodes[i].lastDelivery_ms = emCons->now_ms - 0xFFFFU;
+    }
+    emCons->pFunctSignal = NULL;
+    emCons->functSignalObject = NULL;
+    emCons->pFunctSignalWakeup = NULL;
+
+    CANrxMemoryBarrier();
+    em->emCons = emCons;
+
+    return CO_ERROR_NO;
+}
+
+
+/******************************************************************************/
+void CO_EMcons_initCallback(
+        CO_EMcons_t            *emCons,
+        void                   *object,
+        void                  (*pFunctSignal)(void *object, uint8_t nodeId, const CO_EMconsEntry_t *entry, uint16_t skipped))
+{
+    if(emCons != NULL){
+        emCons->functSignalObject = object;
+        emCons->pFunctSignal = pFunctSignal;
+    }
+}
+
+
+/******************************************************************************/
+void CO_EMcons_initCallbackWakeup(
+        CO_EMcons_t            *emCons,
+        void                  (*pFunctSignal)(void))
+{
+    if(emCons != NULL){
+        emCons->pFunctSignalWakeup = pFunctSignal;
+    }
+}
+
+
+/******************************************************************************/
+void CO_EMcons_setInterval(CO_EMcons_t *emCons, uint16_t interval_ms){
+    if(emCons != NULL){
+        emCons->interval_ms = interval_ms;
+    }
+}
+
+
+/* Set or clear bit of the node in errorNodes bitmap */
+static void CO_EMcons_setErrorBit(CO_EMcons_t *emCons, uint8_t nodeId, bool_t error){
+    uint32_t *word = &emCons->errorNodes[nodeId >> 5];
+    uint32_t bit = 1UL << (nodeId & 0x1FU);
+
+    if(error && (*word & bit) == 0U){
+        *word |= bit;
+        emCons->errorNodesCount++;
+    }
+    else if(!error && (*word & bit) != 0U){
+        *word &= ~bit;
+        emCons->errorNodesCount--;
+    }
+}
+
+
+/* Call callback with the newest message of the node */
+static void CO_EMcons_deliver(CO_EMcons_t *emCons, uint8_t nodeId){
+    CO_EMconsNode_t *node = &emCons->nodes[nodeId];
+
+    emCons->pendingNodes[nodeId >> 5] &= ~(1UL << (nodeId & 0x1FU));
+    node->lastDelivery_ms = emCons->now_ms;
+    if(emCons->pFunctSignal != NULL){
+        emCons->pFunctSignal(emCons->functSignalObject, nodeId,
+                             &node->history[node->historyHead], node->skipped);
+    }
+    node->skipped = 0U;
+}
+
+
+/* Store message from queue into history of the node */
+static void CO_EMcons_store(CO_EMcons_t *emCons, const CO_EMconsFrame_t *frame){
+    uint8_t nodeId = frame->nodeId;
+    CO_EMconsNode_t *node = &emCons->nodes[nodeId];
+    CO_EMconsEntry_t *entry;
+    uint32_t *pendingWord = &emCons->pendingNodes[nodeId >> 5];
+    uint32_t pendingBit = 1UL << (nodeId & 0x1FU);
+
+    if(node->historyCount > 0U){
+        node->historyHead = (uint8_t)((node->historyHead + 1U) % CO_EM_CONS_HISTORY);
+    }
+    if(node->historyCount < CO_EM_CONS_HISTORY){
+        node->historyCount++;
+    }
+    entry = &node->history[node->historyHead];
+    CO_memcpySwap2(&entry->errorCode, &frame->data[0]);
+    entry->errorRegister = frame->data[2];
+    entry->errorBit = frame->data[3];
+    CO_memcpySwap4(&entry->infoCode, &frame->data[4]);
+    entry->timestamp_ms = emCons->now_ms;
+
+    CO_EMcons_setErrorBit(emCons, nodeId, entry->errorRegister != 0U);
+
+    /* deliver now or coalesce with messages within interval */
+    if((*pendingWord & pendingBit) != 0U){
+        node->skipped++;
+    }
+    else if((uint32_t)(emCons->now_ms - node->lastDelivery_ms) >= emCons->interval_ms){
+        CO_EMcons_deliver(emCons, nodeId);
+    }
+    else{
+        *pendingWord |= pendingBit;
+    }
+}
+
+
+/******************************************************************************/
+void CO_EMcons_process(
+        CO_EMcons_t            *emCons,
+        uint16_t                timeDifference_ms,
+        uint16_t               *timerNext_ms)
+{
+    uint16_t tail = emCons->queueTail;
+    uint8_t w;
+
+    emCons->now_ms += timeDifference_ms;
+
+    /* empty the queue */
+    while(tail != emCons->queueHead){
+        CO_EMconsFrame_t frame;
+
+        CANrxMemoryBarrier();
+        frame = emCons->queue[tail & (CO_EM_CONS_RX_QUEUE_SIZE - 1U)];
+        CANrxMemoryBarrier();
+        tail++;
+        emCons->queueTail = tail;
+
+        CO_EMcons_store(emCons, &frame);
+    }
+
+    /* nodes with coalesced messages */
+    for(w=0U; w<CO_EM_CONS_NODE_ID_COUNT / 32U; w++){
+        uint32_t bits = emCons->pendingNodes[w];
+
+        while(bits != 0U){
+            uint8_t b = 0U;
+            uint8_t nodeId;
+            uint32_t elapsed;
+
+            while((bits & (1UL << b)) == 0U){
+                b++;
+            }
+            bits &= ~(1UL << b);
+            nodeId = (uint8_t)(w * 32U + b);
+
+            elapsed = emCons->now_ms - emCons->nodes[nodeId].lastDelivery_ms;
+            if(elapsed >= emCons->interval_ms){
+                CO_EMcons_deliver(emCons, nodeId);
+            }
+            else if(timerNext_ms != NULL){
+                uint16_t diff = (uint16_t)(emCons->interval_ms - elapsed);
+                if(*timerNext_ms > diff){
+                    *timerNext_ms = diff;
+                }
+            }
+        }
+    }
+}
+
+
+/******************************************************************************/
+uint8_t CO_EMcons_getErrorRegister(const CO_EMcons_t *emCons, uint8_t nodeId){
+    const CO_EMconsNode_t *node;
+
+    if(emCons == NULL || nodeId >= CO_EM_CONS_NODE_ID_COUNT){
+        return 0U;
+    }
+    node = &emCons->nodes[nodeId];
+    return (node->historyCount > 0U) ? node->history[node->historyHead].errorRegister : 0U;
+}
+
+
+/******************************************************************************/
+const CO_EMconsEntry_t *CO_EMcons_getHistory(const CO_EMcons_t *emCons, uint8_t nodeId, uint8_t n){
+    const CO_EMconsNode_t *node;
+
+    if(emCons == NULL || nodeId >= CO_EM_CONS_NODE_ID_COUNT){
+        return NULL;
+    }
+    node = &emCons->nodes[nodeId];
+    if(n >= node->historyCount){
+        return NULL;
+    }
+    return &node->history[(node->historyHead + CO_EM_CONS_HISTORY - n) % CO_EM_CONS_HISTORY];
+}
+
+
+/******************************************************************************/
+void CO_EMcons_clearNode(CO_EMcons_t *emCons, uint8_t nodeId){
+    CO_EMconsNode_t *node;
+
+    if(emCons == NULL || nodeId >= CO_EM_CONS_NODE_ID_COUNT){
+        return;
+    }
+    node = &emCons->nodes[nodeId];
+    node->historyHead = 0U;
+    node->historyCount = 0U;
+    node->skipped = 0U;
+    emCons->pendingNodes[nodeId >> 5] &= ~(1UL << (nodeId & 0x1FU));
+    CO_EMcons_setErrorBit(emCons, nodeId, false);
+}
+#endif /* CO_EM_CONSUMER */
@@ -68,6 +68,23 @@ extern "C" {
  * ####Contents of _Pre Defined Error Field_ (object dictionary, index 0x1003):
  * bytes 0..3 are equal to bytes 0..3 in the Emergency message.
  *
+ * Array from Object Dictionary is used as a ring buffer, so adding new error
+ * takes constant time also for long history (up to 254 entries). Sub-index 1
+ * (the newest error) is not necessary the first array element, use
+ * CO_EM_getPreDefErr() to read it from the application. SDO server translates
+ * sub-indexes with the function registered for 0x1003 by CO_EM_init().
+ *
+ * ###Emergency consumer
+ * Emergency messages from other nodes are passed to callback from
+ * CO_EM_initCallbackRx() inside CAN receive function. If CO_EM_CONSUMER is
+ * defined (for example in CO_driver_target.h), CO_EMcons_t may be used
+ * instead. Receive function then only puts message into queue. Messages are
+ * processed by CO_EMcons_process() in mainline: they are stored into history
+ * of each node and delivered to the application with rate limit for each node.
+ * Messages from one node, which come faster, are coalesced, so application gets
+ * the newest one and number of skipped messages. Error register of each node
+ * and bitmap of nodes with errors can be read in O(1).
+ *
  * @see #CO_Default_CAN_ID_t
  */
 
@@ -78,9 +95,11 @@ extern "C" {
  * In object dictionary on index 0x1001.
  *
  * Error register is calculated from critical internal @ref CO_EM_errorStatusBits.
- * Generic and communication bits are calculated in CO_EM_process
- * function, device profile or manufacturer specific bits may be calculated
- * inside the application.
+ * Generic, communication and manufacturer bits are calculated in CO_EM_process
+ * function, device profile specific bits may be calculated inside the
+ * application. CO_errorReport() and CO_errorReset() count active errors for
+ * each of these bits, so calculation does not depend on the size of
+ * @ref CO_EM_errorStatusBits.
  *
  * Internal errors may prevent device to stay in NMT Operational state. Details
  * are described in _Error Behavior_ object in Object Dictionary at index 0x1029.
@@ -212,8 +231,8 @@ typedef enum{
 #define CO_EM_PDO_WRONG_MAPPING         0x1AU /**< 0x1A, communication, critical, Error with PDO mapping */
 #define CO_EM_HEARTBEAT_CONSUMER        0x1BU /**< 0x1B, communication, critical, Heartbeat consumer timeout */
 #define CO_EM_HB_CONSUMER_REMOTE_RESET  0x1CU /**< 0x1C, communication, critical, Heartbeat consumer detected remote node reset */
-#define CO_EM_1D_unused                 0x1DU /**< 0x1D, (unused) */
-#define CO_EM_1E_unused                 0x1EU /**< 0x1E, (unused) */
+#define CO_EM_LIFE_GUARDING             0x1DU /**< 0x1D, communication, critical, Life guarding timeout (no node guarding request) */
+#define CO_EM_NODE_GUARDING             0x1EU /**< 0x1E, communication, critical, Node guarding master lost guarded node */
 #define CO_EM_1F_unused                 0x1FU /**< 0x1F, (unused) */
 
 #define CO_EM_EMERGENCY_BUFFER_FULL     0x20U /**< 0x20, generic, info, Emergency buffer is full, Emergency message wasn't sent */
@@ -240,28 +259,153 @@ typedef enum{
 
 
 /**
- * Size of internal buffer, whwre emergencies are stored after CO_errorReport().
- * Buffer is cleared by CO_EM_process().
+ * Size of internal buffer, where emergencies are stored after CO_errorReport().
+ * Buffer is cleared by CO_EM_process(). Must be power of two.
+ */
+#ifndef CO_EM_INTERNAL_BUFFER_SIZE
+#define CO_EM_INTERNAL_BUFFER_SIZE      16
+#endif
+
+
+/**
+ * Interval in [100 * microseconds], in which CO_EM_process() calls
+ * CO_CANverifyErrors(). Driver may request earlier verification with
+ * CO_EM_requestVerifyErrors(). Set to 0 to verify on each call.
  */
-#define CO_EM_INTERNAL_BUFFER_SIZE      10
+#ifndef CO_EM_VERIFY_ERRORS_INTERVAL
+#define CO_EM_VERIFY_ERRORS_INTERVAL    100U
+#endif
+
+
+/**
+ * One emergency message in internal buffer.
+ */
+typedef struct{
+    /** Sequence number of the slot. Slot is free for writer, if it equals
+     * writer position, and contains message, if it equals reader position + 1. */
+    volatile uint32_t   seq;
+    uint8_t             data[8];            /**< Data of emergency message */
+}CO_EM_bufSlot_t;
+
+
+#if defined(CO_EM_CONSUMER) || defined(CO_DOXYGEN)
+/** Number of node-IDs in CO_EMcons_t, node-ID 0 is not used */
+#define CO_EM_CONS_NODE_ID_COUNT        128U
+
+/** Number of received emergency messages in history of each node */
+#ifndef CO_EM_CONS_HISTORY
+#define CO_EM_CONS_HISTORY              4U
+#endif
+
+/**
+ * Size of queue between CAN receive function and CO_EMcons_process(). Must be
+ * power of two.
+ */
+#ifndef CO_EM_CONS_RX_QUEUE_SIZE
+#define CO_EM_CONS_RX_QUEUE_SIZE        32U
+#endif
+
+/** Default minimum time between two callbacks for the same node in [ms] */
+#ifndef CO_EM_CONS_DEFAULT_INTERVAL
+#define CO_EM_CONS_DEFAULT_INTERVAL     100U
+#endif
+
+
+/**
+ * One received emergency message.
+ */
+typedef struct{
+    uint32_t            infoCode;       /**< Bytes 4..7 of emergency message */
+    uint32_t            timestamp_ms;   /**< Time of processing, see _now_ms_ in CO_EMcons_t */
+    uint16_t            errorCode;      /**< @ref CO_EM_errorCodes, 0 for error reset */
+    uint8_t             errorRegister;  /**< #CO_errorRegisterBitmask_t of the remote node */
+    uint8_t             errorBit;       /**< Byte 3, @ref CO_EM_errorStatusBits for CANopenNode devices */
+}CO_EMconsEntry_t;
+
+
+/**
+ * Emergency history of one node inside CO_EMcons_t.
+ */
+typedef struct{
+    CO_EMconsEntry_t    history[CO_EM_CONS_HISTORY]; /**< Ring of the latest messages */
+    uint8_t             historyHead;    /**< Index of the newest message */
+    uint8_t             historyCount;   /**< Number of valid messages in history */
+    uint16_t            skipped;        /**< Messages received since last callback, which were not delivered */
+    uint32_t            lastDelivery_ms;/**< Time of the last callback */
+}CO_EMconsNode_t;
+
+
+/**
+ * Emergency message in queue of CO_EMcons_t.
+ */
+typedef struct{
+    uint8_t             nodeId;         /**< From CAN identifier */
+    uint8_t             data[8];        /**< Emergency message data */
+}CO_EMconsFrame_t;
+
+
+/**
+ * Emergency consumer object, see Emergency consumer in @ref CO_Emergency.
+ *
+ * Object is initialized by CO_EMcons_init(). Queue is single producer
+ * (CAN receive function), single consumer (CO_EMcons_process()).
+ */
+typedef struct{
+    CO_EMconsFrame_t    queue[CO_EM_CONS_RX_QUEUE_SIZE]; /**< Received messages */
+    volatile uint16_t   queueHead;      /**< Free running counter, changed by receive function */
+    volatile uint16_t   queueTail;      /**< Free running counter, changed by CO_EMcons_process() */
+    uint32_t            queueOverflow;  /**< Messages lost, because queue was full (informative) */
+    CO_EMconsNode_t     nodes[CO_EM_CONS_NODE_ID_COUNT]; /**< History, indexed by node-ID */
+    /** Bitmap by node-ID (bit n%32 of word n/32) of nodes with nonzero error
+     * register in the last emergency message. Can be read by the application. */
+    uint32_t            errorNodes[CO_EM_CONS_NODE_ID_COUNT / 32U];
+    uint8_t             errorNodesCount;/**< Number of bits set in errorNodes */
+    /** Bitmap by node-ID of nodes with message waiting for callback */
+    uint32_t            pendingNodes[CO_EM_CONS_NODE_ID_COUNT / 32U];
+    uint32_t            now_ms;         /**< Sum of timeDifference_ms */
+    uint16_t            interval_ms;    /**< See CO_EMcons_setInterval() */
+    /** From CO_EMcons_initCallback() or NULL */
+    void              (*pFunctSignal)(void *object, uint8_t nodeId, const CO_EMconsEntry_t *entry, uint16_t skipped);
+    void               *functSignalObject;/**< Pointer to object */
+    /** From CO_EMcons_initCallbackWakeup() or NULL */
+    void              (*pFunctSignalWakeup)(void);
+}CO_EMcons_t;
+#endif
 
 
 /**
  * Emergerncy object for CO_errorReport(). It contains error buffer, to which new emergency
  * messages are written, when CO_errorReport() is called. This object is included in
  * CO_EMpr_t object.
+ *
+ * Buffer is lock-free queue with multiple producers (CO_errorReport() and
+ * CO_errorReset() from any thread) and single consumer (CO_EM_process()).
+ * Writer reserves a slot with compare-and-swap on bufWriteCnt, then writes
+ * data and publishes it with slot sequence number. Error status bits are also
+ * updated atomically. If target defines CO_USE_GCC_ATOMICS in
+ * CO_driver_target.h, GCC atomic builtins are used. Otherwise each atomic
+ * operation is a short CO_LOCK_EMCY() section.
  */
 typedef struct{
     uint8_t            *errorStatusBits;        /**< From CO_EM_init() */
     uint8_t             errorStatusBitsSize;    /**< From CO_EM_init() */
 
     /** Internal buffer for storing unsent emergency messages.*/
-    uint8_t             buf[CO_EM_INTERNAL_BUFFER_SIZE * 8];
-    uint8_t            *bufEnd;             /**< End+1 address of the above buffer */
-    uint8_t            *bufWritePtr;        /**< Write pointer in the above buffer */
-    uint8_t            *bufReadPtr;         /**< Read pointer in the above buffer */
-    uint8_t             bufFull;            /**< True if above buffer is full */
+    CO_EM_bufSlot_t     buf[CO_EM_INTERNAL_BUFFER_SIZE];
+    volatile uint32_t   bufWriteCnt;        /**< Number of reserved slots, free running, changed by producers */
+    uint32_t            bufReadCnt;         /**< Number of read slots, free running, changed by consumer */
+    /** Number of emergency messages, which were lost, because buffer was full
+     * (informative, never cleared). */
+    volatile uint32_t   bufOverflowCnt;
+    uint32_t            bufOverflowReported;/**< Value of bufOverflowCnt, when CO_EM_process() last checked it */
     uint8_t             wrongErrorReport;   /**< Error in arguments to CO_errorReport() */
+    /** Number of active errors, which set generic, communication and
+     * manufacturer bit in error register. Counter may be wrong for a moment,
+     * if the same error is reported and reset concurrently. */
+    volatile uint32_t   errorCntGeneric;
+    volatile uint32_t   errorCntComm;       /**< See errorCntGeneric */
+    volatile uint32_t   errorCntManufacturer;/**< See errorCntGeneric */
+    volatile uint8_t    verifyErrorsRequest;/**< Set by CO_EM_requestVerifyErrors() */
 
     /** From CO_EM_initCallback() or NULL */
     void              (*pFunctSignal)(void);
@@ -271,6 +415,9 @@ typedef struct{
                                         const uint8_t errorRegister,
                                         const uint8_t errorBit,
                                         const uint32_t infoCode);
+#if defined(CO_EM_CONSUMER) || defined(CO_DOXYGEN)
+    CO_EMcons_t        *emCons;             /**< From CO_EMcons_init() or NULL */
+#endif
 }CO_EM_t;
 
 
@@ -339,7 +486,9 @@ typedef struct{
     uint32_t           *preDefErr;      /**< From CO_EM_init() */
     uint8_t             preDefErrSize;  /**< From CO_EM_init() */
     uint8_t             preDefErrNoOfErrors;/**< Number of active errors in preDefErr */
+    uint8_t             preDefErrHead;  /**< Index of the newest error in preDefErr ring */
     uint16_t            inhibitEmTimer; /**< Internal timer for emergency message */
+    uint16_t            verifyErrorsTimer;/**< Internal timer for CO_CANverifyErrors(), in [100 * microseconds] */
     CO_EM_t            *em;             /**< CO_EM_t sub object is included here */
     CO_CANmodule_t     *CANdev;         /**< From CO_EM_init() */
     CO_CANtx_t         *CANtxBuff;      /**< CAN transmit buffer */
@@ -361,7 +510,7 @@ typedef struct{
  * @param errorRegister Pointer to _Error Register_ (Object dictionary, index 0x1001).
  * @param preDefErr Pointer to _Pre defined error field_ array from Object
  * dictionary, index 0x1003.
- * @param preDefErrSize Size of the above array.
+ * @param preDefErrSize Size of the above array, maximum 254.
  * @param CANdevRx CAN device for Emergency reception.
  * @param CANdevRxIdx Index of receive buffer in the above CAN device.
  * @param CANdevTx CAN device for Emergency transmission.
@@ -386,6 +535,18 @@ CO_ReturnError_t CO_EM_init(
         uint16_t                CANidTxEM);
 
 
+/**
+ * Get error from _Pre defined error field_.
+ *
+ * @param emPr Error control and Emergency object.
+ * @param subIndex Sub-index of object 0x1003, 1 is the newest error.
+ *
+ * @return Error (bytes 0..3 of the Emergency message) or 0, if there is no
+ * such error.
+ */
+uint32_t CO_EM_getPreDefErr(const CO_EMpr_t *emPr, uint8_t subIndex);
+
+
 /**
  * Initialize Emergency callback function.
  *
@@ -409,7 +570,8 @@ void CO_EM_initCallback(
  * which processes mainline CANopen functions.
  *
  * @remark Depending on the CAN driver implementation, this function is called
- * inside an ISR
+ * inside an ISR. It is not called, if emergency consumer is used, see
+ * CO_EMcons_init().
  *
  * @param em This object.
  * @param pFunctSignal Pointer to the callback function. Not called if NULL.
@@ -423,12 +585,24 @@ void CO_EM_initCallbackRx(
                                                 const uint32_t infoCode));
 
 
+/**
+ * Request verification of CAN errors.
+ *
+ * CO_CANverifyErrors() will be called on the next CO_EM_process(), without
+ * waiting for #CO_EM_VERIFY_ERRORS_INTERVAL. Function is short and may be
+ * called from CAN error interrupt.
+ *
+ * @param em Emergency object.
+ */
+void CO_EM_requestVerifyErrors(CO_EM_t *em);
+
+
 /**
  * Process Error control and Emergency object.
  *
  * Function must be called cyclically. It verifies some communication errors,
- * calculates bit 0 and bit 4 from _Error register_ and sends emergency message
- * if necessary.
+ * calculates bit 0, bit 4 and bit 7 from _Error register_ and sends emergency
+ * message if necessary.
  *
  * @param emPr This object.
  * @param NMTisPreOrOperational True if this node is NMT_PRE_OPERATIONAL or NMT_OPERATIONAL.
@@ -446,6 +620,116 @@ void CO_EM_process(
 
 #endif
 
+
+#if defined(CO_EM_CONSUMER) || defined(CO_DOXYGEN)
+/**
+ * Initialize Emergency consumer object.
+ *
+ * Function must be called in the communication reset section, after
+ * CO_EM_init(). Emergency messages from other nodes are then queued by CAN
+ * receive function and processed by CO_EMcons_process().
+ *
+ * @param emCons This object will be initialized.
+ * @param em Emergency object, which receives messages.
+ *
+ * @return #CO_ReturnError_t CO_ERROR_NO or CO_ERROR_ILLEGAL_ARGUMENT.
+ */
+CO_ReturnError_t CO_EMcons_init(CO_EMcons_t *emCons, CO_EM_t *em);
+
+
+/**
+ * Initialize Emergency consumer callback function.
+ *
+ * Callback is called from CO_EMcons_process() for received emergency message,
+ * but not more often than once per interval for the same node, see
+ * CO_EMcons_setInterval(). If more messages are received within interval,
+ * callback is called for the newest one after the interval.
+ *
+ * @param emCons This object.
+ * @param object Pointer to object, which will be passed to pFunctSignal(). Can be NULL
+ * @param pFunctSignal Pointer to the callback function. Not called if NULL.
+ * Arguments are node-ID, the newest message and number of messages from this
+ * node, which were skipped since the previous callback.
+ */
+void CO_EMcons_initCallback(
+        CO_EMcons_t            *emCons,
+        void                   *object,
+        void                  (*pFunctSignal)(void *object, uint8_t nodeId, const CO_EMconsEntry_t *entry, uint16_t skipped));
+
+
+/**
+ * Initialize Emergency consumer wakeup callback function.
+ *
+ * Function initializes optional callback function, which should immediately
+ * start processing of CO_EMcons_process() function. It is called from CAN
+ * receive function, only when message is put into empty queue.
+ *
+ * @param emCons This object.
+ * @param pFunctSignal Pointer to the callback function. Not called if NULL.
+ */
+void CO_EMcons_initCallbackWakeup(
+        CO_EMcons_t            *emCons,
+        void                  (*pFunctSignal)(void));
+
+
+/**
+ * Set minimum time between two callbacks for the same node.
+ *
+ * @param emCons This object.
+ * @param interval_ms Time in [ms], 0 delivers each message. Default is
+ * #CO_EM_CONS_DEFAULT_INTERVAL.
+ */
+void CO_EMcons_setInterval(CO_EMcons_t *emCons, uint16_t interval_ms);
+
+
+/**
+ * Process Emergency consumer object.
+ *
+ * Function must be called cyclically. It empties the queue and calls the
+ * callback for nodes, which are due.
+ *
+ * @param emCons This object.
+ * @param timeDifference_ms Time difference from previous function call in [milliseconds].
+ * @param timerNext_ms Return value - info to OS - see CO_process().
+ */
+void CO_EMcons_process(
+        CO_EMcons_t            *emCons,
+        uint16_t                timeDifference_ms,
+        uint16_t               *timerNext_ms);
+
+
+/**
+ * Get error register of the node from its last emergency message.
+ *
+ * @param emCons This object.
+ * @param nodeId Node-ID.
+ *
+ * @return #CO_errorRegisterBitmask_t, 0 if node has no active errors.
+ */
+uint8_t CO_EMcons_getErrorRegister(const CO_EMcons_t *emCons, uint8_t nodeId);
+
+
+/**
+ * Get emergency message from history of the node.
+ *
+ * @param emCons This object.
+ * @param nodeId Node-ID.
+ * @param n 0 for the newest message, 1 for previous, etc.
+ *
+ * @return Pointer to message or NULL, if there is no such message.
+ */
+const CO_EMconsEntry_t *CO_EMcons_getHistory(const CO_EMcons_t *emCons, uint8_t nodeId, uint8_t n);
+
+
+/**
+ * Clear history and error state of the node, for example after its bootup.
+ *
+ * @param emCons This object.
+ * @param nodeId Node-ID.
+ */
+void CO_EMcons_clearNode(CO_EMcons_t *emCons, uint8_t nodeId);
+#endif
+
 #ifdef __cplusplus
 }
 #endif /*__cplusplus*/
@@ -26,6 +26,63 @@
 #include "CANopen.h"
 #include "CO_HBconsumer.h"
 
+
+/* Clear inter-arrival statistics */
+static void CO_HBcons_statsClear(CO_HBconsStats_t *stats){
+    stats->count = 0U;
+    stats->late = 0U;
+    stats->intervalMin_us = 0U;
+    stats->intervalMax_us = 0U;
+    stats->intervalMean_us = 0U;
+    stats->intervalSum_us = 0U;
+}
+
+
+/*
+ * Update inter-arrival statistics with heartbeat or bootup message, received
+ * at rxTime_us. Called from receive function, if CO_CAN_RX_TIMESTAMP is
+ * defined, otherwise from CO_HBconsumer_process().
+ */
+static void CO_HBcons_statsUpdate(
+        CO_HBconsNode_t        *HBconsNode,
+        uint32_t                rxTime_us,
+        bool_t                  bootup)
+{
+    CO_HBconsStats_t *stats = &HBconsNode->stats;
+
+    HBconsNode->statsSeq++;
+    CANrxMemoryBarrier();
+
+    if(HBconsNode->statsResetAck != HBconsNode->statsResetReq){
+        HBconsNode->statsResetAck = HBconsNode->statsResetReq;
+        CO_HBcons_statsClear(stats);
+    }
+
+    if(!bootup && HBconsNode->rxTimeValid){
+        uint32_t interval = rxTime_us - HBconsNode->rxTime_us;
+
+        if(stats->count == 0U || interval < stats->intervalMin_us){
+            stats->intervalMin_us = interval;
+        }
+        if(interval > stats->intervalMax_us){
+            stats->intervalMax_us = interval;
+        }
+        stats->intervalSum_us += interval;
+        stats->count++;
+        if(interval > (uint32_t)HBconsNode->time * 1000U){
+            stats->late++;
+        }
+    }
+    /* bootup only restarts the measurement */
+    HBconsNode->rxTime_us = rxTime_us;
+    HBconsNode->rxTimeValid = true;
+
+    CANrxMemoryBarrier();
+    HBconsNode->statsSeq++;
+}
+
+
+#ifndef CO_HBCONSUMER_SCALABLE
 /*
  * Read received message from CAN module.
  *
@@ -40,12 +97,217 @@ static void CO_HBcons_receive(void *object, const CO_CANrxMsg_t *msg){
 
     /* verify message length */
     if(msg->DLC == 1){
+        CO_NMT_internalState_t NMTstate = (CO_NMT_internalState_t)msg->data[0];
+        bool_t changed = (NMTstate != HBconsNode->NMTstate) ||
+                         (HBconsNode->HBstate != CO_HBconsumer_ACTIVE);
+
+#ifdef CO_CAN_RX_TIMESTAMP
+        CO_HBcons_statsUpdate(HBconsNode, CO_CANrxMsg_readTimestamp(msg),
+                              NMTstate == CO_NMT_INITIALIZING);
+#endif
+
         /* copy data and set 'new message' flag. */
-        HBconsNode->NMTstate = (CO_NMT_internalState_t)msg->data[0];
+        HBconsNode->NMTstate = NMTstate;
         SET_CANrxNew(HBconsNode->CANrxNew);
+
+        /* Optional signal to RTOS, which can resume task, which handles
+         * HBconsumer. Unchanged heartbeats are not signalled. */
+        if(changed && HBconsNode->pFunctSignal != NULL) {
+            HBconsNode->pFunctSignal();
+        }
+    }
+}
+
+#else /* CO_HBCONSUMER_SCALABLE */
+/*
+ * Read received heartbeat of any node (CAN-ID 0x700 to 0x77F).
+ *
+ * Node is found by node-ID. Its index is queued for CO_HBconsumer_process(),
+ * if it is not already waiting there.
+ */
+static void CO_HBcons_receive(void *object, const CO_CANrxMsg_t *msg){
+    CO_HBconsumer_t *HBcons;
+    uint8_t idx;
+
+    HBcons = (CO_HBconsumer_t*) object; /* this is the correct pointer type of the first argument */
+    idx = HBcons->nodeIdx[CO_CANrxMsg_readIdent(msg) & 0x7FU];
+
+    /* verify message length */
+    if(idx != CO_HBCONS_NONE && msg->DLC == 1){
+        CO_HBconsNode_t *HBconsNode = &HBcons->monitoredNodes[idx];
+        CO_NMT_internalState_t NMTstate = (CO_NMT_internalState_t)msg->data[0];
+        bool_t changed = (NMTstate != HBconsNode->NMTstate) ||
+                         (HBconsNode->HBstate != CO_HBconsumer_ACTIVE);
+        bool_t queued;
+
+#ifdef CO_CAN_RX_TIMESTAMP
+        CO_HBcons_statsUpdate(HBconsNode, CO_CANrxMsg_readTimestamp(msg),
+                              NMTstate == CO_NMT_INITIALIZING);
+#endif
+
+#ifdef CO_USE_GCC_ATOMICS
+        /* copy data and set 'new message' flag. Node is queued only by the
+         * message, which changed the flag from 0 to 1. If process function
+         * cleared the flag in between, node is queued again. */
+        HBconsNode->NMTstate = NMTstate;
+        queued = __atomic_exchange_n(&HBconsNode->CANrxNew, (void*)1L,
+                                     __ATOMIC_ACQ_REL) != NULL;
+#else
+        /* Flag can't be set atomically. Message is dropped, if previous one
+         * was not processed yet, so queued node always has the flag set. */
+        queued = IS_CANrxNew(HBconsNode->CANrxNew) ? true : false;
+        if(!queued){
+            HBconsNode->NMTstate = NMTstate;
+            SET_CANrxNew(HBconsNode->CANrxNew);
+        }
+#endif
+
+        /* queue the node, if it is not waiting already */
+        if(!queued){
+            uint8_t head = HBcons->rxQueueHead;
+            if((uint8_t)(head - HBcons->rxQueueTail) < CO_HBCONS_NODE_ID_COUNT){
+                HBcons->rxQueue[head & (CO_HBCONS_NODE_ID_COUNT - 1U)] = idx;
+                CANrxMemoryBarrier();
+                HBcons->rxQueueHead = (uint8_t)(head + 1U);
+            }
+        }
+
+        /* Optional signal to RTOS, which can resume task, which handles
+         * HBconsumer. Unchanged heartbeats are not signalled. */
+        if(changed && HBconsNode->pFunctSignal != NULL) {
+            HBconsNode->pFunctSignal();
+        }
+    }
+}
+
+
+/* Take index of the node with received heartbeat from rxQueue. */
+static bool_t CO_HBcons_rxQueuePop(CO_HBconsumer_t *HBcons, uint8_t *idx){
+    uint8_t tail = HBcons->rxQueueTail;
+
+    if(tail == HBcons->rxQueueHead){
+        return false;
+    }
+    CANrxMemoryBarrier();
+    *idx = HBcons->rxQueue[tail & (CO_HBCONS_NODE_ID_COUNT - 1U)];
+    CANrxMemoryBarrier();
+    HBcons->rxQueueTail = (uint8_t)(tail + 1U);
+    return true;
+}
+
+
+/* Deadline heap. Deadlines are compared wrap-around safe. */
+static bool_t CO_HBcons_heapLess(CO_HBconsumer_t *HBcons, uint8_t a, uint8_t b){
+    return (int32_t)(HBcons->monitoredNodes[HBcons->heap[a]].deadline_ms -
+                     HBcons->monitoredNodes[HBcons->heap[b]].deadline_ms) < 0;
+}
+
+static void CO_HBcons_heapSwap(CO_HBconsumer_t *HBcons, uint8_t a, uint8_t b){
+    uint8_t idx = HBcons->heap[a];
+
+    HBcons->heap[a] = HBcons->heap[b];
+    HBcons->heap[b] = idx;
+    HBcons->monitoredNodes[HBcons->heap[a]].heapPos = a;
+    HBcons->monitoredNodes[HBcons->heap[b]].heapPos = b;
+}
+
+static void CO_HBcons_heapUp(CO_HBconsumer_t *HBcons, uint8_t pos){
+    while(pos > 0U){
+        uint8_t parent = (uint8_t)((pos - 1U) / 2U);
+        if(!CO_HBcons_heapLess(HBcons, pos, parent)){
+            break;
+        }
+        CO_HBcons_heapSwap(HBcons, pos, parent);
+        pos = parent;
     }
 }
 
+static void CO_HBcons_heapDown(CO_HBconsumer_t *HBcons, uint8_t pos){
+    for(;;){
+        uint16_t child = (uint16_t)pos * 2U + 1U;
+        uint8_t smallest = pos;
+
+        if(child < HBcons->heapSize && CO_HBcons_heapLess(HBcons, (uint8_t)child, smallest)){
+            smallest = (uint8_t)child;
+        }
+        child++;
+        if(child < HBcons->heapSize && CO_HBcons_heapLess(HBcons, (uint8_t)child, smallest)){
+            smallest = (uint8_t)child;
+        }
+        if(smallest == pos){
+            break;
+        }
+        CO_HBcons_heapSwap(HBcons, pos, smallest);
+        pos = smallest;
+    }
+}
+
+/* Insert node into heap or move it after its deadline_ms has changed. */
+static void CO_HBcons_heapUpdate(CO_HBconsumer_t *HBcons, uint8_t idx){
+    uint8_t pos = HBcons->monitoredNodes[idx].heapPos;
+
+    if(pos == CO_HBCONS_NONE){
+        pos = HBcons->heapSize++;
+        HBcons->heap[pos] = idx;
+        HBcons->monitoredNodes[idx].heapPos = pos;
+    }
+    CO_HBcons_heapUp(HBcons, pos);
+    CO_HBcons_heapDown(HBcons, HBcons->monitoredNodes[idx].heapPos);
+}
+
+static void CO_HBcons_heapRemove(CO_HBconsumer_t *HBcons, uint8_t idx){
+    uint8_t pos = HBcons->monitoredNodes[idx].heapPos;
+    uint8_t last;
+
+    if(pos == CO_HBCONS_NONE){
+        return;
+    }
+    HBcons->monitoredNodes[idx].heapPos = CO_HBCONS_NONE;
+    last = --HBcons->heapSize;
+    if(pos != last){
+        HBcons->heap[pos] = HBcons->heap[last];
+        HBcons->monitoredNodes[HBcons->heap[pos]].heapPos = pos;
+        CO_HBcons_heapUp(HBcons, pos);
+        CO_HBcons_heapDown(HBcons, HBcons->monitoredNodes[HBcons->heap[pos]].heapPos);
+    }
+}
+
+
+/* Set HBstate of the node and update timeoutCount. */
+static void CO_HBcons_setState(
+        CO_HBconsumer_t        *HBcons,
+        CO_HBconsNode_t        *monitoredNode,
+        CO_HBconsumer_state_t   HBstate)
+{
+    if(monitoredNode->HBstate == CO_HBconsumer_TIMEOUT){
+        HBcons->timeoutCount--;
+    }
+    if(HBstate == CO_HBconsumer_TIMEOUT){
+        HBcons->timeoutCount++;
+    }
+    monitoredNode->HBstate = HBstate;
+}
+
+
+/* Update activeNodes and operationalNodes bitmaps from state of the node. */
+static void CO_HBcons_updateBits(CO_HBconsumer_t *HBcons, const CO_HBconsNode_t *monitoredNode){
+    uint8_t w = monitoredNode->nodeId >> 5;
+    uint32_t bit = 1UL << (monitoredNode->nodeId & 0x1FU);
+    bool_t active = monitoredNode->HBstate == CO_HBconsumer_ACTIVE;
+    bool_t operational = monitoredNode->HBstate != CO_HBconsumer_UNCONFIGURED &&
+                         monitoredNode->NMTstate == CO_NMT_OPERATIONAL;
+
+    if(active != ((HBcons->activeNodes[w] & bit) != 0U)){
+        HBcons->activeNodes[w] ^= bit;
+        if(active) HBcons->activeCount++; else HBcons->activeCount--;
+    }
+    if(operational != ((HBcons->operationalNodes[w] & bit) != 0U)){
+        HBcons->operationalNodes[w] ^= bit;
+        if(operational) HBcons->operationalCount++; else HBcons->operationalCount--;
+    }
+}
+#endif /* CO_HBCONSUMER_SCALABLE */
+
 
 /*
  * Configure one monitored node.
@@ -62,11 +324,32 @@ static void CO_HBcons_monitoredNodeConfig(
     if(idx >= HBcons->numberOfMonitoredNodes) return;
 
     monitoredNode = &HBcons->monitoredNodes[idx];
+
+#ifdef CO_HBCONSUMER_SCALABLE
+    /* remove previous configuration of this entry */
+    if(monitoredNode->HBstate != CO_HBconsumer_UNCONFIGURED){
+        HBcons->nodeIdx[monitoredNode->nodeId] = CO_HBCONS_NONE;
+        HBcons->monitoredCount--;
+        CO_HBcons_heapRemove(HBcons, idx);
+        CO_HBcons_setState(HBcons, monitoredNode, CO_HBconsumer_UNCONFIGURED);
+        CO_HBcons_updateBits(HBcons, monitoredNode);
+    }
+    if(nodeId >= CO_HBCONS_NODE_ID_COUNT){
+        nodeId = 0;
+    }
+#endif
+
     monitoredNode->nodeId = nodeId;
     monitoredNode->time = time;
     monitoredNode->NMTstate = CO_NMT_INITIALIZING;
+    monitoredNode->NMTstatePrev = CO_NMT_INITIALIZING;
     monitoredNode->HBstate = CO_HBconsumer_UNCONFIGURED;
 
+    /* restart inter-arrival statistics */
+    CO_HBcons_statsClear(&monitoredNode->stats);
+    monitoredNode->rxTimeValid = false;
+    monitoredNode->statsResetAck = monitoredNode->statsResetReq;
+
     /* is channel used */
     if(monitoredNode->nodeId && monitoredNode->time){
         COB_ID = monitoredNode->nodeId + CO_CAN_ID_HEARTBEAT;
@@ -78,6 +361,14 @@ static void CO_HBcons_monitoredNodeConfig(
         monitoredNode->time = 0;
     }
 
+#ifdef CO_HBCONSUMER_SCALABLE
+    /* all heartbeats are received by one CAN buffer, see CO_HBconsumer_init() */
+    (void)COB_ID;
+    if (monitoredNode->HBstate != CO_HBconsumer_UNCONFIGURED) {
+        HBcons->monitoredCount++;
+        HBcons->nodeIdx[nodeId] = idx;
+    }
+#else
     /* configure Heartbeat consumer CAN reception */
     if (monitoredNode->HBstate != CO_HBconsumer_UNCONFIGURED) {
         CO_CANrxBufferInit(
@@ -89,6 +380,7 @@ static void CO_HBcons_monitoredNodeConfig(
                 (void*)&HBcons->monitoredNodes[idx],
                 CO_HBcons_receive);
     }
+#endif
 }
 
 
@@ -153,6 +445,48 @@ CO_ReturnError_t CO_HBconsumer_init(
     HBcons->allMonitoredOperational = 0;
     HBcons->CANdevRx = CANdevRx;
     HBcons->CANdevRxIdxStart = CANdevRxIdxStart;
+    HBcons->now_ms = 0;
+
+#ifdef CO_HBCONSUMER_SCALABLE
+    if(numberOfMonitoredNodes >= CO_HBCONS_NONE){
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+    for(i=0; i<CO_HBCONS_NODE_ID_COUNT; i++) {
+        HBcons->nodeIdx[i] = CO_HBCONS_NONE;
+    }
+    for(i=0; i<CO_HBCONS_NODE_ID_COUNT / 32U; i++) {
+        HBcons->activeNodes[i] = 0;
+        HBcons->operationalNodes[i] = 0;
+    }
+    HBcons->heapSize = 0;
+    HBcons->rxQueueHead = 0;
+    HBcons->rxQueueTail = 0;
+    HBcons->monitoredCount = 0;
+    HBcons->activeCount = 0;
+    HBcons->operationalCount = 0;
+    HBcons->timeoutCount = 0;
+    for(i=0; i<HBcons->numberOfMonitoredNodes; i++) {
+        monitoredNodes[i].nodeId = 0;
+        monitoredNodes[i].HBstate = CO_HBconsumer_UNCONFIGURED;
+        monitoredNodes[i].heapPos = CO_HBCONS_NONE;
+        CLEAR_CANrxNew(monitoredNodes[i].CANrxNew);
+    }
+
+    /* one receive buffer for heartbeats of all nodes */
+    CO_CANrxBufferInit(
+            CANdevRx,
+            CANdevRxIdxStart,
+            CO_CAN_ID_HEARTBEAT,
+            CO_HBCONS_SCALABLE_CAN_MASK,
+            0,
+            (void*)HBcons,
+            CO_HBcons_receive);
+#endif
+
+    for(i=0; i<HBcons->numberOfMonitoredNodes; i++) {
+        monitoredNodes[i].statsSeq = 0;
+        monitoredNodes[i].statsResetReq = 0;
+    }
 
     for(i=0; i<HBcons->numberOfMonitoredNodes; i++) {
         uint8_t nodeId = (HBcons->HBconsTime[i] >> 16U) & 0xFFU;
@@ -259,10 +593,64 @@ void CO_HBconsumer_initCallbackRemoteReset(
 }
 
 /******************************************************************************/
+void CO_HBconsumer_initCallbackNmtChanged(
+    CO_HBconsumer_t        *HBcons,
+    void                   *object,
+    void                  (*pFunctSignal)(uint8_t nodeId, uint8_t idx, CO_NMT_internalState_t NMTstate, void *object))
+{
+    if (HBcons==NULL) {
+        return;
+    }
+
+    HBcons->pFunctSignalNmtChanged = pFunctSignal;
+    HBcons->functSignalObjectNmtChanged = object;
+}
+
+/******************************************************************************/
+void CO_HBconsumer_initCallbackSignal(
+        CO_HBconsumer_t        *HBcons,
+        void                  (*pFunctSignal)(void))
+{
+    uint8_t i;
+
+    if (HBcons==NULL) {
+        return;
+    }
+
+    for(i=0; i<HBcons->numberOfMonitoredNodes; i++){
+        HBcons->monitoredNodes[i].pFunctSignal = pFunctSignal;
+    }
+}
+
+
+/*
+ * Call pFunctSignalNmtChanged, if NMT state of the node differs from reported
+ * one. Bootup is reported always.
+ */
+static void CO_HBcons_nmtChanged(
+        CO_HBconsumer_t        *HBcons,
+        CO_HBconsNode_t        *monitoredNode,
+        uint8_t                 idx,
+        CO_NMT_internalState_t  NMTstate,
+        bool_t                  bootup)
+{
+    if(NMTstate != monitoredNode->NMTstatePrev || bootup){
+        monitoredNode->NMTstatePrev = NMTstate;
+        if(HBcons->pFunctSignalNmtChanged != NULL){
+            HBcons->pFunctSignalNmtChanged(monitoredNode->nodeId, idx, NMTstate,
+                HBcons->functSignalObjectNmtChanged);
+        }
+    }
+}
+
+
+/******************************************************************************/
+#ifndef CO_HBCONSUMER_SCALABLE
 void CO_HBconsumer_process(
         CO_HBconsumer_t        *HBcons,
         bool_t                  NMTisPreOrOperational,
-        uint16_t                timeDifference_ms)
+        uint16_t                timeDifference_ms,
+        uint16_t               *timerNext_ms)
 {
     uint8_t i;
     uint8_t emcyHeartbeatTimeoutActive = 0;
@@ -272,18 +660,26 @@ void CO_HBconsumer_process(
 
     AllMonitoredOperationalCopy = 5;
     monitoredNode = &HBcons->monitoredNodes[0];
+    HBcons->now_ms += timeDifference_ms;
 
     if(NMTisPreOrOperational){
         for(i=0; i<HBcons->numberOfMonitoredNodes; i++){
             if(monitoredNode->time > 0){/* is node monitored */
+                uint16_t timeDifferenceNode = timeDifference_ms;
+
                 /* Verify if received message is heartbeat or bootup */
                 if(IS_CANrxNew(monitoredNode->CANrxNew)){
+#ifndef CO_CAN_RX_TIMESTAMP
+                    CO_HBcons_statsUpdate(monitoredNode, HBcons->now_ms * 1000U,
+                                          monitoredNode->NMTstate == CO_NMT_INITIALIZING);
+#endif
                     if(monitoredNode->NMTstate == CO_NMT_INITIALIZING){
                         /* bootup message, call callback */
                         if (monitoredNode->pFunctSignalRemoteReset != NULL) {
                             monitoredNode->pFunctSignalRemoteReset(monitoredNode->nodeId, i,
                                 monitoredNode->functSignalObjectRemoteReset);
                         }
+                        CO_HBcons_nmtChanged(HBcons, monitoredNode, i, CO_NMT_INITIALIZING, true);
                     }
                     else {
                         /* heartbeat message */
@@ -294,14 +690,15 @@ void CO_HBconsumer_process(
                         }
                         monitoredNode->HBstate = CO_HBconsumer_ACTIVE;
                         monitoredNode->timeoutTimer = 0;  /* reset timer */
-                        timeDifference_ms = 0;
+                        timeDifferenceNode = 0;
+                        CO_HBcons_nmtChanged(HBcons, monitoredNode, i, monitoredNode->NMTstate, false);
                     }
                     CLEAR_CANrxNew(monitoredNode->CANrxNew);
                 }
 
                 /* Verify timeout */
                 if(monitoredNode->timeoutTimer < monitoredNode->time) {
-                    monitoredNode->timeoutTimer += timeDifference_ms;
+                    monitoredNode->timeoutTimer += timeDifferenceNode;
                 }
                 if(monitoredNode->HBstate!=CO_HBconsumer_UNCONFIGURED &&
                    monitoredNode->HBstate!=CO_HBconsumer_UNKNOWN) {
@@ -317,6 +714,7 @@ void CO_HBconsumer_process(
                                 monitoredNode->functSignalObjectTimeout);
                         }
                         monitoredNode->HBstate = CO_HBconsumer_TIMEOUT;
+                        CO_HBcons_nmtChanged(HBcons, monitoredNode, i, CO_NMT_INITIALIZING, false);
                     }
                     else if(monitoredNode->NMTstate == CO_NMT_INITIALIZING){
                         /* there was a bootup message */
@@ -326,6 +724,16 @@ void CO_HBconsumer_process(
                         monitoredNode->HBstate = CO_HBconsumer_UNKNOWN;
                     }
                 }
+
+                /* Calculate, when heartbeat timeout expires and lower
+                 * timerNext_ms if necessary. */
+                if(monitoredNode->HBstate == CO_HBconsumer_ACTIVE && timerNext_ms != NULL){
+                    uint16_t diff = monitoredNode->time - monitoredNode->timeoutTimer;
+                    if(*timerNext_ms > diff){
+                        *timerNext_ms = diff;
+                    }
+                }
+
                 if(monitoredNode->NMTstate != CO_NMT_OPERATIONAL) {
                     AllMonitoredOperationalCopy = 0;
                 }
@@ -336,7 +744,11 @@ void CO_HBconsumer_process(
     else{ /* not in (pre)operational state */
         for(i=0; i<HBcons->numberOfMonitoredNodes; i++){
             monitoredNode->NMTstate = CO_NMT_INITIALIZING;
+            monitoredNode->NMTstatePrev = CO_NMT_INITIALIZING;
             CLEAR_CANrxNew(monitoredNode->CANrxNew);
+#ifndef CO_CAN_RX_TIMESTAMP
+            monitoredNode->rxTimeValid = false;
+#endif
             if(monitoredNode->HBstate != CO_HBconsumer_UNCONFIGURED){
                 monitoredNode->HBstate = CO_HBconsumer_UNKNOWN;
             }
@@ -356,6 +768,135 @@ void CO_HBconsumer_process(
     HBcons->allMonitoredOperational = AllMonitoredOperationalCopy;
 }
 
+#else /* CO_HBCONSUMER_SCALABLE */
+void CO_HBconsumer_process(
+        CO_HBconsumer_t        *HBcons,
+        bool_t                  NMTisPreOrOperational,
+        uint16_t                timeDifference_ms,
+        uint16_t               *timerNext_ms)
+{
+    uint8_t i;
+    uint8_t emcyRemoteResetActive = 0;
+    CO_HBconsNode_t *monitoredNode;
+
+    HBcons->now_ms += timeDifference_ms;
+
+    if(NMTisPreOrOperational){
+        /* Nodes with received heartbeat or bootup */
+        while(CO_HBcons_rxQueuePop(HBcons, &i)){
+            monitoredNode = &HBcons->monitoredNodes[i];
+            if(!IS_CANrxNew(monitoredNode->CANrxNew)){
+                continue;
+            }
+            /* Clear flag before NMTstate is read, so next message queues
+             * the node again. */
+            CLEAR_CANrxNew(monitoredNode->CANrxNew);
+            CANrxMemoryBarrier();
+            if(monitoredNode->HBstate == CO_HBconsumer_UNCONFIGURED){
+                continue;
+            }
+#ifndef CO_CAN_RX_TIMESTAMP
+            CO_HBcons_statsUpdate(monitoredNode, HBcons->now_ms * 1000U,
+                                  monitoredNode->NMTstate == CO_NMT_INITIALIZING);
+#endif
+
+            if(monitoredNode->NMTstate == CO_NMT_INITIALIZING){
+                /* bootup message, call callback */
+                if (monitoredNode->pFunctSignalRemoteReset != NULL) {
+                    monitoredNode->pFunctSignalRemoteReset(monitoredNode->nodeId, i,
+                        monitoredNode->functSignalObjectRemoteReset);
+                }
+                CO_HBcons_nmtChanged(HBcons, monitoredNode, i, CO_NMT_INITIALIZING, true);
+                if(monitoredNode->HBstate == CO_HBconsumer_ACTIVE){
+                    /* there was a bootup message */
+                    CO_errorReport(HBcons->em, CO_EM_HB_CONSUMER_REMOTE_RESET, CO_EMC_HEARTBEAT, i);
+                    emcyRemoteResetActive = 1;
+
+                    CO_HBcons_heapRemove(HBcons, i);
+                    CO_HBcons_setState(HBcons, monitoredNode, CO_HBconsumer_UNKNOWN);
+                }
+            }
+            else {
+                /* heartbeat message */
+                if (monitoredNode->HBstate!=CO_HBconsumer_ACTIVE &&
+                    monitoredNode->pFunctSignalHbStarted!=NULL) {
+                    monitoredNode->pFunctSignalHbStarted(monitoredNode->nodeId, i,
+                        monitoredNode->functSignalObjectHbStarted);
+                }
+                CO_HBcons_setState(HBcons, monitoredNode, CO_HBconsumer_ACTIVE);
+                monitoredNode->deadline_ms = HBcons->now_ms + monitoredNode->time;
+                CO_HBcons_heapUpdate(HBcons, i);
+                CO_HBcons_nmtChanged(HBcons, monitoredNode, i, monitoredNode->NMTstate, false);
+            }
+            CO_HBcons_updateBits(HBcons, monitoredNode);
+        }
+
+        /* Nodes with expired heartbeat time, earliest deadline first */
+        while(HBcons->heapSize > 0U){
+            i = HBcons->heap[0];
+            monitoredNode = &HBcons->monitoredNodes[i];
+            if((int32_t)(monitoredNode->deadline_ms - HBcons->now_ms) > 0){
+                break;
+            }
+
+            /* timeout expired */
+            CO_HBcons_heapRemove(HBcons, i);
+            CO_errorReport(HBcons->em, CO_EM_HEARTBEAT_CONSUMER, CO_EMC_HEARTBEAT, i);
+
+            monitoredNode->NMTstate = CO_NMT_INITIALIZING;
+            if (monitoredNode->HBstate!=CO_HBconsumer_TIMEOUT &&
+                monitoredNode->pFunctSignalTimeout!=NULL) {
+                monitoredNode->pFunctSignalTimeout(monitoredNode->nodeId, i,
+                    monitoredNode->functSignalObjectTimeout);
+            }
+            CO_HBcons_setState(HBcons, monitoredNode, CO_HBconsumer_TIMEOUT);
+            CO_HBcons_updateBits(HBcons, monitoredNode);
+            CO_HBcons_nmtChanged(HBcons, monitoredNode, i, CO_NMT_INITIALIZING, false);
+        }
+
+        /* Earliest heartbeat timeout of active nodes */
+        if(HBcons->heapSize > 0U && timerNext_ms != NULL){
+            uint32_t diff = HBcons->monitoredNodes[HBcons->heap[0]].deadline_ms - HBcons->now_ms;
+            if(*timerNext_ms > diff){
+                *timerNext_ms = (uint16_t)diff;
+            }
+        }
+
+        HBcons->allMonitoredOperational =
+            (HBcons->operationalCount == HBcons->monitoredCount) ? 5 : 0;
+    }
+    else{ /* not in (pre)operational state */
+        monitoredNode = &HBcons->monitoredNodes[0];
+        for(i=0; i<HBcons->numberOfMonitoredNodes; i++){
+            monitoredNode->NMTstate = CO_NMT_INITIALIZING;
+            monitoredNode->NMTstatePrev = CO_NMT_INITIALIZING;
+            CLEAR_CANrxNew(monitoredNode->CANrxNew);
+#ifndef CO_CAN_RX_TIMESTAMP
+            monitoredNode->rxTimeValid = false;
+#endif
+            monitoredNode->heapPos = CO_HBCONS_NONE;
+            if(monitoredNode->HBstate != CO_HBconsumer_UNCONFIGURED){
+                CO_HBcons_setState(HBcons, monitoredNode, CO_HBconsumer_UNKNOWN);
+                CO_HBcons_updateBits(HBcons, monitoredNode);
+            }
+            monitoredNode++;
+        }
+        HBcons->heapSize = 0;
+        HBcons->rxQueueTail = HBcons->rxQueueHead;
+        HBcons->allMonitoredOperational = 0;
+    }
+
+    /* clear emergencies. We only have one emergency index for all
+     * monitored nodes! */
+    if (HBcons->timeoutCount == 0U) {
+        CO_errorReset(HBcons->em, CO_EM_HEARTBEAT_CONSUMER, 0);
+    }
+    if ( ! emcyRemoteResetActive) {
+        CO_errorReset(HBcons->em, CO_EM_HB_CONSUMER_REMOTE_RESET, 0);
+    }
+}
+#endif /* CO_HBCONSUMER_SCALABLE */
+
 
 /******************************************************************************/
 int8_t CO_HBconsumer_getIdxByNodeId(
@@ -369,6 +910,13 @@ int8_t CO_HBconsumer_getIdxByNodeId(
         return -1;
     }
 
+#ifdef CO_HBCONSUMER_SCALABLE
+    /* configured nodes are found in the table */
+    if (nodeId < CO_HBCONS_NODE_ID_COUNT && HBcons->nodeIdx[nodeId] != CO_HBCONS_NONE) {
+        return (int8_t)HBcons->nodeIdx[nodeId];
+    }
+#endif
+
     /* linear search for the node */
     monitoredNode = &HBcons->monitoredNodes[0];
     for(i=0; i<HBcons->numberOfMonitoredNodes; i++){
@@ -418,3 +966,65 @@ int8_t CO_HBconsumer_getNmtState(
     }
     return -1;
 }
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_HBconsumer_getStats(
+        CO_HBconsumer_t        *HBcons,
+        uint8_t                 idx,
+        CO_HBconsStats_t       *stats,
+        bool_t                  reset)
+{
+    CO_HBconsNode_t *monitoredNode;
+    bool_t resetPending;
+    uint8_t seq;
+
+    if (HBcons==NULL || stats==NULL || idx>=HBcons->numberOfMonitoredNodes) {
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    monitoredNode = &HBcons->monitoredNodes[idx];
+
+    /* Copy consistent statistics, repeat, if they were written meanwhile. */
+    do {
+        seq = monitoredNode->statsSeq;
+        CANrxMemoryBarrier();
+        *stats = monitoredNode->stats;
+        resetPending = monitoredNode->statsResetReq != monitoredNode->statsResetAck;
+        CANrxMemoryBarrier();
+    } while ((seq & 1U) != 0U || seq != monitoredNode->statsSeq);
+
+    if (resetPending) {
+        /* cleared by the next update */
+        CO_HBcons_statsClear(stats);
+    }
+    else if (stats->count > 0U) {
+        stats->intervalMean_us = (uint32_t)(stats->intervalSum_us / stats->count);
+    }
+
+    if (reset) {
+        monitoredNode->statsResetReq++;
+    }
+    return CO_ERROR_NO;
+}
+
+
+#ifdef CO_HBCONSUMER_SCALABLE
+/******************************************************************************/
+bool_t CO_HBconsumer_isNodeActive(
+        const CO_HBconsumer_t  *HBcons,
+        uint8_t                 nodeId)
+{
+    if (HBcons==NULL || nodeId>=CO_HBCONS_NODE_ID_COUNT) {
+        return false;
+    }
+    return (HBcons->activeNodes[nodeId >> 5] & (1UL << (nodeId & 0x1FU))) != 0U;
+}
+
+
+/******************************************************************************/
+bool_t CO_HBconsumer_allActive(const CO_HBconsumer_t *HBcons)
+{
+    return HBcons != NULL && HBcons->activeCount == HBcons->monitoredCount;
+}
+#endif /* CO_HBCONSUMER_SCALABLE */
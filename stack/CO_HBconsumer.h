@@ -47,9 +47,42 @@ extern "C" {
  * Heartbeat set up is done by writing to the OD registers 0x1016 or by using
  * the function _CO_HBconsumer_initEntry()_
  *
+ * If CO_HBCONSUMER_SCALABLE is defined, consumer is optimized for large
+ * networks (up to 127 monitored nodes):
+ *  - All heartbeats (CAN-IDs 0x701 to 0x77F) are received by one masked CAN
+ *    receive buffer, so only one rxArray entry is used.
+ *  - Node is found by table indexed by node-ID, also in
+ *    CO_HBconsumer_getIdxByNodeId().
+ *  - Receive function queues index of the node only, if its heartbeat has to
+ *    be processed. Active nodes are kept in min-heap sorted by heartbeat
+ *    deadline. CO_HBconsumer_process() touches only nodes, which received
+ *    heartbeat or which reached their deadline.
+ *  - Bitmaps _activeNodes_ and _operationalNodes_ inside CO_HBconsumer_t
+ *    give the health of the whole network in O(1), see
+ *    CO_HBconsumer_isNodeActive().
+ *
+ * For each monitored node consumer measures time between consecutive
+ * heartbeats, see CO_HBconsumer_getStats(). Growing intervals are early
+ * warning of bus overload, long before heartbeat timeout occurs. If driver
+ * defines CO_CAN_RX_TIMESTAMP, reception time is taken from the CAN driver.
+ * Otherwise it is time of processing in CO_HBconsumer_process() and resolution
+ * of the intervals is interval of its calls. With CO_HBCONSUMER_SCALABLE
+ * regular heartbeats don't wake the processing, so driver timestamps are
+ * necessary there for usable statistics.
+ *
  * @see  @ref CO_NMT_Heartbeat
  */
 
+
+#ifdef CO_HBCONSUMER_SCALABLE
+/** CAN identifier and mask of receive buffer for all heartbeats */
+#define CO_HBCONS_SCALABLE_CAN_MASK     0x780U
+/** Size of node-ID indexed tables, node-IDs are 1 to 127 */
+#define CO_HBCONS_NODE_ID_COUNT         128U
+/** Value in _nodeIdx_ and _heapPos_ for not used */
+#define CO_HBCONS_NONE                  0xFFU
+#endif
+
 /**
  * Heartbeat state of a node
  */
@@ -61,12 +94,30 @@ typedef enum {
 } CO_HBconsumer_state_t;
 
 
+/**
+ * Heartbeat inter-arrival statistics of one monitored node, see
+ * CO_HBconsumer_getStats().
+ *
+ * Interval is time between two consecutive heartbeats of the node. Bootup
+ * message and (re)configuration of the node restart the measurement.
+ */
+typedef struct{
+    uint32_t            count;          /**< Number of measured intervals */
+    uint32_t            late;           /**< Number of intervals longer than consumer heartbeat time */
+    uint32_t            intervalMin_us; /**< Minimum interval in [microseconds] */
+    uint32_t            intervalMax_us; /**< Maximum interval in [microseconds] */
+    uint32_t            intervalMean_us;/**< Mean interval in [microseconds], calculated by CO_HBconsumer_getStats() */
+    uint64_t            intervalSum_us; /**< Sum of intervals in [microseconds] */
+}CO_HBconsStats_t;
+
+
 /**
  * One monitored node inside CO_HBconsumer_t.
  */
 typedef struct{
     uint8_t                 nodeId;       /**< Node Id of the monitored node */
     CO_NMT_internalState_t  NMTstate;     /**< Of the remote node (Heartbeat payload) */
+    CO_NMT_internalState_t  NMTstatePrev; /**< Last state reported to pFunctSignalNmtChanged */
     CO_HBconsumer_state_t   HBstate;      /**< Current heartbeat state */
     uint16_t                timeoutTimer; /**< Time since last heartbeat received */
     uint16_t                time;         /**< Consumer heartbeat time from OD */
@@ -80,6 +131,20 @@ typedef struct{
     /** Callback for remote reset event */
     void                  (*pFunctSignalRemoteReset)(uint8_t nodeId, uint8_t idx, void *object); /**< From CO_HBconsumer_initRemoteResetCallback() or NULL */
     void                   *functSignalObjectRemoteReset;/**< Pointer to object */
+    /** From CO_HBconsumer_initCallbackSignal() or NULL */
+    void                  (*pFunctSignal)(void);
+    CO_HBconsStats_t        stats;        /**< See CO_HBconsumer_getStats() */
+    uint32_t                rxTime_us;    /**< Reception time of the previous heartbeat */
+    bool_t                  rxTimeValid;  /**< True, if rxTime_us is valid */
+    /** Incremented before and after stats are written, so it is odd during
+     * update. Stats may be written by CAN receive function. */
+    volatile uint8_t        statsSeq;
+    volatile uint8_t        statsResetReq;/**< Incremented by CO_HBconsumer_getStats() for reset */
+    uint8_t                 statsResetAck;/**< Equal to statsResetReq after stats are cleared */
+#if defined(CO_HBCONSUMER_SCALABLE) || defined(CO_DOXYGEN)
+    uint32_t                deadline_ms;  /**< Time of heartbeat timeout, see _now_ms_ in CO_HBconsumer_t */
+    uint8_t                 heapPos;      /**< Position in deadline heap or CO_HBCONS_NONE */
+#endif
 }CO_HBconsNode_t;
 
 
@@ -99,6 +164,34 @@ typedef struct{
     uint8_t             allMonitoredOperational;
     CO_CANmodule_t     *CANdevRx;         /**< From CO_HBconsumer_init() */
     uint16_t            CANdevRxIdxStart; /**< From CO_HBconsumer_init() */
+    /** From CO_HBconsumer_initCallbackNmtChanged() or NULL */
+    void              (*pFunctSignalNmtChanged)(uint8_t nodeId, uint8_t idx, CO_NMT_internalState_t NMTstate, void *object);
+    void               *functSignalObjectNmtChanged;/**< Pointer to object */
+    uint32_t            now_ms;           /**< Sum of timeDifference_ms */
+#if defined(CO_HBCONSUMER_SCALABLE) || defined(CO_DOXYGEN)
+    /** Index in monitoredNodes by node-ID or CO_HBCONS_NONE */
+    uint8_t             nodeIdx[CO_HBCONS_NODE_ID_COUNT];
+    /** Min-heap of indexes of active nodes, sorted by deadline_ms */
+    uint8_t             heap[CO_HBCONS_NODE_ID_COUNT];
+    uint8_t             heapSize;         /**< Number of nodes in heap */
+    /** Indexes of nodes with received heartbeat. Single producer (receive
+     * function), single consumer (CO_HBconsumer_process()). Node is queued
+     * only, when its CANrxNew changes from 0 to 1, so it is in queue only
+     * once. */
+    uint8_t             rxQueue[CO_HBCONS_NODE_ID_COUNT];
+    volatile uint8_t    rxQueueHead;      /**< Written by receive function */
+    volatile uint8_t    rxQueueTail;      /**< Written by CO_HBconsumer_process() */
+    /** Bitmap by node-ID (bit n%32 of word n/32) of monitored nodes in
+     * #CO_HBconsumer_ACTIVE state. Can be read by the application. */
+    uint32_t            activeNodes[CO_HBCONS_NODE_ID_COUNT / 32U];
+    /** Bitmap by node-ID of monitored nodes, which are NMT operational. Can
+     * be read by the application. */
+    uint32_t            operationalNodes[CO_HBCONS_NODE_ID_COUNT / 32U];
+    uint8_t             monitoredCount;   /**< Number of configured nodes */
+    uint8_t             activeCount;      /**< Number of bits in activeNodes */
+    uint8_t             operationalCount; /**< Number of bits in operationalNodes */
+    uint8_t             timeoutCount;     /**< Number of nodes in #CO_HBconsumer_TIMEOUT state */
+#endif
 }CO_HBconsumer_t;
 
 
@@ -117,7 +210,8 @@ typedef struct{
  * @param numberOfMonitoredNodes Total size of the above arrays.
  * @param CANdevRx CAN device for Heartbeat reception.
  * @param CANdevRxIdxStart Starting index of receive buffer in the above CAN device.
- * Number of used indexes is equal to numberOfMonitoredNodes.
+ * Number of used indexes is equal to numberOfMonitoredNodes (one, if
+ * CO_HBCONSUMER_SCALABLE is defined).
  *
  * @return #CO_ReturnError_t CO_ERROR_NO or CO_ERROR_ILLEGAL_ARGUMENT.
  */
@@ -206,6 +300,42 @@ void CO_HBconsumer_initCallbackRemoteReset(
         void                   *object,
         void                  (*pFunctSignal)(uint8_t nodeId, uint8_t idx, void *object));
 
+/**
+ * Initialize Heartbeat consumer NMT state changed callback function.
+ *
+ * Function initializes optional callback function, which is called for all
+ * monitored nodes, when NMT state from heartbeat differs from the previous
+ * one, when bootup message is received (with #CO_NMT_INITIALIZING) and when
+ * heartbeat times out (with #CO_NMT_INITIALIZING, CO_HBconsumer_getState()
+ * returns #CO_HBconsumer_TIMEOUT then). Callback is called from
+ * CO_HBconsumer_process(). It is used by @ref CO_NMTmaster.
+ *
+ * @param HBcons This object.
+ * @param object Pointer to object, which will be passed to pFunctSignal(). Can be NULL
+ * @param pFunctSignal Pointer to the callback function. Not called if NULL.
+ */
+void CO_HBconsumer_initCallbackNmtChanged(
+        CO_HBconsumer_t        *HBcons,
+        void                   *object,
+        void                  (*pFunctSignal)(uint8_t nodeId, uint8_t idx, CO_NMT_internalState_t NMTstate, void *object));
+
+/**
+ * Initialize Heartbeat consumer callback function.
+ *
+ * Function initializes optional callback function, which should immediately
+ * start processing of CO_HBconsumer_process() function.
+ * Callback is called from CAN receive function, when heartbeat of monitored
+ * node changes its NMT state, or when heartbeat is received from node, which
+ * is not in #CO_HBconsumer_ACTIVE state. Regular heartbeats don't trigger the
+ * callback, they are processed at the next deadline from timerNext_ms.
+ *
+ * @param HBcons This object.
+ * @param pFunctSignal Pointer to the callback function. Not called if NULL.
+ */
+void CO_HBconsumer_initCallbackSignal(
+        CO_HBconsumer_t        *HBcons,
+        void                  (*pFunctSignal)(void));
+
 /**
  * Process Heartbeat consumer object.
  *
@@ -214,11 +344,14 @@ void CO_HBconsumer_initCallbackRemoteReset(
  * @param HBcons This object.
  * @param NMTisPreOrOperational True if this node is NMT_PRE_OPERATIONAL or NMT_OPERATIONAL.
  * @param timeDifference_ms Time difference from previous function call in [milliseconds].
+ * @param timerNext_ms Return value - info to OS - see CO_process(). Lowered to
+ * the time of the earliest heartbeat timeout of active monitored nodes.
  */
 void CO_HBconsumer_process(
         CO_HBconsumer_t        *HBcons,
         bool_t                  NMTisPreOrOperational,
-        uint16_t                timeDifference_ms);
+        uint16_t                timeDifference_ms,
+        uint16_t               *timerNext_ms);
 
 /**
  * Get the heartbeat producer object index by node ID
@@ -259,6 +392,54 @@ int8_t CO_HBconsumer_getNmtState(
         CO_NMT_internalState_t *nmtState);
 
 
+/**
+ * Get heartbeat inter-arrival statistics of the monitored node.
+ *
+ * Function may be called from other thread than CAN receive.
+ *
+ * @param HBcons This object.
+ * @param idx Index of the node in HBcons object.
+ * @param stats Statistics are copied here, see #CO_HBconsStats_t.
+ * @param reset If true, statistics are cleared after copy.
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO or CO_ERROR_ILLEGAL_ARGUMENT.
+ */
+CO_ReturnError_t CO_HBconsumer_getStats(
+        CO_HBconsumer_t        *HBcons,
+        uint8_t                 idx,
+        CO_HBconsStats_t       *stats,
+        bool_t                  reset);
+
+
+#if defined(CO_HBCONSUMER_SCALABLE) || defined(CO_DOXYGEN)
+/**
+ * Check if heartbeat of the node is active, O(1).
+ *
+ * Available, if CO_HBCONSUMER_SCALABLE is defined.
+ *
+ * @param HBcons This object.
+ * @param nodeId Node-ID of the monitored node.
+ *
+ * @return True, if node is monitored and in #CO_HBconsumer_ACTIVE state.
+ */
+bool_t CO_HBconsumer_isNodeActive(
+        const CO_HBconsumer_t  *HBcons,
+        uint8_t                 nodeId);
+
+
+/**
+ * Check if all monitored nodes are active, O(1).
+ *
+ * Available, if CO_HBCONSUMER_SCALABLE is defined.
+ *
+ * @param HBcons This object.
+ *
+ * @return True, if all configured nodes are in #CO_HBconsumer_ACTIVE state.
+ */
+bool_t CO_HBconsumer_allActive(const CO_HBconsumer_t *HBcons);
+#endif
+
+
 #ifdef __cplusplus
 }
 #endif /*__cplusplus*/
@@ -79,21 +79,9 @@ static void CO_LSSmaster_receive(void *object, const CO_CANrxMsg_t *msg)
 
     LSSmaster = (CO_LSSmaster_t*)object;   /* this is the correct pointer type of the first argument */
 
-    /* verify message length and message overflow (previous message was not processed yet) */
-    if(msg->DLC==8 && !IS_CANrxNew(LSSmaster->CANrxNew) &&
-       LSSmaster->command!=CO_LSSmaster_COMMAND_WAITING){
-
-        /* copy data and set 'new message' flag */
-        LSSmaster->CANrxData[0] = msg->data[0];
-        LSSmaster->CANrxData[1] = msg->data[1];
-        LSSmaster->CANrxData[2] = msg->data[2];
-        LSSmaster->CANrxData[3] = msg->data[3];
-        LSSmaster->CANrxData[4] = msg->data[4];
-        LSSmaster->CANrxData[5] = msg->data[5];
-        LSSmaster->CANrxData[6] = msg->data[6];
-        LSSmaster->CANrxData[7] = msg->data[7];
-
-        SET_CANrxNew(LSSmaster->CANrxNew);
+    /* verify message length, queue message (mainline copies it to CANrxData) */
+    if(msg->DLC==8 && LSSmaster->command!=CO_LSSmaster_COMMAND_WAITING &&
+       CO_RXqueue_push(&LSSmaster->RXqueue, msg->data)){
 
         /* Optional signal to RTOS, which can resume task, which handles SDO client. */
         if(LSSmaster->pFunctSignal != NULL) {
@@ -102,6 +90,20 @@ static void CO_LSSmaster_receive(void *object, const CO_CANrxMsg_t *msg)
     }
 }
 
+/*
+ * Take next received message from queue, if previous one was processed.
+ *
+ * @return True, if message is available in CANrxData.
+ */
+static bool_t CO_LSSmaster_rxFetch(CO_LSSmaster_t *LSSmaster)
+{
+    if (!IS_CANrxNew(LSSmaster->CANrxNew) &&
+        CO_RXqueue_pop(&LSSmaster->RXqueue, LSSmaster->CANrxData)) {
+        SET_CANrxNew(LSSmaster->CANrxNew);
+    }
+    return IS_CANrxNew(LSSmaster->CANrxNew) ? true : false;
+}
+
 /*
  * Check LSS timeout.
  *
@@ -146,6 +148,7 @@ CO_ReturnError_t CO_LSSmaster_init(
     LSSmaster->command = CO_LSSmaster_COMMAND_WAITING;
     LSSmaster->timeoutTimer = 0;
     CLEAR_CANrxNew(LSSmaster->CANrxNew);
+    CO_RXqueue_init(&LSSmaster->RXqueue, LSSmaster->RXqueueFrames, CO_LSSmaster_RX_QUEUE_SIZE);
     CO_memset(LSSmaster->CANrxData, 0, sizeof(LSSmaster->CANrxData));
     LSSmaster->pFunctSignal = NULL;
     LSSmaster->functSignalObject = NULL;
@@ -197,6 +200,29 @@ void CO_LSSmaster_initCallback(
     }
 }
 
+
+/******************************************************************************/
+void CO_LSSmaster_timerNext(
+        CO_LSSmaster_t         *LSSmaster,
+        uint16_t               *timerNext_ms)
+{
+    if(LSSmaster != NULL && timerNext_ms != NULL &&
+       LSSmaster->command != CO_LSSmaster_COMMAND_WAITING)
+    {
+        uint16_t diff = 0;
+
+        /* Messages are processed one per call, call again without delay */
+        if(LSSmaster->timeoutTimer < LSSmaster->timeout &&
+           CO_RXqueue_occupancy(&LSSmaster->RXqueue) == 0U)
+        {
+            diff = LSSmaster->timeout - LSSmaster->timeoutTimer;
+        }
+        if(*timerNext_ms > diff){
+            *timerNext_ms = diff;
+        }
+    }
+}
+
 /*
  * Helper function - initiate switch state
  */
@@ -213,6 +239,7 @@ static CO_LSSmaster_return_t CO_LSSmaster_switchStateSelectInitiate(
       LSSmaster->timeoutTimer = 0;
 
       CLEAR_CANrxNew(LSSmaster->CANrxNew);
+      CO_RXqueue_flush(&LSSmaster->RXqueue);
       CO_memset(&LSSmaster->TXbuff->data[6], 0, 3);
       LSSmaster->TXbuff->data[0] = CO_LSS_SWITCH_STATE_SEL_VENDOR;
       CO_setUint32(&LSSmaster->TXbuff->data[1], lssAddress->identity.vendorID);
@@ -234,6 +261,7 @@ static CO_LSSmaster_return_t CO_LSSmaster_switchStateSelectInitiate(
       LSSmaster->state = CO_LSSmaster_STATE_CFG_GLOBAL;
 
       CLEAR_CANrxNew(LSSmaster->CANrxNew);
+      CO_RXqueue_flush(&LSSmaster->RXqueue);
       LSSmaster->TXbuff->data[0] = CO_LSS_SWITCH_STATE_GLOBAL;
       LSSmaster->TXbuff->data[1] = CO_LSS_STATE_CONFIGURATION;
       CO_memset(&LSSmaster->TXbuff->data[2], 0, 6);
@@ -254,7 +282,7 @@ static CO_LSSmaster_return_t CO_LSSmaster_switchStateSelectWait(
 {
     CO_LSSmaster_return_t ret;
 
-    if (IS_CANrxNew(LSSmaster->CANrxNew)) {
+    if (CO_LSSmaster_rxFetch(LSSmaster)) {
         uint8_t cs = LSSmaster->CANrxData[0];
         CLEAR_CANrxNew(LSSmaster->CANrxNew);
 
@@ -327,6 +355,7 @@ CO_LSSmaster_return_t CO_LSSmaster_switchStateDeselect(
 
     /* switch state global */
     CLEAR_CANrxNew(LSSmaster->CANrxNew);
+    CO_RXqueue_flush(&LSSmaster->RXqueue);
     LSSmaster->TXbuff->data[0] = CO_LSS_SWITCH_STATE_GLOBAL;
     LSSmaster->TXbuff->data[1] = CO_LSS_STATE_WAITING;
     CO_memset(&LSSmaster->TXbuff->data[2], 0, 6);
@@ -364,7 +393,7 @@ static CO_LSSmaster_return_t CO_LSSmaster_configureCheckWait(
 {
     CO_LSSmaster_return_t ret;
 
-    if (IS_CANrxNew(LSSmaster->CANrxNew)) {
+    if (CO_LSSmaster_rxFetch(LSSmaster)) {
         uint8_t cs = LSSmaster->CANrxData[0];
         uint8_t errorCode = LSSmaster->CANrxData[1];
         CLEAR_CANrxNew(LSSmaster->CANrxNew);
@@ -430,6 +459,7 @@ CO_LSSmaster_return_t CO_LSSmaster_configureBitTiming(
         LSSmaster->timeoutTimer = 0;
 
         CLEAR_CANrxNew(LSSmaster->CANrxNew);
+        CO_RXqueue_flush(&LSSmaster->RXqueue);
         LSSmaster->TXbuff->data[0] = CO_LSS_CFG_BIT_TIMING;
         LSSmaster->TXbuff->data[1] = 0;
         LSSmaster->TXbuff->data[2] = bitTiming;
@@ -476,6 +506,7 @@ CO_LSSmaster_return_t CO_LSSmaster_configureNodeId(
         LSSmaster->timeoutTimer = 0;
 
         CLEAR_CANrxNew(LSSmaster->CANrxNew);
+        CO_RXqueue_flush(&LSSmaster->RXqueue);
         LSSmaster->TXbuff->data[0] = CO_LSS_CFG_NODE_ID;
         LSSmaster->TXbuff->data[1] = nodeId;
         CO_memset(&LSSmaster->TXbuff->data[2], 0, 6);
@@ -517,6 +548,7 @@ CO_LSSmaster_return_t CO_LSSmaster_configureStore(
         LSSmaster->timeoutTimer = 0;
 
         CLEAR_CANrxNew(LSSmaster->CANrxNew);
+        CO_RXqueue_flush(&LSSmaster->RXqueue);
         LSSmaster->TXbuff->data[0] = CO_LSS_CFG_STORE;
         CO_memset(&LSSmaster->TXbuff->data[1], 0, 7);
         CO_CANsend(LSSmaster->CANdevTx, LSSmaster->TXbuff);
@@ -555,6 +587,7 @@ CO_LSSmaster_return_t CO_LSSmaster_ActivateBit(
         LSSmaster->command==CO_LSSmaster_COMMAND_WAITING){
 
         CLEAR_CANrxNew(LSSmaster->CANrxNew);
+        CO_RXqueue_flush(&LSSmaster->RXqueue);
         LSSmaster->TXbuff->data[0] = CO_LSS_CFG_ACTIVATE_BIT_TIMING;
         CO_setUint16(&LSSmaster->TXbuff->data[1], switchDelay_ms);
         CO_memset(&LSSmaster->TXbuff->data[3], 0, 5);
@@ -575,6 +608,7 @@ static CO_LSSmaster_return_t CO_LSSmaster_inquireInitiate(
         uint8_t                 cs)
 {
     CLEAR_CANrxNew(LSSmaster->CANrxNew);
+    CO_RXqueue_flush(&LSSmaster->RXqueue);
     LSSmaster->TXbuff->data[0] = cs;
     CO_memset(&LSSmaster->TXbuff->data[1], 0, 7);
     CO_CANsend(LSSmaster->CANdevTx, LSSmaster->TXbuff);
@@ -593,7 +627,7 @@ static CO_LSSmaster_return_t CO_LSSmaster_inquireCheckWait(
 {
     CO_LSSmaster_return_t ret;
 
-    if (IS_CANrxNew(LSSmaster->CANrxNew)) {
+    if (CO_LSSmaster_rxFetch(LSSmaster)) {
         uint8_t cs = LSSmaster->CANrxData[0];
         *value = CO_getUint32(&LSSmaster->CANrxData[1]);
         CLEAR_CANrxNew(LSSmaster->CANrxNew);
@@ -750,6 +784,7 @@ static void CO_LSSmaster_FsSendMsg(
     LSSmaster->timeoutTimer = 0;
 
     CLEAR_CANrxNew(LSSmaster->CANrxNew);
+    CO_RXqueue_flush(&LSSmaster->RXqueue);
     LSSmaster->TXbuff->data[0] = CO_LSS_IDENT_FASTSCAN;
     CO_setUint32(&LSSmaster->TXbuff->data[1], idNumber);
     LSSmaster->TXbuff->data[5] = bitCheck;
@@ -772,7 +807,7 @@ static CO_LSSmaster_return_t CO_LSSmaster_FsCheckWait(
     if (ret == CO_LSSmaster_TIMEOUT) {
         ret = CO_LSSmaster_SCAN_NOACK;
 
-        if (IS_CANrxNew(LSSmaster->CANrxNew)) {
+        if (CO_LSSmaster_rxFetch(LSSmaster)) {
             uint8_t cs = LSSmaster->CANrxData[0];
             CLEAR_CANrxNew(LSSmaster->CANrxNew);
 
@@ -844,7 +879,7 @@ static CO_LSSmaster_return_t CO_LSSmaster_FsScanWait(
 
         ret = CO_LSSmaster_WAIT_SLAVE;
 
-        if (IS_CANrxNew(LSSmaster->CANrxNew)) {
+        if (CO_LSSmaster_rxFetch(LSSmaster)) {
             uint8_t cs = LSSmaster->CANrxData[0];
             CLEAR_CANrxNew(LSSmaster->CANrxNew);
 
@@ -928,7 +963,7 @@ static CO_LSSmaster_return_t CO_LSSmaster_FsVerifyWait(
         *idNumberRet = 0;
         ret = CO_LSSmaster_SCAN_NOACK;
 
-        if (IS_CANrxNew(LSSmaster->CANrxNew)) {
+        if (CO_LSSmaster_rxFetch(LSSmaster)) {
             uint8_t cs = LSSmaster->CANrxData[0];
             CLEAR_CANrxNew(LSSmaster->CANrxNew);
 
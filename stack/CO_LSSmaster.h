@@ -35,6 +35,7 @@ extern "C" {
 #if CO_NO_LSS_CLIENT == 1
 
 #include "CO_LSS.h"
+#include "CO_RXqueue.h"
 
 /**
  * @addtogroup CO_LSS
@@ -104,6 +105,18 @@ typedef enum {
 } CO_LSSmaster_return_t;
 
 
+/**
+ * LSS master receive queue size.
+ *
+ * Number of received LSS messages, which may wait for processing. Must be
+ * power of two. Fastscan and non-selective inquiries may get responses from
+ * many slaves at once, only first one is processed. See @ref CO_RXqueue.
+ */
+#ifndef CO_LSSmaster_RX_QUEUE_SIZE
+#define CO_LSSmaster_RX_QUEUE_SIZE 4
+#endif
+
+
 /**
  * LSS master object.
  */
@@ -119,8 +132,10 @@ typedef struct{
     uint8_t          fsBitChecked;     /**< Current scan bit position */
     uint32_t         fsIdNumber;       /**< Current scan result */
 
-    volatile void   *CANrxNew;         /**< Indication if new LSS message is received from CAN bus. It needs to be cleared when received message is completely processed. */
+    volatile void   *CANrxNew;         /**< Indication if new LSS message is in CANrxData. It needs to be cleared when received message is completely processed. */
     uint8_t          CANrxData[8];     /**< 8 data bytes of the received message */
+    CO_RXqueue_t     RXqueue;          /**< Queue of LSS messages received from CAN bus, with statistics */
+    CO_RXqueueFrame_t RXqueueFrames[CO_LSSmaster_RX_QUEUE_SIZE]; /**< Buffer for RXqueue */
 
     void           (*pFunctSignal)(void *object); /**< From CO_LSSmaster_initCallback() or NULL */
     void            *functSignalObject;/**< Pointer to object */
@@ -204,6 +219,23 @@ void CO_LSSmaster_initCallback(
         void                  (*pFunctSignal)(void *object));
 
 
+/**
+ * Get time until timeout of the active LSS master command.
+ *
+ * LSS master functions are called by the application, which may sleep
+ * between the calls. Function lowers timerNext_ms to the time, when active
+ * command times out, so the application can call it in time. If received
+ * messages are still waiting in queue, timerNext_ms is set to 0. If no
+ * command is active, timerNext_ms is not changed.
+ *
+ * @param LSSmaster This object.
+ * @param timerNext_ms Return value - info to OS - see CO_process().
+ */
+void CO_LSSmaster_timerNext(
+        CO_LSSmaster_t         *LSSmaster,
+        uint16_t               *timerNext_ms);
+
+
 /**
  * Request LSS switch state select
  *
@@ -254,6 +254,10 @@ typedef struct{
 
     CO_CANmodule_t         *CANdevTx;         /**< From #CO_LSSslave_init() */
     CO_CANtx_t             *TXbuff;           /**< CAN transmit buffer */
+
+    uint16_t                LEDms50;          /**< Internal timer for CO_LSSslave_LEDprocess() */
+    int8_t                  LEDflash1;        /**< Internal LED flash state */
+    int8_t                  LEDflash2;        /**< Internal LED flash state */
 }CO_LSSslave_t;
 
 /**
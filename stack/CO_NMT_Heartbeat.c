@@ -75,6 +75,11 @@ static void CO_NMT_receive(void *object, const CO_CANrxMsg_t *msg){
         if(NMT->pFunctNMT!=NULL && currentOperatingState!=NMT->operatingState){
             NMT->pFunctNMT(NMT->operatingState);
         }
+
+        /* Optional signal to RTOS, which can resume task, which handles NMT. */
+        if(NMT->pFunctSignal != NULL){
+            NMT->pFunctSignal();
+        }
     }
 }
 
@@ -117,8 +122,11 @@ CO_ReturnError_t CO_NMT_init(
     NMT->firstHBTime            = firstHBTime;
     NMT->resetCommand           = 0;
     NMT->HBproducerTimer        = 0xFFFF;
+    NMT->HBdriftFree            = false;
+    NMT->HBproducerSkipped      = 0;
     NMT->emPr                   = emPr;
     NMT->pFunctNMT              = NULL;
+    NMT->pFunctSignal           = NULL;
 
     /* configure NMT CAN reception */
     CO_CANrxBufferInit(
@@ -144,6 +152,17 @@ CO_ReturnError_t CO_NMT_init(
 }
 
 
+/******************************************************************************/
+void CO_NMT_initCallbackSignal(
+        CO_NMT_t               *NMT,
+        void                  (*pFunctSignal)(void))
+{
+    if(NMT != NULL){
+        NMT->pFunctSignal = pFunctSignal;
+    }
+}
+
+
 /******************************************************************************/
 void CO_NMT_initCallback(
         CO_NMT_t               *NMT,
@@ -158,6 +177,17 @@ void CO_NMT_initCallback(
 }
 
 
+/******************************************************************************/
+void CO_NMT_setHBdriftFree(
+        CO_NMT_t               *NMT,
+        bool_t                  driftFree)
+{
+    if(NMT != NULL){
+        NMT->HBdriftFree = driftFree;
+    }
+}
+
+
 /******************************************************************************/
 #ifdef CO_USE_LEDS
 void CO_NMT_blinkingProcess50ms(CO_NMT_t *NMT){
@@ -222,9 +252,22 @@ CO_NMT_reset_cmd_t CO_NMT_process(
     /* Heartbeat producer message & Bootup message */
     if((HBtime != 0 && NMT->HBproducerTimer >= HBtime) || NMT->operatingState == CO_NMT_INITIALIZING){
 
-        /* Start from the beginning. If OS is slow, time sliding may occur. However, heartbeat is
-         * not for synchronization, it is for health report. */
-        NMT->HBproducerTimer = 0;
+        if(NMT->HBdriftFree && HBtime != 0 && NMT->HBproducerTimer >= HBtime &&
+           NMT->operatingState != CO_NMT_INITIALIZING)
+        {
+            /* Keep the phase. Periods, which were missed completely, are
+             * skipped. Bootup has no phase yet, timer is set below. */
+            NMT->HBproducerTimer -= HBtime;
+            if(NMT->HBproducerTimer >= HBtime){
+                NMT->HBproducerSkipped += NMT->HBproducerTimer / HBtime;
+                NMT->HBproducerTimer %= HBtime;
+            }
+        }
+        else{
+            /* Start from the beginning. If OS is slow, time sliding may occur. However, heartbeat is
+             * not for synchronization, it is for health report. */
+            NMT->HBproducerTimer = 0;
+        }
 
         NMT->HB_TXbuff->data[0] = NMT->operatingState;
         CO_CANsend(NMT->HB_CANdev, NMT->HB_TXbuff);
@@ -276,7 +319,8 @@ CO_NMT_reset_cmd_t CO_NMT_process(
     else if(CO_isError(NMT->emPr->em, CO_EM_SYNC_TIME_OUT))
         NMT->LEDredError = NMT->LEDtripleFlash;
 
-    else if(CO_isError(NMT->emPr->em, CO_EM_HEARTBEAT_CONSUMER) || CO_isError(NMT->emPr->em, CO_EM_HB_CONSUMER_REMOTE_RESET))
+    else if(CO_isError(NMT->emPr->em, CO_EM_HEARTBEAT_CONSUMER) || CO_isError(NMT->emPr->em, CO_EM_HB_CONSUMER_REMOTE_RESET)
+         || CO_isError(NMT->emPr->em, CO_EM_LIFE_GUARDING) || CO_isError(NMT->emPr->em, CO_EM_NODE_GUARDING))
         NMT->LEDredError = NMT->LEDdoubleFlash;
 
     else if(CANpassive || CO_isError(NMT->emPr->em, CO_EM_CAN_BUS_WARNING))
@@ -305,7 +349,9 @@ CO_NMT_reset_cmd_t CO_NMT_process(
                 }
                 else if(CO_isError(NMT->emPr->em, CO_EM_CAN_TX_BUS_OFF)
                      || CO_isError(NMT->emPr->em, CO_EM_HEARTBEAT_CONSUMER)
-                     || CO_isError(NMT->emPr->em, CO_EM_HB_CONSUMER_REMOTE_RESET))
+                     || CO_isError(NMT->emPr->em, CO_EM_HB_CONSUMER_REMOTE_RESET)
+                     || CO_isError(NMT->emPr->em, CO_EM_LIFE_GUARDING)
+                     || CO_isError(NMT->emPr->em, CO_EM_NODE_GUARDING))
                 {
                     if(errorBehavior[0] == 0){
                         NMT->operatingState = CO_NMT_PRE_OPERATIONAL;
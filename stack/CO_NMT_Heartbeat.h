@@ -60,6 +60,11 @@ extern "C" {
  *   -----|-----------------------------------------------------------
  *     0  | #CO_NMT_internalState_t
  *
+ * By default heartbeat period starts, when heartbeat is sent, so late
+ * processing moves all following heartbeats. Drift free schedule keeps
+ * heartbeats on multiples of _Producer Heartbeat time_, see
+ * CO_NMT_setHBdriftFree().
+ *
  * @see #CO_Default_CAN_ID_t
  *
  * ###Status LED diodes
@@ -145,9 +150,14 @@ typedef struct{
     uint8_t             nodeId;         /**< CANopen Node ID of this device */
     uint16_t            HBproducerTimer;/**< Internal timer for HB producer */
     uint16_t            firstHBTime;    /**< From CO_NMT_init() */
+    bool_t              HBdriftFree;    /**< From CO_NMT_setHBdriftFree() */
+    /** Number of heartbeat periods skipped by drift free schedule, because
+     * processing was late more than one period. Informative. */
+    uint32_t            HBproducerSkipped;
     CO_EMpr_t          *emPr;           /**< From CO_NMT_init() */
     CO_CANmodule_t     *HB_CANdev;      /**< From CO_NMT_init() */
     void              (*pFunctNMT)(CO_NMT_internalState_t state); /**< From CO_NMT_initCallback() or NULL */
+    void              (*pFunctSignal)(void); /**< From CO_NMT_initCallbackSignal() or NULL */
     CO_CANtx_t         *HB_TXbuff;      /**< CAN transmit buffer */
 }CO_NMT_t;
 
@@ -203,6 +213,40 @@ void CO_NMT_initCallback(
         void                  (*pFunctNMT)(CO_NMT_internalState_t state));
 
 
+/**
+ * Initialize NMT signal callback function.
+ *
+ * Function initializes optional callback function, which should immediately
+ * start processing of CO_NMT_process() function. Callback is called after
+ * NMT command for this node is received from the CAN bus, so NMT state change
+ * or reset command is processed without waiting for the next timerNext_ms.
+ *
+ * @param NMT This object.
+ * @param pFunctSignal Pointer to the callback function. Not called if NULL.
+ */
+void CO_NMT_initCallbackSignal(
+        CO_NMT_t               *NMT,
+        void                  (*pFunctSignal)(void));
+
+
+/**
+ * Set drift free schedule of Heartbeat producer.
+ *
+ * If enabled, heartbeats are sent on multiples of _Producer Heartbeat time_
+ * from the first heartbeat, regardless of delays in CO_NMT_process() calls.
+ * If processing was late more than one period, missed periods are skipped and
+ * counted in _HBproducerSkipped_. Heartbeat sent immediately after change of
+ * NMT state starts new schedule. Default is disabled, setting is cleared by
+ * CO_NMT_init().
+ *
+ * @param NMT This object.
+ * @param driftFree True for drift free schedule.
+ */
+void CO_NMT_setHBdriftFree(
+        CO_NMT_t               *NMT,
+        bool_t                  driftFree);
+
+
 /**
  * Calculate blinking bytes.
  *
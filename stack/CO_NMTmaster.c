@@ -0,0 +1,475 @@
+/*
+ * CANopen NMT master with network state table.
+ *
+ * @file        CO_NMTmaster.c
+ * @ingroup     CO_NMTmaster
+ * @copyright   2020
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "CANopen.h"
+
+#if CO_NO_NMT_MASTER == 1
+
+#include "CO_NMTmaster.h"
+
+
+/* NMT state, which node reaches after command, CO_NMT_INITIALIZING for resets */
+static uint8_t CO_NMTM_target(uint8_t command){
+    switch(command){
+        case CO_NMT_ENTER_OPERATIONAL:      return CO_NMT_OPERATIONAL;
+        case CO_NMT_ENTER_STOPPED:          return CO_NMT_STOPPED;
+        case CO_NMT_ENTER_PRE_OPERATIONAL:  return CO_NMT_PRE_OPERATIONAL;
+        default:                            return CO_NMT_INITIALIZING;
+    }
+}
+
+
+/* True, if node is in network list of the heartbeat consumer */
+static bool_t CO_NMTM_isMonitored(CO_NMTmaster_t *NMTM, uint8_t nodeId){
+    int8_t idx = CO_HBconsumer_getIdxByNodeId(NMTM->HBcons, nodeId);
+
+    return idx >= 0 &&
+           CO_HBconsumer_getState(NMTM->HBcons, (uint8_t)idx) != CO_HBconsumer_UNCONFIGURED;
+}
+
+
+/* Finish request for the node and inform application */
+static void CO_NMTM_finish(CO_NMTmaster_t *NMTM, uint8_t nodeId, CO_NMTmaster_event_t event){
+    CO_NMTmasterNode_t *node = &NMTM->nodes[nodeId];
+
+    if(node->command != 0U){
+        node->command = 0;
+        NMTM->pendingCount--;
+        if(NMTM->pFunctSignal != NULL){
+            NMTM->pFunctSignal(NMTM->functSignalObject, nodeId, event, node->state);
+        }
+    }
+}
+
+
+/*
+ * Called from CO_HBconsumer_process(), when NMT state of monitored node
+ * changes.
+ */
+static void CO_NMTM_nmtChanged(uint8_t nodeId, uint8_t idx, CO_NMT_internalState_t NMTstate, void *object){
+    CO_NMTmaster_t *NMTM = (CO_NMTmaster_t*)object;
+    CO_NMTmasterNode_t *node;
+    CO_NMTmaster_event_t event;
+
+    if(nodeId == 0U || nodeId >= CO_NMTM_NODE_ID_COUNT){
+        return;
+    }
+    node = &NMTM->nodes[nodeId];
+
+    if(NMTstate != CO_NMT_INITIALIZING){
+        event = CO_NMTM_EVENT_STATE;
+        node->state = (uint8_t)NMTstate;
+    }
+    else if(CO_HBconsumer_getState(NMTM->HBcons, idx) == CO_HBconsumer_TIMEOUT){
+        event = CO_NMTM_EVENT_LOST;
+        node->state = CO_NMTM_STATE_UNKNOWN;
+    }
+    else{
+        event = CO_NMTM_EVENT_BOOTUP;
+        node->state = CO_NMT_INITIALIZING;
+    }
+
+    if(NMTM->pFunctSignal != NULL){
+        NMTM->pFunctSignal(NMTM->functSignalObject, nodeId, event, node->state);
+    }
+
+    /* verify pending request */
+    if(node->command != 0U){
+        uint8_t target = CO_NMTM_target(node->command);
+
+        if(target == CO_NMT_INITIALIZING){
+            if(event == CO_NMTM_EVENT_BOOTUP && node->sent > 0U){
+                CO_NMTM_finish(NMTM, nodeId, CO_NMTM_EVENT_DONE);
+            }
+        }
+        else if(event == CO_NMTM_EVENT_STATE && node->state == target){
+            CO_NMTM_finish(NMTM, nodeId, CO_NMTM_EVENT_DONE);
+        }
+    }
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_NMTmaster_init(
+        CO_NMTmaster_t         *NMTM,
+        CO_NMT_t               *NMT,
+        CO_HBconsumer_t        *HBcons,
+        CO_CANmodule_t         *CANdevTx,
+        uint16_t                CANdevTxIdx)
+{
+    uint16_t i;
+
+    /* verify arguments */
+    if(NMTM==NULL || NMT==NULL || HBcons==NULL || CANdevTx==NULL){
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    /* Configure object variables */
+    NMTM->NMT = NMT;
+    NMTM->HBcons = HBcons;
+    NMTM->CANdevTx = CANdevTx;
+    NMTM->pendingCount = 0;
+    NMTM->retryTime_ms = CO_NMTM_DEFAULT_RETRY_TIME;
+    NMTM->retries = CO_NMTM_DEFAULT_RETRIES;
+    NMTM->txCount = 0;
+    NMTM->pFunctSignal = NULL;
+    NMTM->functSignalObject = NULL;
+
+    for(i=0; i<CO_NMTM_NODE_ID_COUNT; i++){
+        NMTM->nodes[i].state = CO_NMTM_STATE_UNKNOWN;
+        NMTM->nodes[i].command = 0;
+        NMTM->nodes[i].sent = 0;
+        NMTM->nodes[i].timer_ms = 0;
+    }
+
+    /* node states are received by heartbeat consumer */
+    CO_HBconsumer_initCallbackNmtChanged(HBcons, (void*)NMTM, CO_NMTM_nmtChanged);
+
+    /* configure NMT master CAN transmission */
+    NMTM->CANtxBuff = CO_CANtxBufferInit(
+            CANdevTx,               /* CAN device */
+            CANdevTxIdx,            /* index of specific buffer inside CAN module */
+            CO_CAN_ID_NMT_SERVICE,  /* CAN identifier */
+            0,                      /* rtr */
+            2,                      /* number of data bytes */
+            0);                     /* synchronous message flag bit */
+
+    if(NMTM->CANtxBuff == NULL){
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    return CO_ERROR_NO;
+}
+
+
+/******************************************************************************/
+void CO_NMTmaster_initCallback(
+        CO_NMTmaster_t         *NMTM,
+        void                   *object,
+        void                  (*pFunctSignal)(void *object, uint8_t nodeId, CO_NMTmaster_event_t event, uint8_t state))
+{
+    if(NMTM != NULL){
+        NMTM->functSignalObject = object;
+        NMTM->pFunctSignal = pFunctSignal;
+    }
+}
+
+
+/******************************************************************************/
+void CO_NMTmaster_setRetry(
+        CO_NMTmaster_t         *NMTM,
+        uint16_t                retryTime_ms,
+        uint8_t                 retries)
+{
+    if(NMTM != NULL){
+        NMTM->retryTime_ms = retryTime_ms;
+        NMTM->retries = (retries > 0U) ? retries : 1U;
+    }
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_NMTmaster_sendCommand(
+        CO_NMTmaster_t         *NMTM,
+        CO_NMT_command_t        command,
+        uint8_t                 nodeId)
+{
+    CO_NMT_t *NMT;
+    CO_ReturnError_t err;
+
+    if(NMTM == NULL || NMTM->CANtxBuff == NULL){
+        /* error, CO_NMTmaster_init() was not called. */
+        return CO_ERROR_TX_UNCONFIGURED;
+    }
+    NMT = NMTM->NMT;
+
+    /* Apply NMT command also to this node, if set so. */
+    if(nodeId == 0 || nodeId == NMT->nodeId){
+        switch(command){
+            case CO_NMT_ENTER_OPERATIONAL:
+                if((*NMT->emPr->errorRegister) == 0) {
+                    NMT->operatingState = CO_NMT_OPERATIONAL;
+                }
+                break;
+            case CO_NMT_ENTER_STOPPED:
+                NMT->operatingState = CO_NMT_STOPPED;
+                break;
+            case CO_NMT_ENTER_PRE_OPERATIONAL:
+                NMT->operatingState = CO_NMT_PRE_OPERATIONAL;
+                break;
+            case CO_NMT_RESET_NODE:
+                NMT->resetCommand = CO_RESET_APP;
+                break;
+            case CO_NMT_RESET_COMMUNICATION:
+                NMT->resetCommand = CO_RESET_COMM;
+                break;
+            default:
+                return CO_ERROR_ILLEGAL_ARGUMENT;
+        }
+    }
+
+    NMTM->CANtxBuff->data[0] = (uint8_t)command;
+    NMTM->CANtxBuff->data[1] = nodeId;
+
+    err = CO_CANsend(NMTM->CANdevTx, NMTM->CANtxBuff);
+    if(err == CO_ERROR_NO){
+        NMTM->txCount++;
+    }
+    return err;
+}
+
+
+/* Set request for one node */
+static void CO_NMTM_setRequest(CO_NMTmaster_t *NMTM, uint8_t nodeId, uint8_t command){
+    CO_NMTmasterNode_t *node = &NMTM->nodes[nodeId];
+    uint8_t target;
+
+    if(node->command == 0U){
+        NMTM->pendingCount++;
+    }
+    node->command = command;
+    node->sent = 0;
+    node->timer_ms = 0;
+
+    /* Reset is never complete in advance, it must be sent. */
+    target = CO_NMTM_target(command);
+    if(target != CO_NMT_INITIALIZING && node->state == target){
+        CO_NMTM_finish(NMTM, nodeId, CO_NMTM_EVENT_DONE);
+    }
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_NMTmaster_request(
+        CO_NMTmaster_t         *NMTM,
+        CO_NMT_command_t        command,
+        uint8_t                 nodeId)
+{
+    CO_HBconsumer_t *HBcons;
+    uint8_t i;
+
+    if(NMTM == NULL || nodeId >= CO_NMTM_NODE_ID_COUNT){
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+    switch(command){
+        case CO_NMT_ENTER_OPERATIONAL:
+        case CO_NMT_ENTER_STOPPED:
+        case CO_NMT_ENTER_PRE_OPERATIONAL:
+        case CO_NMT_RESET_NODE:
+        case CO_NMT_RESET_COMMUNICATION:
+            break;
+        default:
+            return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    if(nodeId != 0U){
+        if(nodeId == NMTM->NMT->nodeId){
+            return CO_ERROR_ILLEGAL_ARGUMENT;
+        }
+        CO_NMTM_setRequest(NMTM, nodeId, (uint8_t)command);
+        return CO_ERROR_NO;
+    }
+
+    /* all nodes from the network list */
+    HBcons = NMTM->HBcons;
+    for(i=0; i<HBcons->numberOfMonitoredNodes; i++){
+        uint8_t id = HBcons->monitoredNodes[i].nodeId;
+
+        if(HBcons->monitoredNodes[i].HBstate != CO_HBconsumer_UNCONFIGURED &&
+           id != 0U && id < CO_NMTM_NODE_ID_COUNT && id != NMTM->NMT->nodeId){
+            CO_NMTM_setRequest(NMTM, id, (uint8_t)command);
+        }
+    }
+
+    return CO_ERROR_NO;
+}
+
+
+/******************************************************************************/
+uint8_t CO_NMTmaster_getState(
+        const CO_NMTmaster_t   *NMTM,
+        uint8_t                 nodeId)
+{
+    if(NMTM == NULL || nodeId >= CO_NMTM_NODE_ID_COUNT){
+        return CO_NMTM_STATE_UNKNOWN;
+    }
+    return NMTM->nodes[nodeId].state;
+}
+
+
+/******************************************************************************/
+bool_t CO_NMTmaster_isBusy(const CO_NMTmaster_t *NMTM){
+    return NMTM != NULL && NMTM->pendingCount > 0U;
+}
+
+
+/*
+ * Check, if 'command' may be broadcast: each monitored node is due for it or
+ * is already in its target state without own request.
+ */
+static bool_t CO_NMTM_canBroadcast(CO_NMTmaster_t *NMTM, uint8_t command, const uint32_t due[]){
+    CO_HBconsumer_t *HBcons = NMTM->HBcons;
+    uint8_t target = CO_NMTM_target(command);
+    uint8_t i;
+
+    for(i=0; i<HBcons->numberOfMonitoredNodes; i++){
+        uint8_t nodeId = HBcons->monitoredNodes[i].nodeId;
+        const CO_NMTmasterNode_t *node;
+
+        if(HBcons->monitoredNodes[i].HBstate == CO_HBconsumer_UNCONFIGURED ||
+           nodeId >= CO_NMTM_NODE_ID_COUNT || nodeId == NMTM->NMT->nodeId){
+            continue;
+        }
+        node = &NMTM->nodes[nodeId];
+        if((due[nodeId >> 5] & (1UL << (nodeId & 0x1FU))) != 0U && node->command == command){
+            continue;
+        }
+        if(node->command == 0U && target != CO_NMT_INITIALIZING && node->state == target){
+            continue;
+        }
+        return false;
+    }
+    return true;
+}
+
+
+/* Mark command to the node as sent. Unmonitored nodes are not verified. */
+static void CO_NMTM_sent(CO_NMTmaster_t *NMTM, uint8_t nodeId){
+    CO_NMTmasterNode_t *node = &NMTM->nodes[nodeId];
+
+    node->sent++;
+    node->timer_ms = 0;
+    if(!CO_NMTM_isMonitored(NMTM, nodeId)){
+        CO_NMTM_finish(NMTM, nodeId, CO_NMTM_EVENT_DONE);
+    }
+}
+
+
+/******************************************************************************/
+void CO_NMTmaster_process(
+        CO_NMTmaster_t         *NMTM,
+        uint16_t                timeDifference_ms,
+        uint16_t               *timerNext_ms)
+{
+    uint32_t due[CO_NMTM_NODE_ID_COUNT / 32U] = {0, 0, 0, 0};
+    uint8_t dueCount = 0;
+    uint8_t firstCommand = 0;
+    uint8_t burst = CO_NMTM_TX_BURST;
+    uint8_t i;
+
+    if(NMTM->pendingCount == 0U){
+        return;
+    }
+
+    /* Find nodes, for which command has to be sent */
+    for(i=1; i<CO_NMTM_NODE_ID_COUNT; i++){
+        CO_NMTmasterNode_t *node = &NMTM->nodes[i];
+
+        if(node->command == 0U){
+            continue;
+        }
+        if(node->sent > 0U){
+            if(node->timer_ms < NMTM->retryTime_ms){
+                node->timer_ms += timeDifference_ms;
+            }
+            if(node->timer_ms < NMTM->retryTime_ms){
+                if(timerNext_ms != NULL){
+                    uint16_t diff = NMTM->retryTime_ms - node->timer_ms;
+                    if(*timerNext_ms > diff){
+                        *timerNext_ms = diff;
+                    }
+                }
+                continue;
+            }
+            if(node->sent >= NMTM->retries){
+                CO_NMTM_finish(NMTM, i, CO_NMTM_EVENT_FAILED);
+                continue;
+            }
+        }
+        due[i >> 5] |= 1UL << (i & 0x1FU);
+        dueCount++;
+        if(firstCommand == 0U){
+            firstCommand = node->command;
+        }
+    }
+
+    if(dueCount == 0U){
+        return;
+    }
+
+    /* One broadcast command instead of many, if possible */
+    if(dueCount > 1U && CO_NMTM_canBroadcast(NMTM, firstCommand, due)){
+        if(NMTM->CANtxBuff->bufferFull){
+            burst = 0;
+        }
+        else{
+            NMTM->CANtxBuff->data[0] = firstCommand;
+            NMTM->CANtxBuff->data[1] = 0;
+            if(CO_CANsend(NMTM->CANdevTx, NMTM->CANtxBuff) == CO_ERROR_NO){
+                NMTM->txCount++;
+                for(i=1; i<CO_NMTM_NODE_ID_COUNT; i++){
+                    if((due[i >> 5] & (1UL << (i & 0x1FU))) != 0U &&
+                       NMTM->nodes[i].command == firstCommand){
+                        due[i >> 5] &= ~(1UL << (i & 0x1FU));
+                        dueCount--;
+                        CO_NMTM_sent(NMTM, i);
+                    }
+                }
+            }
+            burst--;
+        }
+    }
+
+    /* Individual commands for the rest */
+    for(i=1; i<CO_NMTM_NODE_ID_COUNT && dueCount > 0U && burst > 0U; i++){
+        if((due[i >> 5] & (1UL << (i & 0x1FU))) == 0U){
+            continue;
+        }
+        if(NMTM->CANtxBuff->bufferFull){
+            break;
+        }
+        NMTM->CANtxBuff->data[0] = NMTM->nodes[i].command;
+        NMTM->CANtxBuff->data[1] = i;
+        if(CO_CANsend(NMTM->CANdevTx, NMTM->CANtxBuff) != CO_ERROR_NO){
+            break;
+        }
+        NMTM->txCount++;
+        dueCount--;
+        burst--;
+        CO_NMTM_sent(NMTM, i);
+    }
+
+    /* Remaining commands are sent in the next call */
+    if(dueCount > 0U && timerNext_ms != NULL){
+        *timerNext_ms = 0;
+    }
+
+    /* earliest retry of just sent commands */
+    if(NMTM->pendingCount > 0U && timerNext_ms != NULL && *timerNext_ms > NMTM->retryTime_ms){
+        *timerNext_ms = NMTM->retryTime_ms;
+    }
+}
+
+#endif /* CO_NO_NMT_MASTER == 1 */
@@ -0,0 +1,269 @@
+/**
+ * CANopen NMT master with network state table.
+ *
+ * @file        CO_NMTmaster.h
+ * @ingroup     CO_NMTmaster
+ * @copyright   2020
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef CO_NMT_MASTER_H
+#define CO_NMT_MASTER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if CO_NO_NMT_MASTER == 1
+
+/**
+ * @defgroup CO_NMTmaster NMT master
+ * @ingroup CO_CANopen
+ * @{
+ *
+ * CANopen NMT master with network state table.
+ *
+ * NMT master keeps NMT state of all nodes, which are monitored by
+ * @ref CO_HBconsumer (network list in object 0x1016). Table is updated from
+ * received heartbeats and bootup messages, application is informed about
+ * changes by callback, see CO_NMTmaster_initCallback().
+ *
+ * Application requests NMT state of one or all nodes with
+ * CO_NMTmaster_request(). CO_NMTmaster_process() then sends the NMT commands,
+ * verifies state of the nodes from their heartbeats and repeats commands,
+ * which were not successful. If the same command is due for all monitored
+ * nodes (nodes, which are already in the requested state, are counted too),
+ * one broadcast command (node-ID 0) is sent instead of individual commands.
+ * So network of many nodes is started with a single CAN message.
+ *
+ * Broadcast command reaches also nodes, which are not in the network list. It
+ * does not change state of this node. Reset commands are broadcast only, if
+ * all monitored nodes are requested to reset.
+ *
+ * Commands for nodes, which are not monitored, are sent once and not verified.
+ */
+
+
+/** Number of node-IDs in state table, node-ID 0 is not used */
+#define CO_NMTM_NODE_ID_COUNT       128U
+
+/** State of the node in state table is not known (no heartbeat) */
+#define CO_NMTM_STATE_UNKNOWN       0xFFU
+
+/** Default time in [ms], after which unsuccessful NMT command is repeated */
+#ifndef CO_NMTM_DEFAULT_RETRY_TIME
+#define CO_NMTM_DEFAULT_RETRY_TIME  1000U
+#endif
+
+/** Default number of NMT commands sent to the node, before request fails */
+#ifndef CO_NMTM_DEFAULT_RETRIES
+#define CO_NMTM_DEFAULT_RETRIES     3U
+#endif
+
+/** Maximum number of NMT messages sent in one CO_NMTmaster_process() call */
+#ifndef CO_NMTM_TX_BURST
+#define CO_NMTM_TX_BURST            8U
+#endif
+
+
+/**
+ * Events reported by NMT master callback.
+ */
+typedef enum{
+    CO_NMTM_EVENT_STATE     = 0,    /**< NMT state from heartbeat changed */
+    CO_NMTM_EVENT_BOOTUP    = 1,    /**< Bootup message received */
+    CO_NMTM_EVENT_LOST      = 2,    /**< Heartbeat timeout, state is unknown now */
+    CO_NMTM_EVENT_DONE      = 3,    /**< Node reached the requested state */
+    CO_NMTM_EVENT_FAILED    = 4     /**< Node did not reach requested state after all retries */
+}CO_NMTmaster_event_t;
+
+
+/**
+ * One node in state table of CO_NMTmaster_t.
+ */
+typedef struct{
+    uint8_t             state;          /**< #CO_NMT_internalState_t or #CO_NMTM_STATE_UNKNOWN */
+    uint8_t             command;        /**< Requested #CO_NMT_command_t or 0 */
+    uint8_t             sent;           /**< Number of sent commands for the request */
+    uint16_t            timer_ms;       /**< Time since the last command was sent */
+}CO_NMTmasterNode_t;
+
+
+/**
+ * NMT master object.
+ */
+typedef struct{
+    CO_NMT_t           *NMT;            /**< From CO_NMTmaster_init() */
+    CO_HBconsumer_t    *HBcons;         /**< From CO_NMTmaster_init() */
+    CO_CANmodule_t     *CANdevTx;       /**< From CO_NMTmaster_init() */
+    CO_CANtx_t         *CANtxBuff;      /**< CAN transmit buffer */
+    /** State table, indexed by node-ID */
+    CO_NMTmasterNode_t  nodes[CO_NMTM_NODE_ID_COUNT];
+    uint8_t             pendingCount;   /**< Number of nodes with requested command */
+    uint16_t            retryTime_ms;   /**< See CO_NMTmaster_setRetry() */
+    uint8_t             retries;        /**< See CO_NMTmaster_setRetry() */
+    uint32_t            txCount;        /**< Number of sent NMT messages, informative */
+    /** From CO_NMTmaster_initCallback() or NULL */
+    void              (*pFunctSignal)(void *object, uint8_t nodeId, CO_NMTmaster_event_t event, uint8_t state);
+    void               *functSignalObject;/**< Pointer to object */
+}CO_NMTmaster_t;
+
+
+/**
+ * Initialize NMT master object.
+ *
+ * Function must be called in the communication reset section, after
+ * CO_HBconsumer_init(). It takes NMT state changed callback of the heartbeat
+ * consumer, see CO_HBconsumer_initCallbackNmtChanged().
+ *
+ * @param NMTM This object will be initialized.
+ * @param NMT NMT object of this node.
+ * @param HBcons Heartbeat consumer object, source of the node states.
+ * @param CANdevTx CAN device for NMT master message.
+ * @param CANdevTxIdx Index of transmit buffer in the above CAN device.
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO or CO_ERROR_ILLEGAL_ARGUMENT.
+ */
+CO_ReturnError_t CO_NMTmaster_init(
+        CO_NMTmaster_t         *NMTM,
+        CO_NMT_t               *NMT,
+        CO_HBconsumer_t        *HBcons,
+        CO_CANmodule_t         *CANdevTx,
+        uint16_t                CANdevTxIdx);
+
+
+/**
+ * Initialize NMT master callback function.
+ *
+ * Function initializes optional callback function, which is called for
+ * #CO_NMTmaster_event_t of each node. It is called from CO_process(), _state_
+ * is the new state of the node from the state table.
+ *
+ * @param NMTM This object.
+ * @param object Pointer to object, which will be passed to pFunctSignal(). Can be NULL
+ * @param pFunctSignal Pointer to the callback function. Not called if NULL.
+ */
+void CO_NMTmaster_initCallback(
+        CO_NMTmaster_t         *NMTM,
+        void                   *object,
+        void                  (*pFunctSignal)(void *object, uint8_t nodeId, CO_NMTmaster_event_t event, uint8_t state));
+
+
+/**
+ * Set repetition of unsuccessful NMT commands.
+ *
+ * @param NMTM This object.
+ * @param retryTime_ms Time after which command is repeated, if node did not
+ * reach the requested state. Default is #CO_NMTM_DEFAULT_RETRY_TIME.
+ * @param retries Number of commands sent to the node, before request fails.
+ * Default is #CO_NMTM_DEFAULT_RETRIES.
+ */
+void CO_NMTmaster_setRetry(
+        CO_NMTmaster_t         *NMTM,
+        uint16_t                retryTime_ms,
+        uint8_t                 retries);
+
+
+/**
+ * Send NMT command immediately.
+ *
+ * Command is also applied to this node, if nodeId is zero or equal to own
+ * node-ID. Request for the node from CO_NMTmaster_request() is not changed.
+ *
+ * @param NMTM This object.
+ * @param command NMT command.
+ * @param nodeId Node-ID or 0 for all nodes.
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO, CO_ERROR_ILLEGAL_ARGUMENT or same as
+ * CO_CANsend().
+ */
+CO_ReturnError_t CO_NMTmaster_sendCommand(
+        CO_NMTmaster_t         *NMTM,
+        CO_NMT_command_t        command,
+        uint8_t                 nodeId);
+
+
+/**
+ * Request NMT command for the node or for all monitored nodes.
+ *
+ * Commands are sent by CO_NMTmaster_process(). Request completes with
+ * #CO_NMTM_EVENT_DONE or #CO_NMTM_EVENT_FAILED. Previous request for the node
+ * is replaced. Request for the node, which is already in the requested state,
+ * completes immediately.
+ *
+ * @param NMTM This object.
+ * @param command NMT command.
+ * @param nodeId Node-ID (1..127) or 0 for all monitored nodes. This node is
+ * not included.
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO or CO_ERROR_ILLEGAL_ARGUMENT.
+ */
+CO_ReturnError_t CO_NMTmaster_request(
+        CO_NMTmaster_t         *NMTM,
+        CO_NMT_command_t        command,
+        uint8_t                 nodeId);
+
+
+/**
+ * Get NMT state of the node from state table.
+ *
+ * @param NMTM This object.
+ * @param nodeId Node-ID.
+ *
+ * @return #CO_NMT_internalState_t or #CO_NMTM_STATE_UNKNOWN.
+ */
+uint8_t CO_NMTmaster_getState(
+        const CO_NMTmaster_t   *NMTM,
+        uint8_t                 nodeId);
+
+
+/**
+ * Check, if there are requests, which are not completed.
+ *
+ * @param NMTM This object.
+ *
+ * @return True, if some nodes didn't reach the requested state yet.
+ */
+bool_t CO_NMTmaster_isBusy(const CO_NMTmaster_t *NMTM);
+
+
+/**
+ * Process NMT master object.
+ *
+ * Function must be called cyclically, after CO_HBconsumer_process(). It only
+ * walks the state table, if there are pending requests.
+ *
+ * @param NMTM This object.
+ * @param timeDifference_ms Time difference from previous function call in [milliseconds].
+ * @param timerNext_ms Return value - info to OS - see CO_process().
+ */
+void CO_NMTmaster_process(
+        CO_NMTmaster_t         *NMTM,
+        uint16_t                timeDifference_ms,
+        uint16_t               *timerNext_ms);
+
+/** @} */
+
+#endif /* CO_NO_NMT_MASTER == 1 */
+
+#ifdef __cplusplus
+}
+#endif /*__cplusplus*/
+
+#endif
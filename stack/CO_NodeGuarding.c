@@ -0,0 +1,660 @@
+/*
+ * CANopen Node guarding slave and master objects.
+ *
+ * @file        CO_NodeGuarding.c
+ * @ingroup     CO_NodeGuarding
+ * @copyright   2020
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "CANopen.h"
+
+#if CO_NO_NG_SLAVE == 1 || CO_NO_NG_MASTER == 1
+
+#include "CO_NodeGuarding.h"
+
+
+#if CO_NO_NG_SLAVE == 1
+/*
+ * Read received guarding request (RTR).
+ *
+ * Function will be called (by CAN receive interrupt) every time, when CAN
+ * message with correct identifier will be received. For more information and
+ * description of parameters see file CO_driver.h.
+ */
+static void CO_NGslave_receive(void *object, const CO_CANrxMsg_t *msg){
+    CO_NGslave_t *NGS;
+
+    (void)msg;
+    NGS = (CO_NGslave_t*) object; /* this is the correct pointer type of the first argument */
+
+    SET_CANrxNew(NGS->CANrxNew);
+
+    /* Optional signal to RTOS, which can resume task, which sends response. */
+    if(NGS->pFunctSignal != NULL){
+        NGS->pFunctSignal();
+    }
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_NGslave_init(
+        CO_NGslave_t           *NGS,
+        CO_EM_t                *em,
+        CO_NMT_t               *NMT,
+        CO_CANmodule_t         *CANdevRx,
+        uint16_t                CANdevRxIdx,
+        CO_CANmodule_t         *CANdevTx,
+        uint16_t                CANdevTxIdx)
+{
+    CO_ReturnError_t ret;
+
+    /* verify arguments */
+    if(NGS==NULL || em==NULL || NMT==NULL || CANdevRx==NULL || CANdevTx==NULL){
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    /* Configure object variables */
+    NGS->em = em;
+    NGS->NMT = NMT;
+    NGS->CANdevTx = CANdevTx;
+    CLEAR_CANrxNew(NGS->CANrxNew);
+    NGS->toggle = 0U;
+    NGS->lifeGuarding = false;
+    NGS->lifeTimeout = false;
+    NGS->lifeTimer_ms = 0U;
+    NGS->pFunctSignal = NULL;
+
+    /* configure guarding request reception */
+    ret = CO_CANrxBufferInit(
+            CANdevRx,               /* CAN device */
+            CANdevRxIdx,            /* rx buffer index */
+            CO_CAN_ID_HEARTBEAT + NMT->nodeId, /* CAN identifier */
+            0x7FF,                  /* mask */
+            1,                      /* rtr */
+            (void*)NGS,             /* object passed to receive function */
+            CO_NGslave_receive);    /* this function will process received message */
+
+    /* configure guarding response transmission */
+    NGS->CANtxBuff = CO_CANtxBufferInit(
+            CANdevTx,               /* CAN device */
+            CANdevTxIdx,            /* index of specific buffer inside CAN module */
+            CO_CAN_ID_HEARTBEAT + NMT->nodeId, /* CAN identifier */
+            0,                      /* rtr */
+            1,                      /* number of data bytes */
+            0);                     /* synchronous message flag bit */
+
+    if(NGS->CANtxBuff == NULL){
+        ret = CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    return ret;
+}
+
+
+/******************************************************************************/
+void CO_NGslave_initCallbackSignal(
+        CO_NGslave_t           *NGS,
+        void                  (*pFunctSignal)(void))
+{
+    if(NGS != NULL){
+        NGS->pFunctSignal = pFunctSignal;
+    }
+}
+
+
+/******************************************************************************/
+void CO_NGslave_process(
+        CO_NGslave_t           *NGS,
+        uint16_t                guardTime_ms,
+        uint8_t                 lifeTimeFactor,
+        uint16_t                HBproducerTime_ms,
+        uint16_t                timeDifference_ms,
+        uint16_t               *timerNext_ms)
+{
+    uint32_t lifeTime_ms = CO_NG_LIFE_TIME(guardTime_ms, lifeTimeFactor);
+
+    /* Heartbeat has priority over node guarding */
+    if(HBproducerTime_ms != 0U){
+        lifeTime_ms = 0U;
+    }
+
+    if(NGS->lifeGuarding && NGS->lifeTimer_ms < lifeTime_ms){
+        NGS->lifeTimer_ms += timeDifference_ms;
+    }
+
+    if(IS_CANrxNew(NGS->CANrxNew)){
+        if(HBproducerTime_ms == 0U){
+            NGS->CANtxBuff->data[0] = (uint8_t)(NGS->NMT->operatingState | NGS->toggle);
+            if(CO_CANsend(NGS->CANdevTx, NGS->CANtxBuff) == CO_ERROR_NO){
+                NGS->toggle ^= 0x80U;
+            }
+        }
+
+        /* (re)start life time */
+        NGS->lifeGuarding = true;
+        NGS->lifeTimer_ms = 0U;
+        if(NGS->lifeTimeout){
+            NGS->lifeTimeout = false;
+            CO_errorReset(NGS->em, CO_EM_LIFE_GUARDING, 0U);
+        }
+        CLEAR_CANrxNew(NGS->CANrxNew);
+    }
+
+    /* verify life time */
+    if(NGS->lifeGuarding && lifeTime_ms != 0U){
+        if(NGS->lifeTimer_ms >= lifeTime_ms){
+            if(!NGS->lifeTimeout){
+                NGS->lifeTimeout = true;
+                CO_errorReport(NGS->em, CO_EM_LIFE_GUARDING, CO_EMC_HEARTBEAT, lifeTime_ms);
+            }
+        }
+        else if(timerNext_ms != NULL){
+            uint32_t diff = lifeTime_ms - NGS->lifeTimer_ms;
+            if(*timerNext_ms > diff){
+                *timerNext_ms = (uint16_t)diff;
+            }
+        }
+    }
+}
+#endif /* CO_NO_NG_SLAVE == 1 */
+
+
+#if CO_NO_NG_MASTER == 1
+
+#if (CO_NGM_WHEEL_SIZE & (CO_NGM_WHEEL_SIZE - 1U)) != 0U || CO_NGM_WHEEL_SIZE > 256U
+    #error CO_NGM_WHEEL_SIZE must be power of 2 and not above 256
+#endif
+
+/* Lists, in which node may be linked, see _list_ in CO_NGmasterNode_t */
+#define CO_NGM_LIST_NONE    0U
+#define CO_NGM_LIST_WHEEL   1U
+#define CO_NGM_LIST_TX      2U
+
+
+/*
+ * Read received guarding response or bootup of any node (CAN-ID 0x700 to
+ * 0x77F).
+ *
+ * Node-ID is queued for CO_NGmaster_process(), if it is not already waiting
+ * there. Heartbeats of monitored nodes are received by heartbeat consumer.
+ */
+static void CO_NGmaster_receive(void *object, const CO_CANrxMsg_t *msg){
+    CO_NGmaster_t *NGM;
+    CO_NGmasterNode_t *node;
+    uint8_t nodeId;
+
+    NGM = (CO_NGmaster_t*) object; /* this is the correct pointer type of the first argument */
+    nodeId = (uint8_t)(CO_CANrxMsg_readIdent(msg) & 0x7FU);
+    node = &NGM->nodes[nodeId];
+
+    /* verify node and message length */
+    if(nodeId != 0U && node->guardTime_ms != 0U && msg->DLC == 1U &&
+       !IS_CANrxNew(node->CANrxNew))
+    {
+        uint8_t head = NGM->rxQueueHead;
+
+        node->response = msg->data[0];
+#ifdef CO_CAN_RX_TIMESTAMP
+        node->responseTime_us = CO_CANrxMsg_readTimestamp(msg);
+#endif
+        SET_CANrxNew(node->CANrxNew);
+
+        /* queue the node, it is there only once */
+        NGM->rxQueue[head & (CO_NGM_NODE_ID_COUNT - 1U)] = nodeId;
+        CANrxMemoryBarrier();
+        NGM->rxQueueHead = (uint8_t)(head + 1U);
+    }
+}
+
+
+/* Inform application */
+static void CO_NGM_signal(CO_NGmaster_t *NGM, uint8_t nodeId, CO_NGmaster_event_t event){
+    if(NGM->pFunctSignal != NULL){
+        NGM->pFunctSignal(NGM->functSignalObject, nodeId, event, NGM->nodes[nodeId].state);
+    }
+}
+
+
+/* Current time in [microseconds], in time base of responseTime_us */
+static uint32_t CO_NGM_now_us(CO_NGmaster_t *NGM){
+#ifdef CO_CAN_RX_TIMESTAMP
+    (void)NGM;
+    return CO_CANtimestampNow();
+#else
+    return NGM->now_ms * 1000U;
+#endif
+}
+
+
+/* Insert node into timer wheel, request is due after guard time */
+static void CO_NGM_wheelInsert(CO_NGmaster_t *NGM, uint8_t nodeId){
+    CO_NGmasterNode_t *node = &NGM->nodes[nodeId];
+    uint32_t ticks = ((uint32_t)node->guardTime_ms + CO_NGM_TICK_MS - 1U) / CO_NGM_TICK_MS;
+    uint8_t *slot;
+
+    node->deadline = NGM->tick + ((ticks > 0U) ? ticks : 1U);
+    slot = &NGM->wheel[node->deadline & (CO_NGM_WHEEL_SIZE - 1U)];
+    node->list = CO_NGM_LIST_WHEEL;
+    node->prev = 0U;
+    node->next = *slot;
+    if(*slot != 0U){
+        NGM->nodes[*slot].prev = nodeId;
+    }
+    *slot = nodeId;
+}
+
+
+/* Remove node from timer wheel */
+static void CO_NGM_wheelRemove(CO_NGmaster_t *NGM, uint8_t nodeId){
+    CO_NGmasterNode_t *node = &NGM->nodes[nodeId];
+
+    if(node->prev != 0U){
+        NGM->nodes[node->prev].next = node->next;
+    }
+    else{
+        NGM->wheel[node->deadline & (CO_NGM_WHEEL_SIZE - 1U)] = node->next;
+    }
+    if(node->next != 0U){
+        NGM->nodes[node->next].prev = node->prev;
+    }
+    node->list = CO_NGM_LIST_NONE;
+}
+
+
+/* Append node to the end of transmit queue */
+static void CO_NGM_txAppend(CO_NGmaster_t *NGM, uint8_t nodeId){
+    CO_NGmasterNode_t *node = &NGM->nodes[nodeId];
+
+    node->list = CO_NGM_LIST_TX;
+    node->next = 0U;
+    if(NGM->txTail != 0U){
+        NGM->nodes[NGM->txTail].next = nodeId;
+    }
+    else{
+        NGM->txHead = nodeId;
+    }
+    NGM->txTail = nodeId;
+}
+
+
+/* Remove node from transmit queue. Used only for configuration, O(n). */
+static void CO_NGM_txRemove(CO_NGmaster_t *NGM, uint8_t nodeId){
+    uint8_t prev = 0U;
+    uint8_t id = NGM->txHead;
+
+    while(id != 0U && id != nodeId){
+        prev = id;
+        id = NGM->nodes[id].next;
+    }
+    if(id == 0U){
+        return;
+    }
+    if(prev != 0U){
+        NGM->nodes[prev].next = NGM->nodes[id].next;
+    }
+    else{
+        NGM->txHead = NGM->nodes[id].next;
+    }
+    if(NGM->txTail == id){
+        NGM->txTail = prev;
+    }
+    NGM->nodes[id].list = CO_NGM_LIST_NONE;
+}
+
+
+/* Node is lost or recovered, maintain emergency */
+static void CO_NGM_setLost(CO_NGmaster_t *NGM, uint8_t nodeId, bool_t lost){
+    CO_NGmasterNode_t *node = &NGM->nodes[nodeId];
+
+    if(lost && !node->lost){
+        node->lost = true;
+        node->state = CO_NGM_STATE_UNKNOWN;
+        NGM->lostCount++;
+        CO_errorReport(NGM->em, CO_EM_NODE_GUARDING, CO_EMC_HEARTBEAT, nodeId);
+    }
+    else if(!lost && node->lost){
+        node->lost = false;
+        NGM->lostCount--;
+        if(NGM->lostCount == 0U){
+            CO_errorReset(NGM->em, CO_EM_NODE_GUARDING, 0U);
+        }
+    }
+}
+
+
+/* Process received response or bootup */
+static void CO_NGM_response(CO_NGmaster_t *NGM, uint8_t nodeId){
+    CO_NGmasterNode_t *node = &NGM->nodes[nodeId];
+    uint8_t data = node->response;
+    uint8_t state;
+
+#ifndef CO_CAN_RX_TIMESTAMP
+    node->responseTime_us = CO_NGM_now_us(NGM);
+#endif
+    CLEAR_CANrxNew(node->CANrxNew);
+
+    if(node->guardTime_ms == 0U){
+        return;
+    }
+
+    /* bootup, node starts with toggle bit 0 again */
+    if(data == 0U){
+        node->toggle = 0U;
+        node->state = CO_NMT_INITIALIZING;
+        CO_NGM_signal(NGM, nodeId, CO_NGM_EVENT_BOOTUP);
+        return;
+    }
+
+    /* response to other master or late response, ignore */
+    if(!node->waiting){
+        return;
+    }
+    node->waiting = false;
+    node->missed = 0U;
+    node->responses++;
+
+    /* latency */
+    {
+        uint32_t latency = node->responseTime_us - node->requestTime_us;
+        uint32_t limit = CO_NGM_HIST_BASE_US;
+        uint8_t bin = 0U;
+
+        while(latency >= limit && bin < (CO_NGM_HIST_BINS - 1U)){
+            bin++;
+            limit <<= 1;
+        }
+        node->latencyHist[bin]++;
+        if(latency > node->latencyMax_us){
+            node->latencyMax_us = latency;
+        }
+    }
+
+    if((data & 0x80U) != node->toggle){
+        node->toggleErrors++;
+        CO_NGM_signal(NGM, nodeId, CO_NGM_EVENT_TOGGLE);
+    }
+    node->toggle = (uint8_t)((data & 0x80U) ^ 0x80U);
+
+    state = (uint8_t)(data & 0x7FU);
+    CO_NGM_setLost(NGM, nodeId, false);
+    if(state != node->state){
+        node->state = state;
+        CO_NGM_signal(NGM, nodeId, CO_NGM_EVENT_STATE);
+    }
+}
+
+
+/* Request of the node is due, verify previous response */
+static void CO_NGM_due(CO_NGmaster_t *NGM, uint8_t nodeId){
+    CO_NGmasterNode_t *node = &NGM->nodes[nodeId];
+
+    if(node->waiting){
+        node->timeouts++;
+        if(node->missed < 0xFFU){
+            node->missed++;
+        }
+        CO_NGM_signal(NGM, nodeId, CO_NGM_EVENT_TIMEOUT);
+
+        if(node->lifeTimeFactor != 0U && node->missed >= node->lifeTimeFactor && !node->lost){
+            CO_NGM_setLost(NGM, nodeId, true);
+            CO_NGM_signal(NGM, nodeId, CO_NGM_EVENT_LOST);
+        }
+    }
+
+    CO_NGM_txAppend(NGM, nodeId);
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_NGmaster_init(
+        CO_NGmaster_t          *NGM,
+        CO_EM_t                *em,
+        CO_CANmodule_t         *CANdevRx,
+        uint16_t                CANdevRxIdx,
+        CO_CANmodule_t         *CANdevTx,
+        uint16_t                CANdevTxIdx)
+{
+    CO_ReturnError_t ret;
+    uint16_t i;
+
+    /* verify arguments */
+    if(NGM==NULL || em==NULL || CANdevRx==NULL || CANdevTx==NULL){
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    /* Configure object variables */
+    CO_memset((uint8_t*)NGM, 0, (uint16_t)sizeof(CO_NGmaster_t));
+    NGM->em = em;
+    NGM->CANdevTx = CANdevTx;
+    NGM->CANdevTxIdx = CANdevTxIdx;
+    for(i=0U; i<CO_NGM_NODE_ID_COUNT; i++){
+        NGM->nodes[i].state = CO_NGM_STATE_UNKNOWN;
+    }
+
+    /* configure reception of all responses, CAN-ID 0x700 to 0x77F */
+    ret = CO_CANrxBufferInit(
+            CANdevRx,               /* CAN device */
+            CANdevRxIdx,            /* rx buffer index */
+            CO_CAN_ID_HEARTBEAT,    /* CAN identifier */
+            0x780,                  /* mask */
+            0,                      /* rtr */
+            (void*)NGM,             /* object passed to receive function */
+            CO_NGmaster_receive);   /* this function will process received message */
+
+    /* configure request transmission, CAN-ID is set for each request */
+    NGM->CANtxBuff = CO_CANtxBufferInit(
+            CANdevTx,               /* CAN device */
+            CANdevTxIdx,            /* index of specific buffer inside CAN module */
+            CO_CAN_ID_HEARTBEAT,    /* CAN identifier */
+            1,                      /* rtr */
+            1,                      /* number of data bytes */
+            0);                     /* synchronous message flag bit */
+
+    if(NGM->CANtxBuff == NULL){
+        ret = CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    return ret;
+}
+
+
+/******************************************************************************/
+void CO_NGmaster_initCallback(
+        CO_NGmaster_t          *NGM,
+        void                   *object,
+        void                  (*pFunctSignal)(void *object, uint8_t nodeId, CO_NGmaster_event_t event, uint8_t state))
+{
+    if(NGM != NULL){
+        NGM->functSignalObject = object;
+        NGM->pFunctSignal = pFunctSignal;
+    }
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_NGmaster_initNode(
+        CO_NGmaster_t          *NGM,
+        uint8_t                 nodeId,
+        uint16_t                guardTime_ms,
+        uint8_t                 lifeTimeFactor)
+{
+    CO_NGmasterNode_t *node;
+
+    if(NGM == NULL || nodeId == 0U || nodeId >= CO_NGM_NODE_ID_COUNT){
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+    node = &NGM->nodes[nodeId];
+
+    /* stop previous guarding */
+    if(node->list == CO_NGM_LIST_WHEEL){
+        CO_NGM_wheelRemove(NGM, nodeId);
+    }
+    else if(node->list == CO_NGM_LIST_TX){
+        CO_NGM_txRemove(NGM, nodeId);
+    }
+    if(node->guardTime_ms != 0U){
+        NGM->guardedCount--;
+    }
+    CO_NGM_setLost(NGM, nodeId, false);
+
+    node->guardTime_ms = guardTime_ms;
+    node->lifeTimeFactor = lifeTimeFactor;
+    node->state = CO_NGM_STATE_UNKNOWN;
+    node->toggle = 0U;
+    node->waiting = false;
+    node->missed = 0U;
+    CO_NGmaster_resetStats(NGM, nodeId);
+
+    /* first request with the next CO_NGmaster_process() */
+    if(guardTime_ms != 0U){
+        NGM->guardedCount++;
+        CO_NGM_txAppend(NGM, nodeId);
+    }
+
+    return CO_ERROR_NO;
+}
+
+
+/******************************************************************************/
+uint8_t CO_NGmaster_getState(
+        const CO_NGmaster_t    *NGM,
+        uint8_t                 nodeId)
+{
+    if(NGM == NULL || nodeId >= CO_NGM_NODE_ID_COUNT){
+        return CO_NGM_STATE_UNKNOWN;
+    }
+    return NGM->nodes[nodeId].state;
+}
+
+
+/******************************************************************************/
+void CO_NGmaster_resetStats(
+        CO_NGmaster_t          *NGM,
+        uint8_t                 nodeId)
+{
+    CO_NGmasterNode_t *node;
+    uint8_t i;
+
+    if(NGM == NULL || nodeId >= CO_NGM_NODE_ID_COUNT){
+        return;
+    }
+    node = &NGM->nodes[nodeId];
+    node->responses = 0U;
+    node->timeouts = 0U;
+    node->toggleErrors = 0U;
+    node->latencyMax_us = 0U;
+    for(i=0U; i<CO_NGM_HIST_BINS; i++){
+        node->latencyHist[i] = 0U;
+    }
+}
+
+
+/******************************************************************************/
+void CO_NGmaster_process(
+        CO_NGmaster_t          *NGM,
+        uint16_t                timeDifference_ms,
+        uint16_t               *timerNext_ms)
+{
+    uint32_t ticks;
+    uint32_t i;
+
+    NGM->now_ms += timeDifference_ms;
+
+    /* received responses, before timeouts are verified */
+    while(NGM->rxQueueTail != NGM->rxQueueHead){
+        uint8_t tail = NGM->rxQueueTail;
+        uint8_t nodeId;
+
+        CANrxMemoryBarrier();
+        nodeId = NGM->rxQueue[tail & (CO_NGM_NODE_ID_COUNT - 1U)];
+        NGM->rxQueueTail = (uint8_t)(tail + 1U);
+        CO_NGM_response(NGM, nodeId);
+    }
+
+    /* advance timer wheel, walk slots of elapsed ticks, each slot once */
+    ticks = ((uint32_t)NGM->tickTimer_ms + timeDifference_ms) / CO_NGM_TICK_MS;
+    NGM->tickTimer_ms = (uint16_t)(((uint32_t)NGM->tickTimer_ms + timeDifference_ms) % CO_NGM_TICK_MS);
+    for(i=0U; i<ticks && i<CO_NGM_WHEEL_SIZE; i++){
+        uint8_t nodeId = NGM->wheel[(NGM->tick + 1U + i) & (CO_NGM_WHEEL_SIZE - 1U)];
+
+        while(nodeId != 0U){
+            uint8_t next = NGM->nodes[nodeId].next;
+
+            /* nodes of later rounds stay in slot */
+            if((int32_t)(NGM->nodes[nodeId].deadline - (NGM->tick + ticks)) <= 0){
+                CO_NGM_wheelRemove(NGM, nodeId);
+                CO_NGM_due(NGM, nodeId);
+            }
+            nodeId = next;
+        }
+    }
+    NGM->tick += ticks;
+
+    /* send requests, while transmit buffer is free */
+    while(NGM->txHead != 0U && !NGM->CANtxBuff->bufferFull){
+        uint8_t nodeId = NGM->txHead;
+        CO_NGmasterNode_t *node = &NGM->nodes[nodeId];
+
+        NGM->txHead = node->next;
+        if(NGM->txHead == 0U){
+            NGM->txTail = 0U;
+        }
+
+        NGM->CANtxBuff = CO_CANtxBufferInit(
+                NGM->CANdevTx,
+                NGM->CANdevTxIdx,
+                CO_CAN_ID_HEARTBEAT + nodeId,
+                1,
+                1,
+                0);
+        node->waiting = true;
+        node->requestTime_us = CO_NGM_now_us(NGM);
+        (void)CO_CANsend(NGM->CANdevTx, NGM->CANtxBuff);
+        CO_NGM_wheelInsert(NGM, nodeId);
+    }
+
+    /* time to the next request */
+    if(timerNext_ms != NULL){
+        uint32_t diff = 0xFFFFU;
+
+        if(NGM->txHead != 0U){
+            /* wait for transmit buffer */
+            diff = 1U;
+        }
+        else if(NGM->guardedCount > 0U){
+            for(i=1U; i<=CO_NGM_WHEEL_SIZE; i++){
+                if(NGM->wheel[(NGM->tick + i) & (CO_NGM_WHEEL_SIZE - 1U)] != 0U){
+                    diff = i * CO_NGM_TICK_MS - NGM->tickTimer_ms;
+                    break;
+                }
+            }
+            if(i > CO_NGM_WHEEL_SIZE){
+                /* all nodes in later rounds */
+                diff = CO_NGM_WHEEL_SIZE * CO_NGM_TICK_MS - NGM->tickTimer_ms;
+            }
+        }
+        if(*timerNext_ms > diff){
+            *timerNext_ms = (uint16_t)diff;
+        }
+    }
+}
+#endif /* CO_NO_NG_MASTER == 1 */
+
+#endif /* CO_NO_NG_SLAVE == 1 || CO_NO_NG_MASTER == 1 */
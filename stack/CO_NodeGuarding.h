@@ -0,0 +1,382 @@
+/**
+ * CANopen Node guarding slave and master objects.
+ *
+ * @file        CO_NodeGuarding.h
+ * @ingroup     CO_NodeGuarding
+ * @copyright   2020
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef CO_NODE_GUARDING_H
+#define CO_NODE_GUARDING_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if CO_NO_NG_SLAVE == 1 || CO_NO_NG_MASTER == 1
+
+/**
+ * @defgroup CO_NodeGuarding Node guarding
+ * @ingroup CO_CANopen
+ * @{
+ *
+ * CANopen Node guarding and Life guarding protocol.
+ *
+ * Node guarding is older alternative to the heartbeat. Master sends remote
+ * transmit request (RTR) with CAN-ID 0x700 + node-ID to each guarded node
+ * every _guard time_. Node responds with one byte: NMT state in bits 0..6 and
+ * toggle bit in bit 7, which alternates with each response, starting with 0.
+ *
+ * Node guarding slave (CO_NO_NG_SLAVE) responds to the requests, if heartbeat
+ * producer is disabled. It uses _Guard time_ (index 0x100C) and _Life time
+ * factor_ (index 0x100D) from Object Dictionary. Life guarding starts with
+ * the first request. If next request is not received within _life time_
+ * (guard time * life time factor), slave reports #CO_EM_LIFE_GUARDING error,
+ * which is handled by _Error behavior_ (index 0x1029) as communication error.
+ *
+ * Node guarding master (CO_NO_NG_MASTER) guards up to 127 nodes, configured
+ * by CO_NGmaster_initNode(). Each node has own guard time and life time
+ * factor. If node does not respond before the next request, it is a node
+ * guarding event. After _life time factor_ consecutive events node is lost
+ * and #CO_EM_NODE_GUARDING error is reported.
+ *
+ * Master keeps all nodes in one table indexed by node-ID. Next requests are
+ * kept in one hashed timer wheel with #CO_NGM_WHEEL_SIZE slots of
+ * #CO_NGM_TICK_MS. CO_NGmaster_process() walks only slots of elapsed ticks
+ * and touches only nodes, which are due or which responded, so processing
+ * cost does not depend on number of guarded nodes. Requests are sent through
+ * one CAN transmit buffer, nodes which are due while buffer is busy wait in
+ * transmit queue.
+ *
+ * For each node master keeps histogram of response latency, time from the
+ * request to the response. If driver defines CO_CAN_RX_TIMESTAMP, latency is
+ * measured with CAN timestamps, otherwise with resolution of
+ * CO_NGmaster_process() calls.
+ */
+
+
+/**
+ * Life time of node guarding slave in [ms].
+ *
+ * @param guardTime_ms _Guard time_ from Object Dictionary (index 0x100C).
+ * @param lifeTimeFactor _Life time factor_ from Object Dictionary (index 0x100D).
+ */
+#define CO_NG_LIFE_TIME(guardTime_ms, lifeTimeFactor) ((uint32_t)(guardTime_ms) * (uint32_t)(lifeTimeFactor))
+
+
+#if CO_NO_NG_SLAVE == 1
+/**
+ * Node guarding slave object.
+ */
+typedef struct{
+    CO_EM_t            *em;             /**< From CO_NGslave_init() */
+    CO_NMT_t           *NMT;            /**< From CO_NGslave_init() */
+    CO_CANmodule_t     *CANdevTx;       /**< From CO_NGslave_init() */
+    CO_CANtx_t         *CANtxBuff;      /**< CAN transmit buffer */
+    volatile void      *CANrxNew;       /**< Set by receive function, if request was received */
+    uint8_t             toggle;         /**< Toggle bit of the next response, 0x00 or 0x80 */
+    bool_t              lifeGuarding;   /**< True, if request was received and life time is running */
+    bool_t              lifeTimeout;    /**< True, if #CO_EM_LIFE_GUARDING is reported */
+    uint32_t            lifeTimer_ms;   /**< Time since last request */
+    /** From CO_NGslave_initCallbackSignal() or NULL */
+    void              (*pFunctSignal)(void);
+}CO_NGslave_t;
+
+
+/**
+ * Initialize Node guarding slave object.
+ *
+ * Function must be called in the communication reset section, after
+ * CO_NMT_init().
+ *
+ * @param NGS This object will be initialized.
+ * @param em Emergency object.
+ * @param NMT NMT object, source of NMT state and node-ID.
+ * @param CANdevRx CAN device for guarding request reception.
+ * @param CANdevRxIdx Index of receive buffer in the above CAN device.
+ * @param CANdevTx CAN device for guarding response.
+ * @param CANdevTxIdx Index of transmit buffer in the above CAN device. It may
+ * be the same buffer as used by heartbeat producer, because response has the
+ * same CAN-ID and heartbeat and node guarding are not used together.
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO or CO_ERROR_ILLEGAL_ARGUMENT.
+ */
+CO_ReturnError_t CO_NGslave_init(
+        CO_NGslave_t           *NGS,
+        CO_EM_t                *em,
+        CO_NMT_t               *NMT,
+        CO_CANmodule_t         *CANdevRx,
+        uint16_t                CANdevRxIdx,
+        CO_CANmodule_t         *CANdevTx,
+        uint16_t                CANdevTxIdx);
+
+
+/**
+ * Initialize Node guarding slave callback function.
+ *
+ * Function initializes optional callback function, which should immediately
+ * start processing of CO_NGslave_process() function, so response is sent
+ * without delay. Callback is called from CAN receive function, when request
+ * is received.
+ *
+ * @param NGS This object.
+ * @param pFunctSignal Pointer to the callback function. Not called if NULL.
+ */
+void CO_NGslave_initCallbackSignal(
+        CO_NGslave_t           *NGS,
+        void                  (*pFunctSignal)(void));
+
+
+/**
+ * Process Node guarding slave object.
+ *
+ * Function must be called cyclically. It sends response to received request
+ * and verifies life time.
+ *
+ * @param NGS This object.
+ * @param guardTime_ms _Guard time_ from Object Dictionary (index 0x100C).
+ * @param lifeTimeFactor _Life time factor_ from Object Dictionary (index 0x100D).
+ * @param HBproducerTime_ms _Producer Heartbeat time_ from Object Dictionary
+ * (index 0x1017). If nonzero, requests are not responded.
+ * @param timeDifference_ms Time difference from previous function call in [milliseconds].
+ * @param timerNext_ms Return value - info to OS - see CO_process().
+ */
+void CO_NGslave_process(
+        CO_NGslave_t           *NGS,
+        uint16_t                guardTime_ms,
+        uint8_t                 lifeTimeFactor,
+        uint16_t                HBproducerTime_ms,
+        uint16_t                timeDifference_ms,
+        uint16_t               *timerNext_ms);
+#endif /* CO_NO_NG_SLAVE == 1 */
+
+
+#if CO_NO_NG_MASTER == 1
+/** Number of node-IDs in node table, node-ID 0 is not used */
+#define CO_NGM_NODE_ID_COUNT        128U
+
+/** State of the node is not known (no response yet or node lost) */
+#define CO_NGM_STATE_UNKNOWN        0xFFU
+
+/** Resolution of timer wheel in [ms] */
+#ifndef CO_NGM_TICK_MS
+#define CO_NGM_TICK_MS              10U
+#endif
+
+/** Number of slots in timer wheel, must be power of 2 and not above 256 */
+#ifndef CO_NGM_WHEEL_SIZE
+#define CO_NGM_WHEEL_SIZE           128U
+#endif
+
+/** Number of bins in latency histogram. Last bin counts all larger latencies. */
+#ifndef CO_NGM_HIST_BINS
+#define CO_NGM_HIST_BINS            10U
+#endif
+
+/** Upper limit of the first histogram bin in [microseconds]. Limit of each
+ * next bin is doubled. */
+#ifndef CO_NGM_HIST_BASE_US
+#define CO_NGM_HIST_BASE_US         500U
+#endif
+
+
+/**
+ * Events reported by Node guarding master callback.
+ */
+typedef enum{
+    CO_NGM_EVENT_STATE      = 0,    /**< NMT state from response changed, also first response or recovery */
+    CO_NGM_EVENT_BOOTUP     = 1,    /**< Bootup message received */
+    CO_NGM_EVENT_TOGGLE     = 2,    /**< Response with wrong toggle bit */
+    CO_NGM_EVENT_TIMEOUT    = 3,    /**< No response within guard time (node guarding event) */
+    CO_NGM_EVENT_LOST       = 4     /**< Life time elapsed, state is unknown now */
+}CO_NGmaster_event_t;
+
+
+/**
+ * One node in node table of CO_NGmaster_t.
+ */
+typedef struct{
+    uint16_t            guardTime_ms;   /**< Guard time, 0 if node is not guarded */
+    uint8_t             lifeTimeFactor; /**< Life time factor, 0 if node is never lost */
+    uint8_t             state;          /**< #CO_NMT_internalState_t from response or #CO_NGM_STATE_UNKNOWN */
+    uint8_t             toggle;         /**< Expected toggle bit of the next response, 0x00 or 0x80 */
+    bool_t              waiting;        /**< True, if request was sent and response was not received yet */
+    bool_t              lost;           /**< True, if node is lost */
+    uint8_t             missed;         /**< Number of consecutive requests without response */
+    uint8_t             list;           /**< Internal, list in which node is linked */
+    uint8_t             next;           /**< Internal, next node-ID in list, 0 for end */
+    uint8_t             prev;           /**< Internal, previous node-ID in wheel slot, 0 for first */
+    uint32_t            deadline;       /**< Internal, tick of the next request */
+    uint32_t            requestTime_us; /**< Time of the last request */
+    volatile uint32_t   responseTime_us;/**< Time of the last response, written by receive function */
+    volatile uint8_t    response;       /**< Data of the last response, written by receive function */
+    volatile void      *CANrxNew;       /**< Set by receive function, if node is in rxQueue */
+    uint32_t            responses;      /**< Number of received responses */
+    uint32_t            timeouts;       /**< Number of requests without response */
+    uint32_t            toggleErrors;   /**< Number of responses with wrong toggle bit */
+    uint32_t            latencyMax_us;  /**< Maximum response latency */
+    /** Histogram of response latency. Bin 0 counts latencies below
+     * #CO_NGM_HIST_BASE_US, upper limit of each next bin is doubled. */
+    uint32_t            latencyHist[CO_NGM_HIST_BINS];
+}CO_NGmasterNode_t;
+
+
+/**
+ * Node guarding master object.
+ */
+typedef struct{
+    CO_EM_t            *em;             /**< From CO_NGmaster_init() */
+    CO_CANmodule_t     *CANdevTx;       /**< From CO_NGmaster_init() */
+    uint16_t            CANdevTxIdx;    /**< From CO_NGmaster_init() */
+    CO_CANtx_t         *CANtxBuff;      /**< CAN transmit buffer */
+    /** Node table, indexed by node-ID */
+    CO_NGmasterNode_t   nodes[CO_NGM_NODE_ID_COUNT];
+    /** Timer wheel, first node-ID in each slot or 0 */
+    uint8_t             wheel[CO_NGM_WHEEL_SIZE];
+    uint32_t            tick;           /**< Current tick of timer wheel */
+    uint16_t            tickTimer_ms;   /**< Time since the current tick */
+    uint8_t             txHead;         /**< First node-ID in transmit queue or 0 */
+    uint8_t             txTail;         /**< Last node-ID in transmit queue or 0 */
+    /** Node-IDs with received response. Single producer (receive function),
+     * single consumer (CO_NGmaster_process()). */
+    uint8_t             rxQueue[CO_NGM_NODE_ID_COUNT];
+    volatile uint8_t    rxQueueHead;    /**< Written by receive function */
+    volatile uint8_t    rxQueueTail;    /**< Written by CO_NGmaster_process() */
+    uint32_t            now_ms;         /**< Sum of timeDifference_ms */
+    uint8_t             guardedCount;   /**< Number of guarded nodes */
+    uint8_t             lostCount;      /**< Number of lost nodes */
+    /** From CO_NGmaster_initCallback() or NULL */
+    void              (*pFunctSignal)(void *object, uint8_t nodeId, CO_NGmaster_event_t event, uint8_t state);
+    void               *functSignalObject;/**< Pointer to object */
+}CO_NGmaster_t;
+
+
+/**
+ * Initialize Node guarding master object.
+ *
+ * Function must be called in the communication reset section. Receive
+ * buffer receives all CAN-IDs 0x700 to 0x77F, so it must be after receive
+ * buffers of heartbeat consumer.
+ *
+ * @param NGM This object will be initialized.
+ * @param em Emergency object.
+ * @param CANdevRx CAN device for guarding response reception.
+ * @param CANdevRxIdx Index of receive buffer in the above CAN device.
+ * @param CANdevTx CAN device for guarding requests.
+ * @param CANdevTxIdx Index of transmit buffer in the above CAN device.
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO or CO_ERROR_ILLEGAL_ARGUMENT.
+ */
+CO_ReturnError_t CO_NGmaster_init(
+        CO_NGmaster_t          *NGM,
+        CO_EM_t                *em,
+        CO_CANmodule_t         *CANdevRx,
+        uint16_t                CANdevRxIdx,
+        CO_CANmodule_t         *CANdevTx,
+        uint16_t                CANdevTxIdx);
+
+
+/**
+ * Initialize Node guarding master callback function.
+ *
+ * Function initializes optional callback function, which is called for
+ * #CO_NGmaster_event_t of each node. It is called from CO_NGmaster_process(),
+ * _state_ is the new state of the node from the node table.
+ *
+ * @param NGM This object.
+ * @param object Pointer to object, which will be passed to pFunctSignal(). Can be NULL
+ * @param pFunctSignal Pointer to the callback function. Not called if NULL.
+ */
+void CO_NGmaster_initCallback(
+        CO_NGmaster_t          *NGM,
+        void                   *object,
+        void                  (*pFunctSignal)(void *object, uint8_t nodeId, CO_NGmaster_event_t event, uint8_t state));
+
+
+/**
+ * Start or stop guarding of the node.
+ *
+ * First request is sent with the next CO_NGmaster_process(). Statistics of
+ * the node are cleared. Configuration of all nodes is cleared by
+ * CO_NGmaster_init(), so it must be repeated after communication reset.
+ *
+ * @param NGM This object.
+ * @param nodeId Node-ID (1..127).
+ * @param guardTime_ms Guard time, 0 stops guarding.
+ * @param lifeTimeFactor Life time factor. If 0, node is never lost.
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO or CO_ERROR_ILLEGAL_ARGUMENT.
+ */
+CO_ReturnError_t CO_NGmaster_initNode(
+        CO_NGmaster_t          *NGM,
+        uint8_t                 nodeId,
+        uint16_t                guardTime_ms,
+        uint8_t                 lifeTimeFactor);
+
+
+/**
+ * Get NMT state of the node from node table.
+ *
+ * @param NGM This object.
+ * @param nodeId Node-ID.
+ *
+ * @return #CO_NMT_internalState_t or #CO_NGM_STATE_UNKNOWN.
+ */
+uint8_t CO_NGmaster_getState(
+        const CO_NGmaster_t    *NGM,
+        uint8_t                 nodeId);
+
+
+/**
+ * Clear statistics and latency histogram of the node.
+ *
+ * @param NGM This object.
+ * @param nodeId Node-ID.
+ */
+void CO_NGmaster_resetStats(
+        CO_NGmaster_t          *NGM,
+        uint8_t                 nodeId);
+
+
+/**
+ * Process Node guarding master object.
+ *
+ * Function must be called cyclically. It processes received responses, sends
+ * requests, which are due, and detects missing responses.
+ *
+ * @param NGM This object.
+ * @param timeDifference_ms Time difference from previous function call in [milliseconds].
+ * @param timerNext_ms Return value - info to OS - see CO_process().
+ */
+void CO_NGmaster_process(
+        CO_NGmaster_t          *NGM,
+        uint16_t                timeDifference_ms,
+        uint16_t               *timerNext_ms);
+#endif /* CO_NO_NG_MASTER == 1 */
+
+/** @} */
+
+#endif /* CO_NO_NG_SLAVE == 1 || CO_NO_NG_MASTER == 1 */
+
+#ifdef __cplusplus
+}
+#endif /*__cplusplus*/
+
+#endif
@@ -59,6 +59,9 @@ static void CO_PDO_receive(void *object, const CO_CANrxMsg_t *msg){
             RPDO->CANrxData[1][5] = msg->data[5];
             RPDO->CANrxData[1][6] = msg->data[6];
             RPDO->CANrxData[1][7] = msg->data[7];
+#ifdef CO_CAN_RX_TIMESTAMP
+            RPDO->CANrxTimestamp[1] = CO_CANrxMsg_readTimestamp(msg);
+#endif
 
             SET_CANrxNew(RPDO->CANrxNew[1]);
         }
@@ -72,6 +75,9 @@ static void CO_PDO_receive(void *object, const CO_CANrxMsg_t *msg){
             RPDO->CANrxData[0][5] = msg->data[5];
             RPDO->CANrxData[0][6] = msg->data[6];
             RPDO->CANrxData[0][7] = msg->data[7];
+#ifdef CO_CAN_RX_TIMESTAMP
+            RPDO->CANrxTimestamp[0] = CO_CANrxMsg_readTimestamp(msg);
+#endif
 
             SET_CANrxNew(RPDO->CANrxNew[0]);
         }
@@ -804,6 +810,8 @@ CO_ReturnError_t CO_TPDO_init(
     TPDO->CANdevTx = CANdevTx;
     TPDO->CANdevTxIdx = CANdevTxIdx;
     TPDO->syncCounter = 255;
+    TPDO->schedule = false;
+    TPDO->schedState = 0U;
     TPDO->inhibitTimer = 0;
     TPDO->eventTimer = ((uint32_t) TPDOCommPar->eventTimer) * 1000;
     if(TPDOCommPar->transmissionType>=254) TPDO->sendRequest = 1;
@@ -931,6 +939,9 @@ void CO_RPDO_process(CO_RPDO_t *RPDO, bool_t syncWas){
             for(; i>0; i--) {
                 **(ppODdataByte++) = *(pPDOdataByte++);
             }
+#ifdef CO_CAN_RX_TIMESTAMP
+            RPDO->timestamp = RPDO->CANrxTimestamp[bufNo];
+#endif
 #if defined(RPDO_CALLS_EXTENSION)
             update = true;
 #endif /* defined(RPDO_CALLS_EXTENSION) */
@@ -968,6 +979,19 @@ void CO_RPDO_process(CO_RPDO_t *RPDO, bool_t syncWas){
 }
 
 
+/*
+ * Send synchronous TPDO or leave it to the scheduler, see CO_TPDOsched_init().
+ */
+static void CO_TPDOsendSync(CO_TPDO_t *TPDO){
+    if(TPDO->schedule){
+        TPDO->schedState = 1U;
+    }
+    else{
+        CO_TPDOsend(TPDO);
+    }
+}
+
+
 /******************************************************************************/
 void CO_TPDO_process(
         CO_TPDO_t              *TPDO,
@@ -991,7 +1015,7 @@ void CO_TPDO_process(
         else if(TPDO->SYNC && syncWas){
             /* send synchronous acyclic PDO */
             if(TPDO->TPDOCommPar->transmissionType == 0){
-                if(TPDO->sendRequest) CO_TPDOsend(TPDO);
+                if(TPDO->sendRequest) CO_TPDOsendSync(TPDO);
             }
             /* send synchronous cyclic PDO */
             else{
@@ -1006,13 +1030,13 @@ void CO_TPDO_process(
                 if(TPDO->syncCounter == 254){
                     if(TPDO->SYNC->counter == TPDO->TPDOCommPar->SYNCStartValue){
                         TPDO->syncCounter = TPDO->TPDOCommPar->transmissionType;
-                        CO_TPDOsend(TPDO);
+                        CO_TPDOsendSync(TPDO);
                     }
                 }
                 /* Send PDO after every N-th Sync */
                 else if(--TPDO->syncCounter == 0){
                     TPDO->syncCounter = TPDO->TPDOCommPar->transmissionType;
-                    CO_TPDOsend(TPDO);
+                    CO_TPDOsendSync(TPDO);
                 }
             }
         }
@@ -1028,3 +1052,194 @@ void CO_TPDO_process(
     TPDO->inhibitTimer = (TPDO->inhibitTimer > timeDifference_us) ? (TPDO->inhibitTimer - timeDifference_us) : 0;
     TPDO->eventTimer = (TPDO->eventTimer > timeDifference_us) ? (TPDO->eventTimer - timeDifference_us) : 0;
 }
+
+
+#ifdef CO_TPDO_SCHEDULER
+/******************************************************************************/
+CO_ReturnError_t CO_TPDOsched_init(
+        CO_TPDOsched_t         *sched,
+        CO_TPDO_t              *TPDO[],
+        uint16_t                TPDOcount,
+        CO_SYNC_t              *SYNC,
+        uint16_t                CANbitRate)
+{
+    uint16_t i;
+
+    /* verify arguments */
+    if(sched==NULL || (TPDO==NULL && TPDOcount>0U) || SYNC==NULL){
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    /* without bit rate TPDOs are sent by CO_TPDO_process() */
+    if(CANbitRate == 0U){
+        TPDOcount = 0U;
+    }
+
+    sched->TPDO = TPDO;
+    sched->TPDOcount = TPDOcount;
+    sched->SYNC = SYNC;
+    sched->CANbitRate = CANbitRate;
+    sched->pending = 0U;
+    sched->predicted_us = 0U;
+    sched->windowLength_us = 0U;
+    CO_TPDOsched_getStats(sched, NULL, true);
+
+    for(i=0U; i<TPDOcount; i++){
+        TPDO[i]->schedule = true;
+        TPDO[i]->schedState = 0U;
+    }
+
+    return CO_ERROR_NO;
+}
+
+
+/******************************************************************************/
+uint32_t CO_TPDOsched_frameTime(uint16_t CANbitRate, uint8_t DLC){
+    uint32_t bits = 55U + 10U * (uint32_t)DLC;
+
+    return (bits * 1000U + CANbitRate - 1U) / CANbitRate;
+}
+
+
+/*
+ * Send TPDO from scheduler and add its frame time to the prediction.
+ */
+static void CO_TPDOsched_send(CO_TPDOsched_t *sched, CO_TPDO_t *TPDO, uint32_t frameTime){
+    if(CO_TPDOsend(TPDO) == CO_ERROR_NO){
+        TPDO->schedState = 2U;
+        sched->pending++;
+        sched->predicted_us += frameTime;
+    }
+    else{
+        TPDO->schedState = 0U;
+    }
+}
+
+
+/******************************************************************************/
+void CO_TPDOsched_process(
+        CO_TPDOsched_t         *sched,
+        bool_t                  syncWas,
+        uint32_t                ObjDict_synchronousWindowLength)
+{
+    uint16_t i;
+
+    if(syncWas){
+        CO_SYNC_t *SYNC = sched->SYNC;
+        uint16_t due = 0U;
+
+        /* TPDOs from previous cycle, which are still waiting, are deleted
+         * at the end of the window, see CO_CANclearPendingSyncPDOs() */
+        for(i=0U; i<sched->TPDOcount; i++){
+            CO_TPDO_t *TPDO = sched->TPDO[i];
+
+            if(TPDO->schedState == 1U){
+                due++;
+            }
+            else{
+                TPDO->schedState = 0U;
+            }
+        }
+        sched->pending = 0U;
+        if(due == 0U){
+            return;
+        }
+
+        /* SYNC age and SYNC message itself, if sent by this node */
+        sched->predicted_us = SYNC->timer;
+        if(SYNC->isProducer){
+            sched->predicted_us += CO_TPDOsched_frameTime(sched->CANbitRate,
+                                        (SYNC->counterOverflowValue != 0U) ? 1U : 0U);
+        }
+        sched->windowLength_us = ObjDict_synchronousWindowLength;
+
+        /* send all due TPDOs in order of CAN identifier */
+        for(;;){
+            CO_TPDO_t *next = NULL;
+
+            for(i=0U; i<sched->TPDOcount; i++){
+                CO_TPDO_t *TPDO = sched->TPDO[i];
+
+                if(TPDO->schedState == 1U && (next == NULL ||
+                   (TPDO->TPDOCommPar->COB_IDUsedByTPDO & 0x7FFU) <
+                   (next->TPDOCommPar->COB_IDUsedByTPDO & 0x7FFU)))
+                {
+                    next = TPDO;
+                }
+            }
+            if(next == NULL){
+                break;
+            }
+            CO_TPDOsched_send(sched, next, CO_TPDOsched_frameTime(sched->CANbitRate, next->dataLength));
+        }
+
+        sched->stats.cycles++;
+        sched->stats.predicted_us = sched->predicted_us;
+        if(sched->predicted_us > sched->stats.predictedMax_us){
+            sched->stats.predictedMax_us = sched->predicted_us;
+        }
+        if(ObjDict_synchronousWindowLength != 0U &&
+           sched->predicted_us > ObjDict_synchronousWindowLength)
+        {
+            sched->stats.predictedOverruns++;
+        }
+    }
+
+    /* measure, when the last TPDO left transmit buffer */
+    if(sched->pending > 0U){
+        uint16_t pending = 0U;
+        uint32_t frameTime = 0U;
+
+        for(i=0U; i<sched->TPDOcount; i++){
+            CO_TPDO_t *TPDO = sched->TPDO[i];
+
+            if(TPDO->schedState == 2U){
+                if(TPDO->CANtxBuff->bufferFull){
+                    pending++;
+                }
+                else{
+                    TPDO->schedState = 0U;
+                    frameTime = CO_TPDOsched_frameTime(sched->CANbitRate, TPDO->dataLength);
+                }
+            }
+        }
+
+        if(pending == 0U){
+            uint32_t actual = sched->SYNC->timer + frameTime;
+
+            sched->stats.actual_us = actual;
+            if(actual > sched->stats.actualMax_us){
+                sched->stats.actualMax_us = actual;
+            }
+            if(sched->windowLength_us != 0U && actual > sched->windowLength_us){
+                sched->stats.overruns++;
+            }
+        }
+        sched->pending = pending;
+    }
+}
+
+
+/******************************************************************************/
+void CO_TPDOsched_getStats(
+        CO_TPDOsched_t         *sched,
+        CO_TPDOschedStats_t    *stats,
+        bool_t                  reset)
+{
+    if(sched == NULL){
+        return;
+    }
+    if(stats != NULL){
+        *stats = sched->stats;
+    }
+    if(reset){
+        sched->stats.cycles = 0U;
+        sched->stats.predicted_us = 0U;
+        sched->stats.predictedMax_us = 0U;
+        sched->stats.actual_us = 0U;
+        sched->stats.actualMax_us = 0U;
+        sched->stats.predictedOverruns = 0U;
+        sched->stats.overruns = 0U;
+    }
+}
+#endif /* CO_TPDO_SCHEDULER */
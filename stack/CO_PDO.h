@@ -57,6 +57,10 @@ extern "C" {
  *  - Function CO_TPDO_process() (called by application) sends TPDO if
  *    necessary. There are possible different transmission types, including
  *    automatic detection of Change of State of specific variable.
+ *  - If CO_TPDO_SCHEDULER is defined, synchronous TPDOs are sent by
+ *    scheduler, see CO_TPDOsched_init(). It sends them in order of CAN
+ *    identifier and reports their bus time against the _Synchronous window
+ *    length_ (index 0x1007).
  */
 
 
@@ -184,6 +188,14 @@ typedef struct{
     volatile void      *CANrxNew[2];
     /** 8 data bytes of the received message. */
     uint8_t             CANrxData[2][8];
+#if defined(CO_CAN_RX_TIMESTAMP) || defined(CO_DOXYGEN)
+    /** Reception times of the messages in CANrxData */
+    uint32_t            CANrxTimestamp[2];
+    /** Reception time of the data, last copied to Object Dictionary by
+    CO_RPDO_process(), see CO_CANrxMsg_readTimestamp(). Age of the mapped
+    variables is `CO_CANtimestampNow() - timestamp`. */
+    uint32_t            timestamp;
+#endif
     CO_CANmodule_t     *CANdevRx;       /**< From CO_RPDO_init() */
     uint16_t            CANdevRxIdx;    /**< From CO_RPDO_init() */
 }CO_RPDO_t;
@@ -223,6 +235,11 @@ typedef struct{
     CO_CANmodule_t     *CANdevTx;       /**< From CO_TPDO_init() */
     CO_CANtx_t         *CANtxBuff;      /**< CAN transmit buffer inside CANdev */
     uint16_t            CANdevTxIdx;    /**< From CO_TPDO_init() */
+    /** True, if synchronous TPDO is sent by CO_TPDOsched_process() */
+    bool_t              schedule;
+    /** State inside scheduler: 0 - idle, 1 - due after SYNC, 2 - sent,
+    waiting in transmit buffer */
+    uint8_t             schedState;
 }CO_TPDO_t;
 
 
@@ -379,6 +396,120 @@ void CO_TPDO_process(
         bool_t                  syncWas,
         uint32_t                timeDifference_us);
 
+
+#if defined(CO_TPDO_SCHEDULER) || defined(CO_DOXYGEN)
+/**
+ * Statistics of synchronous TPDO scheduler, see CO_TPDOsched_getStats().
+ *
+ * Times are measured from SYNC. Predicted time is the end of the last
+ * scheduled TPDO on the bus, calculated from worst case frame length. Actual
+ * time is the moment, when the last scheduled TPDO left the transmit buffer,
+ * plus its frame time. It is measured by CO_TPDOsched_process(), so its
+ * resolution is the interval of the calls.
+ */
+typedef struct{
+    uint32_t            cycles;         /**< Number of SYNC cycles with synchronous TPDOs */
+    uint32_t            predicted_us;   /**< Predicted window usage in the last cycle */
+    uint32_t            predictedMax_us;/**< Maximum of predicted_us */
+    uint32_t            actual_us;      /**< Actual window usage in the last cycle */
+    uint32_t            actualMax_us;   /**< Maximum of actual_us */
+    uint32_t            predictedOverruns;/**< Number of cycles, where predicted usage exceeded window */
+    uint32_t            overruns;       /**< Number of cycles, where actual usage exceeded window */
+}CO_TPDOschedStats_t;
+
+
+/**
+ * Scheduler for synchronous TPDOs.
+ */
+typedef struct{
+    CO_TPDO_t         **TPDO;           /**< From CO_TPDOsched_init() */
+    uint16_t            TPDOcount;      /**< From CO_TPDOsched_init() */
+    CO_SYNC_t          *SYNC;           /**< From CO_TPDOsched_init() */
+    uint16_t            CANbitRate;     /**< From CO_TPDOsched_init() */
+    uint16_t            pending;        /**< Number of sent TPDOs, still in transmit buffers */
+    uint32_t            predicted_us;   /**< Predicted usage of the current cycle */
+    uint32_t            windowLength_us;/**< Window length of the current cycle */
+    CO_TPDOschedStats_t stats;          /**< See CO_TPDOsched_getStats() */
+}CO_TPDOsched_t;
+
+
+/**
+ * Initialize scheduler for synchronous TPDOs.
+ *
+ * Function must be called in the communication reset section, after
+ * CO_TPDO_init() for all TPDOs. From then synchronous TPDOs are not sent by
+ * CO_TPDO_process(), but by CO_TPDOsched_process().
+ *
+ * Scheduler is available, if CO_TPDO_SCHEDULER is defined.
+ *
+ * After SYNC, all due TPDOs are sent in order of CAN identifier (bus
+ * priority). Scheduler predicts their bus time from data length and bit rate
+ * (worst case bit stuffing, 55 + 10 * DLC bits for 11-bit identifier). SYNC,
+ * if it is sent by this node, is included. Prediction is only reported, if it
+ * exceeds the synchronous window, see #CO_TPDOschedStats_t. No TPDO is held
+ * back because of it, as worst case is rarely reached. TPDOs, which are still
+ * in transmit buffer after the window, are deleted by
+ * CO_CANclearPendingSyncPDOs(). Messages of other nodes inside the window are
+ * not known and not considered.
+ *
+ * @param sched This object will be initialized.
+ * @param TPDO Array of TPDO objects.
+ * @param TPDOcount Number of TPDO objects in array.
+ * @param SYNC SYNC object.
+ * @param CANbitRate CAN bit rate in [kbit/s]. If 0 (bit rate is not known,
+ * for example it is configured outside of the driver), scheduler is disabled.
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO or CO_ERROR_ILLEGAL_ARGUMENT.
+ */
+CO_ReturnError_t CO_TPDOsched_init(
+        CO_TPDOsched_t         *sched,
+        CO_TPDO_t              *TPDO[],
+        uint16_t                TPDOcount,
+        CO_SYNC_t              *SYNC,
+        uint16_t                CANbitRate);
+
+
+/**
+ * Get bus time of CAN message.
+ *
+ * @param CANbitRate CAN bit rate in [kbit/s].
+ * @param DLC Data length.
+ *
+ * @return Worst case time of standard CAN frame including interframe space
+ * in [microseconds], rounded up.
+ */
+uint32_t CO_TPDOsched_frameTime(uint16_t CANbitRate, uint8_t DLC);
+
+
+/**
+ * Process scheduler for synchronous TPDOs.
+ *
+ * Function must be called cyclically, after CO_TPDO_process() for all TPDOs.
+ *
+ * @param sched This object.
+ * @param syncWas True, if CANopen SYNC message was just received or transmitted.
+ * @param ObjDict_synchronousWindowLength _Synchronous window length_ variable from
+ * Object dictionary (index 0x1007). If 0, predicted overruns are not counted.
+ */
+void CO_TPDOsched_process(
+        CO_TPDOsched_t         *sched,
+        bool_t                  syncWas,
+        uint32_t                ObjDict_synchronousWindowLength);
+
+
+/**
+ * Get statistics of synchronous TPDO scheduler.
+ *
+ * @param sched This object.
+ * @param stats Statistics are copied here, see #CO_TPDOschedStats_t.
+ * @param reset If true, statistics are cleared after copy.
+ */
+void CO_TPDOsched_getStats(
+        CO_TPDOsched_t         *sched,
+        CO_TPDOschedStats_t    *stats,
+        bool_t                  reset);
+#endif /* CO_TPDO_SCHEDULER */
+
 #ifdef __cplusplus
 }
 #endif /*__cplusplus*/
@@ -0,0 +1,125 @@
+/*
+ * Queue for received CAN messages.
+ *
+ * @file        CO_RXqueue.c
+ * @ingroup     CO_RXqueue
+ * @copyright   2020
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "CO_driver.h"
+#include "CO_RXqueue.h"
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_RXqueue_init(
+        CO_RXqueue_t           *RXqueue,
+        CO_RXqueueFrame_t       frames[],
+        uint16_t                size)
+{
+    /* verify arguments */
+    if(RXqueue==NULL || frames==NULL || size<2U || size>0x8000U || (size & (size-1U))!=0U){
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    RXqueue->frames = frames;
+    RXqueue->mask = size - 1U;
+    RXqueue->head = 0U;
+    RXqueue->tail = 0U;
+    RXqueue->maxOccupancy = 0U;
+    RXqueue->received = 0U;
+    RXqueue->overflow = 0U;
+
+    return CO_ERROR_NO;
+}
+
+
+/******************************************************************************/
+bool_t CO_RXqueue_push(CO_RXqueue_t *RXqueue, const uint8_t data[]){
+    uint16_t head = RXqueue->head;
+    uint16_t occupancy = (uint16_t)(head - RXqueue->tail);
+    uint8_t *dest;
+
+    if(occupancy > RXqueue->mask){
+        RXqueue->overflow++;
+        return false;
+    }
+
+    dest = RXqueue->frames[head & RXqueue->mask].data;
+    dest[0] = data[0];
+    dest[1] = data[1];
+    dest[2] = data[2];
+    dest[3] = data[3];
+    dest[4] = data[4];
+    dest[5] = data[5];
+    dest[6] = data[6];
+    dest[7] = data[7];
+
+    /* frame must be written, before it is visible to consumer */
+    CANrxMemoryBarrier();
+    RXqueue->head = head + 1U;
+
+    RXqueue->received++;
+    if(occupancy >= RXqueue->maxOccupancy){
+        RXqueue->maxOccupancy = occupancy + 1U;
+    }
+
+    return true;
+}
+
+
+/******************************************************************************/
+bool_t CO_RXqueue_pop(CO_RXqueue_t *RXqueue, uint8_t data[]){
+    uint16_t tail = RXqueue->tail;
+    const uint8_t *src;
+
+    if(tail == RXqueue->head){
+        return false;
+    }
+
+    /* read head, before frame is read */
+    CANrxMemoryBarrier();
+    src = RXqueue->frames[tail & RXqueue->mask].data;
+    data[0] = src[0];
+    data[1] = src[1];
+    data[2] = src[2];
+    data[3] = src[3];
+    data[4] = src[4];
+    data[5] = src[5];
+    data[6] = src[6];
+    data[7] = src[7];
+
+    /* frame must be read, before producer may overwrite it */
+    CANrxMemoryBarrier();
+    RXqueue->tail = tail + 1U;
+
+    return true;
+}
+
+
+/******************************************************************************/
+void CO_RXqueue_flush(CO_RXqueue_t *RXqueue){
+    RXqueue->tail = RXqueue->head;
+}
+
+
+/******************************************************************************/
+uint16_t CO_RXqueue_occupancy(const CO_RXqueue_t *RXqueue){
+    return (uint16_t)(RXqueue->head - RXqueue->tail);
+}
@@ -0,0 +1,155 @@
+/**
+ * Queue for received CAN messages.
+ *
+ * @file        CO_RXqueue.h
+ * @ingroup     CO_RXqueue
+ * @copyright   2020
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef CO_RX_QUEUE_H
+#define CO_RX_QUEUE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @defgroup CO_RXqueue RX queue
+ * @ingroup CO_CANopen
+ * @{
+ *
+ * Lock-free queue for received CAN messages.
+ *
+ * Most CANopen objects copy received message into single CANrxData buffer and
+ * set CANrxNew flag. If next message arrives before the previous one is
+ * processed by mainline, it is lost. Objects, which must handle bursts of
+ * messages (SDO server, SDO client, LSS master) put received messages into
+ * this queue instead. Mainline then moves them one by one into CANrxData.
+ *
+ * Queue is single producer, single consumer. Producer is CAN receive
+ * function (interrupt or receive thread), which calls CO_RXqueue_push().
+ * Consumer is mainline, which calls CO_RXqueue_pop() and CO_RXqueue_flush().
+ * Each index is written only by one side, so no locking is necessary.
+ * Ordering of memory accesses is assured with CANrxMemoryBarrier() from
+ * CO_driver_target.h.
+ */
+
+
+/**
+ * Data of one queued CAN message. Services which use the queue accept
+ * only messages with 8 data bytes.
+ */
+typedef struct{
+    uint8_t             data[8];        /**< CAN message data */
+}CO_RXqueueFrame_t;
+
+
+/**
+ * RX queue object.
+ */
+typedef struct{
+    /** Buffer for frames, from CO_RXqueue_init() */
+    CO_RXqueueFrame_t  *frames;
+    /** Size of the buffer minus one, size is power of two */
+    uint16_t            mask;
+    /** Free running counter of written frames, changed only by producer */
+    volatile uint16_t   head;
+    /** Free running counter of read frames, changed only by consumer */
+    volatile uint16_t   tail;
+    /** Highest number of frames in queue since initialization (informative) */
+    uint16_t            maxOccupancy;
+    /** Number of frames, accepted into queue (informative) */
+    uint32_t            received;
+    /** Number of frames, lost because queue was full (informative) */
+    uint32_t            overflow;
+}CO_RXqueue_t;
+
+
+/**
+ * Initialize RX queue object.
+ *
+ * Function must be called in the communication reset section, before CAN
+ * receive buffer, which pushes into queue, is initialized.
+ *
+ * @param RXqueue This object will be initialized.
+ * @param frames Buffer for frames.
+ * @param size Number of frames in buffer. Must be power of two, 2 to 32768.
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO or CO_ERROR_ILLEGAL_ARGUMENT.
+ */
+CO_ReturnError_t CO_RXqueue_init(
+        CO_RXqueue_t           *RXqueue,
+        CO_RXqueueFrame_t       frames[],
+        uint16_t                size);
+
+
+/**
+ * Put received message into queue.
+ *
+ * Function is called by producer (from CAN receive function).
+ *
+ * @param RXqueue This object.
+ * @param data 8 data bytes of received CAN message.
+ *
+ * @return True, if message was queued, false if queue was full.
+ */
+bool_t CO_RXqueue_push(CO_RXqueue_t *RXqueue, const uint8_t data[]);
+
+
+/**
+ * Take the oldest message from queue.
+ *
+ * Function is called by consumer (from mainline).
+ *
+ * @param RXqueue This object.
+ * @param data Buffer for 8 data bytes of message.
+ *
+ * @return True, if message was copied to data, false if queue was empty.
+ */
+bool_t CO_RXqueue_pop(CO_RXqueue_t *RXqueue, uint8_t data[]);
+
+
+/**
+ * Discard all messages in queue.
+ *
+ * Function is called by consumer (from mainline), for example before new
+ * request is sent, so stale responses are not processed.
+ *
+ * @param RXqueue This object.
+ */
+void CO_RXqueue_flush(CO_RXqueue_t *RXqueue);
+
+
+/**
+ * Get number of messages in queue.
+ *
+ * @param RXqueue This object.
+ *
+ * @return Number of messages, which are waiting for consumer.
+ */
+uint16_t CO_RXqueue_occupancy(const CO_RXqueue_t *RXqueue);
+
+
+#ifdef __cplusplus
+}
+#endif /*__cplusplus*/
+
+/** @} */
+#endif
@@ -180,27 +180,22 @@ static void CO_SDO_receive(void *object, const CO_CANrxMsg_t *msg){
 
     SDO = (CO_SDO_t*)object;   /* this is the correct pointer type of the first argument */
 
-    /* WARNING: When doing a SDO block upload and immediately after that
-     * starting another SDO request, this request is dropped. Especially if
+    /* Messages are queued, so request, which immediately follows previous
+     * one (for example after SDO block upload), is not dropped, if
      * processing function has slow response.
      * See: https://github.com/CANopenNode/CANopenNode/issues/39 */
 
-    /* verify message length and message overflow (previous message was not processed yet) */
-    if((msg->DLC == 8U) && (!IS_CANrxNew(SDO->CANrxNew))){
+    /* verify message length */
+    if(msg->DLC == 8U){
         if(SDO->state != CO_SDO_ST_DOWNLOAD_BL_SUBBLOCK) {
-            /* copy data and set 'new message' flag */
-            SDO->CANrxData[0] = msg->data[0];
-            SDO->CANrxData[1] = msg->data[1];
-            SDO->CANrxData[2] = msg->data[2];
-            SDO->CANrxData[3] = msg->data[3];
-            SDO->CANrxData[4] = msg->data[4];
-            SDO->CANrxData[5] = msg->data[5];
-            SDO->CANrxData[6] = msg->data[6];
-            SDO->CANrxData[7] = msg->data[7];
-
-            SET_CANrxNew(SDO->CANrxNew);
+            /* CO_SDO_process() will copy data to CANrxData */
+            if(CO_RXqueue_push(&SDO->RXqueue, msg->data) && SDO->pFunctSignal != NULL) {
+                /* Optional signal to RTOS, which can resume task, which handles SDO server. */
+                SDO->pFunctSignal();
+            }
         }
-        else {
+        /* verify message overflow (previous message was not processed yet) */
+        else if(!IS_CANrxNew(SDO->CANrxNew)) {
             /* block download, copy data directly */
             uint8_t seqno;
 
@@ -243,11 +238,11 @@ static void CO_SDO_receive(void *object, const CO_CANrxMsg_t *msg){
                 SDO->state = CO_SDO_ST_DOWNLOAD_BL_SUB_RESP_2;
                 SET_CANrxNew(SDO->CANrxNew);
             }
-        }
 
-        /* Optional signal to RTOS, which can resume task, which handles SDO server. */
-        if(IS_CANrxNew(SDO->CANrxNew) && SDO->pFunctSignal != NULL) {
-            SDO->pFunctSignal();
+            /* Optional signal to RTOS, which can resume task, which handles SDO server. */
+            if(IS_CANrxNew(SDO->CANrxNew) && SDO->pFunctSignal != NULL) {
+                SDO->pFunctSignal();
+            }
         }
     }
 }
@@ -313,6 +308,10 @@ CO_ReturnError_t CO_SDO_init(
             SDO->ODExtensions[i].object = NULL;
             SDO->ODExtensions[i].flags = NULL;
         }
+        SDO->ext1003.pODFunc = NULL;
+        SDO->ext1003.object = NULL;
+        SDO->ext1003.flags = NULL;
+        SDO->pExt1003 = &SDO->ext1003;
     }
     /* copy object dictionary from parent */
     else{
@@ -320,12 +319,14 @@ CO_ReturnError_t CO_SDO_init(
         SDO->OD = parentSDO->OD;
         SDO->ODSize = parentSDO->ODSize;
         SDO->ODExtensions = parentSDO->ODExtensions;
+        SDO->pExt1003 = parentSDO->pExt1003;
     }
 
     /* Configure object variables */
     SDO->nodeId = nodeId;
     SDO->state = CO_SDO_ST_IDLE;
     CLEAR_CANrxNew(SDO->CANrxNew);
+    CO_RXqueue_init(&SDO->RXqueue, SDO->RXqueueFrames, CO_SDO_RX_QUEUE_SIZE);
     SDO->pFunctSignal = NULL;
 
 
@@ -407,6 +408,12 @@ void CO_OD_configure(
 #else
 #warning OD Extension system needs reworking
 #endif
+
+    /* Order of 0x1003 sub-indexes is given by its function, see ext1003 */
+    if(index == OD_H1003_PREDEF_ERR_FIELD && SDO->pExt1003 != NULL){
+        SDO->pExt1003->pODFunc = pODFunc;
+        SDO->pExt1003->object = object;
+    }
 }
 
 
@@ -571,6 +578,46 @@ void* CO_OD_getDataPointer(CO_SDO_t *SDO, const CO_OD_entry_t* object, uint8_t s
 }
 
 
+/******************************************************************************/
+void CO_OD_readCopy(void *dest, const void *src, uint32_t length){
+    uint8_t *d;
+    const volatile uint8_t *s;
+    uint32_t len;
+
+#ifdef CO_OD_SEQLOCK
+    uint16_t retry;
+
+    for(retry = 0; retry < CO_OD_SEQLOCK_RETRIES; retry++){
+        uint32_t seq = CO_OD_seq;
+
+        /* writer is inside CO_LOCK_OD(), if sequence is odd */
+        if((seq & 1U) != 0U){
+            continue;
+        }
+        CANrxMemoryBarrier();
+
+        d = (uint8_t*)dest;
+        s = (const volatile uint8_t*)src;
+        len = length;
+        while(len--) *(d++) = *(s++);
+
+        CANrxMemoryBarrier();
+        if(seq == CO_OD_seq){
+            return;
+        }
+    }
+#endif
+
+    /* copy with writers locked out */
+    CO_LOCK_OD();
+    d = (uint8_t*)dest;
+    s = (const volatile uint8_t*)src;
+    len = length;
+    while(len--) *(d++) = *(s++);
+    CO_UNLOCK_OD();
+}
+
+
 /******************************************************************************/
 uint8_t* CO_OD_getFlagsPointer(CO_SDO_t *SDO, const CO_OD_entry_t* object, uint8_t subIndex){
     CO_OD_extension_t* ext;
@@ -618,6 +665,9 @@ uint32_t CO_SDO_initTransfer(CO_SDO_t *SDO, uint16_t index, uint8_t subIndex){
 
     /* fill ODF_arg */
     SDO->ODF_arg.object = NULL;
+    if(index == OD_H1003_PREDEF_ERR_FIELD){
+        SDO->ODF_arg.object = SDO->pExt1003->object;
+    }
     if(SDO->ODExtensions){
 #if 0
         CO_OD_extension_t *ext = &SDO->ODExtensions[SDO->entryNo];
@@ -670,40 +720,46 @@ uint32_t CO_SDO_readOD(CO_SDO_t *SDO, uint16_t SDOBufferSize){
 #warning OD Extension system needs rework
 #endif
     }
-
-    CO_LOCK_OD();
+    if(SDO->ODF_arg.index == OD_H1003_PREDEF_ERR_FIELD && SDO->pExt1003->pODFunc != NULL){
+        ext = SDO->pExt1003;
+    }
 
     /* copy data from OD to SDO buffer if not domain */
     if(ODdata != NULL){
         /* This will be redundant in some cases, such as when using modbus */
-        while(length--) *(SDObuffer++) = *(ODdata++);
+        CO_OD_readCopy(SDObuffer, ODdata, length);
     }
     /* if domain, Object dictionary function MUST exist */
     else{
         if(ext == NULL || ext->pODFunc == NULL){
-            CO_UNLOCK_OD();
             return CO_SDO_AB_DEVICE_INCOMPAT;     /* general internal incompatibility in the device */
         }
     }
 
-    /* call Object dictionary function if registered */
+    /* call Object dictionary function if registered. Domain function is
+     * called without OD lock, it must protect its own data. */
     SDO->ODF_arg.reading = true;
     if(ext != NULL && ext->pODFunc != NULL){
-        uint32_t abortCode = ext->pODFunc(&SDO->ODF_arg);
-        if(abortCode != 0U){
+        uint32_t abortCode;
+
+        if(ODdata != NULL){
+            CO_LOCK_OD();
+            abortCode = ext->pODFunc(&SDO->ODF_arg);
             CO_UNLOCK_OD();
+        }
+        else{
+            abortCode = ext->pODFunc(&SDO->ODF_arg);
+        }
+        if(abortCode != 0U){
             return abortCode;
         }
 
         /* dataLength (upadted by pODFunc) must be inside limits */
         if((SDO->ODF_arg.dataLength == 0U) || (SDO->ODF_arg.dataLength > SDOBufferSize)){
-            CO_UNLOCK_OD();
             return CO_SDO_AB_DEVICE_INCOMPAT;     /* general internal incompatibility in the device */
         }
     }
 
-    CO_UNLOCK_OD();
-
     SDO->ODF_arg.offset += SDO->ODF_arg.dataLength;
     SDO->ODF_arg.firstSegment = false;
 
@@ -752,6 +808,7 @@ uint32_t CO_SDO_writeOD(CO_SDO_t *SDO, uint16_t length){
     uint8_t *SDObuffer = SDO->ODF_arg.data;
     uint8_t *ODdata = (uint8_t*)SDO->ODF_arg.ODdataStorage;
     bool_t exception_1003 = false;
+    bool_t lockOD;
 
     /* is object writeable? */
     if((SDO->ODF_arg.attribute & CO_ODA_WRITEABLE) == 0){
@@ -784,7 +841,12 @@ uint32_t CO_SDO_writeOD(CO_SDO_t *SDO, uint16_t length){
     }
 #endif
 
-    CO_LOCK_OD();
+    /* Domain has no data in OD, so OD is not locked. Domain function must
+     * protect its own data. */
+    lockOD = (ODdata != NULL) ? true : false;
+    if(lockOD){
+        CO_LOCK_OD();
+    }
 
     /* call Object dictionary function if registered */
     SDO->ODF_arg.reading = false;
@@ -795,7 +857,9 @@ uint32_t CO_SDO_writeOD(CO_SDO_t *SDO, uint16_t length){
         if(ext->pODFunc != NULL){
             uint32_t abortCode = ext->pODFunc(&SDO->ODF_arg);
             if(abortCode != 0U){
-                CO_UNLOCK_OD();
+                if(lockOD){
+                    CO_UNLOCK_OD();
+                }
                 return abortCode;
             }
         }
@@ -803,6 +867,15 @@ uint32_t CO_SDO_writeOD(CO_SDO_t *SDO, uint16_t length){
 #warning OD Extension system needs rework
 #endif
     }
+    if(SDO->ODF_arg.index == OD_H1003_PREDEF_ERR_FIELD && SDO->pExt1003->pODFunc != NULL){
+        uint32_t abortCode = SDO->pExt1003->pODFunc(&SDO->ODF_arg);
+        if(abortCode != 0U){
+            if(lockOD){
+                CO_UNLOCK_OD();
+            }
+            return abortCode;
+        }
+    }
     SDO->ODF_arg.offset += SDO->ODF_arg.dataLength;
     SDO->ODF_arg.firstSegment = false;
 
@@ -818,7 +891,9 @@ uint32_t CO_SDO_writeOD(CO_SDO_t *SDO, uint16_t length){
         }
     }
 
-    CO_UNLOCK_OD();
+    if(lockOD){
+        CO_UNLOCK_OD();
+    }
 /* BEGIN MODBUS INTEGRATION */
     if (SDO->ODF_arg.attribute & CO_ODA_FROM_MODBUS) {
       if (SDO->object->pData) {
@@ -854,8 +929,10 @@ static void CO_SDO_abort(CO_SDO_t *SDO, uint32_t code){
 }
 
 
-/******************************************************************************/
-int8_t CO_SDO_process(
+/*
+ * Process one received message or SDO timeout, see CO_SDO_process().
+ */
+static int8_t CO_SDO_processMessage(
         CO_SDO_t               *SDO,
         bool_t                  NMTisPreOrOperational,
         uint16_t                timeDifference_ms,
@@ -865,6 +942,11 @@ int8_t CO_SDO_process(
     CO_SDO_state_t state = CO_SDO_ST_IDLE;
     bool_t sendResponse = false;
 
+    /* take next message from queue, if previous one was processed */
+    if((!IS_CANrxNew(SDO->CANrxNew)) && CO_RXqueue_pop(&SDO->RXqueue, SDO->CANrxData)){
+        SET_CANrxNew(SDO->CANrxNew);
+    }
+
     /* return if idle */
     if((SDO->state == CO_SDO_ST_IDLE) && (!IS_CANrxNew(SDO->CANrxNew))){
         return 0;
@@ -874,6 +956,7 @@ int8_t CO_SDO_process(
     if(!NMTisPreOrOperational){
         SDO->state = CO_SDO_ST_IDLE;
         CLEAR_CANrxNew(SDO->CANrxNew);
+        CO_RXqueue_flush(&SDO->RXqueue);
         return 0;
     }
 
@@ -976,6 +1059,14 @@ int8_t CO_SDO_process(
         }
     }
 
+    /* Calculate, when SDO timeout expires and lower timerNext_ms if necessary. */
+    if(timerNext_ms != NULL){
+        uint16_t diff = SDOtimeoutTime - SDO->timeoutTimer;
+        if(*timerNext_ms > diff){
+            *timerNext_ms = diff;
+        }
+    }
+
     /* return immediately if still idle */
     if(state == CO_SDO_ST_IDLE){
         return 0;
@@ -1580,3 +1671,24 @@ int8_t CO_SDO_process(
 
     return 0;
 }
+
+
+/******************************************************************************/
+int8_t CO_SDO_process(
+        CO_SDO_t               *SDO,
+        bool_t                  NMTisPreOrOperational,
+        uint16_t                timeDifference_ms,
+        uint16_t                SDOtimeoutTime,
+        uint16_t               *timerNext_ms)
+{
+    int8_t ret = CO_SDO_processMessage(SDO, NMTisPreOrOperational,
+                    timeDifference_ms, SDOtimeoutTime, timerNext_ms);
+
+    /* One message is processed per call. If more are waiting in queue, for
+     * example next segment, inform OS to call this function without delay. */
+    if(timerNext_ms != NULL && CO_RXqueue_occupancy(&SDO->RXqueue) > 0U){
+        *timerNext_ms = 0;
+    }
+
+    return ret;
+}
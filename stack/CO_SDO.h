@@ -27,6 +27,8 @@
 #ifndef CO_SDO_H
 #define CO_SDO_H
 
+#include "CO_RXqueue.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -272,6 +274,16 @@ typedef enum{
  * CO_UNLOCK_OD();
  * \endcode
  *
+ * CO_LOCK_OD() protects writers. Data, which is larger than a single machine
+ * word, should be read with CO_OD_readCopy(). If target driver defines
+ * CO_OD_SEQLOCK, OD lock increments sequence counter CO_OD_seq and reader
+ * copies data without lock, so it never delays the realtime thread. It just
+ * repeats the copy, if writer was active in the meantime:
+ *
+ * \code{.c}
+ * CO_OD_readCopy(&copy, p, sizeof(copy));
+ * \endcode
+ *
  * Be aware that accessing the OD directly using CO_OD.h files is more CPU
  * efficient as CO_OD_find() has to do a search everytime it is called.
  *
@@ -339,6 +351,29 @@ typedef enum{
     #endif
 
 
+/**
+ * Number of lock-free attempts in CO_OD_readCopy().
+ *
+ * Used only, if CO_OD_SEQLOCK is defined by target driver. If data is still
+ * inconsistent after that number of copies, it is copied with OD locked.
+ */
+    #ifndef CO_OD_SEQLOCK_RETRIES
+        #define CO_OD_SEQLOCK_RETRIES 8
+    #endif
+
+
+/**
+ * SDO receive queue size.
+ *
+ * Number of received SDO messages, which may wait for processing in
+ * CO_SDO_process(). Must be power of two. Message, which arrives when queue
+ * is full, is lost. See @ref CO_RXqueue.
+ */
+    #ifndef CO_SDO_RX_QUEUE_SIZE
+        #define CO_SDO_RX_QUEUE_SIZE  4
+    #endif
+
+
 /**
  * Object Dictionary attributes. Bit masks for attribute in CO_OD_entry_t.
  */
@@ -603,6 +638,13 @@ typedef struct{
     /** Pointer to array of CO_OD_extension_t objects. Size of the array is
     equal to ODSize. */
     CO_OD_extension_t  *ODExtensions;
+    /** Extension of _Pre-Defined Error Field_ (index 0x1003), registered by
+    CO_OD_configure(). It is kept separately, while ODExtensions are not used,
+    because 0x1003 array is a ring buffer and its function gives the order of
+    sub-indexes. */
+    CO_OD_extension_t   ext1003;
+    /** Pointer to ext1003 of this object or of the parent SDO */
+    CO_OD_extension_t  *pExt1003;
     /** Offset in buffer of next data segment being read/written */
     uint16_t            bufferOffset;
     /** Sequence number of OD entry as returned from CO_OD_find() */
@@ -634,8 +676,12 @@ typedef struct{
     bool_t              timeoutSubblockDownolad;
     /** Indication end of block transfer */
     bool_t              endOfTransfer;
-    /** Variable indicates, if new SDO message received from CAN bus */
+    /** Variable indicates, if new SDO message is in CANrxData */
     volatile void      *CANrxNew;
+    /** Queue of SDO messages received from CAN bus, with statistics */
+    CO_RXqueue_t        RXqueue;
+    /** Buffer for RXqueue */
+    CO_RXqueueFrame_t   RXqueueFrames[CO_SDO_RX_QUEUE_SIZE];
     /** From CO_SDO_initCallback() or NULL */
     void              (*pFunctSignal)(void);
     /** From CO_SDO_init() */
@@ -920,6 +966,24 @@ void* CO_OD_getDataPointer(CO_SDO_t *SDO, const CO_OD_entry_t* object, uint8_t s
 uint8_t* CO_OD_getFlagsPointer(CO_SDO_t *SDO, const CO_OD_entry_t* object, uint8_t subIndex);
 
 
+/**
+ * Copy consistent snapshot of Object dictionary data.
+ *
+ * If target driver defines CO_OD_SEQLOCK, data is copied without lock and
+ * copy is repeated, if writer held CO_LOCK_OD() during copying. Otherwise data
+ * is copied inside CO_LOCK_OD() / CO_UNLOCK_OD().
+ *
+ * Function may be used for large blocks, for example for whole OD storage
+ * section, before it is written to non-volatile memory. Function must not be
+ * called inside CO_LOCK_OD(), because it may take the lock itself.
+ *
+ * @param dest Destination buffer.
+ * @param src Pointer to data in Object dictionary.
+ * @param length Number of bytes to copy.
+ */
+void CO_OD_readCopy(void *dest, const void *src, uint32_t length);
+
+
 /**
  * Initialize SDO transfer.
  *
@@ -100,22 +100,17 @@ static void CO_SDOclient_receive(void *object, const CO_CANrxMsg_t *msg){
 
     SDO_C = (CO_SDOclient_t*)object;    /* this is the correct pointer type of the first argument */
 
-    /* verify message length and message overflow (previous message was not processed yet) */
-    if((msg->DLC == 8U) && (!IS_CANrxNew(SDO_C->CANrxNew)) && (SDO_C->state != SDO_STATE_NOTDEFINED)){
+    /* verify message length */
+    if((msg->DLC == 8U) && (SDO_C->state != SDO_STATE_NOTDEFINED)){
         if(SDO_C->state != SDO_STATE_BLOCKUPLOAD_INPROGRES) {
-            /* copy data and set 'new message' flag */
-            SDO_C->CANrxData[0] = msg->data[0];
-            SDO_C->CANrxData[1] = msg->data[1];
-            SDO_C->CANrxData[2] = msg->data[2];
-            SDO_C->CANrxData[3] = msg->data[3];
-            SDO_C->CANrxData[4] = msg->data[4];
-            SDO_C->CANrxData[5] = msg->data[5];
-            SDO_C->CANrxData[6] = msg->data[6];
-            SDO_C->CANrxData[7] = msg->data[7];
-
-            SET_CANrxNew(SDO_C->CANrxNew);
+            /* CO_SDOclientDownload() or CO_SDOclientUpload() will copy data to CANrxData */
+            if(CO_RXqueue_push(&SDO_C->RXqueue, msg->data) && SDO_C->pFunctSignal != NULL) {
+                /* Optional signal to RTOS, which can resume task, which handles SDO client. */
+                SDO_C->pFunctSignal();
+            }
         }
-        else {
+        /* verify message overflow (previous message was not processed yet) */
+        else if(!IS_CANrxNew(SDO_C->CANrxNew)) {
             /* block upload, copy data directly */
             uint8_t seqno;
 
@@ -156,16 +151,26 @@ static void CO_SDOclient_receive(void *object, const CO_CANrxMsg_t *msg){
                 SDO_C->state = SDO_STATE_BLOCKUPLOAD_SUB_END;
                 SET_CANrxNew(SDO_C->CANrxNew);
             }
-        }
 
-        /* Optional signal to RTOS, which can resume task, which handles SDO client. */
-        if(IS_CANrxNew(SDO_C->CANrxNew) && SDO_C->pFunctSignal != NULL) {
-            SDO_C->pFunctSignal();
+            /* Optional signal to RTOS, which can resume task, which handles SDO client. */
+            if(IS_CANrxNew(SDO_C->CANrxNew) && SDO_C->pFunctSignal != NULL) {
+                SDO_C->pFunctSignal();
+            }
         }
     }
 }
 
 
+/*
+ * Take next received message from queue, if previous one was processed.
+ */
+static void CO_SDOclient_rxFetch(CO_SDOclient_t *SDO_C){
+    if((!IS_CANrxNew(SDO_C->CANrxNew)) && CO_RXqueue_pop(&SDO_C->RXqueue, SDO_C->CANrxData)){
+        SET_CANrxNew(SDO_C->CANrxNew);
+    }
+}
+
+
 /******************************************************************************/
 CO_ReturnError_t CO_SDOclient_init(
         CO_SDOclient_t         *SDO_C,
@@ -185,6 +190,7 @@ CO_ReturnError_t CO_SDOclient_init(
     /* Configure object variables */
     SDO_C->state = SDO_STATE_NOTDEFINED;
     CLEAR_CANrxNew(SDO_C->CANrxNew);
+    CO_RXqueue_init(&SDO_C->RXqueue, SDO_C->RXqueueFrames, CO_SDOCLI_RX_QUEUE_SIZE);
 
     SDO_C->pst    = 21; /*  block transfer */
     SDO_C->block_size_max = 127; /*  block transfer */
@@ -240,6 +246,7 @@ CO_SDOclient_return_t CO_SDOclient_setup(
     /* Configure object variables */
     SDO_C->state = SDO_STATE_NOTDEFINED;
     CLEAR_CANrxNew(SDO_C->CANrxNew);
+    CO_RXqueue_flush(&SDO_C->RXqueue);
 
     /* setup Object Dictionary variables */
     if((COB_IDClientToServer & 0x80000000L) != 0 || (COB_IDServerToClient & 0x80000000L) != 0 || nodeIDOfTheSDOServer == 0){
@@ -397,6 +404,7 @@ CO_SDOclient_return_t CO_SDOclientDownloadInitiate(
 
     /* empty receive buffer, reset timeout timer and send message */
     CLEAR_CANrxNew(SDO_C->CANrxNew);
+    CO_RXqueue_flush(&SDO_C->RXqueue);
     SDO_C->timeoutTimer = 0;
     CO_CANsend(SDO_C->CANdevTx, SDO_C->CANtxBuff);
 
@@ -451,6 +459,7 @@ CO_SDOclient_return_t CO_SDOclientDownload(
 
 
 /*  RX data ****************************************************************************************** */
+    CO_SDOclient_rxFetch(SDO_C);
     if(IS_CANrxNew(SDO_C->CANrxNew)){
         uint8_t SCS = SDO_C->CANrxData[0]>>5;    /* Client command specifier */
 
@@ -802,6 +811,7 @@ CO_SDOclient_return_t CO_SDOclientUploadInitiate(
 
     /* empty receive buffer, reset timeout timer and send message */
     CLEAR_CANrxNew(SDO_C->CANrxNew);
+    CO_RXqueue_flush(&SDO_C->RXqueue);
     SDO_C->timeoutTimer = 0;
     SDO_C->timeoutTimerBLOCK =0;
     CO_CANsend(SDO_C->CANdevTx, SDO_C->CANtxBuff);
@@ -872,6 +882,7 @@ CO_SDOclient_return_t CO_SDOclientUpload(
 
 
 /*  RX data ******************************************************************************** */
+    CO_SDOclient_rxFetch(SDO_C);
     if(IS_CANrxNew(SDO_C->CANrxNew)){
         uint8_t SCS = SDO_C->CANrxData[0]>>5;    /* Client command specifier */
 
@@ -1237,6 +1248,19 @@ CO_SDOclient_return_t CO_SDOclientUpload(
 }
 
 
+/******************************************************************************/
+void CO_SDOclient_timerNext(
+        CO_SDOclient_t         *SDO_C,
+        uint16_t               *timerNext_ms)
+{
+    if(SDO_C != NULL && timerNext_ms != NULL &&
+       CO_RXqueue_occupancy(&SDO_C->RXqueue) > 0U)
+    {
+        *timerNext_ms = 0;
+    }
+}
+
+
 /******************************************************************************/
 void CO_SDOclientClose(CO_SDOclient_t *SDO_C){
     if(SDO_C != NULL) {
@@ -28,6 +28,8 @@
 #ifndef CO_SDO_CLIENT_H
 #define CO_SDO_CLIENT_H
 
+#include "CO_RXqueue.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -43,6 +45,18 @@ extern "C" {
  */
 
 
+/**
+ * SDO client receive queue size.
+ *
+ * Number of received SDO messages, which may wait for processing in
+ * CO_SDOclientDownload() or CO_SDOclientUpload(). Must be power of two.
+ * See @ref CO_RXqueue.
+ */
+#ifndef CO_SDOCLI_RX_QUEUE_SIZE
+    #define CO_SDOCLI_RX_QUEUE_SIZE 4
+#endif
+
+
 /**
  * Return values of SDO client functions.
  */
@@ -129,6 +143,10 @@ typedef struct{
     volatile void      *CANrxNew;
     /** 8 data bytes of the received message */
     uint8_t             CANrxData[8];
+    /** Queue of SDO messages received from CAN bus, with statistics */
+    CO_RXqueue_t        RXqueue;
+    /** Buffer for RXqueue */
+    CO_RXqueueFrame_t   RXqueueFrames[CO_SDOCLI_RX_QUEUE_SIZE];
     /** From CO_SDOclient_initCallback() or NULL */
     void              (*pFunctSignal)(void);
     /** From CO_SDOclient_init() */
@@ -334,6 +352,22 @@ CO_SDOclient_return_t CO_SDOclientUpload(
         uint32_t               *pSDOabortCode);
 
 
+/**
+ * Inform OS, if SDO client must be processed again without delay.
+ *
+ * CO_SDOclientDownload() and CO_SDOclientUpload() process one received
+ * message per call. If more messages are waiting in queue, function sets
+ * timerNext_ms to 0, so the application calls them again without sleeping.
+ * Otherwise timerNext_ms is not changed.
+ *
+ * @param SDO_C This object.
+ * @param timerNext_ms Return value - info to OS - see CO_process().
+ */
+void CO_SDOclient_timerNext(
+        CO_SDOclient_t         *SDO_C,
+        uint16_t               *timerNext_ms);
+
+
 /**
  * Close SDO communication temporary.
  *
@@ -45,6 +45,9 @@ static void CO_SYNC_receive(void *object, const CO_CANrxMsg_t *msg){
     operState = *SYNC->operatingState;
 
     if((operState == CO_NMT_OPERATIONAL) || (operState == CO_NMT_PRE_OPERATIONAL)){
+#ifdef CO_CAN_RX_TIMESTAMP
+        SYNC->rxTimestamp = CO_CANrxMsg_readTimestamp(msg);
+#endif
         if(SYNC->counterOverflowValue == 0){
             if(msg->DLC == 0U){
                 SET_CANrxNew(SYNC->CANrxNew);
@@ -69,6 +72,88 @@ static void CO_SYNC_receive(void *object, const CO_CANrxMsg_t *msg){
 }
 
 
+/*
+ * Clear statistics of SYNC producer on absolute time.
+ */
+static void CO_SYNC_resetStats(CO_SYNC_t *SYNC){
+    SYNC->stats.count = 0U;
+    SYNC->stats.missed = 0U;
+    SYNC->stats.latenessMin = 0xFFFFFFFFUL;
+    SYNC->stats.latenessMax = 0U;
+    SYNC->stats.latenessSum = 0U;
+    SYNC->stats.periodMin = 0xFFFFFFFFUL;
+    SYNC->stats.periodMax = 0U;
+    SYNC->stats.drift = 0;
+    SYNC->producerFirstLateness = 0U;
+}
+
+
+/*
+ * Verify, if SYNC producer on absolute time must send SYNC now.
+ *
+ * If producer is not scheduled yet, the first SYNC is scheduled one period
+ * from now. Otherwise next deadline is calculated from the previous one, so
+ * lateness does not accumulate.
+ *
+ * @return True, if SYNC must be sent.
+ */
+static bool_t CO_SYNC_producerDue(CO_SYNC_t *SYNC, CO_time_us_t now_us){
+    CO_SYNCstats_t *stats = &SYNC->stats;
+    CO_time_us_t late;
+    uint32_t lateness;
+
+    if(!SYNC->producerScheduled){
+        SYNC->producerDeadline_us = now_us + SYNC->periodTime;
+        SYNC->producerScheduled = true;
+        CO_SYNC_resetStats(SYNC);
+        return false;
+    }
+    if(now_us < SYNC->producerDeadline_us){
+        return false;
+    }
+
+    /* skip periods, which were missed completely */
+    late = now_us - SYNC->producerDeadline_us;
+    if(late >= SYNC->periodTime){
+        CO_time_us_t missed = late / SYNC->periodTime;
+
+        SYNC->producerDeadline_us += missed * SYNC->periodTime;
+        late -= missed * SYNC->periodTime;
+        stats->missed += (missed > 0xFFFFFFFFUL) ? 0xFFFFFFFFUL : (uint32_t)missed;
+    }
+    lateness = (uint32_t)late;
+    SYNC->producerDeadline_us += SYNC->periodTime;
+
+    /* statistics */
+    if(stats->count == 0U){
+        SYNC->producerFirstLateness = lateness;
+    }
+    else{
+        CO_time_us_t diff = now_us - SYNC->producerLastTx_us;
+        uint32_t period = (diff > 0xFFFFFFFFUL) ? 0xFFFFFFFFUL : (uint32_t)diff;
+
+        if(period < stats->periodMin){
+            stats->periodMin = period;
+        }
+        if(period > stats->periodMax){
+            stats->periodMax = period;
+        }
+    }
+    if(lateness < stats->latenessMin){
+        stats->latenessMin = lateness;
+    }
+    if(lateness > stats->latenessMax){
+        stats->latenessMax = lateness;
+    }
+    stats->latenessSum += lateness;
+    stats->drift = (int32_t)(lateness - SYNC->producerFirstLateness);
+    stats->count++;
+    SYNC->producerLastTx_us = now_us;
+
+    return true;
+}
+
+
 /*
  * Function for accessing _COB ID SYNC Message_ (index 0x1005) from SDO server.
  *
@@ -125,6 +210,7 @@ static CO_SDO_abortCode_t CO_ODF_1005(CO_ODF_arg_t *ODF_arg){
             else{
                 SYNC->isProducer = false;
             }
+            SYNC->producerScheduled = false;
 
             CO_CANrxBufferInit(
                     SYNC->CANdevRx,         /* CAN device */
@@ -168,6 +254,7 @@ static CO_SDO_abortCode_t CO_ODF_1006(CO_ODF_arg_t *ODF_arg){
         }
 
         SYNC->timer = 0;
+        SYNC->producerScheduled = false;
     }
 
     return ret;
@@ -257,6 +344,11 @@ CO_ReturnError_t CO_SYNC_init(
     SYNC->timer = 0;
     SYNC->counter = 0;
     SYNC->receiveError = 0U;
+    SYNC->producerScheduled = false;
+    SYNC->producerDeadline_us = 0U;
+    SYNC->producerLastTx_us = 0U;
+    SYNC->syncTime_us = 0U;
+    CO_SYNC_resetStats(SYNC);
 
     SYNC->em = em;
     SYNC->operatingState = operatingState;
@@ -294,10 +386,16 @@ CO_ReturnError_t CO_SYNC_init(
 }
 
 
-/******************************************************************************/
-uint8_t CO_SYNC_process(
+/*
+ * Process SYNC communication, see CO_SYNC_process().
+ *
+ * @param now_us Pointer to current time for SYNC producer on absolute time or
+ * NULL for producer on accumulated time difference.
+ */
+static uint8_t CO_SYNC_processInternal(
         CO_SYNC_t              *SYNC,
         uint32_t                timeDifference_us,
+        const CO_time_us_t     *now_us,
         uint32_t                ObjDict_synchronousWindowLength)
 {
     uint8_t ret = 0;
@@ -310,14 +408,29 @@ uint8_t CO_SYNC_process(
 
         /* was SYNC just received */
         if(IS_CANrxNew(SYNC->CANrxNew)){
+#ifdef CO_CAN_RX_TIMESTAMP
+            /* SYNC window starts, when SYNC was received from CAN bus */
+            uint32_t age = CO_CANtimestampNow() - SYNC->rxTimestamp;
+            SYNC->timer = (age & 0x80000000UL) ? 0 : age;
+#else
             SYNC->timer = 0;
+#endif
             ret = 1;
             CLEAR_CANrxNew(SYNC->CANrxNew);
         }
 
         /* SYNC producer */
         if(SYNC->isProducer && SYNC->periodTime){
-            if(SYNC->timer >= SYNC->periodTime){
+            bool_t send;
+
+            if(now_us == NULL){
+                send = (SYNC->timer >= SYNC->periodTime) ? true : false;
+            }
+            else{
+                send = CO_SYNC_producerDue(SYNC, *now_us);
+            }
+
+            if(send){
                 if(++SYNC->counter > SYNC->counterOverflowValue) SYNC->counter = 1;
                 SYNC->timer = 0;
                 ret = 1;
@@ -326,6 +439,14 @@ uint8_t CO_SYNC_process(
                 CO_CANsend(SYNC->CANdevTx, SYNC->CANtxBuff);
             }
         }
+        else{
+            SYNC->producerScheduled = false;
+        }
+
+        /* local time of SYNC, timer contains its age */
+        if(ret == 1 && now_us != NULL){
+            SYNC->syncTime_us = *now_us - SYNC->timer;
+        }
 
         /* Synchronous PDOs are allowed only inside time window */
         if(ObjDict_synchronousWindowLength){
@@ -349,6 +470,7 @@ uint8_t CO_SYNC_process(
     }
     else {
         CLEAR_CANrxNew(SYNC->CANrxNew);
+        SYNC->producerScheduled = false;
     }
 
     /* verify error from receive function */
@@ -359,3 +481,63 @@ uint8_t CO_SYNC_process(
 
     return ret;
 }
+
+
+/******************************************************************************/
+uint8_t CO_SYNC_process(
+        CO_SYNC_t              *SYNC,
+        uint32_t                timeDifference_us,
+        uint32_t                ObjDict_synchronousWindowLength)
+{
+    return CO_SYNC_processInternal(SYNC, timeDifference_us, NULL, ObjDict_synchronousWindowLength);
+}
+
+
+/******************************************************************************/
+uint8_t CO_SYNC_process_us(
+        CO_SYNC_t              *SYNC,
+        uint32_t                timeDifference_us,
+        CO_time_us_t            now_us,
+        uint32_t                ObjDict_synchronousWindowLength)
+{
+    return CO_SYNC_processInternal(SYNC, timeDifference_us, &now_us, ObjDict_synchronousWindowLength);
+}
+
+
+/******************************************************************************/
+bool_t CO_SYNC_getProducerDeadline(
+        const CO_SYNC_t        *SYNC,
+        CO_time_us_t           *deadline_us)
+{
+    if(SYNC == NULL || !SYNC->isProducer || !SYNC->producerScheduled){
+        return false;
+    }
+    if(deadline_us != NULL){
+        *deadline_us = SYNC->producerDeadline_us;
+    }
+    return true;
+}
+
+
+/******************************************************************************/
+void CO_SYNC_getStats(
+        CO_SYNC_t              *SYNC,
+        CO_SYNCstats_t         *stats,
+        bool_t                  reset)
+{
+    if(SYNC == NULL){
+        return;
+    }
+    if(stats != NULL){
+        *stats = SYNC->stats;
+        if(stats->count == 0U){
+            stats->latenessMin = 0U;
+        }
+        if(stats->count < 2U){
+            stats->periodMin = 0U;
+        }
+    }
+    if(reset){
+        CO_SYNC_resetStats(SYNC);
+    }
+}
@@ -58,9 +58,40 @@ extern "C" {
  * transmitted, internal variable CANrxToggle toggles. That variable is then
  * used by synchronous RPDO to determine, which of the two buffers is used for
  * RPDO reception and which for RPDO processing.
+ *
+ * ####SYNC producer on absolute time
+ * CO_SYNC_process() sends SYNC, when accumulated time difference reaches the
+ * period. SYNC is then sent in the first cycle after the period and the error
+ * of each period accumulates. CO_SYNC_process_us() schedules each SYNC on an
+ * absolute deadline: next deadline is the previous deadline plus the period,
+ * so lateness of one cycle does not shift the following SYNC messages. Caller
+ * may use the deadline (see CO_SYNC_getProducerDeadline()) to wake exactly at
+ * the SYNC time. Achieved lateness, period jitter and drift are available from
+ * CO_SYNC_getStats().
  */
 
 
+/**
+ * Statistics of SYNC producer on absolute time, see CO_SYNC_getStats().
+ *
+ * Lateness is time from the scheduled deadline until SYNC is sent. Period is
+ * measured between consecutive SYNC messages, its jitter is periodMax -
+ * periodMin. Drift is lateness of the last SYNC minus lateness of the first
+ * SYNC since reset of statistics. It shows, how far SYNC moved from its ideal
+ * schedule and stays within the jitter, if deadlines are met.
+ */
+typedef struct{
+    uint32_t            count;          /**< Number of transmitted SYNC messages */
+    uint32_t            missed;         /**< Number of periods skipped, because they were late more than one period */
+    uint32_t            latenessMin;    /**< Minimum lateness in [microseconds] */
+    uint32_t            latenessMax;    /**< Maximum lateness in [microseconds] */
+    uint64_t            latenessSum;    /**< Sum of lateness in [microseconds], for average */
+    uint32_t            periodMin;      /**< Minimum measured period in [microseconds] */
+    uint32_t            periodMax;      /**< Maximum measured period in [microseconds] */
+    int32_t             drift;          /**< Drift in [microseconds] */
+}CO_SYNCstats_t;
+
+
 /**
  * SYNC producer and consumer object.
  */
@@ -92,8 +123,13 @@ typedef struct{
     /** Counter of the SYNC message if counterOverflowValue is different than zero */
     uint8_t             counter;
     /** Timer for the SYNC message in [microseconds].
-    Set to zero after received or transmitted SYNC message */
+    Set to zero after received or transmitted SYNC message. If CAN driver
+    provides reception timestamps, it is set to the age of received SYNC. */
     uint32_t            timer;
+#if defined(CO_CAN_RX_TIMESTAMP) || defined(CO_DOXYGEN)
+    /** Reception time of the last SYNC message, see CO_CANrxMsg_readTimestamp() */
+    uint32_t            rxTimestamp;
+#endif
     /** Set to nonzero value, if SYNC with wrong data length is received from CAN */
     uint16_t            receiveError;
     CO_CANmodule_t     *CANdevRx;       /**< From CO_SYNC_init() */
@@ -101,6 +137,19 @@ typedef struct{
     CO_CANmodule_t     *CANdevTx;       /**< From CO_SYNC_init() */
     CO_CANtx_t         *CANtxBuff;      /**< CAN transmit buffer inside CANdevTx */
     uint16_t            CANdevTxIdx;    /**< From CO_SYNC_init() */
+    /** True, if producerDeadline_us is valid. Cleared, if producer stops or
+    period changes, then the first SYNC is scheduled one period later. */
+    bool_t              producerScheduled;
+    /** Absolute time of the next SYNC transmission in [microseconds], used
+    by CO_SYNC_process_us(). */
+    CO_time_us_t        producerDeadline_us;
+    CO_time_us_t        producerLastTx_us;/**< Time of the last transmitted SYNC */
+    uint32_t            producerFirstLateness;/**< Lateness of the first SYNC in stats */
+    CO_SYNCstats_t      stats;          /**< See CO_SYNC_getStats() */
+    /** Local time of the last received or transmitted SYNC in [microseconds],
+    set by CO_SYNC_process_us(). With CO_CAN_RX_TIMESTAMP it is time of
+    reception from CAN bus. */
+    CO_time_us_t        syncTime_us;
 }CO_SYNC_t;
 
 
@@ -156,6 +205,56 @@ uint8_t CO_SYNC_process(
         uint32_t                timeDifference_us,
         uint32_t                ObjDict_synchronousWindowLength);
 
+
+/**
+ * Process SYNC communication at absolute time.
+ *
+ * Same as CO_SYNC_process(), but SYNC producer sends SYNC messages on absolute
+ * deadlines, see @ref CO_SYNC. If one or more periods were missed completely,
+ * they are skipped and counted in statistics, so SYNC stays on its schedule.
+ *
+ * @param SYNC This object.
+ * @param timeDifference_us Time difference from previous function call in
+ * [microseconds], used for SYNC window and timeout.
+ * @param now_us Current monotonic time in [microseconds].
+ * @param ObjDict_synchronousWindowLength _Synchronous window length_ variable from
+ * Object dictionary (index 0x1007).
+ *
+ * @return Same as CO_SYNC_process().
+ */
+uint8_t CO_SYNC_process_us(
+        CO_SYNC_t              *SYNC,
+        uint32_t                timeDifference_us,
+        CO_time_us_t            now_us,
+        uint32_t                ObjDict_synchronousWindowLength);
+
+
+/**
+ * Get time of the next SYNC message from producer.
+ *
+ * @param SYNC This object.
+ * @param deadline_us Absolute time of the next SYNC in [microseconds] is
+ * written here, see CO_SYNC_process_us().
+ *
+ * @return True, if this node is SYNC producer and the next SYNC is scheduled.
+ */
+bool_t CO_SYNC_getProducerDeadline(
+        const CO_SYNC_t        *SYNC,
+        CO_time_us_t           *deadline_us);
+
+
+/**
+ * Get statistics of SYNC producer on absolute time.
+ *
+ * @param SYNC This object.
+ * @param stats Statistics are copied here, see #CO_SYNCstats_t.
+ * @param reset If true, statistics are cleared after copy.
+ */
+void CO_SYNC_getStats(
+        CO_SYNC_t              *SYNC,
+        CO_SYNCstats_t         *stats,
+        bool_t                  reset);
+
 #ifdef __cplusplus
 }
 #endif /*__cplusplus*/
@@ -25,6 +25,18 @@
 
 #include "CANopen.h"
 
+
+/* Part of measured offset, which is corrected immediately (1/2) and which is
+ * integrated into drift estimate (1/8 of offset rate). */
+#define CO_TIME_PHASE_GAIN_SHIFT    1
+#define CO_TIME_DRIFT_GAIN_SHIFT    3
+
+#define CO_TIME_MS_PER_DAY          86400000ULL
+
+/* TIME message has resolution of 1 ms and is received about 1 ms after it was
+ * sampled, so its offset is not precise. */
+#define CO_TIME_MSG_TOLERANCE       2000
+
 /*
  * Read received message from CAN module.
  *
@@ -39,9 +51,17 @@ static void CO_TIME_receive(void *object, const CO_CANrxMsg_t *msg){
     operState = *TIME->operatingState;
 
     if((operState == CO_NMT_OPERATIONAL) || (operState == CO_NMT_PRE_OPERATIONAL)){
+#ifdef CO_CAN_RX_TIMESTAMP
+        TIME->rxTimestamp = CO_CANrxMsg_readTimestamp(msg);
+#endif
         SET_CANrxNew(TIME->CANrxNew);
         // Process Time from msg buffer
         CO_memcpy((uint8_t*)&TIME->Time.ullValue, msg->data, msg->DLC);
+
+        /* Optional signal to RTOS, which can resume task, which handles TIME. */
+        if(TIME->pFunctSignal != NULL) {
+            TIME->pFunctSignal();
+        }
     }
     else{
         TIME->receiveError = (uint16_t)msg->DLC;
@@ -81,6 +101,19 @@ CO_ReturnError_t CO_TIME_init(
     CLEAR_CANrxNew(TIME->CANrxNew);
     TIME->timer = 0;
     TIME->receiveError = 0U;
+    TIME->pFunctSignal = NULL;
+    TIME->timeSource = NULL;
+    TIME->timeSourceObject = NULL;
+    TIME->clock.seq = 0U;
+    TIME->clock.valid = false;
+    TIME->clock.highRes = false;
+    TIME->clock.localRef_us = 0U;
+    TIME->clock.networkRef_us = 0U;
+    TIME->clock.drift = 0;
+    TIME->clock.offset_us = 0;
+    TIME->clock.latency_us = 0;
+    TIME->clock.samples = 0U;
+    TIME->clock.steps = 0U;
 
     TIME->em = em;
     TIME->operatingState = operatingState;
@@ -115,10 +148,189 @@ CO_ReturnError_t CO_TIME_init(
     return CO_ERROR_NO;
 }
 
+/******************************************************************************/
+void CO_TIME_initCallback(
+        CO_TIME_t              *TIME,
+        void                  (*pFunctSignal)(void))
+{
+    if(TIME != NULL){
+        TIME->pFunctSignal = pFunctSignal;
+    }
+}
+
+/******************************************************************************/
+void CO_TIME_setTimeSource(
+        CO_TIME_t              *TIME,
+        CO_timeSource_t         timeSource,
+        void                   *object)
+{
+    if(TIME != NULL){
+        TIME->timeSource = timeSource;
+        TIME->timeSourceObject = object;
+    }
+}
+
+
+/* Clock is changed between CO_TIME_writeBegin() and CO_TIME_writeEnd(). */
+static void CO_TIME_writeBegin(CO_TIMEclock_t *clock){
+    clock->seq++;
+    CANrxMemoryBarrier();
+}
+
+static void CO_TIME_writeEnd(CO_TIMEclock_t *clock){
+    CANrxMemoryBarrier();
+    clock->seq++;
+}
+
+
+/* Network time from the clock, for writers of the clock, which don't need
+ * consistency check. */
+static uint64_t CO_TIME_nowInternal(const CO_TIMEclock_t *clock, CO_time_us_t local_us){
+    int64_t dt;
+
+    if(!clock->valid){
+        return 0U;
+    }
+
+    dt = (int64_t)(local_us - clock->localRef_us);
+    return clock->networkRef_us + (uint64_t)(dt + ((dt * clock->drift) >> 32));
+}
+
+
+/* CO_TIME_set() inside CO_TIME_writeBegin() and CO_TIME_writeEnd() */
+static void CO_TIME_setInternal(CO_TIMEclock_t *clock, uint64_t network_us, CO_time_us_t local_us){
+    clock->localRef_us = local_us;
+    clock->networkRef_us = network_us;
+    clock->offset_us = 0;
+    clock->valid = true;
+}
+
+
+/******************************************************************************/
+uint64_t CO_TIME_now(const CO_TIME_t *TIME, CO_time_us_t local_us){
+    const CO_TIMEclock_t *clock = &TIME->clock;
+    uint64_t now;
+    uint32_t seq;
+
+    /* repeat, if clock was changed meanwhile */
+    do{
+        seq = clock->seq;
+        CANrxMemoryBarrier();
+        now = CO_TIME_nowInternal(clock, local_us);
+        CANrxMemoryBarrier();
+    }while((seq & 1U) != 0U || seq != clock->seq);
+
+    return now;
+}
+
+
+/******************************************************************************/
+void CO_TIME_set(CO_TIME_t *TIME, uint64_t network_us, CO_time_us_t local_us){
+    CO_TIME_writeBegin(&TIME->clock);
+    CO_TIME_setInternal(&TIME->clock, network_us, local_us);
+    CO_TIME_writeEnd(&TIME->clock);
+}
+
+
+/*
+ * Correct network clock with a sample, see CO_TIME_correct().
+ *
+ * @param stepThreshold Offset in [microseconds], above which clock is stepped.
+ * @param updateDrift If false, only phase is corrected.
+ */
+static void CO_TIME_correctInternal(
+        CO_TIME_t              *TIME,
+        uint64_t                network_us,
+        CO_time_us_t            local_us,
+        int64_t                 stepThreshold,
+        bool_t                  updateDrift)
+{
+    CO_TIMEclock_t *clock = &TIME->clock;
+    int64_t dt, offset;
+    uint64_t estimate;
+
+    clock->samples++;
+
+    if(!clock->valid){
+        clock->steps++;
+        CO_TIME_set(TIME, network_us, local_us);
+        return;
+    }
+
+    /* samples must come in order */
+    dt = (int64_t)(local_us - clock->localRef_us);
+    if(dt <= 0){
+        return;
+    }
+
+    estimate = CO_TIME_nowInternal(clock, local_us);
+    offset = (int64_t)(network_us - estimate);
+
+    CO_TIME_writeBegin(clock);
+
+    if(offset > stepThreshold || offset < -stepThreshold){
+        clock->steps++;
+        CO_TIME_setInternal(clock, network_us, local_us);
+        clock->offset_us = (offset > INT32_MAX) ? INT32_MAX : (offset < INT32_MIN) ? INT32_MIN : (int32_t)offset;
+        CO_TIME_writeEnd(clock);
+        return;
+    }
+
+    /* offset rate (in 2^-32 units) is error of drift estimate */
+    if(updateDrift){
+        int64_t drift = clock->drift + ((offset * 4294967296LL / dt) >> CO_TIME_DRIFT_GAIN_SHIFT);
+
+        if(drift > CO_TIME_DRIFT_MAX){
+            drift = CO_TIME_DRIFT_MAX;
+        }
+        else if(drift < -CO_TIME_DRIFT_MAX){
+            drift = -CO_TIME_DRIFT_MAX;
+        }
+        clock->drift = (int32_t)drift;
+    }
+
+    /* correct part of the offset now, rest is removed by drift */
+    clock->localRef_us = local_us;
+    clock->networkRef_us = estimate + (uint64_t)(offset >> CO_TIME_PHASE_GAIN_SHIFT);
+    clock->offset_us = (int32_t)offset;
+
+    CO_TIME_writeEnd(clock);
+}
+
+
+/******************************************************************************/
+void CO_TIME_correct(CO_TIME_t *TIME, uint64_t network_us, CO_time_us_t local_us){
+    CO_TIME_correctInternal(TIME, network_us, local_us, CO_TIME_STEP_THRESHOLD, true);
+}
+
+
+/******************************************************************************/
+uint32_t CO_TIME_getHighResStamp(const CO_TIME_t *TIME, CO_time_us_t syncTime_us){
+    return (uint32_t)CO_TIME_now(TIME, syncTime_us);
+}
+
+
+/******************************************************************************/
+void CO_TIME_highResStamp(CO_TIME_t *TIME, uint32_t stamp_us, CO_time_us_t syncTime_us){
+    uint64_t estimate;
+
+    if(TIME == NULL || !TIME->clock.valid){
+        return;
+    }
+
+    /* stamp contains lower 32 bits, upper bits are from the clock */
+    stamp_us += (uint32_t)TIME->clock.latency_us;
+    estimate = CO_TIME_now(TIME, syncTime_us);
+    CO_TIME_correct(TIME, estimate + (uint64_t)(int64_t)(int32_t)(stamp_us - (uint32_t)estimate), syncTime_us);
+    TIME->clock.highRes = true;
+}
+
+
 /******************************************************************************/
 uint8_t CO_TIME_process(
         CO_TIME_t              *TIME,
-        uint32_t                timeDifference_ms)
+        uint32_t                timeDifference_ms,
+        uint16_t               *timerNext_ms)
 {
     uint8_t ret = 0;
     uint32_t timerNew;
@@ -131,9 +343,42 @@ uint8_t CO_TIME_process(
 
         /* was TIME just received */
         if(TIME->CANrxNew){
-            TIME->timer = 0;
+            uint32_t age_us = 0U;
+
+#ifdef CO_CAN_RX_TIMESTAMP
+            /* timeout is measured from reception on CAN bus */
+            age_us = CO_CANtimestampNow() - TIME->rxTimestamp;
+            if(age_us & 0x80000000UL){
+                age_us = 0U;
+            }
+#endif
+            TIME->timer = age_us / 1000;
             ret = 1;
             CLEAR_CANrxNew(TIME->CANrxNew);
+
+            /* Correct phase of network clock with TIME message. Drift is
+             * estimated only from high resolution stamps. If they are
+             * received, TIME message only steps the clock, if it is far off. */
+            if(TIME->isConsumer && TIME->timeSource != NULL){
+                CO_time_us_t local_us = TIME->timeSource(TIME->timeSourceObject) - age_us;
+                /* middle of the millisecond */
+                uint64_t network_us = ((uint64_t)TIME->Time.days * CO_TIME_MS_PER_DAY
+                                     + TIME->Time.ms) * 1000U + 500U;
+                int64_t threshold = CO_TIME_STEP_THRESHOLD + CO_TIME_MSG_TOLERANCE;
+
+                CO_LOCK_OD();
+                if(!TIME->clock.highRes){
+                    CO_TIME_correctInternal(TIME, network_us, local_us, threshold, false);
+                }
+                else{
+                    int64_t offset = (int64_t)(network_us - CO_TIME_now(TIME, local_us));
+
+                    if(offset > threshold || offset < -threshold){
+                        CO_TIME_correctInternal(TIME, network_us, local_us, threshold, false);
+                    }
+                }
+                CO_UNLOCK_OD();
+            }
         }
 
         /* TIME producer */
@@ -141,6 +386,12 @@ uint8_t CO_TIME_process(
             if(TIME->timer >= TIME->periodTime){
                 TIME->timer = 0;
                 ret = 1;
+                if(TIME->clock.valid && TIME->timeSource != NULL){
+                    uint64_t ms = CO_TIME_now(TIME, TIME->timeSource(TIME->timeSourceObject)) / 1000U;
+
+                    TIME->Time.ms = (unsigned long)(ms % CO_TIME_MS_PER_DAY);
+                    TIME->Time.days = (unsigned)(ms / CO_TIME_MS_PER_DAY);
+                }
                 CO_memcpy(TIME->TXbuff->data, (const uint8_t*)&TIME->Time.ullValue, TIME_MSG_LENGTH);
                 CO_CANsend(TIME->CANdevTx, TIME->TXbuff);
             }
@@ -150,6 +401,23 @@ uint8_t CO_TIME_process(
         if(TIME->isConsumer && TIME->periodTime && TIME->timer > TIME->periodTimeoutTime
         && *TIME->operatingState == CO_NMT_OPERATIONAL)
             CO_errorReport(TIME->em, CO_EM_TIME_TIMEOUT, CO_EMC_COMMUNICATION, TIME->timer);
+
+        /* Calculate, when next TIME needs to be send or when timeout expires
+         * and lower timerNext_ms if necessary. */
+        if(timerNext_ms != NULL && TIME->periodTime){
+            uint32_t diff = 0xFFFFFFFFL;
+
+            if(TIME->isProducer){
+                diff = TIME->periodTime - TIME->timer;
+            }
+            else if(TIME->isConsumer && TIME->timer <= TIME->periodTimeoutTime){
+                diff = TIME->periodTimeoutTime - TIME->timer;
+                if(diff < 0xFFFFFFFFL) diff++;
+            }
+            if(*timerNext_ms > diff){
+                *timerNext_ms = (uint16_t)diff;
+            }
+        }
     }
     else {
         CLEAR_CANrxNew(TIME->CANrxNew);
@@ -69,10 +69,82 @@ extern "C" {
  * - TIMECyclePeriod : Time transmit period in ms
  *
  * Write time value in \p CO->TIME->Time variable, this will be sent at TIMECyclePeriod.
+ * If network clock is set with CO_TIME_set(), current time of the clock is
+ * sent instead.
+ *
+ *
+ * ###NETWORK CLOCK
+ *
+ * Each TIME object contains clock, which follows network time in
+ * [microseconds] since 1.1.1984. Clock is a linear function of local monotonic
+ * time (see CO_setTimeSource()), so CO_TIME_now() is only multiplication and
+ * shift and can be called often.
+ *
+ * Producer sets its clock with CO_TIME_set(). Consumer disciplines its clock
+ * from samples, which pair network time with local time of the same moment.
+ * Each sample measures offset of the clock. Part of the offset is corrected
+ * immediately and drift of the local oscillator is estimated from the offset
+ * rate, so clock follows the producer also between samples. Offset larger than
+ * #CO_TIME_STEP_THRESHOLD steps the clock.
+ *
+ * Samples are:
+ * - TIME message, received by CO_TIME_process(). It has resolution of one
+ *   millisecond, so it is used for discipline only until high resolution
+ *   stamps arrive. Local time of reception is taken from CAN RX timestamp, if
+ *   CO_CAN_RX_TIMESTAMP is defined, otherwise from time of processing.
+ * - High resolution time stamp (object 0x1013), passed by application to
+ *   CO_TIME_highResStamp(). Producer takes the stamp with
+ *   CO_TIME_getHighResStamp() for the moment of SYNC and transmits it in PDO
+ *   after the SYNC, consumer correlates it with the reception time of the
+ *   same SYNC (see syncTime_us in CO_SYNC_t). Stamp is lower 32 bits of the
+ *   network time, so consumer clock must be set by TIME message first. With
+ *   CAN RX timestamps clocks of the nodes match within tens of microseconds.
+ *
+ * Clock is changed by CO_TIME_process() and CO_TIME_highResStamp(). If they
+ * run in different threads, they must be called inside CO_LOCK_OD().
+ * CO_TIME_process() locks it itself. CO_TIME_now() may be called from any
+ * thread without lock, it retries, if clock was changed during the read (see
+ * _seq_ in CO_TIMEclock_t).
  */
 
 #define TIME_MSG_LENGTH 6U
 
+
+/** Offset of network clock in [microseconds], above which clock is stepped */
+#ifndef CO_TIME_STEP_THRESHOLD
+#define CO_TIME_STEP_THRESHOLD      1000
+#endif
+
+/** Maximum estimated drift of the local clock, in [2^-32] units (1000 ppm) */
+#ifndef CO_TIME_DRIFT_MAX
+#define CO_TIME_DRIFT_MAX           4294967L
+#endif
+
+
+/**
+ * Network clock, see CO_TIME_now().
+ */
+typedef struct{
+    /** Incremented before and after change of the clock, so it is odd during
+    the change. Used by CO_TIME_now() for consistent read. */
+    volatile uint32_t   seq;
+    bool_t              valid;          /**< True, if clock was set or received */
+    bool_t              highRes;        /**< True, if high resolution stamps are received */
+    CO_time_us_t        localRef_us;    /**< Local time of the last correction */
+    uint64_t            networkRef_us;  /**< Network time at localRef_us */
+    /** Estimated rate of network clock minus rate of local clock, in
+    [2^-32] units. 4295 is approximately 1 ppm. */
+    int32_t             drift;
+    int32_t             offset_us;      /**< Offset measured by the last sample (network - clock) */
+    /** Delay from the SYNC time of the producer to the SYNC time of this
+    node in [microseconds], added to high resolution stamps. Application may
+    set it to transmission time of SYNC message, if producer takes the stamp
+    before transmission and this node at the end of reception. 0 by default. */
+    int32_t             latency_us;
+    uint32_t            samples;        /**< Number of samples */
+    uint32_t            steps;          /**< Number of samples, which stepped the clock */
+}CO_TIMEclock_t;
+
 /**
  * TIME producer and consumer object.
  */
@@ -97,6 +169,11 @@ typedef struct{
     /** Timer for the TIME message in [microseconds].
     Set to zero after received or transmitted TIME message */
     uint32_t            timer;
+#if defined(CO_CAN_RX_TIMESTAMP) || defined(CO_DOXYGEN)
+    /** Reception time of the last TIME message (time, when _Time_ was valid),
+    see CO_CANrxMsg_readTimestamp() */
+    uint32_t            rxTimestamp;
+#endif
     /** Set to nonzero value, if TIME with wrong data length is received from CAN */
     uint16_t            receiveError;
     CO_CANmodule_t     *CANdevRx;       /**< From CO_TIME_init() */
@@ -105,6 +182,11 @@ typedef struct{
     uint16_t            CANdevTxIdx;    /**< From CO_TIME_init() */
     CO_CANtx_t         *TXbuff;         /**< CAN transmit buffer */
     TIME_OF_DAY         Time;
+    /** From CO_TIME_initCallback() or NULL */
+    void              (*pFunctSignal)(void);
+    CO_timeSource_t     timeSource;     /**< From CO_TIME_setTimeSource() or NULL */
+    void               *timeSourceObject;/**< Object passed to timeSource */
+    CO_TIMEclock_t      clock;          /**< Network clock, see CO_TIME_now() */
 }CO_TIME_t;
 
 /**
@@ -135,6 +217,102 @@ CO_ReturnError_t CO_TIME_init(
         CO_CANmodule_t         *CANdevTx,
         uint16_t                CANdevTxIdx);
 
+/**
+ * Initialize TIME callback function.
+ *
+ * Function initializes optional callback function, which should immediately
+ * start processing of CO_TIME_process() function.
+ * Callback is called after TIME message is received from the CAN bus.
+ *
+ * @param TIME This object.
+ * @param pFunctSignal Pointer to the callback function. Not called if NULL.
+ */
+void CO_TIME_initCallback(
+        CO_TIME_t              *TIME,
+        void                  (*pFunctSignal)(void));
+
+/**
+ * Set source of local monotonic time.
+ *
+ * It is used for local time of received TIME message and for TIME producer,
+ * which sends time of network clock. CO_CANopenInit() sets the time source of
+ * the CANopen object, see CO_setTimeSource().
+ *
+ * @param TIME This object.
+ * @param timeSource Function, which returns local monotonic time in [microseconds] or NULL.
+ * @param object Pointer to object, which will be passed to timeSource. May be NULL.
+ */
+void CO_TIME_setTimeSource(
+        CO_TIME_t              *TIME,
+        CO_timeSource_t         timeSource,
+        void                   *object);
+
+
+/**
+ * Get network time.
+ *
+ * @param TIME This object.
+ * @param local_us Local monotonic time, for example from CO_timeNow().
+ *
+ * @return Network time in [microseconds] since 1.1.1984, which corresponds to
+ * local_us, or 0, if clock is not valid yet.
+ */
+uint64_t CO_TIME_now(const CO_TIME_t *TIME, CO_time_us_t local_us);
+
+
+/**
+ * Set network clock.
+ *
+ * Used by TIME producer, for example from system real time clock. Estimated
+ * drift is kept.
+ *
+ * @param TIME This object.
+ * @param network_us Network time in [microseconds] since 1.1.1984.
+ * @param local_us Local monotonic time at the same moment.
+ */
+void CO_TIME_set(CO_TIME_t *TIME, uint64_t network_us, CO_time_us_t local_us);
+
+
+/**
+ * Correct network clock with a sample.
+ *
+ * See @ref CO_TIME. Used internally by TIME consumer, may also be used with
+ * samples from other source.
+ *
+ * @param TIME This object.
+ * @param network_us Network time in [microseconds] since 1.1.1984.
+ * @param local_us Local monotonic time at the same moment.
+ */
+void CO_TIME_correct(CO_TIME_t *TIME, uint64_t network_us, CO_time_us_t local_us);
+
+
+/**
+ * Get high resolution time stamp for SYNC (producer).
+ *
+ * @param TIME This object.
+ * @param syncTime_us Local time of SYNC, see syncTime_us in CO_SYNC_t.
+ *
+ * @return Value for _High resolution time stamp_ (object 0x1013): lower 32
+ * bits of network time at the SYNC, in [microseconds].
+ */
+uint32_t CO_TIME_getHighResStamp(const CO_TIME_t *TIME, CO_time_us_t syncTime_us);
+
+
+/**
+ * Correct network clock with high resolution time stamp (consumer).
+ *
+ * Should be called after RPDO with _High resolution time stamp_ (object
+ * 0x1013) is processed. Stamp is ignored, if clock was not set yet by TIME
+ * message.
+ *
+ * @param TIME This object.
+ * @param stamp_us High resolution time stamp from producer, see
+ * CO_TIME_getHighResStamp().
+ * @param syncTime_us Local time of reception of SYNC, to which stamp belongs.
+ */
+void CO_TIME_highResStamp(CO_TIME_t *TIME, uint32_t stamp_us, CO_time_us_t syncTime_us);
+
+
 /**
  * Process TIME communication.
  *
@@ -142,13 +320,16 @@ CO_ReturnError_t CO_TIME_init(
  *
  * @param TIME This object.
  * @param timeDifference_ms Time difference from previous function call in [milliseconds].
+ * @param timerNext_ms Return value - info to OS - see CO_process(). Lowered to
+ * the time of the next TIME message (producer) or TIME timeout (consumer).
  *
  * @return 0: No special meaning.
  * @return 1: New TIME message recently received (consumer) / transmited (producer).
  */
 uint8_t CO_TIME_process(
         CO_TIME_t              *TIME,
-        uint32_t                timeDifference_ms);
+        uint32_t                timeDifference_ms,
+        uint16_t               *timerNext_ms);
 
 #ifdef __cplusplus
 }
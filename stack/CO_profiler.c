@@ -0,0 +1,197 @@
+/*
+ * Cycle time profiler for CANopen processing functions.
+ *
+ * @file        CO_profiler.c
+ * @ingroup     CO_profiler
+ * @copyright   2020
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "CO_driver.h"
+#include "CO_profiler.h"
+
+#ifdef CO_USE_PROFILER
+
+#include <stdio.h>
+#include <stdarg.h>
+#ifdef CO_PROFILER_CLOCK_MONOTONIC
+#include <time.h>
+#endif
+
+
+/* Names of modules in CSV output, same order as CO_profilerModule_t */
+static const char * const CO_profiler_names[CO_PROF_NO] = {
+    "process", "SDO", "EM", "NMT", "HBcons", "TIME", "SYNC", "RPDO", "TPDO"
+};
+
+
+/******************************************************************************/
+void CO_profiler_reset(CO_profiler_t *profiler){
+    uint16_t i;
+
+    for(i=0; i<CO_PROF_NO; i++){
+        CO_profilerStat_t *stat = &profiler->stat[i];
+        uint16_t j;
+
+        stat->count = 0;
+        stat->min = 0xFFFFFFFFU;
+        stat->max = 0;
+        stat->sum = 0;
+        for(j=0; j<CO_PROFILER_HIST_SIZE; j++){
+            stat->hist[j] = 0;
+        }
+    }
+}
+
+
+/******************************************************************************/
+void CO_profiler_init(CO_profiler_t *profiler){
+    CO_profiler_reset(profiler);
+    profiler->OD = NULL;
+    profiler->ODlength = 0;
+}
+
+
+#ifdef CO_PROFILER_CLOCK_MONOTONIC
+/******************************************************************************/
+uint32_t CO_profiler_timestamp(void){
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t)now.tv_sec * 1000000000U + (uint32_t)now.tv_nsec;
+}
+#endif
+
+
+/******************************************************************************/
+void CO_profiler_record(CO_profiler_t *profiler, CO_profilerModule_t module, uint32_t ticks){
+    CO_profilerStat_t *stat = &profiler->stat[module];
+    uint16_t bin = 0;
+    uint32_t t = ticks;
+
+    stat->count++;
+    stat->sum += ticks;
+    if(ticks < stat->min){
+        stat->min = ticks;
+    }
+    if(ticks > stat->max){
+        stat->max = ticks;
+    }
+
+    /* bin is number of significant bits in ticks */
+    while(t != 0U && bin < (CO_PROFILER_HIST_SIZE - 1)){
+        t >>= 1;
+        bin++;
+    }
+    stat->hist[bin]++;
+}
+
+
+/******************************************************************************/
+void CO_profiler_setODexport(CO_profiler_t *profiler, uint32_t *OD, uint16_t length){
+    profiler->OD = OD;
+    profiler->ODlength = (OD != NULL) ? length : 0;
+}
+
+
+/* Ticks to nanoseconds, saturated */
+static uint32_t CO_profiler_ns(uint64_t ticks){
+    uint64_t ns = ticks * CO_PROFILER_TICK_NS;
+
+    return (ns > 0xFFFFFFFFU) ? 0xFFFFFFFFU : (uint32_t)ns;
+}
+
+
+/******************************************************************************/
+void CO_profiler_exportOD(CO_profiler_t *profiler){
+    uint16_t i;
+
+    if(profiler->OD == NULL){
+        return;
+    }
+
+    CO_LOCK_OD();
+    for(i=0; i<CO_PROF_NO && (i * 4U + 4U) <= profiler->ODlength; i++){
+        const CO_profilerStat_t *stat = &profiler->stat[i];
+        uint32_t *od = &profiler->OD[i * 4U];
+        uint32_t count = stat->count;
+
+        od[0] = count;
+        od[1] = (count != 0U) ? CO_profiler_ns(stat->min) : 0U;
+        od[2] = CO_profiler_ns(stat->max);
+        od[3] = (count != 0U) ? CO_profiler_ns(stat->sum / count) : 0U;
+    }
+    CO_UNLOCK_OD();
+}
+
+
+/* Append formatted string to buf at *len, output is truncated to bufSize */
+static void CO_profiler_append(char *buf, size_t bufSize, size_t *len, const char *format, ...){
+    va_list args;
+    int n;
+
+    if(*len + 1U >= bufSize){
+        return;
+    }
+    va_start(args, format);
+    n = vsnprintf(&buf[*len], bufSize - *len, format, args);
+    va_end(args);
+    if(n > 0){
+        *len += (size_t)n;
+        if(*len >= bufSize){
+            *len = bufSize - 1U;
+        }
+    }
+}
+
+
+/******************************************************************************/
+size_t CO_profiler_printCSV(const CO_profiler_t *profiler, char *buf, size_t bufSize){
+    size_t len = 0;
+    uint16_t i, j;
+
+    if(buf == NULL || bufSize == 0){
+        return 0;
+    }
+    buf[0] = '\0';
+
+    CO_profiler_append(buf, bufSize, &len, "module,tick_ns,count,min,max,avg");
+    for(j=0; j<CO_PROFILER_HIST_SIZE; j++){
+        CO_profiler_append(buf, bufSize, &len, ",h%u", (unsigned)j);
+    }
+
+    for(i=0; i<CO_PROF_NO; i++){
+        const CO_profilerStat_t *stat = &profiler->stat[i];
+        uint32_t count = stat->count;
+
+        CO_profiler_append(buf, bufSize, &len, "\n%s,%u,%lu,%lu,%lu,%lu",
+                           CO_profiler_names[i], (unsigned)CO_PROFILER_TICK_NS,
+                           (unsigned long)count,
+                           (unsigned long)((count != 0U) ? stat->min : 0U),
+                           (unsigned long)stat->max,
+                           (unsigned long)((count != 0U) ? (stat->sum / count) : 0U));
+        for(j=0; j<CO_PROFILER_HIST_SIZE; j++){
+            CO_profiler_append(buf, bufSize, &len, ",%lu", (unsigned long)stat->hist[j]);
+        }
+    }
+
+    return len;
+}
+
+#endif /* CO_USE_PROFILER */
@@ -0,0 +1,236 @@
+/**
+ * Cycle time profiler for CANopen processing functions.
+ *
+ * @file        CO_profiler.h
+ * @ingroup     CO_profiler
+ * @copyright   2020
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef CO_PROFILER_H
+#define CO_PROFILER_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @defgroup CO_profiler Profiler
+ * @ingroup CO_CANopen
+ * @{
+ *
+ * Cycle time profiler for CANopen processing functions.
+ *
+ * Profiler is enabled, if CO_USE_PROFILER is defined. It measures execution
+ * time of each module call inside CO_process(), CO_process_SYNC(),
+ * CO_process_RPDO() and CO_process_TPDO(). For each module it accumulates
+ * count, minimum, maximum, average and a histogram. Otherwise
+ * CO_PROFILE_BEGIN() and CO_PROFILE_END() are empty and profiler costs
+ * nothing.
+ *
+ * Time is read with CO_PROFILER_TIMESTAMP(), which returns free running 32 bit
+ * counter with resolution CO_PROFILER_TICK_NS nanoseconds. Target may define
+ * both macros, for example for cycle counter of the microcontroller. By default
+ * CLOCK_MONOTONIC is used on Linux and NuttX, otherwise CO_timebase_us().
+ *
+ * Statistics may be read from CO_profiler_t, printed with
+ * CO_profiler_printCSV() (also available with "profiler" command of the
+ * command interface) or exported to Object Dictionary array, see
+ * CO_profiler_setODexport().
+ *
+ * Each module is measured only from one thread, so no locking is used.
+ * Statistics, which are read from other thread, are informative.
+ */
+
+
+/**
+ * Number of histogram bins for each module.
+ *
+ * Bin 0 counts calls shorter than one tick, bin n counts calls from 2^(n-1) to
+ * 2^n - 1 ticks. Last bin counts all longer calls.
+ */
+#ifndef CO_PROFILER_HIST_SIZE
+#define CO_PROFILER_HIST_SIZE   24
+#endif
+
+
+#ifndef CO_PROFILER_TIMESTAMP
+    #if defined(__linux__) || defined(__NuttX__)
+        /** Read free running counter */
+        #define CO_PROFILER_TIMESTAMP() CO_profiler_timestamp()
+        /** Resolution of CO_PROFILER_TIMESTAMP() in nanoseconds */
+        #define CO_PROFILER_TICK_NS     1U
+        #define CO_PROFILER_CLOCK_MONOTONIC
+    #elif defined(CO_TIMEBASE_US)
+        #define CO_PROFILER_TIMESTAMP() ((uint32_t)CO_timebase_us(NULL))
+        #define CO_PROFILER_TICK_NS     1000U
+    #elif defined(CO_USE_PROFILER)
+        #error CO_PROFILER_TIMESTAMP() must be defined for this target
+    #endif
+#endif
+
+
+/**
+ * Measured modules.
+ */
+typedef enum{
+    CO_PROF_PROCESS     = 0,    /**< Whole CO_process() */
+    CO_PROF_SDO         = 1,    /**< SDO servers in CO_process() */
+    CO_PROF_EM          = 2,    /**< Emergency in CO_process() */
+    CO_PROF_NMT         = 3,    /**< NMT and heartbeat producer in CO_process() */
+    CO_PROF_HB          = 4,    /**< Heartbeat consumer in CO_process() */
+    CO_PROF_TIME        = 5,    /**< TIME in CO_process() */
+    CO_PROF_SYNC        = 6,    /**< CO_process_SYNC() */
+    CO_PROF_RPDO        = 7,    /**< CO_process_RPDO() */
+    CO_PROF_TPDO        = 8,    /**< CO_process_TPDO() */
+    CO_PROF_NO          = 9     /**< Number of modules */
+}CO_profilerModule_t;
+
+
+/**
+ * Statistics of one module. Times are in ticks of CO_PROFILER_TIMESTAMP().
+ */
+typedef struct{
+    uint32_t            start;          /**< Time of CO_PROFILE_BEGIN(), internal */
+    uint32_t            count;          /**< Number of measured calls */
+    uint32_t            min;            /**< Shortest call */
+    uint32_t            max;            /**< Longest call */
+    uint64_t            sum;            /**< Sum of all calls, for average */
+    uint32_t            hist[CO_PROFILER_HIST_SIZE]; /**< Histogram, see #CO_PROFILER_HIST_SIZE */
+}CO_profilerStat_t;
+
+
+/**
+ * Profiler object.
+ */
+typedef struct{
+    CO_profilerStat_t   stat[CO_PROF_NO]; /**< Statistics for each #CO_profilerModule_t */
+    uint32_t           *OD;             /**< From CO_profiler_setODexport() or NULL */
+    uint16_t            ODlength;       /**< From CO_profiler_setODexport() */
+}CO_profiler_t;
+
+
+/**
+ * Clear all statistics.
+ *
+ * Export to Object Dictionary is not changed.
+ *
+ * @param profiler This object.
+ */
+void CO_profiler_reset(CO_profiler_t *profiler);
+
+
+/**
+ * Initialize profiler object.
+ *
+ * Clears statistics and disables export to Object Dictionary.
+ *
+ * @param profiler This object.
+ */
+void CO_profiler_init(CO_profiler_t *profiler);
+
+
+#if defined(CO_PROFILER_CLOCK_MONOTONIC) || defined(CO_DOXYGEN)
+/**
+ * Default CO_PROFILER_TIMESTAMP() on Linux and NuttX.
+ *
+ * @return CLOCK_MONOTONIC in nanoseconds, lower 32 bits.
+ */
+uint32_t CO_profiler_timestamp(void);
+#endif
+
+
+/**
+ * Add one measured call to statistics.
+ *
+ * @param profiler This object.
+ * @param module Measured module.
+ * @param ticks Duration of the call.
+ */
+void CO_profiler_record(CO_profiler_t *profiler, CO_profilerModule_t module, uint32_t ticks);
+
+
+/**
+ * Export statistics to Object Dictionary.
+ *
+ * Application may define manufacturer specific array of UNSIGNED32 in Object
+ * Dictionary. For each #CO_profilerModule_t four values are written to it:
+ * count, minimum, maximum and average time in nanoseconds (saturated to
+ * 0xFFFFFFFF). Values are updated only on demand by CO_profiler_exportOD(),
+ * so CO_process() doesn't lock Object Dictionary for the profiler.
+ *
+ * @param profiler This object.
+ * @param OD Pointer to the first element of the array (sub-index 1) or NULL
+ * to disable export.
+ * @param length Number of elements in array. Modules, which don't fit, are not
+ * exported.
+ */
+void CO_profiler_setODexport(CO_profiler_t *profiler, uint32_t *OD, uint16_t length);
+
+
+/**
+ * Write statistics to Object Dictionary array, see CO_profiler_setODexport().
+ *
+ * Function is not called by the stack. Application calls it, when it needs
+ * fresh values in Object Dictionary, for example from a slow timer or before
+ * statistics are read by SDO. It takes CO_LOCK_OD() for the write.
+ *
+ * @param profiler This object.
+ */
+void CO_profiler_exportOD(CO_profiler_t *profiler);
+
+
+/**
+ * Print statistics in CSV format.
+ *
+ * First line is header, then follows one line for each module with: name,
+ * tick resolution in nanoseconds, count, min, max, average and histogram bins.
+ * Times are in ticks.
+ *
+ * @param profiler This object.
+ * @param buf Buffer for the string.
+ * @param bufSize Size of the buffer. Output is truncated, if buffer is too
+ * small.
+ *
+ * @return Length of the string in buf (without terminating zero).
+ */
+size_t CO_profiler_printCSV(const CO_profiler_t *profiler, char *buf, size_t bufSize);
+
+
+#if defined(CO_USE_PROFILER) || defined(CO_DOXYGEN)
+/** Mark start of module call. */
+#define CO_PROFILE_BEGIN(profiler, module) \
+    {(profiler)->stat[module].start = CO_PROFILER_TIMESTAMP();}
+/** Mark end of module call and record its duration. */
+#define CO_PROFILE_END(profiler, module) \
+    {CO_profiler_record((profiler), (module), CO_PROFILER_TIMESTAMP() - (profiler)->stat[module].start);}
+#else
+#define CO_PROFILE_BEGIN(profiler, module)
+#define CO_PROFILE_END(profiler, module)
+#endif
+
+
+#ifdef __cplusplus
+}
+#endif /*__cplusplus*/
+
+/** @} */
+#endif
@@ -36,10 +36,160 @@
 
 #include <fcntl.h>
 #include <syslog.h>
+#include <sys/ioctl.h>
+#include <errno.h>
+#include <unistd.h>
+#include <time.h>
 #include "CO_debug.h"
+#include "../socketCAN/CO_filter_compress.h"
 #include <nuttx/can/can.h>
 
 
+#ifdef CONFIG_CAN_EXTID
+/* CO_CANrxMsg_t must be layout compatible with struct can_msg_s, see
+ * CO_MsgReceived(). Compilation fails here, if it is not. */
+typedef char CO_CANrxMsg_layoutCheck_t[
+    ((sizeof(((struct can_msg_s *)0)->cm_hdr.ch_id) == sizeof(uint32_t))
+     && (sizeof(struct can_hdr_s) == offsetof(CO_CANrxMsg_t, data))
+     && (offsetof(struct can_msg_s, cm_data) == offsetof(CO_CANrxMsg_t, data))
+     && (CAN_MAXDATALEN == 8)) ? 1 : -1];
+#endif
+
+
+/******************************************************************************/
+CO_lock_t CO_CAN_SEND_lock = {PTHREAD_MUTEX_INITIALIZER};
+CO_lock_t CO_EMCY_lock = {PTHREAD_MUTEX_INITIALIZER};
+CO_lock_t CO_OD_lock = {PTHREAD_MUTEX_INITIALIZER};
+volatile uint32_t CO_OD_seq = 0;
+
+
+/******************************************************************************/
+void CO_lock(CO_lock_t *lock){
+    pthread_mutex_lock(&lock->mtx);
+#ifdef CO_LOCK_STATS
+    lock->lockedAt_us = CO_timebase_us(NULL);
+    lock->lockCount++;
+#endif
+}
+
+
+/******************************************************************************/
+void CO_unlock(CO_lock_t *lock){
+#ifdef CO_LOCK_STATS
+    uint64_t hold = CO_timebase_us(NULL) - lock->lockedAt_us;
+
+    if(hold > lock->holdMax_us){
+        lock->holdMax_us = (hold > 0xFFFFFFFFU) ? 0xFFFFFFFFU : (uint32_t)hold;
+    }
+#endif
+    pthread_mutex_unlock(&lock->mtx);
+}
+
+
+#ifdef CO_LOCK_STATS
+/******************************************************************************/
+void CO_lockResetStats(CO_lock_t *lock){
+    pthread_mutex_lock(&lock->mtx);
+    lock->holdMax_us = 0;
+    lock->lockCount = 0;
+    pthread_mutex_unlock(&lock->mtx);
+}
+#endif
+
+
+/******************************************************************************/
+CO_time_us_t CO_timebase_us(void *object){
+    struct timespec now;
+
+    (void)object;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (CO_time_us_t)now.tv_sec * 1000000U + (CO_time_us_t)now.tv_nsec / 1000U;
+}
+
+
+#ifdef CANIOC_ADD_STDFILTER
+/* Acceptance filter (11-bit identifier and mask), as programmed into hardware */
+typedef struct {
+    uint16_t ident;
+    uint16_t mask;
+} CO_CANfilter_t;
+
+
+/* Remove all hardware filters, installed by CO_CANsetFilters(). */
+static void CO_CANclearFilters(CO_CANmodule_t *CANmodule){
+    uint16_t i;
+
+    for(i = 0U; i < CANmodule->filterCount; i++){
+        if(ioctl(CANmodule->driver_state->read_fd, CANIOC_DEL_STDFILTER,
+                 (unsigned long)CANmodule->filterId[i]) < 0){
+            syslog(LOG_ERR, "Failed to delete CAN filter %d!\n", CANmodule->filterId[i]);
+        }
+    }
+    CANmodule->filterCount = 0U;
+    CANmodule->useCANrxFilters = false;
+}
+
+
+/* Reduce filters to a minimal set, which accepts exactly the same identifiers,
+ * see CO_FILTER_COMPRESS_FUNCTION(). Returns new number of filters. */
+static CO_FILTER_COMPRESS_FUNCTION(CO_CANcompressFilters, CO_CANfilter_t, ident, mask, uint16_t)
+
+
+/* Derive hardware acceptance filters from rxArray and program them into the CAN
+ * controller. If there are not enough hardware filters, CAN messages will be
+ * filtered by software only. */
+static void CO_CANsetFilters(CO_CANmodule_t *CANmodule){
+    CO_CANfilter_t filters[CO_CAN_NSTDFILTERS];
+    uint16_t count = 0U;
+    uint16_t i;
+
+    CO_CANclearFilters(CANmodule);
+
+    for(i = 0U; i < CANmodule->rxSize; i++){
+        CO_CANrx_t *buffer = &CANmodule->rxArray[i];
+
+        if(buffer->pFunct == NULL){
+            continue;
+        }
+        /* RTR bit can not be filtered by hardware, it is verified by software. */
+        filters[count].ident = buffer->ident & buffer->mask & 0x07FFU;
+        filters[count].mask = buffer->mask & 0x07FFU;
+        count++;
+        if(count == CO_CAN_NSTDFILTERS){
+            count = (uint16_t)CO_CANcompressFilters(filters, (int)count);
+            if(count == CO_CAN_NSTDFILTERS){
+                syslog(LOG_INFO, "Not enough CAN hardware filters, filtering by software\n");
+                return;
+            }
+        }
+    }
+    count = (uint16_t)CO_CANcompressFilters(filters, (int)count);
+
+    for(i = 0U; i < count; i++){
+        struct canioc_stdfilter_s stdfilter;
+        int ret;
+
+        stdfilter.sf_id1 = filters[i].ident;
+        stdfilter.sf_id2 = filters[i].mask;
+        stdfilter.sf_type = CAN_FILTER_MASK;
+        stdfilter.sf_prio = CAN_MSGPRIO_HIGH;
+
+        ret = ioctl(CANmodule->driver_state->read_fd, CANIOC_ADD_STDFILTER,
+                    (unsigned long)&stdfilter);
+        if(ret < 0){
+            /* hardware has fewer filter banks than expected */
+            syslog(LOG_INFO, "CAN hardware filter rejected, filtering by software\n");
+            CO_CANclearFilters(CANmodule);
+            return;
+        }
+        CANmodule->filterId[CANmodule->filterCount++] = ret;
+    }
+
+    CANmodule->useCANrxFilters = (count > 0U) ? true : false;
+}
+#endif /* CANIOC_ADD_STDFILTER */
+
+
 /******************************************************************************/
 void CO_CANsetConfigurationMode(void *CANdriverState){
     /* Put CAN module in configuration mode */
@@ -50,6 +200,9 @@ void CO_CANsetConfigurationMode(void *CANdriverState){
 void CO_CANsetNormalMode(CO_CANmodule_t *CANmodule){
     /* Put CAN module in normal mode */
 
+#ifdef CANIOC_ADD_STDFILTER
+    CO_CANsetFilters(CANmodule);
+#endif
     CANmodule->CANnormal = true;
 }
 
@@ -80,7 +233,11 @@ CO_ReturnError_t CO_CANmodule_init(
     CANmodule->txArray = txArray;
     CANmodule->txSize = txSize;
     CANmodule->CANnormal = false;
-    CANmodule->useCANrxFilters = false; //(rxSize <= 32U) ? true : false;/* microcontroller dependent */
+    /* Hardware filters are configured from rxArray in CO_CANsetNormalMode() */
+    CANmodule->useCANrxFilters = false;
+#ifdef CANIOC_ADD_STDFILTER
+    CANmodule->filterCount = 0U;
+#endif
     CANmodule->bufferInhibitFlag = false;
     CANmodule->firstCANtxMessage = true;
     CANmodule->CANtxCount = 0U;
@@ -119,18 +276,10 @@ CO_ReturnError_t CO_CANmodule_init(
     /* Configure CAN timing */
 
 
-    /* Configure CAN module hardware filters */
-    if(CANmodule->useCANrxFilters){
-        /* CAN module filters are used, they will be configured with */
-        /* CO_CANrxBufferInit() functions, called by separate CANopen */
-        /* init functions. */
-        /* Configure all masks so, that received message must match filter */
-    }
-    else{
-        /* CAN module filters are not used, all messages with standard 11-bit */
-        /* identifier will be received */
-        /* Configure mask 0 so, that all messages with standard identifier are accepted */
-    }
+    /* Configure CAN module hardware filters. Filters are derived from rxArray,
+     * after it is configured by CO_CANrxBufferInit() functions, called by
+     * separate CANopen init functions. Until then all messages with standard
+     * 11-bit identifier will be received. */
 
 
     /* configure CAN interrupt registers */
@@ -143,6 +292,9 @@ CO_ReturnError_t CO_CANmodule_init(
 /******************************************************************************/
 void CO_CANmodule_disable(CO_CANmodule_t *CANmodule){
     /* turn off the module */
+#ifdef CANIOC_ADD_STDFILTER
+    CO_CANclearFilters(CANmodule);
+#endif
 }
 
 
@@ -179,10 +331,14 @@ CO_ReturnError_t CO_CANrxBufferInit(
         }
         buffer->mask = (mask & 0x07FFU) | 0x0800U;
 
-        /* Set CAN hardware module filter and mask. */
-        if(CANmodule->useCANrxFilters){
-
+        /* Set CAN hardware module filter and mask. If CAN module is already
+         * in normal mode (PDO COB-ID was changed, for example), filters are
+         * derived again from the whole rxArray. */
+#ifdef CANIOC_ADD_STDFILTER
+        if(CANmodule->CANnormal){
+            CO_CANsetFilters(CANmodule);
         }
+#endif
     }
     else{
         ret = CO_ERROR_ILLEGAL_ARGUMENT;
@@ -239,32 +395,25 @@ CO_ReturnError_t CO_CANsend(CO_CANmodule_t *CANmodule, CO_CANtx_t *buffer){
         err = CO_ERROR_TX_OVERFLOW;
     }
 
+    size_t count = CAN_MSGLEN(buffer->DLC);
+    struct can_msg_s msg;
+    msg.cm_hdr.ch_dlc = buffer->DLC;
+    msg.cm_hdr.ch_rtr = 0;
+    msg.cm_hdr.ch_id = buffer->ident;
+    memcpy(msg.cm_data, buffer->data, buffer->DLC);
+
+    /* Lock only shared flag. Blocking write() is outside of critical section,
+     * CAN character device serializes writers itself. */
     CO_LOCK_CAN_SEND();
-    /* if CAN TX buffer is free, copy message to it */
-//    if(CANmodule->CANtxCount == 0){
-        size_t count = CAN_MSGLEN(buffer->DLC);
-        CANmodule->bufferInhibitFlag = buffer->syncFlag;
-        struct can_msg_s msg;
-        msg.cm_hdr.ch_dlc = buffer->DLC;
-        msg.cm_hdr.ch_rtr = 0;
-        msg.cm_hdr.ch_id = buffer->ident;
-        memcpy(msg.cm_data, buffer->data, buffer->DLC);
-        //CO_DBG("Sending CAN message: ID: %x, DLC %x\n", msg.cm_hdr.ch_id, msg.cm_hdr.ch_dlc);
-        res = write(CANmodule->driver_state->write_fd, (uint8_t*) &msg, count);
-        if (res != count) {
-            syslog(LOG_ERR, "Failed to write CAN message!\n");
-        } else {
-            //syslog(LOG_INFO, "*************** Wrote CAN message successfully!!!\n");
-        }
-        /* copy message and txRequest */
-//    }
-//    /* if no buffer is free, message will be sent by interrupt */
-//    else{
-//        buffer->bufferFull = true;
-//        CANmodule->CANtxCount++;
-//    }
+    CANmodule->bufferInhibitFlag = buffer->syncFlag;
     CO_UNLOCK_CAN_SEND();
 
+    //CO_DBG("Sending CAN message: ID: %x, DLC %x\n", msg.cm_hdr.ch_id, msg.cm_hdr.ch_dlc);
+    res = write(CANmodule->driver_state->write_fd, (uint8_t*) &msg, count);
+    if (res != count) {
+        syslog(LOG_ERR, "Failed to write CAN message!\n");
+    }
+
     return err;
 }
 
@@ -367,61 +516,83 @@ void CO_CANverifyErrors(CO_CANmodule_t *CANmodule){
 /******************************************************************************/
 void CO_MsgReceived(CO_CANmodule_t *CANmodule, struct can_msg_s *in_msg) {
 
-    CO_CANrxMsg_t rcvMsg;      /* pointer to received message in CAN module */
+#ifdef CONFIG_CAN_EXTID
+    /* received message is used in place, through layout compatible view */
+    const CO_CANrxMsg_t *rcvMsg = (const CO_CANrxMsg_t *)in_msg;
+#else
+    /* 16-bit ch_id, message is copied */
+    CO_CANrxMsg_t rcvMsgCopy;
+    const CO_CANrxMsg_t *rcvMsg = &rcvMsgCopy;
+#endif
     uint16_t index;             /* index of received message */
     uint32_t rcvMsgIdent;       /* identifier of the received message */
     CO_CANrx_t *buffer = NULL;  /* receive message buffer from CO_CANmodule_t object. */
     bool_t msgMatched = false;
 
-    /* FIXME: it might be possible to do this without the additional memory copy */
-    rcvMsg.DLC = in_msg->cm_hdr.ch_dlc; /* get message from module here */
-    rcvMsg.ident = in_msg->cm_hdr.ch_id;
-//    rcvMsg.RTR = in_msg->cm_hdr.ch_rtr;
-    memcpy(rcvMsg.data, in_msg->cm_data, sizeof(rcvMsg.data));
-    rcvMsgIdent = in_msg->cm_hdr.ch_id;
-#if 0
-    if(CANmodule->useCANrxFilters){
-        /* CAN module filters are used. Message with known 11-bit identifier has */
-        /* been received */
-        index = 0;  /* get index of the received message here. Or something similar */
-        if(index < CANmodule->rxSize){
-            buffer = &CANmodule->rxArray[index];
-            /* verify also RTR */
-            if(((rcvMsgIdent ^ buffer->ident) & buffer->mask) == 0U){
-                msgMatched = true;
-            }
-        }
-    }
-    else{
+#ifndef CONFIG_CAN_EXTID
+    rcvMsgCopy.ident = in_msg->cm_hdr.ch_id;
+    rcvMsgCopy.DLC = in_msg->cm_hdr.ch_dlc;
+    memcpy(rcvMsgCopy.data, in_msg->cm_data, sizeof(rcvMsgCopy.data));
 #endif
-        /* CAN module filters are not used, message with any standard 11-bit identifier */
-        /* has been received. Search rxArray form CANmodule for the same CAN-ID. */
-        //CO_DBG("DRIVER: %d, %d, %d\n", CANmodule, CANmodule->rxArray, CANmodule->rxSize);
-        buffer = &CANmodule->rxArray[0];
-        for(index = CANmodule->rxSize; index > 0U; index--){
-//        CO_DBG("m\n", rcvMsgIdent, buffer->ident, buffer->mask, (rcvMsgIdent ^ buffer->ident) & buffer->mask);
-            if(((rcvMsgIdent ^ buffer->ident) & buffer->mask) == 0U){
-                CO_DBG("Message Matched\n");
-                msgMatched = true;
-                break;
-            }
-            buffer++;
+    rcvMsgIdent = rcvMsg->ident;
+    if(in_msg->cm_hdr.ch_rtr){
+        rcvMsgIdent |= 0x0800U;
+    }
+    /* Hardware filters (if used) can not tell, which rxArray entry matched,
+     * so rxArray is searched in both cases. */
+    /* Search rxArray form CANmodule for the same CAN-ID. */
+    buffer = &CANmodule->rxArray[0];
+    for(index = CANmodule->rxSize; index > 0U; index--){
+        if(((rcvMsgIdent ^ buffer->ident) & buffer->mask) == 0U){
+            msgMatched = true;
+            break;
         }
-#if 0
+        buffer++;
     }
-#endif
 
     /* Call specific function, which will process the message */
     if(msgMatched && (buffer != NULL) && (buffer->pFunct != NULL)){
         CO_DBG("CAN message handler matched!\n");
-//        usleep(100*USEC_PER_MSEC);
-        buffer->pFunct(buffer->object, &rcvMsg);
+        buffer->pFunct(buffer->object, rcvMsg);
     } else {
       syslog(LOG_INFO, "No message handler found\n");
     }
+}
 
-    /* Clear interrupt flag */
+
+/******************************************************************************/
+int CO_CANrxRead(CO_CANmodule_t *CANmodule) {
+    ssize_t nbytes;
+    size_t offset = 0U;
+    int count = 0;
+
+    /* CAN device returns only whole messages, as many as fit into buffer */
+    nbytes = read(CANmodule->driver_state->read_fd, CANmodule->rxBuf,
+                  CO_CAN_RX_BATCH * sizeof(struct can_msg_s));
+    if(nbytes < 0){
+        if((errno == EAGAIN) || (errno == EINTR)){
+            return 0;
+        }
+        syslog(LOG_ERR, "Failed to read CAN messages!\n");
+        return -1;
+    }
+
+    /* Messages are packed, each is CAN_MSGLEN(dlc) bytes long */
+    while((offset + sizeof(struct can_hdr_s)) <= (size_t)nbytes){
+        struct can_msg_s *msg = (struct can_msg_s *)&CANmodule->rxBuf[offset];
+
+        offset += CAN_MSGLEN(msg->cm_hdr.ch_dlc);
+        if(offset > (size_t)nbytes){
+            break;
+        }
+        CO_MsgReceived(CANmodule, msg);
+        count++;
+    }
+
+    return count;
 }
+
+
 #if 0
     /* receive interrupt */
     if(1){
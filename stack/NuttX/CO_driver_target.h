@@ -39,8 +39,12 @@ extern "C" {
 #include <stdbool.h>        /* for 'true', 'false' */
 #include <endian.h>         /* For determination of endianness */
 
+#include <nuttx/compiler.h>
+#ifdef CONFIG_CAN_TIMESTAMP
+#include <sys/time.h>
+#endif
 #include <nuttx/can/can.h>
-#include <sched.h>
+#include <pthread.h>
 /**
  * Endianness.
  *
@@ -167,16 +171,73 @@ extern "C" {
  * After presence of SYNC message on CANopen bus, CANrx should be temporary
  * disabled until all receive PDOs are processed. See also CO_SYNC.h file and
  * CO_SYNC_initCallback() function.
+ *
+ * ####NuttX implementation.
+ * Each critical section has its own mutex of type #CO_lock_t, so other tasks
+ * in the system (which don't use CANopenNode) are not blocked, as they would
+ * be with sched_lock(). Mutex is held only for short, bounded sections:
+ * CO_CANsend() does not hold it during write() to CAN device. OD lock is held
+ * by writers only, readers use CO_OD_readCopy() (CO_OD_SEQLOCK is defined).
+ * Critical sections must not be entered from interrupt handler.
+ *
+ * If CO_LOCK_STATS is defined, worst case hold time of each lock is measured,
+ * see #CO_lock_t.
  * @{
  */
-#define CO_LOCK_CAN_SEND()    sched_lock()  /**< Lock critical section in CO_CANsend() */
-#define CO_UNLOCK_CAN_SEND()  sched_unlock()/**< Unlock critical section in CO_CANsend() */
 
-#define CO_LOCK_EMCY()        sched_lock() /**< Lock critical section in CO_errorReport() or CO_errorReset() */
-#define CO_UNLOCK_EMCY()      sched_unlock()/**< Unlock critical section in CO_errorReport() or CO_errorReset() */
+/**
+ * Lock for one critical section.
+ */
+typedef struct{
+    pthread_mutex_t     mtx;            /**< Mutex */
+#if defined(CO_LOCK_STATS) || defined(CO_DOXYGEN)
+    uint64_t            lockedAt_us;    /**< Time, when lock was taken, internal */
+    uint32_t            holdMax_us;     /**< Longest time, lock was held [microseconds] */
+    uint32_t            lockCount;      /**< Number of times, lock was taken */
+#endif
+}CO_lock_t;
+
+extern CO_lock_t CO_CAN_SEND_lock;      /**< Lock for CO_LOCK_CAN_SEND() */
+extern CO_lock_t CO_EMCY_lock;          /**< Lock for CO_LOCK_EMCY() */
+extern CO_lock_t CO_OD_lock;            /**< Lock for CO_LOCK_OD() */
+extern volatile uint32_t CO_OD_seq;     /**< Incremented on CO_LOCK_OD() and CO_UNLOCK_OD() */
+
+/**
+ * Take the lock.
+ *
+ * @param lock Lock object.
+ */
+void CO_lock(CO_lock_t *lock);
+
+/**
+ * Release the lock.
+ *
+ * @param lock Lock object.
+ */
+void CO_unlock(CO_lock_t *lock);
+
+#if defined(CO_LOCK_STATS) || defined(CO_DOXYGEN)
+/**
+ * Reset statistics of the lock.
+ *
+ * Worst case hold time may be read from CO_lock_t, for example from
+ * diagnostic task. Statistics should be cleared after initialization, which
+ * may hold the locks longer.
+ *
+ * @param lock Lock object.
+ */
+void CO_lockResetStats(CO_lock_t *lock);
+#endif
+
+#define CO_LOCK_CAN_SEND()    CO_lock(&CO_CAN_SEND_lock)    /**< Lock critical section in CO_CANsend() */
+#define CO_UNLOCK_CAN_SEND()  CO_unlock(&CO_CAN_SEND_lock)  /**< Unlock critical section in CO_CANsend() */
 
-#define CO_LOCK_OD()          sched_lock() /**< Lock critical section when accessing Object Dictionary */
-#define CO_UNLOCK_OD()        sched_unlock()/**< Unock critical section when accessing Object Dictionary */
+#define CO_LOCK_EMCY()        CO_lock(&CO_EMCY_lock)        /**< Lock critical section in CO_errorReport() or CO_errorReset() */
+#define CO_UNLOCK_EMCY()      CO_unlock(&CO_EMCY_lock)      /**< Unlock critical section in CO_errorReport() or CO_errorReset() */
+
+#define CO_OD_SEQLOCK                                       /**< OD readers use CO_OD_seq */
+#define CO_LOCK_OD()          {CO_lock(&CO_OD_lock); CO_OD_seq++; CANrxMemoryBarrier();}    /**< Lock critical section when writing Object Dictionary */
+#define CO_UNLOCK_OD()        {CANrxMemoryBarrier(); CO_OD_seq++; CO_unlock(&CO_OD_lock);}  /**< Unock critical section when writing Object Dictionary */
 /** @} */
 
 /**
@@ -193,8 +254,8 @@ extern "C" {
  * \endcode
  * @{
  */
-/** Memory barrier */
-#define CANrxMemoryBarrier()
+/** Memory barrier, CAN messages are received in task by CO_CANrxRead() */
+#define CANrxMemoryBarrier() {__sync_synchronize();}
 /** Check if new message has arrived */
 #define IS_CANrxNew(rxNew) ((uintptr_t)rxNew)
 /** Set new message flag */
@@ -219,6 +280,29 @@ typedef unsigned char           domain_t;   /**< domain_t */
 /** @} */
 
 
+/* GCC atomic builtins are used by lock-free emergency buffer, see CO_EM_t. */
+#define CO_USE_GCC_ATOMICS
+
+
+/* CLOCK_MONOTONIC is used as default time source, see CO_timebase_us(). */
+#define CO_TIMEBASE_US
+
+
+/**
+ * Number of hardware acceptance filters, which may be programmed into the CAN
+ * controller with CANIOC_ADD_STDFILTER. If more filters are necessary to cover
+ * all CO_CANrx_t entries, hardware filtering is not used and all received
+ * messages are filtered by software.
+ */
+#ifndef CO_CAN_NSTDFILTERS
+#ifdef CONFIG_CAN_NSTDFILTERS
+#define CO_CAN_NSTDFILTERS      CONFIG_CAN_NSTDFILTERS
+#else
+#define CO_CAN_NSTDFILTERS      14
+#endif
+#endif
+
+
 /* Contains information to tie the CANopen module to the OS' CAN driver */
 typedef struct {
     char *path;
@@ -226,16 +310,42 @@ typedef struct {
     int write_fd;
 } CO_CAN_driverState_t;
 
+#if defined(CONFIG_CAN_EXTID) || defined(CO_DOXYGEN)
 /**
- * CAN receive message structure as aligned in CAN module. It is different in
- * different microcontrollers. It usually contains other variables.
+ * CAN receive message structure as aligned in CAN module. With
+ * CONFIG_CAN_EXTID it is a view of the NuttX struct can_msg_s, as returned by
+ * read() from CAN character device, so received messages can be processed in
+ * place, without copying. Layout is verified at compile time in CO_driver.c.
+ * Without CONFIG_CAN_EXTID identifier in struct can_hdr_s is 16-bit, so
+ * message is copied into this structure by CO_MsgReceived().
  */
-typedef struct{
+typedef begin_packed_struct struct{
     /** CAN identifier. It must be read through CO_CANrxMsg_readIdent() function. */
     uint32_t            ident;
-    uint8_t             DLC ;           /**< Length of CAN message */
+    uint8_t             DLC : 4;        /**< Length of CAN message */
+    uint8_t             RTR : 1;        /**< Remote transmission request */
+    uint8_t                 : 3;
+#ifdef CONFIG_CAN_TIMESTAMP
+    struct timeval      timestamp;      /**< Reception time */
+#endif
     uint8_t             data[8];        /**< 8 data bytes */
+} end_packed_struct CO_CANrxMsg_t;
+#else
+typedef struct{
+    uint32_t            ident;
+    uint8_t             DLC ;
+    uint8_t             data[8];
 }CO_CANrxMsg_t;
+#endif
+
+
+/**
+ * Number of CAN messages, which are read from CAN device with single read()
+ * call inside CO_CANrxRead().
+ */
+#ifndef CO_CAN_RX_BATCH
+#define CO_CAN_RX_BATCH         8
+#endif
 
 
 /**
@@ -288,6 +398,14 @@ typedef struct{
     volatile uint16_t   CANtxCount;
     uint32_t            errOld;         /**< Previous state of CAN errors */
     void               *em;             /**< Emergency object */
+#if defined(CANIOC_ADD_STDFILTER) || defined(CO_DOXYGEN)
+    /** Handles of the hardware filters, returned by CANIOC_ADD_STDFILTER */
+    int                 filterId[CO_CAN_NSTDFILTERS];
+    uint16_t            filterCount;    /**< Number of installed hardware filters */
+#endif
+    /** Buffer for CO_CANrxRead(). Extra bytes at the end allow access to all 8
+      * data bytes of the last (shorter) message in the buffer. */
+    uint8_t             rxBuf[CO_CAN_RX_BATCH * sizeof(struct can_msg_s) + CAN_MAXDATALEN];
 }CO_CANmodule_t;
 
 
@@ -300,8 +418,32 @@ typedef struct{
  */
 void CO_CANinterrupt(CO_CANmodule_t *CANmodule);
 
+/**
+ * Process received CAN message.
+ *
+ * Function searches rxArray for matching CAN identifier and calls
+ * corresponding callback. With CONFIG_CAN_EXTID message is passed to the
+ * callback in place, so it must not be modified until function returns.
+ *
+ * @param CANmodule This object.
+ * @param in_msg Message, as received from NuttX CAN character device.
+ */
 void CO_MsgReceived(CO_CANmodule_t *CANmodule, struct can_msg_s *in_msg);
 
+/**
+ * Read and process received CAN messages.
+ *
+ * Function reads up to #CO_CAN_RX_BATCH messages from nonblocking CAN device
+ * with single read() call and processes each of them with CO_MsgReceived().
+ * It should be called, when CAN device becomes readable (poll()).
+ *
+ * @param CANmodule This object.
+ *
+ * @return Number of processed messages, 0 if there was no message or -1 on
+ * read error.
+ */
+int CO_CANrxRead(CO_CANmodule_t *CANmodule);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -150,6 +150,11 @@ extern "C" {
  * that not all variables are allowed to be mapped to PDOs, so they may not need
  * to be protected. SDO server protects sections with access to OD variables.
  *
+ * If CO_LOCK_OD() is a mutex, target may define CO_OD_SEQLOCK and increment
+ * global `volatile uint32_t CO_OD_seq` after locking and before unlocking.
+ * Then CO_OD_readCopy() (used by SDO upload and OD storage) reads OD data
+ * without lock and long readers never delay the timer thread.
+ *
  * ####CAN receive thread.
  * It partially processes received CAN data and puts them into appropriate
  * objects. Objects are later processed. It does not need protection of
@@ -193,6 +198,15 @@ extern "C" {
 #define CLEAR_CANrxNew(rxNew) {CANrxMemoryBarrier(); rxNew = (void*)0L;}
 /** @} */
 
+/**
+ * Define, if compiler supports GCC __atomic builtins for 8 and 32 bit
+ * variables. Then CO_errorReport() and CO_errorReset() don't use
+ * CO_LOCK_EMCY(), see CO_EM_t.
+ */
+#ifdef CO_DOXYGEN
+#define CO_USE_GCC_ATOMICS
+#endif
+
 /**
  * @defgroup CO_dataTypes Data types
  * @{
@@ -24,26 +24,29 @@
  * limitations under the License.
  */
 
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE     /* for CPU_SET() */
+#endif
+
 #include <sys/timerfd.h>
+#include <sys/mman.h>
 #include <fcntl.h>
 #include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <sched.h>
+#include <poll.h>
+#include <alloca.h>
+#include <pthread.h>
 
 #include "CO_driver.h"
 #include "CANopen.h"
-
-/* Helper function - get monotonic clock time in ms */
-static uint64_t CO_LinuxThreads_clock_gettime_ms(void)
-{
-  struct timespec ts;
-
-  (void)clock_gettime(CLOCK_MONOTONIC, &ts);
-  return ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
-}
+#include "CO_Linux_threads.h"
+#include "CO_msgs.h"
 
 /* Mainline thread (threadMain) ***************************************************/
 static struct
 {
-  uint64_t  start;                  /* time value CO_process() was called last time in ms */
   void    (*pFunct)(void* object);  /* Callback function */
   void     *object;
 } threadMain;
@@ -63,12 +66,19 @@ static void threadMain_resumeCallback(void)
 
 void threadMain_init(void (*callback)(void*), void *object)
 {
-  threadMain.start = CO_LinuxThreads_clock_gettime_ms();
   threadMain.pFunct = callback;
   threadMain.object = object;
 
   CO_SDO_initCallback(CO->SDO[0], threadMain_resumeCallback);
   CO_EM_initCallback(CO->em, threadMain_resumeCallback);
+  CO_NMT_initCallbackSignal(CO->NMT, threadMain_resumeCallback);
+  CO_HBconsumer_initCallbackSignal(CO->HBcons, threadMain_resumeCallback);
+#if CO_NO_NG_SLAVE == 1
+  CO_NGslave_initCallbackSignal(CO->NGslave, threadMain_resumeCallback);
+#endif
+#if CO_NO_TIME == 1
+  CO_TIME_initCallback(CO->TIME, threadMain_resumeCallback);
+#endif
 #if CO_NO_LSS_CLIENT == 1
   CO_LSSmaster_initCallback(CO->LSSmaster, threadMain.object, threadMain.pFunct);
 #endif
@@ -85,45 +95,65 @@ void threadMain_close(void)
   threadMain.object = NULL;
 }
 
-void threadMain_process(CO_NMT_reset_cmd_t *reset)
+uint16_t threadMain_process(CO_NMT_reset_cmd_t *reset)
 {
-  uint16_t finished;
-  uint16_t diff;
-  uint64_t now;
+  CO_time_us_t now;
+  CO_time_us_t deadline;
 
-  now = CO_LinuxThreads_clock_gettime_ms();
-  diff = (uint16_t)(now - threadMain.start);
-
-  /* we use timerNext_ms in CO_process() as indication if processing is
-   * finished. We ignore any calculated values for maximum delay times. */
+  /* Deadline, which is not in the future, means processing is not finished,
+   * so call it again. Otherwise return the delay until the deadline. */
   do {
-    finished = 1;
-    *reset = CO_process(CO, diff, &finished);
-    diff = 0;
-  } while ((*reset == CO_RESET_NOT) && (finished == 0));
+    now = CO_timeNow(CO);
+    deadline = now + (CO_time_us_t)CO_THREAD_MAIN_SLEEP_MAX_MS * 1000;
+    *reset = CO_process_us(CO, now, &deadline);
+  } while ((*reset == CO_RESET_NOT) && (deadline <= now));
 
-  /* prepare next call */
-  threadMain.start = now;
+  /* round up, so deadline is expired, when thread is woken up */
+  return (deadline > now) ? (uint16_t)((deadline - now + 999) / 1000) : 0;
 }
 
 /* Realtime thread (threadRT) *****************************************************/
 static struct {
-  uint32_t us_interval;         /* configured interval in us */
   int interval_fd;              /* timer fd */
+  uint64_t interval_ns;         /* timer interval */
+  uint64_t expected_ns;         /* CLOCK_MONOTONIC of next timer expiration */
+  uint32_t busyPoll_us;         /* from CANrx_threadTmr_setRT() */
+  CO_RTjitter_t jitter;
 } threadRT;
 
+static uint64_t CANrx_threadTmr_now_ns(void)
+{
+  struct timespec ts;
+
+  (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void CANrx_threadTmr_resetJitter(void)
+{
+  threadRT.jitter.count = 0;
+  threadRT.jitter.overruns = 0;
+  threadRT.jitter.latencyMin = INT32_MAX;
+  threadRT.jitter.latencyMax = 0;
+  threadRT.jitter.latencySum = 0;
+}
+
 void CANrx_threadTmr_init(uint16_t interval)
 {
   struct itimerspec itval;
 
-  threadRT.us_interval = interval * 1000;
   /* set up non-blocking interval timer */
   threadRT.interval_fd = timerfd_create(CLOCK_MONOTONIC, 0);
   (void)fcntl(threadRT.interval_fd, F_SETFL, O_NONBLOCK);
   itval.it_interval.tv_sec = 0;
   itval.it_interval.tv_nsec = interval * 1000000;
   itval.it_value = itval.it_interval;
+  threadRT.interval_ns = (uint64_t)interval * 1000000;
+  threadRT.expected_ns = CANrx_threadTmr_now_ns() + threadRT.interval_ns;
   (void)timerfd_settime(threadRT.interval_fd, 0, &itval, NULL);
+
+  threadRT.busyPoll_us = 0;
+  CANrx_threadTmr_resetJitter();
 }
 
 void CANrx_threadTmr_close(void)
@@ -132,36 +162,134 @@ void CANrx_threadTmr_close(void)
   threadRT.interval_fd = -1;
 }
 
+bool_t CANrx_threadTmr_setRT(const CO_RTconfig_t *config)
+{
+  bool_t ret = true;
+
+  if (config == NULL) {
+    return false;
+  }
+
+  if (config->priority > 0) {
+    struct sched_param param;
+
+    memset(&param, 0, sizeof(param));
+    param.sched_priority = config->priority;
+    errno = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+    if (errno != 0) {
+      log_printf(LOG_WARNING, DBG_ERRNO, "pthread_setschedparam()");
+      ret = false;
+    }
+  }
+
+  if (config->cpu >= 0) {
+    cpu_set_t cpuset;
+
+    CPU_ZERO(&cpuset);
+    CPU_SET(config->cpu, &cpuset);
+    errno = pthread_setaffinity_np(pthread_self(), sizeof(cpuset), &cpuset);
+    if (errno != 0) {
+      log_printf(LOG_WARNING, DBG_ERRNO, "pthread_setaffinity_np()");
+      ret = false;
+    }
+  }
+
+  if (config->lockMemory) {
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+      log_printf(LOG_WARNING, DBG_ERRNO, "mlockall()");
+      ret = false;
+    }
+  }
+
+  /* map stack pages now, not inside realtime loop */
+  if (config->stackPrefault > 0) {
+    volatile uint8_t *stack = alloca(config->stackPrefault);
+    size_t i;
+
+    for (i = 0; i < config->stackPrefault; i += 1024) {
+      stack[i] = 0;
+    }
+  }
+
+  threadRT.busyPoll_us = config->busyPoll_us;
+
+  return ret;
+}
+
+void CANrx_threadTmr_getJitter(CO_RTjitter_t *jitter, bool_t reset)
+{
+  if (jitter != NULL) {
+    *jitter = threadRT.jitter;
+    if (jitter->count == 0) {
+      jitter->latencyMin = 0;
+    }
+  }
+  if (reset) {
+    CANrx_threadTmr_resetJitter();
+  }
+}
+
 void CANrx_threadTmr_process(void)
 {
   int32_t result;
-  int32_t i;
   bool_t syncWas;
   unsigned long long missed;
 
+  /* Busy poll: epoll file descriptor of the driver is readable, when CAN
+   * socket, timer or pipe is ready. Spin on it without blocking inside the
+   * window, then CO_CANrxWait() blocks as usual. */
+  if (threadRT.busyPoll_us > 0) {
+    struct pollfd pfd;
+    uint64_t end = CANrx_threadTmr_now_ns() + (uint64_t)threadRT.busyPoll_us * 1000;
+
+    pfd.fd = CO->CANmodule[0]->fdEpoll;
+    pfd.events = POLLIN;
+    while (poll(&pfd, 1, 0) == 0 && CANrx_threadTmr_now_ns() < end) {
+    }
+  }
+
   result = CO_CANrxWait(CO->CANmodule[0], threadRT.interval_fd, NULL);
   if (result < 0) {
     result = read(threadRT.interval_fd, &missed, sizeof(missed));
     if (result > 0) {
+      /* Latency from the last expiration, which is (missed - 1) intervals
+       * after the expected one. */
+      int64_t latency;
+
+      threadRT.expected_ns += (missed - 1) * threadRT.interval_ns;
+      latency = (int64_t)(CANrx_threadTmr_now_ns() - threadRT.expected_ns);
+      threadRT.expected_ns += threadRT.interval_ns;
+      if (latency > INT32_MAX) {
+        latency = INT32_MAX;
+      }
+      threadRT.jitter.count++;
+      threadRT.jitter.overruns += (uint32_t)(missed - 1);
+      threadRT.jitter.latencySum += latency;
+      if (latency < threadRT.jitter.latencyMin) {
+        threadRT.jitter.latencyMin = (int32_t)latency;
+      }
+      if (latency > threadRT.jitter.latencyMax) {
+        threadRT.jitter.latencyMax = (int32_t)latency;
+      }
+
       /* at least one timer interval occured */
       CO_LOCK_OD();
 
       if(CO->CANmodule[0]->CANnormal) {
-
-        for (i = 0; i <= missed; i++) {
+        /* Time is measured, so missed intervals need no extra processing */
+        CO_time_us_t now = CO_timeNow(CO);
 
 #if CO_NO_SYNC == 1
-          /* Process Sync */
-          syncWas = CO_process_SYNC(CO, threadRT.us_interval);
+        /* Process Sync */
+        syncWas = CO_process_SYNC_us(CO, now);
 #else
-          syncWas = false;
+        syncWas = false;
 #endif
-          /* Read inputs */
-          CO_process_RPDO(CO, syncWas);
+        /* Read inputs */
+        CO_process_RPDO(CO, syncWas);
 
-          /* Write outputs */
-          CO_process_TPDO(CO, syncWas, threadRT.us_interval);
-        }
+        /* Write outputs */
+        CO_process_TPDO_us(CO, syncWas, now);
       }
 
       CO_UNLOCK_OD();
@@ -27,6 +27,8 @@
 #ifndef CO_LINUX_TASKS_H
 #define CO_LINUX_TASKS_H
 
+#include <stddef.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -38,12 +40,19 @@ extern "C" {
  * Like the CO socketCAN driver implementation, this driver uses the global CO
  * object and has one thread-local struct for variables. */
 
+/**
+ * Maximum delay in milliseconds, returned by threadMain_process().
+ */
+#ifndef CO_THREAD_MAIN_SLEEP_MAX_MS
+#define CO_THREAD_MAIN_SLEEP_MAX_MS 10000
+#endif
+
 /**
  * Initialize mainline thread.
  *
  * threadMain is non-realtime thread for CANopenNode processing. It is nonblocking
- * and should be called cyclically in 50 ms intervals or less if necessary. This
- * is indicated by the callback function.
+ * and should be called after the delay returned by threadMain_process() or
+ * immediately, if this is indicated by the callback function.
  * This thread processes CO_process() function from CANopen.c file.
  *
  * @param callback this function is called to indicate #threadMain_process() has
@@ -63,8 +72,12 @@ extern void threadMain_close(void);
  * Function must be called cyclically and after callback
  *
  * @param reset return value from CO_process() function.
+ *
+ * @return Delay in milliseconds, after which function must be called again,
+ * if callback is not called before. It is the earliest deadline of CANopen
+ * objects, but not more than CO_THREAD_MAIN_SLEEP_MAX_MS.
  */
-extern void threadMain_process(CO_NMT_reset_cmd_t *reset);
+extern uint16_t threadMain_process(CO_NMT_reset_cmd_t *reset);
 
 /**
  * Initialize realtime thread.
@@ -88,6 +101,63 @@ extern void CANrx_threadTmr_init(uint16_t interval);
  */
 extern void CANrx_threadTmr_close(void);
 
+/**
+ * Configuration of realtime run mode, see CANrx_threadTmr_setRT().
+ */
+typedef struct {
+  /** SCHED_FIFO priority of the calling thread (1...99). If 0, scheduling
+   * policy is not changed. */
+  int       priority;
+  /** CPU, to which the calling thread is pinned. If -1, affinity is not
+   * changed. */
+  int       cpu;
+  /** If true, all current and future memory of the process is locked with
+   * mlockall(). */
+  bool_t    lockMemory;
+  /** Number of bytes of stack, which are touched in advance. 0 to disable. */
+  size_t    stackPrefault;
+  /** CANrx_threadTmr_process() polls CAN sockets and timer without blocking
+   * for this time, before it blocks. 0 to disable. */
+  uint32_t  busyPoll_us;
+} CO_RTconfig_t;
+
+/**
+ * Statistics of realtime thread wakeups, see CANrx_threadTmr_getJitter().
+ *
+ * Latency is the time from the timer expiration until it is read by
+ * CANrx_threadTmr_process(). Jitter of the cycle is latencyMax - latencyMin.
+ */
+typedef struct {
+  uint32_t  count;        /**< Number of timer cycles measured */
+  uint32_t  overruns;     /**< Number of timer expirations, which were missed */
+  int32_t   latencyMin;   /**< Minimum latency in nanoseconds */
+  int32_t   latencyMax;   /**< Maximum latency in nanoseconds */
+  int64_t   latencySum;   /**< Sum of latencies in nanoseconds, for average */
+} CO_RTjitter_t;
+
+/**
+ * Configure realtime run mode for the calling thread.
+ *
+ * Function should be called from the realtime thread after
+ * CANrx_threadTmr_init() and before the loop with CANrx_threadTmr_process().
+ * It sets SCHED_FIFO priority and CPU affinity of the calling thread, locks
+ * memory, prefaults stack and enables busy polling. Settings, which fail, are
+ * logged and the rest are still applied.
+ *
+ * @param config Configuration, see #CO_RTconfig_t.
+ *
+ * @return True, if all settings were applied.
+ */
+extern bool_t CANrx_threadTmr_setRT(const CO_RTconfig_t *config);
+
+/**
+ * Get achieved wakeup latency and jitter of realtime thread.
+ *
+ * @param jitter Statistics are copied here.
+ * @param reset If true, statistics are cleared after copy.
+ */
+extern void CANrx_threadTmr_getJitter(CO_RTjitter_t *jitter, bool_t reset);
+
 /**
  * Process realtime thread.
  *
@@ -55,6 +55,7 @@
 
 pthread_mutex_t CO_EMCY_mutex = PTHREAD_MUTEX_INITIALIZER;
 pthread_mutex_t CO_OD_mutex = PTHREAD_MUTEX_INITIALIZER;
+volatile uint32_t CO_OD_seq = 0;
 
 #ifndef CO_DRIVER_MULTI_INTERFACE
 static CO_ReturnError_t CO_CANmodule_addInterface(CO_CANmodule_t *CANmodule, const void *CANdriverState);
@@ -352,7 +353,6 @@ CO_ReturnError_t CO_CANmodule_addInterface(
         log_printf(LOG_DEBUG, DBG_ERRNO, "setsockopt(ovfl)");
         return CO_ERROR_SYSCALL;
     }
-#ifdef CO_DRIVER_MULTI_INTERFACE
     /* enable software time stamp mode (hardware timestamps do not work properly
      * on all devices)*/
     tmp = (SOF_TIMESTAMPING_SOFTWARE |
@@ -362,7 +362,6 @@ CO_ReturnError_t CO_CANmodule_addInterface(
         log_printf(LOG_DEBUG, DBG_ERRNO, "setsockopt(timestamping)");
         return CO_ERROR_SYSCALL;
     }
-#endif
 
     //todo - modify rx buffer size? first one needs root
     //ret = setsockopt(fd, SOL_SOCKET, SO_RCVBUFFORCE, (void *)&bytes, sLen);
@@ -479,6 +478,34 @@ uint16_t CO_CANrxMsg_readIdent(const CO_CANrxMsg_t *rxMsg)
 }
 
 
+/******************************************************************************/
+uint32_t CO_CANrxMsg_readTimestamp(const CO_CANrxMsg_t *rxMsg)
+{
+    return rxMsg->timestamp;
+}
+
+
+/******************************************************************************/
+uint32_t CO_CANtimestampNow(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t)((uint64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000);
+}
+
+
+/******************************************************************************/
+CO_time_us_t CO_timebase_us(void *object)
+{
+    struct timespec now;
+
+    (void)object;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (CO_time_us_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+
 /******************************************************************************/
 CO_ReturnError_t CO_CANrxBufferInit(
         CO_CANmodule_t         *CANmodule,
@@ -772,7 +799,7 @@ void CO_CANverifyErrors(CO_CANmodule_t *CANmodule)
 static CO_ReturnError_t CO_CANread(
         CO_CANmodule_t         *CANmodule,
         CO_CANinterface_t      *interface,
-        struct can_frame       *msg,
+        CO_CANrxMsg_t          *msg,
         struct timespec        *timestamp)
 {
     int32_t n;
@@ -781,11 +808,17 @@ static CO_ReturnError_t CO_CANread(
      * example in berlios candump.c */
     struct iovec iov;
     struct msghdr msghdr;
-    char ctrlmsg[CMSG_SPACE(sizeof(struct timeval)) + CMSG_SPACE(sizeof(dropped))];
+    /* SO_TIMESTAMPING delivers three timestamps (struct scm_timestamping) */
+    char ctrlmsg[CMSG_SPACE(3 * sizeof(struct timespec)) + CMSG_SPACE(sizeof(dropped))];
     struct cmsghdr *cmsg;
+    struct timespec now;
+
+    timestamp->tv_sec = 0;
+    timestamp->tv_nsec = 0;
 
+    /* CO_CANrxMsg_t starts with struct can_frame */
     iov.iov_base = msg;
-    iov.iov_len = sizeof(*msg);
+    iov.iov_len = CAN_MTU;
 
     msghdr.msg_name = NULL;
     msghdr.msg_namelen = 0;
@@ -829,12 +862,28 @@ static CO_ReturnError_t CO_CANread(
         }
     }
 
+    /* Translate reception time to monotonic clock, which is used by the
+     * CANopen objects. If there is no timestamp, use current time. */
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    msg->timestamp = (uint32_t)((uint64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000);
+    if (timestamp->tv_sec != 0) {
+        struct timespec realNow;
+        int64_t age_us;
+
+        clock_gettime(CLOCK_REALTIME, &realNow);
+        age_us = ((int64_t)realNow.tv_sec - timestamp->tv_sec) * 1000000
+               + (realNow.tv_nsec - timestamp->tv_nsec) / 1000;
+        if (age_us > 0) {
+            msg->timestamp -= (uint32_t)age_us;
+        }
+    }
+
     return CO_ERROR_NO;
 }
 
 static int32_t CO_CANrxMsg(
         CO_CANmodule_t        *CANmodule,
-        struct can_frame      *msg,
+        CO_CANrxMsg_t         *msg,
         CO_CANrxMsg_t         *buffer)
 {
     int32_t retval;
@@ -845,8 +894,8 @@ static int32_t CO_CANrxMsg(
 
     /* CANopenNode can message is binary compatible to the socketCAN one, except
      * for extension flags */
-    msg->can_id &= CAN_EFF_MASK;
-    rcvMsg = (CO_CANrxMsg_t *)msg;
+    msg->ident &= CAN_EFF_MASK;
+    rcvMsg = msg;
 
     /* Message has been received. Search rxArray from CANmodule for the
      * same CAN-ID. */
@@ -887,7 +936,7 @@ int32_t CO_CANrxWait(CO_CANmodule_t *CANmodule, int fdTimer, CO_CANrxMsg_t *buff
     CO_ReturnError_t err;
     CO_CANinterface_t *interface = NULL;
     struct epoll_event ev[1];
-    struct can_frame msg;
+    CO_CANrxMsg_t msg;
     struct timespec timestamp;
 
     if (CANmodule==NULL || CANmodule->CANinterfaceCount==0) {
@@ -923,7 +972,7 @@ int32_t CO_CANrxWait(CO_CANmodule_t *CANmodule, int fdTimer, CO_CANrxMsg_t *buff
         else if ((ev[0].events & (EPOLLERR | EPOLLHUP)) != 0) {
             /* epoll detected close/error on socket. Try to pull event */
             errno = 0;
-            recv(ev[0].data.fd, &msg, sizeof(msg), MSG_DONTWAIT);
+            recv(ev[0].data.fd, &msg, CAN_MTU, MSG_DONTWAIT);
             log_printf(LOG_DEBUG, DBG_CAN_RX_EPOLL, ev[0].events, strerror(errno));
             continue;
         }
@@ -965,10 +1014,10 @@ int32_t CO_CANrxWait(CO_CANmodule_t *CANmodule, int fdTimer, CO_CANrxMsg_t *buff
     retval = -1;
     if(CANmodule->CANnormal){
 
-        if (msg.can_id & CAN_ERR_FLAG) {
+        if (msg.ident & CAN_ERR_FLAG) {
             /* error msg */
 #ifdef CO_DRIVER_ERROR_REPORTING
-            CO_CANerror_rxMsgError(&interface->errorhandler, &msg);
+            CO_CANerror_rxMsgError(&interface->errorhandler, (struct can_frame *)&msg);
 #endif
         }
         else {
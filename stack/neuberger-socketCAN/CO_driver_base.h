@@ -177,9 +177,16 @@ extern pthread_mutex_t CO_EMCY_mutex;
 static inline int CO_LOCK_EMCY()    { return pthread_mutex_lock(&CO_EMCY_mutex); }  /**< Lock critical section in CO_errorReport() or CO_errorReset() */
 static inline void CO_UNLOCK_EMCY() { (void)pthread_mutex_unlock(&CO_EMCY_mutex); } /**< Unlock critical section in CO_errorReport() or CO_errorReset() */
 
+/**
+ * OD lock is held by writers only. Sequence counter CO_OD_seq is incremented
+ * on lock and unlock, so readers can copy OD data without lock, see
+ * CO_OD_readCopy().
+ */
+#define CO_OD_SEQLOCK
 extern pthread_mutex_t CO_OD_mutex;
-static inline int CO_LOCK_OD()      { return pthread_mutex_lock(&CO_OD_mutex); }    /**< Lock critical section when accessing Object Dictionary */
-static inline void CO_UNLOCK_OD()   { (void)pthread_mutex_unlock(&CO_OD_mutex); }   /**< Unock critical section when accessing Object Dictionary */
+extern volatile uint32_t CO_OD_seq; /**< Odd while OD is locked by writer */
+static inline int CO_LOCK_OD()      { int ret = pthread_mutex_lock(&CO_OD_mutex); CO_OD_seq++; __sync_synchronize(); return ret; } /**< Lock critical section when writing Object Dictionary */
+static inline void CO_UNLOCK_OD()   { __sync_synchronize(); CO_OD_seq++; (void)pthread_mutex_unlock(&CO_OD_mutex); }              /**< Unock critical section when writing Object Dictionary */
 
 /** @} */
 
@@ -229,7 +236,23 @@ typedef unsigned char           domain_t;   /**< domain_t */
 #define CO_CAN_MSG_SFF_MAX_COB_ID (1 << CAN_SFF_ID_BITS)
 
 /**
- * CAN receive message structure as aligned in socketCAN.
+ * Received messages carry time of reception, see CO_CANrxMsg_readTimestamp().
+ */
+#define CO_CAN_RX_TIMESTAMP
+
+/**
+ * CLOCK_MONOTONIC is used as default time source, see CO_timebase_us().
+ */
+#define CO_TIMEBASE_US
+
+/**
+ * GCC atomic builtins are used by lock-free emergency buffer, see CO_EM_t.
+ */
+#define CO_USE_GCC_ATOMICS
+
+/**
+ * CAN receive message structure as aligned in socketCAN. First part is the
+ * same as struct can_frame, reception time is appended by the driver.
  */
 typedef struct{
     /** CAN identifier. It must be read through CO_CANrxMsg_readIdent() function. */
@@ -237,6 +260,9 @@ typedef struct{
     uint8_t             DLC ;           /**< Length of CAN message */
     uint8_t             padding[3];     /**< ensure alignment */
     uint8_t             data[8];        /**< 8 data bytes */
+    /** Reception time in [microseconds], CLOCK_MONOTONIC based. It must be
+     * read through CO_CANrxMsg_readTimestamp() function. */
+    uint32_t            timestamp;
 }CO_CANrxMsg_t;
 
 /**
@@ -24,6 +24,7 @@
 
 
 #include "CANopen.h"
+#include "CO_Linux_tasks.h"
 #include <errno.h>
 #include <fcntl.h>
 #ifdef HAVE_TIMERFD
@@ -46,7 +47,8 @@ static struct {
     int                 fdTmr;          /* file descriptor for taskTmr */
     int                 fdPipe[2];      /* file descriptors for pipe [0]=read, [1]=write */
     struct itimerspec   tmrSpec;
-    uint16_t            tmr1msPrev;
+    CO_time_us_t        timePrev;       /* time of previous processing */
+    uint16_t            timerNext;      /* delay until next deadline in ms */
     uint16_t           *maxTime;
 } taskMain;
 
@@ -115,7 +117,8 @@ void taskMain_init(int fdEpoll, uint16_t *maxTime) {
     }
 #endif
 
-    taskMain.tmr1msPrev = 0;
+    taskMain.timePrev = CO_timeNow(CO);
+    taskMain.timerNext = 0;
     taskMain.maxTime = maxTime;
 }
 
@@ -127,7 +130,7 @@ void taskMain_close(void) {
 }
 
 
-bool_t taskMain_process(int fd, CO_NMT_reset_cmd_t *reset, uint16_t timer1ms) {
+bool_t taskMain_process(int fd, CO_NMT_reset_cmd_t *reset) {
     bool_t wasProcessed = true;
 
     /* Signal from pipe, consume all bytes. */
@@ -157,27 +160,34 @@ bool_t taskMain_process(int fd, CO_NMT_reset_cmd_t *reset, uint16_t timer1ms) {
 
     /* Process mainline. */
     if(wasProcessed) {
-        uint16_t timer1msDiff;
-        uint16_t timerNext = 50;
-
-        /* Calculate time difference */
-        timer1msDiff = timer1ms - taskMain.tmr1msPrev;
-        taskMain.tmr1msPrev = timer1ms;
+        CO_time_us_t now = CO_timeNow(CO);
+        CO_time_us_t deadline = now + (CO_time_us_t)CO_TASK_MAIN_SLEEP_MAX_MS * 1000;
+        CO_time_us_t delay;
+        CO_time_us_t interval;
 
         /* Calculate maximum interval in milliseconds (informative) */
+        interval = (now - taskMain.timePrev) / 1000;
+        taskMain.timePrev = now;
         if(taskMain.maxTime != NULL) {
-            if(timer1msDiff > *taskMain.maxTime) {
-                *taskMain.maxTime = timer1msDiff;
+            if(interval > 0xFFFF) {
+                *taskMain.maxTime = 0xFFFF;
+            } else if(interval > *taskMain.maxTime) {
+                *taskMain.maxTime = (uint16_t)interval;
             }
         }
 
 
         /* CANopen process */
-        *reset = CO_process(CO, timer1msDiff, &timerNext);
+        *reset = CO_process_us(CO, now, &deadline);
 
 
-        /* Set delay for next sleep. */
-        taskMain.tmrSpec.it_value.tv_nsec = (long)(++timerNext) * NSEC_PER_MSEC;
+        /* Set delay for next sleep: sleep until the earliest deadline reported
+         * by CANopen objects, or until pipe is triggered by CANrx callback.
+         * Zero delay would disarm the timer, so use at least 1us. */
+        delay = (deadline > now) ? (deadline - now) : 1;
+        taskMain.timerNext = (uint16_t)((delay + 999) / 1000);
+        taskMain.tmrSpec.it_value.tv_sec = (time_t)(delay / 1000000);
+        taskMain.tmrSpec.it_value.tv_nsec = (long)(delay % 1000000) * 1000;
 #ifdef HAVE_TIMERFD
         if(timerfd_settime(taskMain.fdTmr, 0, &taskMain.tmrSpec, NULL) == -1)
             CO_error(0x21500000L + errno);
@@ -189,6 +199,11 @@ bool_t taskMain_process(int fd, CO_NMT_reset_cmd_t *reset, uint16_t timer1ms) {
 }
 
 
+uint16_t taskMain_getTimerNext(void) {
+    return taskMain.timerNext;
+}
+
+
 void taskMain_cbSignal(void) {
     if(write(taskMain.fdPipe[1], "x", 1) == -1)
         CO_error(0x23100000L + errno);
@@ -308,9 +323,10 @@ bool_t CANrx_taskTmr_process(int fd) {
 
         if(CO->CANmodule[0]->CANnormal) {
             bool_t syncWas;
+            CO_time_us_t now = CO_timeNow(CO);
 
             /* Process Sync */
-            syncWas = CO_process_SYNC(CO, taskRT.intervalus);
+            syncWas = CO_process_SYNC_us(CO, now);
 
             /* Read inputs */
             CO_process_RPDO(CO, syncWas);
@@ -318,7 +334,7 @@ bool_t CANrx_taskTmr_process(int fd) {
             /* Further I/O or nonblocking application code may go here. */
 
             /* Write outputs */
-            CO_process_TPDO(CO, syncWas, taskRT.intervalus);
+            CO_process_TPDO_us(CO, syncWas, now);
         }
 
         /* Unlock */
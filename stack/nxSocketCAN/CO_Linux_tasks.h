@@ -27,11 +27,29 @@
 #define CO_LINUX_TASKS_H
 
 
+/**
+ * Maximum sleep time of taskMain in milliseconds.
+ *
+ * taskMain sleeps until the earliest deadline, reported by CO_process() in
+ * timerNext_ms, or until it is triggered by taskMain_cbSignal(). This value
+ * limits the sleep on idle node. It must be lower than 65535, because
+ * taskMain_getTimerNext() returns 16-bit value.
+ */
+#ifndef CO_TASK_MAIN_SLEEP_MAX_MS
+#define CO_TASK_MAIN_SLEEP_MAX_MS 10000
+#endif
+
+
 /**
  * Initialize mainline task.
  *
  * taskMain is non-realtime task for CANopenNode processing. It is nonblocking
- * and is executing cyclically in 50 ms intervals or less if necessary.
+ * and is executing, when the earliest deadline of CANopen objects expires (see
+ * timerNext_ms in CO_process()), but at least every CO_TASK_MAIN_SLEEP_MAX_MS.
+ * It is also executing immediately after taskMain_cbSignal(), which should be
+ * registered with CO_SDO_initCallback(), CO_EM_initCallback(),
+ * CO_NMT_initCallbackSignal(), CO_HBconsumer_initCallbackSignal() and
+ * CO_TIME_initCallback().
  * It uses Linux epoll, timerfd for interval and pipe for task triggering.
  * This task processes CO_process() function from CANopen.c file.
  *
@@ -49,15 +67,25 @@ void taskMain_close(void);
 /**
  * Process mainline task.
  *
- * Function must be called after epoll.
+ * Function must be called after epoll. Time is read with CO_timeNow() and
+ * objects are processed with CO_process_us(). Timer is set with microsecond
+ * resolution to the earliest deadline.
  *
  * @param fd Available file descriptor from epoll().
  * @param reset return value from CO_process() function.
- * @param timer1ms variable, which must increment each millisecond.
  *
  * @return True, if fd was matched.
  */
-bool_t taskMain_process(int fd, CO_NMT_reset_cmd_t *reset, uint16_t timer1ms);
+bool_t taskMain_process(int fd, CO_NMT_reset_cmd_t *reset);
+
+/**
+ * Get delay until next deadline of mainline task.
+ *
+ * @return Delay from the last processing until the earliest deadline, in
+ * milliseconds, rounded up. May be used as epoll timeout, if timerfd is not
+ * available.
+ */
+uint16_t taskMain_getTimerNext(void);
 
 /**
  * Signal function, which triggers mainline task.
@@ -50,6 +50,9 @@ CO_SDO_abortCode_t CO_ODF_1011(CO_ODF_arg_t *ODF_arg);
  * to filename, adds two bytes of CRC code. It then verifies the written file and
  * in case of errors sets back the old file and returns error.
  *
+ * Memory block is first copied into temporary buffer with CO_OD_readCopy(), so
+ * OD is not locked during file operations.
+ *
  * Function is used with CANopen OD object at index 1010.
  *
  * @param odAddress Address of the memory block, which will be stored.
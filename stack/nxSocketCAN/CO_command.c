@@ -652,6 +652,40 @@ if(strcmp(token, "w") == 0 || strcmp(token, "write") == 0) {
         }
         else
 
+#ifdef CO_USE_PROFILER
+        /* profiler command - 'profiler' prints cycle time statistics in CSV
+         * format, 'profiler reset' clears them, 'profiler export' writes them
+         * to Object Dictionary, see CO_profiler_setODexport() */
+        if(strcmp(token, "profiler") == 0) {
+            int errTok = 0;
+
+            token = getTok(NULL, spaceDelim, &errTok);
+            if(token == NULL || *token == '#') {
+                respLen = sprintf(resp, "[%d] OK\n", sequence);
+                /* leave space for line termination */
+                respLen += CO_profiler_printCSV(&CO->profiler, resp + respLen, respSize - respLen - 3);
+            }
+            else if(strcmp(token, "reset") == 0) {
+                lastTok(NULL, spaceDelim, &err);
+                if(err == 0) {
+                    CO_profiler_reset(&CO->profiler);
+                    respLen = sprintf(resp, "[%d] OK", sequence);
+                }
+            }
+            else if(strcmp(token, "export") == 0) {
+                lastTok(NULL, spaceDelim, &err);
+                if(err == 0) {
+                    CO_profiler_exportOD(&CO->profiler);
+                    respLen = sprintf(resp, "[%d] OK", sequence);
+                }
+            }
+            else {
+                err = 1;
+            }
+        }
+        else
+#endif
+
         /* LSS command */
 #if CO_NO_LSS_CLIENT == 1
           if (strstr(token, "lss_") != NULL) {
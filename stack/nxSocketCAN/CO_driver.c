@@ -25,9 +25,11 @@
 
 #include "CO_driver.h"
 #include "CO_Emergency.h"
+#include "../socketCAN/CO_filter.h"
 #include <string.h> /* for memcpy */
 #include <stdlib.h> /* for malloc, free */
 #include <errno.h>
+#include <time.h>
 #include <sys/socket.h>
 #include <netpacket/can.h>
 #include <nuttx/can.h>
@@ -37,6 +39,7 @@
 #ifndef CO_SINGLE_THREAD
     pthread_mutex_t CO_EMCY_mtx = PTHREAD_MUTEX_INITIALIZER;
     pthread_mutex_t CO_OD_mtx = PTHREAD_MUTEX_INITIALIZER;
+    volatile uint32_t CO_OD_seq = 0;
 #endif
 
 
@@ -55,26 +58,10 @@ static CO_ReturnError_t setFilters(CO_CANmodule_t *CANmodule){
         if(filtersOut == NULL){
             ret = CO_ERROR_OUT_OF_MEMORY;
         }else{
-            int i;
-            int idZeroCnt = 0;
-
-            /* Copy filterIn to filtersOut. Accept only first filter with
-             * can_id=0, omit others. */
-            for(i=0; i<nFiltersIn; i++){
-                struct can_filter *fin;
-
-                fin = &CANmodule->filter[i];
-                if(fin->can_id == 0){
-                    idZeroCnt++;
-                }
-                if(fin->can_id != 0 || idZeroCnt == 1){
-                    struct can_filter *fout;
-
-                    fout = &filtersOut[nFiltersOut++];
-                    fout->can_id = fin->can_id;
-                    fout->can_mask = fin->can_mask;
-                }
-            }
+            /* Copy filterIn to filtersOut and merge them into minimal set.
+             * Unused filters (can_id=0) are merged into one. */
+            memcpy(filtersOut, CANmodule->filter, sizeof(struct can_filter) * nFiltersIn);
+            nFiltersOut = CO_filter_compress(filtersOut, nFiltersIn);
 
             if(setsockopt(CANmodule->fd, SOL_CAN_RAW, CAN_RAW_FILTER,
                           filtersOut, sizeof(struct can_filter) * nFiltersOut) != 0)
@@ -228,6 +215,16 @@ uint16_t CO_CANrxMsg_readIdent(const CO_CANrxMsg_t *rxMsg){
 }
 
 
+/******************************************************************************/
+CO_time_us_t CO_timebase_us(void *object){
+    struct timespec now;
+
+    (void)object;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (CO_time_us_t)now.tv_sec * 1000000U + (CO_time_us_t)now.tv_nsec / 1000U;
+}
+
+
 /******************************************************************************/
 CO_ReturnError_t CO_CANrxBufferInit(
         CO_CANmodule_t         *CANmodule,
@@ -82,9 +82,15 @@
     #define CO_LOCK_EMCY()          {if(pthread_mutex_lock(&CO_EMCY_mtx) != 0) CO_errExit("Mutex lock CO_EMCY_mtx failed");}
     #define CO_UNLOCK_EMCY()        {if(pthread_mutex_unlock(&CO_EMCY_mtx) != 0) CO_errExit("Mutex unlock CO_EMCY_mtx failed");}
 
+    /* OD lock is held by writers only. It increments CO_OD_seq on lock and
+     * unlock, so readers can copy OD data without lock, see CO_OD_readCopy(). */
     extern pthread_mutex_t CO_OD_mtx;
-    #define CO_LOCK_OD()            {if(pthread_mutex_lock(&CO_OD_mtx) != 0) CO_errExit("Mutex lock CO_OD_mtx failed");}
-    #define CO_UNLOCK_OD()          {if(pthread_mutex_unlock(&CO_OD_mtx) != 0) CO_errExit("Mutex unlock CO_OD_mtx failed");}
+    extern volatile uint32_t CO_OD_seq;
+    #define CO_OD_SEQLOCK
+    #define CO_LOCK_OD()            {if(pthread_mutex_lock(&CO_OD_mtx) != 0) CO_errExit("Mutex lock CO_OD_mtx failed"); \
+                                     CO_OD_seq++; CANrxMemoryBarrier();}
+    #define CO_UNLOCK_OD()          {CANrxMemoryBarrier(); CO_OD_seq++; \
+                                     if(pthread_mutex_unlock(&CO_OD_mtx) != 0) CO_errExit("Mutex unlock CO_OD_mtx failed");}
 
     #define CANrxMemoryBarrier()    {__sync_synchronize();}
 #endif /* CO_SINGLE_THREAD */
@@ -95,6 +101,14 @@
 #define CLEAR_CANrxNew(rxNew) {CANrxMemoryBarrier(); rxNew = (void*)0L;}
 
 
+/* GCC atomic builtins are used by lock-free emergency buffer, see CO_EM_t. */
+#define CO_USE_GCC_ATOMICS
+
+
+/* CLOCK_MONOTONIC is used as default time source, see CO_timebase_us(). */
+#define CO_TIMEBASE_US
+
+
 /* Data types */
 /* int8_t to uint64_t are defined in stdint.h */
 typedef _Bool                   bool_t;
@@ -72,6 +72,7 @@ int sdoClientUpload(
 
         do {
             uint16_t timer1ms, timer1msDiff;
+            uint16_t timerNext_ms = 1U;
 
             /* Calculate time difference */
             timer1ms = CO_timer1ms;
@@ -79,7 +80,12 @@ int sdoClientUpload(
             timer1msPrev = timer1ms;
 
             ret = CO_SDOclientUpload(SDOclient, timer1msDiff, SDOtimeoutTime, dataRxLen, SDOabortCode);
-            nanosleep(&sleepTime, NULL);
+
+            /* Don't sleep, if more messages are waiting in queue */
+            CO_SDOclient_timerNext(SDOclient, &timerNext_ms);
+            if(timerNext_ms > 0U){
+                nanosleep(&sleepTime, NULL);
+            }
         } while(ret > 0);
 
         CO_SDOclientClose(SDOclient);
@@ -135,6 +141,7 @@ int sdoClientDownload(
 
         do {
             uint16_t timer1ms, timer1msDiff;
+            uint16_t timerNext_ms = 1U;
 
             /* Calculate time difference */
             timer1ms = CO_timer1ms;
@@ -142,7 +149,12 @@ int sdoClientDownload(
             timer1msPrev = timer1ms;
 
             ret = CO_SDOclientDownload(SDOclient, timer1msDiff, SDOtimeoutTime, SDOabortCode);
-            nanosleep(&sleepTime, NULL);
+
+            /* Don't sleep, if more messages are waiting in queue */
+            CO_SDOclient_timerNext(SDOclient, &timerNext_ms);
+            if(timerNext_ms > 0U){
+                nanosleep(&sleepTime, NULL);
+            }
         } while(ret > 0);
 
         CO_SDOclientClose(SDOclient);
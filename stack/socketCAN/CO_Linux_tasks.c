@@ -23,9 +23,18 @@
  */
 
 
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE     /* for CPU_SET() */
+#endif
+
 #include "CANopen.h"
+#include "CO_Linux_tasks.h"
 #include <errno.h>
 #include <fcntl.h>
+#include <sched.h>
+#include <string.h>
+#include <alloca.h>
+#include <sys/mman.h>
 #include <sys/timerfd.h>
 #include <sys/epoll.h>
 
@@ -44,7 +53,8 @@ static struct {
     int                 fdTmr;          /* file descriptor for taskTmr */
     int                 fdPipe[2];      /* file descriptors for pipe [0]=read, [1]=write */
     struct itimerspec   tmrSpec;
-    uint16_t            tmr1msPrev;
+    CO_time_us_t        timePrev;       /* time of previous processing */
+    uint16_t            timerNext;      /* delay until next deadline in ms */
     uint16_t           *maxTime;
 } taskMain;
 
@@ -101,7 +111,8 @@ void taskMain_init(int fdEpoll, uint16_t *maxTime) {
     if(timerfd_settime(taskMain.fdTmr, 0, &taskMain.tmrSpec, NULL) != 0)
         CO_errExit("taskMain_init - timerfd_settime failed");
 
-    taskMain.tmr1msPrev = 0;
+    taskMain.timePrev = CO_timeNow(CO);
+    taskMain.timerNext = 0;
     taskMain.maxTime = maxTime;
 }
 
@@ -113,7 +124,7 @@ void taskMain_close(void) {
 }
 
 
-bool_t taskMain_process(int fd, CO_NMT_reset_cmd_t *reset, uint16_t timer1ms) {
+bool_t taskMain_process(int fd, CO_NMT_reset_cmd_t *reset) {
     bool_t wasProcessed = true;
 
     /* Signal from pipe, consume all bytes. */
@@ -141,27 +152,35 @@ bool_t taskMain_process(int fd, CO_NMT_reset_cmd_t *reset, uint16_t timer1ms) {
 
     /* Process mainline. */
     if(wasProcessed) {
-        uint16_t timer1msDiff;
-        uint16_t timerNext = 50;
-
-        /* Calculate time difference */
-        timer1msDiff = timer1ms - taskMain.tmr1msPrev;
-        taskMain.tmr1msPrev = timer1ms;
+        CO_time_us_t now = CO_timeNow(CO);
+        CO_time_us_t deadline = now + (CO_time_us_t)CO_TASK_MAIN_SLEEP_MAX_MS * 1000;
+        CO_time_us_t delay;
+        CO_time_us_t interval;
 
         /* Calculate maximum interval in milliseconds (informative) */
+        interval = (now - taskMain.timePrev) / 1000;
+        taskMain.timePrev = now;
         if(taskMain.maxTime != NULL) {
-            if(timer1msDiff > *taskMain.maxTime) {
-                *taskMain.maxTime = timer1msDiff;
+            if(interval > 0xFFFF) {
+                *taskMain.maxTime = 0xFFFF;
+            } else if(interval > *taskMain.maxTime) {
+                *taskMain.maxTime = (uint16_t)interval;
             }
         }
 
 
         /* CANopen process */
-        *reset = CO_process(CO, timer1msDiff, &timerNext);
+        *reset = CO_process_us(CO, now, &deadline);
+        CO_CANsendFlush(CO->CANmodule[0]);
 
 
-        /* Set delay for next sleep. */
-        taskMain.tmrSpec.it_value.tv_nsec = (long)(++timerNext) * NSEC_PER_MSEC;
+        /* Set delay for next sleep: sleep until the earliest deadline reported
+         * by CANopen objects, or until pipe is triggered by CANrx callback.
+         * Zero delay would disarm the timer, so use at least 1us. */
+        delay = (deadline > now) ? (deadline - now) : 1;
+        taskMain.timerNext = (uint16_t)((delay + 999) / 1000);
+        taskMain.tmrSpec.it_value.tv_sec = (time_t)(delay / 1000000);
+        taskMain.tmrSpec.it_value.tv_nsec = (long)(delay % 1000000) * 1000;
         if(timerfd_settime(taskMain.fdTmr, 0, &taskMain.tmrSpec, NULL) == -1)
             CO_error(0x21500000L + errno);
 
@@ -171,6 +190,11 @@ bool_t taskMain_process(int fd, CO_NMT_reset_cmd_t *reset, uint16_t timer1ms) {
 }
 
 
+uint16_t taskMain_getTimerNext(void) {
+    return taskMain.timerNext;
+}
+
+
 void taskMain_cbSignal(void) {
     if(write(taskMain.fdPipe[1], "x", 1) == -1)
         CO_error(0x23100000L + errno);
@@ -186,14 +210,28 @@ static struct {
     long                intervalns;
     long                intervalus;
     uint16_t           *maxTime;
+    uint32_t            busyPoll_us;    /* from CANrx_taskTmr_setRT() */
+    CO_RTjitter_t       jitter;
+    int                 fdSync;         /* file descriptor for SYNC producer timer */
+    bool_t              syncArmed;      /* fdSync is armed to syncDeadline */
+    CO_time_us_t        syncDeadline;
 } taskRT;
 
 
+static void CANrx_taskTmr_resetJitter(void) {
+    taskRT.jitter.count = 0;
+    taskRT.jitter.overruns = 0;
+    taskRT.jitter.latencyMin = INT32_MAX;
+    taskRT.jitter.latencyMax = 0;
+    taskRT.jitter.latencySum = 0;
+}
+
+
 void CANrx_taskTmr_init(int fdEpoll, long intervalns, uint16_t *maxTime) {
     struct epoll_event ev;
 
     /* get file descriptors */
-    taskRT.fdRx0 = CO->CANmodule[0]->fd;
+    taskRT.fdRx0 = CO->CANmodule[0]->fdRx;
 
     taskRT.fdTmr = timerfd_create(CLOCK_MONOTONIC, 0);
     if(taskRT.fdTmr == -1)
@@ -210,6 +248,17 @@ void CANrx_taskTmr_init(int fdEpoll, long intervalns, uint16_t *maxTime) {
     if(epoll_ctl(fdEpoll, EPOLL_CTL_ADD, taskRT.fdTmr, &ev) == -1)
         CO_errExit("CANrx_taskTmr_init - epoll_ctl taskTmr failed");
 
+    /* SYNC producer timer, armed on SYNC deadline by CANrx_taskTmr_process() */
+    taskRT.fdSync = timerfd_create(CLOCK_MONOTONIC, 0);
+    if(taskRT.fdSync == -1)
+        CO_errExit("CANrx_taskTmr_init - timerfd_create SYNC failed");
+
+    ev.events = EPOLLIN;
+    ev.data.fd = taskRT.fdSync;
+    if(epoll_ctl(fdEpoll, EPOLL_CTL_ADD, taskRT.fdSync, &ev) == -1)
+        CO_errExit("CANrx_taskTmr_init - epoll_ctl SYNC timer failed");
+    taskRT.syncArmed = false;
+
     /* Prepare timer (one shot, each time calculate new expiration time) It is
      * necessary not to use taskRT.tmrSpec.it_interval, because it is sliding. */
     taskRT.tmrSpec.it_interval.tv_sec = 0;
@@ -225,11 +274,164 @@ void CANrx_taskTmr_init(int fdEpoll, long intervalns, uint16_t *maxTime) {
     taskRT.intervalns = intervalns;
     taskRT.intervalus = intervalns / 1000;
     taskRT.maxTime = maxTime;
+    taskRT.busyPoll_us = 0;
+    CANrx_taskTmr_resetJitter();
 }
 
 
 void CANrx_taskTmr_close(void) {
     close(taskRT.fdTmr);
+    close(taskRT.fdSync);
+}
+
+
+/* Arm SYNC timer on deadline of the next SYNC message or disarm it, if this
+ * node is not SYNC producer. timerfd is changed only if deadline changes.
+ * Deadline is in time base of CO_timeNow(), which may be set by
+ * CO_setTimeSource(), so only the remaining time is used and added to
+ * CLOCK_MONOTONIC of the timerfd. */
+static void CANrx_taskTmr_armSync(void) {
+    struct itimerspec spec;
+    CO_time_us_t deadline;
+    bool_t producer = CO_SYNC_getProducerDeadline(CO->SYNC, &deadline);
+
+    if(producer == taskRT.syncArmed && (!producer || deadline == taskRT.syncDeadline)) {
+        return;
+    }
+
+    memset(&spec, 0, sizeof(spec));
+    if(producer) {
+        CO_time_us_t now = CO_timeNow(CO);
+        CO_time_us_t remaining = (deadline > now) ? (deadline - now) : 0U;
+
+        if(clock_gettime(CLOCK_MONOTONIC, &spec.it_value) == -1)
+            CO_error(0x22200000L + errno);
+        spec.it_value.tv_sec += (time_t)(remaining / 1000000U);
+        spec.it_value.tv_nsec += (long)(remaining % 1000000U) * 1000;
+        if(spec.it_value.tv_nsec >= NSEC_PER_SEC) {
+            spec.it_value.tv_sec++;
+            spec.it_value.tv_nsec -= NSEC_PER_SEC;
+        }
+    }
+    if(timerfd_settime(taskRT.fdSync, TFD_TIMER_ABSTIME, &spec, NULL) == -1) {
+        CO_error(0x22700000L + errno);
+        producer = false;
+    }
+    taskRT.syncArmed = producer;
+    taskRT.syncDeadline = deadline;
+}
+
+
+/* Process SYNC, RPDOs and TPDOs. */
+static void CANrx_taskTmr_processCANopen(void) {
+    /* Lock PDOs and OD */
+    CO_LOCK_OD();
+
+    if(CO->CANmodule[0]->CANnormal) {
+        bool_t syncWas;
+        CO_time_us_t now = CO_timeNow(CO);
+
+        /* Process Sync */
+        syncWas = CO_process_SYNC_us(CO, now);
+
+        /* Read inputs */
+        CO_process_RPDO(CO, syncWas);
+
+        /* Further I/O or nonblocking application code may go here. */
+
+        /* Write outputs */
+        CO_process_TPDO_us(CO, syncWas, now);
+
+        CANrx_taskTmr_armSync();
+    }
+    CO_CANsendFlush(CO->CANmodule[0]);
+
+    /* Unlock */
+    CO_UNLOCK_OD();
+}
+
+
+bool_t CANrx_taskTmr_setRT(const CO_RTconfig_t *config) {
+    bool_t ret = true;
+
+    if(config == NULL) {
+        return false;
+    }
+
+    if(config->priority > 0) {
+        struct sched_param param;
+
+        memset(&param, 0, sizeof(param));
+        param.sched_priority = config->priority;
+        errno = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+        if(errno != 0) {
+            CO_error(0x22400000L + errno);
+            ret = false;
+        }
+    }
+
+    if(config->cpu >= 0) {
+        cpu_set_t cpuset;
+
+        CPU_ZERO(&cpuset);
+        CPU_SET(config->cpu, &cpuset);
+        errno = pthread_setaffinity_np(pthread_self(), sizeof(cpuset), &cpuset);
+        if(errno != 0) {
+            CO_error(0x22500000L + errno);
+            ret = false;
+        }
+    }
+
+    if(config->lockMemory) {
+        if(mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+            CO_error(0x22600000L + errno);
+            ret = false;
+        }
+    }
+
+    /* Touch stack, so its pages are mapped now and not inside realtime loop.
+     * With locked memory they stay mapped. */
+    if(config->stackPrefault > 0) {
+        volatile uint8_t *stack = alloca(config->stackPrefault);
+        size_t i;
+
+        for(i = 0; i < config->stackPrefault; i += 1024) {
+            stack[i] = 0;
+        }
+    }
+
+    taskRT.busyPoll_us = config->busyPoll_us;
+
+    return ret;
+}
+
+
+int CANrx_taskTmr_wait(int fdEpoll, struct epoll_event *ev) {
+    if(taskRT.busyPoll_us > 0) {
+        CO_time_us_t end = CO_timeNow(CO) + taskRT.busyPoll_us;
+
+        do {
+            int ready = epoll_wait(fdEpoll, ev, 1, 0);
+            if(ready != 0) {
+                return ready;
+            }
+        } while(CO_timeNow(CO) < end);
+    }
+
+    return epoll_wait(fdEpoll, ev, 1, -1);
+}
+
+
+void CANrx_taskTmr_getJitter(CO_RTjitter_t *jitter, bool_t reset) {
+    if(jitter != NULL) {
+        *jitter = taskRT.jitter;
+        if(jitter->count == 0) {
+            jitter->latencyMin = 0;
+        }
+    }
+    if(reset) {
+        CANrx_taskTmr_resetJitter();
+    }
 }
 
 
@@ -239,25 +441,55 @@ bool_t CANrx_taskTmr_process(int fd) {
     /* Get received CAN message. */
     if(fd == taskRT.fdRx0) {
         CO_CANrxWait(CO->CANmodule[0]);
+        /* Messages may be sent from receive callbacks. */
+        CO_CANsendFlush(CO->CANmodule[0]);
     }
 
     /* Execute taskTmr */
     else if(fd == taskRT.fdTmr) {
         uint64_t tmrExp;
+        /* Number of intervals, by which the next shot is advanced */
+        int64_t intervals = 1;
 
         /* Wait for timer to expire */
         if(read(taskRT.fdTmr, &tmrExp, sizeof(tmrExp)) != sizeof(uint64_t))
             CO_error(0x22100000L + errno);
 
-        /* Calculate maximum interval in microseconds (informative) */
-        if(taskRT.maxTime != NULL) {
+        /* Measure latency from scheduled expiration (informative) */
+        {
             struct timespec tmrMeasure;
+            int64_t latency;
+
             if(clock_gettime(CLOCK_MONOTONIC, &tmrMeasure) == -1)
                 CO_error(0x22200000L + errno);
-            if(tmrMeasure.tv_sec == taskRT.tmrVal->tv_sec) {
-                long dt = tmrMeasure.tv_nsec - taskRT.tmrVal->tv_nsec;
-                dt /= 1000;
-                dt += taskRT.intervalus;
+            latency = (int64_t)(tmrMeasure.tv_sec - taskRT.tmrVal->tv_sec) * NSEC_PER_SEC
+                    + (tmrMeasure.tv_nsec - taskRT.tmrVal->tv_nsec);
+
+            /* Timer is one shot, so cycles, which were missed, are counted
+             * from latency. They are skipped, so next shot is in the future
+             * and missed cycles are not counted again. */
+            if(latency >= taskRT.intervalns) {
+                int64_t missed = latency / taskRT.intervalns;
+
+                taskRT.jitter.overruns += (uint32_t)missed;
+                intervals += missed;
+            }
+            if(latency > INT32_MAX) {
+                latency = INT32_MAX;
+            }
+
+            taskRT.jitter.count++;
+            taskRT.jitter.latencySum += latency;
+            if(latency < taskRT.jitter.latencyMin) {
+                taskRT.jitter.latencyMin = (int32_t)latency;
+            }
+            if(latency > taskRT.jitter.latencyMax) {
+                taskRT.jitter.latencyMax = (int32_t)latency;
+            }
+
+            /* Maximum interval in microseconds */
+            if(taskRT.maxTime != NULL) {
+                long dt = (long)(latency / 1000) + taskRT.intervalus;
                 if(dt > 0xFFFF) {
                     *taskRT.maxTime = 0xFFFF;
                 }else if(dt > *taskRT.maxTime) {
@@ -267,35 +499,27 @@ bool_t CANrx_taskTmr_process(int fd) {
         }
 
         /* Calculate next shot for the timer */
-        taskRT.tmrVal->tv_nsec += taskRT.intervalns;
-        if(taskRT.tmrVal->tv_nsec >= NSEC_PER_SEC) {
-            taskRT.tmrVal->tv_nsec -= NSEC_PER_SEC;
-            taskRT.tmrVal->tv_sec++;
+        {
+            int64_t nsec = taskRT.tmrVal->tv_nsec + intervals * taskRT.intervalns;
+
+            taskRT.tmrVal->tv_sec += (time_t)(nsec / NSEC_PER_SEC);
+            taskRT.tmrVal->tv_nsec = (long)(nsec % NSEC_PER_SEC);
         }
         if(timerfd_settime(taskRT.fdTmr, TFD_TIMER_ABSTIME, &taskRT.tmrSpec, NULL) == -1)
             CO_error(0x22300000L + errno);
 
+        CANrx_taskTmr_processCANopen();
+    }
 
-        /* Lock PDOs and OD */
-        CO_LOCK_OD();
-
-        if(CO->CANmodule[0]->CANnormal) {
-            bool_t syncWas;
-
-            /* Process Sync */
-            syncWas = CO_process_SYNC(CO, taskRT.intervalus);
-
-            /* Read inputs */
-            CO_process_RPDO(CO, syncWas);
-
-            /* Further I/O or nonblocking application code may go here. */
+    /* SYNC producer deadline, process immediately, so SYNC is sent on time */
+    else if(fd == taskRT.fdSync) {
+        uint64_t tmrExp;
 
-            /* Write outputs */
-            CO_process_TPDO(CO, syncWas, taskRT.intervalus);
-        }
+        if(read(taskRT.fdSync, &tmrExp, sizeof(tmrExp)) != sizeof(uint64_t))
+            CO_error(0x22700000L + errno);
+        taskRT.syncArmed = false;
 
-        /* Unlock */
-        CO_UNLOCK_OD();
+        CANrx_taskTmr_processCANopen();
     }
 
     else {
@@ -26,12 +26,33 @@
 #ifndef CO_LINUX_TASKS_H
 #define CO_LINUX_TASKS_H
 
+#include <stddef.h>
+#include <sys/epoll.h>
+
+
+/**
+ * Maximum sleep time of taskMain in milliseconds.
+ *
+ * taskMain sleeps until the earliest deadline, reported by CO_process() in
+ * timerNext_ms, or until it is triggered by taskMain_cbSignal(). This value
+ * limits the sleep on idle node. It must be lower than 65535, because
+ * taskMain_getTimerNext() returns 16-bit value.
+ */
+#ifndef CO_TASK_MAIN_SLEEP_MAX_MS
+#define CO_TASK_MAIN_SLEEP_MAX_MS 10000
+#endif
+
 
 /**
  * Initialize mainline task.
  *
  * taskMain is non-realtime task for CANopenNode processing. It is nonblocking
- * and is executing cyclically in 50 ms intervals or less if necessary.
+ * and is executing, when the earliest deadline of CANopen objects expires (see
+ * timerNext_ms in CO_process()), but at least every CO_TASK_MAIN_SLEEP_MAX_MS.
+ * It is also executing immediately after taskMain_cbSignal(), which should be
+ * registered with CO_SDO_initCallback(), CO_EM_initCallback(),
+ * CO_NMT_initCallbackSignal(), CO_HBconsumer_initCallbackSignal() and
+ * CO_TIME_initCallback().
  * It uses Linux epoll, timerfd for interval and pipe for task triggering.
  * This task processes CO_process() function from CANopen.c file.
  *
@@ -49,15 +70,25 @@ void taskMain_close(void);
 /**
  * Process mainline task.
  *
- * Function must be called after epoll.
+ * Function must be called after epoll. Time is read with CO_timeNow() and
+ * objects are processed with CO_process_us(). Timer is set with microsecond
+ * resolution to the earliest deadline.
  *
  * @param fd Available file descriptor from epoll().
  * @param reset return value from CO_process() function.
- * @param timer1ms variable, which must increment each millisecond.
  *
  * @return True, if fd was matched.
  */
-bool_t taskMain_process(int fd, CO_NMT_reset_cmd_t *reset, uint16_t timer1ms);
+bool_t taskMain_process(int fd, CO_NMT_reset_cmd_t *reset);
+
+/**
+ * Get delay until next deadline of mainline task.
+ *
+ * @return Delay from the last processing until the earliest deadline, in
+ * milliseconds, rounded up. May be used as epoll timeout, if timerfd is not
+ * available.
+ */
+uint16_t taskMain_getTimerNext(void);
 
 /**
  * Signal function, which triggers mainline task.
@@ -78,6 +109,13 @@ void taskMain_cbSignal(void);
  * CANrx_taskTmr uses Linux epoll, CAN socket form CO_driver.c and timerfd for
  * interval.
  *
+ * If this node is SYNC producer, additional timerfd is armed on deadline of
+ * the next SYNC message (see CO_SYNC_getProducerDeadline()), so SYNC is sent
+ * on time, independent of the interval. Deadline is converted from time base of
+ * CO_timeNow() to CLOCK_MONOTONIC, so any time source may be used, see
+ * CO_setTimeSource().
+ * Achieved lateness and jitter of SYNC are available from CO_SYNC_getStats().
+ *
  *
  * @param fdEpoll File descriptor for Linux epoll API.
  * @param intervalns Interval of periodic timer in nanoseconds.
@@ -91,6 +129,85 @@ void CANrx_taskTmr_init(int fdEpoll, long intervalns, uint16_t *maxTime);
  */
 void CANrx_taskTmr_close(void);
 
+/**
+ * Configuration of realtime run mode, see CANrx_taskTmr_setRT().
+ */
+typedef struct {
+    /** SCHED_FIFO priority of the calling thread (1...99). If 0, scheduling
+     * policy is not changed. */
+    int                 priority;
+    /** CPU, to which the calling thread is pinned. If -1, affinity is not
+     * changed. */
+    int                 cpu;
+    /** If true, all current and future memory of the process is locked with
+     * mlockall(), so page faults don't occur inside realtime loop. */
+    bool_t              lockMemory;
+    /** Number of bytes of stack, which are touched in advance, so stack pages
+     * are already mapped (and locked) before realtime loop. 0 to disable. */
+    size_t              stackPrefault;
+    /** After each event CANrx_taskTmr_wait() polls epoll without blocking for
+     * this time, before it blocks. This avoids wakeup latency of the
+     * scheduler for CAN messages and timer, which arrive inside the window,
+     * but consumes CPU. 0 to disable. */
+    uint32_t            busyPoll_us;
+} CO_RTconfig_t;
+
+/**
+ * Statistics of realtime task wakeups, see CANrx_taskTmr_getJitter().
+ *
+ * Latency is the time from the scheduled timer expiration until
+ * CANrx_taskTmr_process() reads the timer. Jitter of the cycle is
+ * latencyMax - latencyMin.
+ */
+typedef struct {
+    uint32_t            count;          /**< Number of timer cycles measured */
+    uint32_t            overruns;       /**< Number of cycles, which were missed because of latency */
+    int32_t             latencyMin;     /**< Minimum latency in nanoseconds */
+    int32_t             latencyMax;     /**< Maximum latency in nanoseconds */
+    int64_t             latencySum;     /**< Sum of latencies in nanoseconds, for average */
+} CO_RTjitter_t;
+
+/**
+ * Configure realtime run mode for the calling thread.
+ *
+ * Function should be called from the thread, which runs CANrx_taskTmr, after
+ * CANrx_taskTmr_init() and before the realtime loop. It sets SCHED_FIFO
+ * priority and CPU affinity of the calling thread, locks memory, prefaults
+ * stack and enables busy polling in CANrx_taskTmr_wait(). Realtime mode is
+ * optional, without this function task runs as before.
+ *
+ * Settings, which fail (for example because of missing privileges), are
+ * reported with CO_error() and the rest are still applied.
+ *
+ * @param config Configuration, see #CO_RTconfig_t.
+ *
+ * @return True, if all settings were applied.
+ */
+bool_t CANrx_taskTmr_setRT(const CO_RTconfig_t *config);
+
+/**
+ * Wait for the next event of realtime task.
+ *
+ * May be used instead of epoll_wait() in realtime loop. If busy polling is
+ * enabled by CANrx_taskTmr_setRT(), epoll is first polled without blocking for
+ * the configured window, then it blocks as epoll_wait() with infinite timeout.
+ *
+ * @param fdEpoll File descriptor for Linux epoll API, same as in
+ * CANrx_taskTmr_init().
+ * @param ev Event, which is ready. Pass its fd to CANrx_taskTmr_process().
+ *
+ * @return Same as epoll_wait() with maxevents = 1.
+ */
+int CANrx_taskTmr_wait(int fdEpoll, struct epoll_event *ev);
+
+/**
+ * Get achieved wakeup latency and jitter of realtime task.
+ *
+ * @param jitter Statistics are copied here.
+ * @param reset If true, statistics are cleared after copy.
+ */
+void CANrx_taskTmr_getJitter(CO_RTjitter_t *jitter, bool_t reset);
+
 /**
  * Process realtime task.
  *
@@ -107,8 +107,16 @@ int CO_OD_storage_saveSecure(
     int ret = RETURN_SUCCESS;
 
     char *filename_old = NULL;
+    uint8_t *snapshot = NULL;
     uint16_t CRC = 0;
 
+    /* Take consistent copy of data, file is written without OD lock. */
+    snapshot = malloc(odSize);
+    if(snapshot == NULL) {
+        return RETURN_ERROR;
+    }
+    CO_OD_readCopy(snapshot, odAddress, odSize);
+
     /* Generate new string with extension '.old' and rename current file to it. */
     filename_old = malloc(strlen(filename)+10);
     if(filename_old != NULL) {
@@ -128,10 +136,8 @@ int CO_OD_storage_saveSecure(
         FILE *fp = fopen(filename, "w");
         if(fp != NULL) {
 
-            CO_LOCK_OD();
-            fwrite((const void *)odAddress, 1, odSize, fp);
-            CRC = crc16_ccitt((unsigned char*)odAddress, odSize, 0);
-            CO_UNLOCK_OD();
+            fwrite((const void *)snapshot, 1, odSize, fp);
+            CRC = crc16_ccitt((unsigned char*)snapshot, odSize, 0);
 
             fwrite((const void *)&CRC, 1, 2, fp);
             fclose(fp);
@@ -172,6 +178,7 @@ int CO_OD_storage_saveSecure(
     }
 
     free(filename_old);
+    free(snapshot);
 
     return ret;
 }
@@ -348,8 +355,8 @@ CO_ReturnError_t CO_OD_storage_autoSave(
         if(ret == CO_ERROR_NO && saveData) {
             uint16_t CRC;
 
-            /* copy data to temporary buffer */
-            memcpy(buf, odStor->odAddress, odStor->odSize);
+            /* copy consistent data to temporary buffer */
+            CO_OD_readCopy(buf, odStor->odAddress, odStor->odSize);
 
             rewind(odStor->fp);
             fwrite((const void *)buf, 1, odStor->odSize, odStor->fp);
@@ -25,9 +25,11 @@
 
 #include "CO_driver.h"
 #include "CO_Emergency.h"
+#include "CO_filter.h"
 #include <string.h> /* for memcpy */
 #include <stdlib.h> /* for malloc, free */
 #include <errno.h>
+#include <time.h>
 #include <sys/socket.h>
 
 
@@ -35,7 +37,123 @@
 #ifndef CO_SINGLE_THREAD
     pthread_mutex_t CO_EMCY_mtx = PTHREAD_MUTEX_INITIALIZER;
     pthread_mutex_t CO_OD_mtx = PTHREAD_MUTEX_INITIALIZER;
+    volatile uint32_t CO_OD_seq = 0;
+#ifdef CO_DRIVER_IO_URING
+    pthread_mutex_t CO_CAN_SEND_mtx = PTHREAD_MUTEX_INITIALIZER;
 #endif
+#endif
+
+
+#ifdef CO_DRIVER_IO_URING
+/* user_data of io_uring requests. Sends use index of txFrame. */
+#define CO_URING_UDATA_RECV         0xFFFF0001U
+#define CO_URING_UDATA_TIMEOUT      0xFFFF0002U
+
+
+/* Arm multishot recv on CAN socket. Kernel picks buffers from rxBufRing and
+ * posts one completion per received frame, until recv is terminated. */
+static int uringArmRecv(CO_CANmodule_t *CANmodule){
+    struct io_uring_sqe *sqe = CO_uring_getSqe(&CANmodule->rxRing);
+
+    if(sqe == NULL){
+        return -EBUSY;
+    }
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = CANmodule->fd;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = CANmodule->rxBufRing.bgid;
+    sqe->user_data = CO_URING_UDATA_RECV;
+
+    return CO_uring_submit(&CANmodule->rxRing, 0);
+}
+
+
+/* Create rings for CAN socket. */
+static CO_ReturnError_t uringInit(CO_CANmodule_t *CANmodule){
+    uint16_t i;
+
+    /* Sends of all frames in flight and timeout of the chain */
+    if(CO_uring_init(&CANmodule->txRing, CO_URING_TX_SIZE + 1U) != 0){
+        return CO_ERROR_SYSCALL;
+    }
+    if(CO_uring_init(&CANmodule->rxRing, 4) != 0){
+        return CO_ERROR_SYSCALL;
+    }
+    if(CO_uring_bufRingInit(&CANmodule->rxRing, &CANmodule->rxBufRing,
+                            CO_URING_RX_BUFFERS, sizeof(struct can_frame), 0) != 0){
+        return CO_ERROR_SYSCALL;
+    }
+    if(uringArmRecv(CANmodule) < 0){
+        return CO_ERROR_SYSCALL;
+    }
+
+    for(i=0U; i<CO_URING_TX_SIZE; i++){
+        CANmodule->txBusy[i] = false;
+    }
+    CANmodule->txNext = 0;
+    CANmodule->txChain = 0;
+    CANmodule->txTimeout.tv_sec = CO_URING_TX_TIMEOUT_US / 1000000;
+    CANmodule->txTimeout.tv_nsec = (CO_URING_TX_TIMEOUT_US % 1000000) * 1000;
+
+    /* ring is readable, when completions are available */
+    CANmodule->fdRx = CANmodule->rxRing.fd;
+
+    return CO_ERROR_NO;
+}
+
+
+/* Consume completions of sends, free their frames and report failures.
+ * Must be called inside CO_LOCK_CAN_SEND(). */
+static void uringTxReap(CO_CANmodule_t *CANmodule){
+    struct io_uring_cqe *cqe;
+
+    while((cqe = CO_uring_peekCqe(&CANmodule->txRing)) != NULL){
+        uint64_t udata = cqe->user_data;
+        int32_t res = cqe->res;
+
+        CO_uring_cqeSeen(&CANmodule->txRing);
+        if(udata < CO_URING_TX_SIZE){
+            CANmodule->txBusy[udata] = false;
+            CANmodule->txChain--;
+            /* Socket reported an error, send was canceled by timeout of the
+             * chain or by failure of previous send in the chain. */
+            if(res != sizeof(struct can_frame)){
+                CO_errorReport((CO_EM_t*)CANmodule->em, CO_EM_CAN_TX_OVERFLOW, CO_EMC_CAN_OVERRUN, (uint32_t)-res);
+            }
+        }
+    }
+}
+
+
+/* Submit queued sends as one chain, if previous chain has completed.
+ * Must be called inside CO_LOCK_CAN_SEND(). */
+static void uringTxSubmit(CO_CANmodule_t *CANmodule){
+    CO_uring_t *ring = &CANmodule->txRing;
+    unsigned pending;
+
+    uringTxReap(CANmodule);
+    pending = CO_uring_pending(ring);
+    if(CANmodule->txChain == 0U && pending > 0U){
+        /* Queued sends are linked, so frames leave in order. Timeout ends the
+         * chain and cancels the last send, if it waits too long for space in
+         * socket buffer. CO_CANsend() keeps one entry free for it. */
+        struct io_uring_sqe *sqeTmo = CO_uring_getSqe(ring);
+
+        sqeTmo->opcode = IORING_OP_LINK_TIMEOUT;
+        sqeTmo->fd = -1;
+        sqeTmo->addr = (uintptr_t)&CANmodule->txTimeout;
+        sqeTmo->len = 1;
+        sqeTmo->user_data = CO_URING_UDATA_TIMEOUT;
+
+        CANmodule->txChain = (uint16_t)pending;
+        if(CO_uring_submit(ring, 0) < 0){
+            CO_errorReport((CO_EM_t*)CANmodule->em, CO_EM_CAN_TX_OVERFLOW, CO_EMC_CAN_OVERRUN, errno);
+        }
+        uringTxReap(CANmodule);
+    }
+}
+#endif /* CO_DRIVER_IO_URING */
 
 
 /** Set socketCAN filters *****************************************************/
@@ -53,26 +171,10 @@ static CO_ReturnError_t setFilters(CO_CANmodule_t *CANmodule){
         if(filtersOut == NULL){
             ret = CO_ERROR_OUT_OF_MEMORY;
         }else{
-            int i;
-            int idZeroCnt = 0;
-
-            /* Copy filterIn to filtersOut. Accept only first filter with
-             * can_id=0, omit others. */
-            for(i=0; i<nFiltersIn; i++){
-                struct can_filter *fin;
-
-                fin = &CANmodule->filter[i];
-                if(fin->can_id == 0){
-                    idZeroCnt++;
-                }
-                if(fin->can_id != 0 || idZeroCnt == 1){
-                    struct can_filter *fout;
-
-                    fout = &filtersOut[nFiltersOut++];
-                    fout->can_id = fin->can_id;
-                    fout->can_mask = fin->can_mask;
-                }
-            }
+            /* Copy filterIn to filtersOut and merge them into minimal set.
+             * Unused filters (can_id=0) are merged into one. */
+            memcpy(filtersOut, CANmodule->filter, sizeof(struct can_filter) * nFiltersIn);
+            nFiltersOut = CO_filter_compress(filtersOut, nFiltersIn);
 
             if(setsockopt(CANmodule->fd, SOL_CAN_RAW, CAN_RAW_FILTER,
                           filtersOut, sizeof(struct can_filter) * nFiltersOut) != 0)
@@ -187,6 +289,13 @@ CO_ReturnError_t CO_CANmodule_init(
                 ret = CO_ERROR_OUT_OF_MEMORY;
             }
         }
+
+        CANmodule->fdRx = CANmodule->fd;
+#ifdef CO_DRIVER_IO_URING
+        if(ret == CO_ERROR_NO){
+            ret = uringInit(CANmodule);
+        }
+#endif
     }
 
     /* Additional check. */
@@ -214,6 +323,11 @@ CO_ReturnError_t CO_CANmodule_init(
 
 /******************************************************************************/
 void CO_CANmodule_disable(CO_CANmodule_t *CANmodule){
+#ifdef CO_DRIVER_IO_URING
+    CO_uring_bufRingClose(&CANmodule->rxRing, &CANmodule->rxBufRing);
+    CO_uring_close(&CANmodule->rxRing);
+    CO_uring_close(&CANmodule->txRing);
+#endif
     close(CANmodule->fd);
     free(CANmodule->filter);
     CANmodule->filter = NULL;
@@ -226,6 +340,16 @@ uint16_t CO_CANrxMsg_readIdent(const CO_CANrxMsg_t *rxMsg){
 }
 
 
+/******************************************************************************/
+CO_time_us_t CO_timebase_us(void *object){
+    struct timespec now;
+
+    (void)object;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (CO_time_us_t)now.tv_sec * 1000000U + (CO_time_us_t)now.tv_nsec / 1000U;
+}
+
+
 /******************************************************************************/
 CO_ReturnError_t CO_CANrxBufferInit(
         CO_CANmodule_t         *CANmodule,
@@ -302,6 +426,7 @@ CO_CANtx_t *CO_CANtxBufferInit(
 
 
 /******************************************************************************/
+#ifndef CO_DRIVER_IO_URING
 CO_ReturnError_t CO_CANsend(CO_CANmodule_t *CANmodule, CO_CANtx_t *buffer){
     CO_ReturnError_t err = CO_ERROR_NO;
     ssize_t n;
@@ -322,6 +447,70 @@ CO_ReturnError_t CO_CANsend(CO_CANmodule_t *CANmodule, CO_CANtx_t *buffer){
 }
 
 
+/******************************************************************************/
+void CO_CANsendFlush(CO_CANmodule_t *CANmodule){
+    (void)CANmodule;
+}
+
+#else /* CO_DRIVER_IO_URING */
+CO_ReturnError_t CO_CANsend(CO_CANmodule_t *CANmodule, CO_CANtx_t *buffer){
+    CO_ReturnError_t err = CO_ERROR_NO;
+    uint16_t slot;
+
+    CO_LOCK_CAN_SEND();
+
+    /* Frame is copied, buffer may be reused after return. Send is queued and
+     * submitted with other queued sends as one linked chain, see
+     * uringTxSubmit(). Only one chain is in flight, so frames leave in
+     * order. */
+    slot = CANmodule->txNext;
+    if(CANmodule->txBusy[slot]){
+        uringTxReap(CANmodule);
+    }
+    if(CANmodule->txBusy[slot] || CO_uring_sqSpace(&CANmodule->txRing) < 2U){
+        CO_errorReport((CO_EM_t*)CANmodule->em, CO_EM_CAN_TX_OVERFLOW, CO_EMC_CAN_OVERRUN, 0);
+        err = CO_ERROR_TX_OVERFLOW;
+    }
+    else{
+        struct can_frame *frame = &CANmodule->txFrame[slot];
+        struct io_uring_sqe *sqe = CO_uring_getSqe(&CANmodule->txRing);
+
+        memcpy(frame, buffer, sizeof(struct can_frame));
+        CANmodule->txBusy[slot] = true;
+        CANmodule->txNext = (slot + 1U) % CO_URING_TX_SIZE;
+
+        sqe->opcode = IORING_OP_SEND;
+        sqe->fd = CANmodule->fd;
+        sqe->addr = (uintptr_t)frame;
+        sqe->len = sizeof(struct can_frame);
+        sqe->flags = IOSQE_IO_LINK;
+        sqe->user_data = slot;
+
+#ifdef CO_LOG_CAN_MESSAGES
+        void CO_logMessage(const CanMsg *msg);
+        CO_logMessage((const CanMsg*) buffer);
+#endif
+
+        if(CO_uring_pending(&CANmodule->txRing) >= CO_URING_TX_BATCH){
+            uringTxSubmit(CANmodule);
+        }
+    }
+
+    CO_UNLOCK_CAN_SEND();
+
+    return err;
+}
+
+
+/******************************************************************************/
+void CO_CANsendFlush(CO_CANmodule_t *CANmodule){
+    CO_LOCK_CAN_SEND();
+    uringTxSubmit(CANmodule);
+    CO_UNLOCK_CAN_SEND();
+}
+#endif /* CO_DRIVER_IO_URING */
+
+
 /******************************************************************************/
 void CO_CANclearPendingSyncPDOs(CO_CANmodule_t *CANmodule){
     /* Messages can not be cleared, because they are allready in kernel */
@@ -391,7 +580,41 @@ void CO_CANverifyErrors(CO_CANmodule_t *CANmodule){
 }
 
 
+/* Find receive buffer for CAN frame and call its function ********************/
+static void CO_CANrxDispatch(CO_CANmodule_t *CANmodule, const struct can_frame *msg){
+    const CO_CANrxMsg_t *rcvMsg;    /* pointer to received message in CAN module */
+    uint32_t rcvMsgIdent;           /* identifier of the received message */
+    CO_CANrx_t *buffer;             /* receive message buffer from CO_CANmodule_t object. */
+    int i;
+    bool_t msgMatched = false;
+
+    rcvMsg = (const CO_CANrxMsg_t *) msg;
+    rcvMsgIdent = rcvMsg->ident;
+
+    /* Search rxArray form CANmodule for the matching CAN-ID. */
+    buffer = &CANmodule->rxArray[0];
+    for(i = CANmodule->rxSize; i > 0U; i--){
+        if(((rcvMsgIdent ^ buffer->ident) & buffer->mask) == 0U){
+            msgMatched = true;
+            break;
+        }
+        buffer++;
+    }
+
+    /* Call specific function, which will process the message */
+    if(msgMatched && (buffer->pFunct != NULL)){
+        buffer->pFunct(buffer->object, rcvMsg);
+    }
+
+#ifdef CO_LOG_CAN_MESSAGES
+    void CO_logMessage(const CanMsg *msg);
+    CO_logMessage((CanMsg*)&rcvMsg);
+#endif
+}
+
+
 /******************************************************************************/
+#ifndef CO_DRIVER_IO_URING
 void CO_CANrxWait(CO_CANmodule_t *CANmodule){
     struct can_frame msg;
     int n, size;
@@ -411,34 +634,61 @@ void CO_CANrxWait(CO_CANmodule_t *CANmodule){
             CO_errorReport((CO_EM_t*)CANmodule->em, CO_EM_CAN_RXB_OVERFLOW, CO_EMC_COMMUNICATION, n);
         }
         else{
-            CO_CANrxMsg_t *rcvMsg;      /* pointer to received message in CAN module */
-            uint32_t rcvMsgIdent;       /* identifier of the received message */
-            CO_CANrx_t *buffer;         /* receive message buffer from CO_CANmodule_t object. */
-            int i;
-            bool_t msgMatched = false;
-
-            rcvMsg = (CO_CANrxMsg_t *) &msg;
-            rcvMsgIdent = rcvMsg->ident;
-
-            /* Search rxArray form CANmodule for the matching CAN-ID. */
-            buffer = &CANmodule->rxArray[0];
-            for(i = CANmodule->rxSize; i > 0U; i--){
-                if(((rcvMsgIdent ^ buffer->ident) & buffer->mask) == 0U){
-                    msgMatched = true;
-                    break;
-                }
-                buffer++;
-            }
+            CO_CANrxDispatch(CANmodule, &msg);
+        }
+    }
+}
+
+#else /* CO_DRIVER_IO_URING */
+void CO_CANrxWait(CO_CANmodule_t *CANmodule){
+    struct io_uring_cqe *cqe;
+    bool_t rearm = false;
+
+    if(CANmodule == NULL){
+        errno = EFAULT;
+        CO_errExit("CO_CANreceive - CANmodule not configured.");
+    }
 
-            /* Call specific function, which will process the message */
-            if(msgMatched && (buffer->pFunct != NULL)){
-                buffer->pFunct(buffer->object, rcvMsg);
+    /* Block until at least one completion is available */
+    if(CO_uring_peekCqe(&CANmodule->rxRing) == NULL){
+        if(CO_uring_submit(&CANmodule->rxRing, 1) < 0){
+            return;
+        }
+    }
+
+    /* Process all received frames */
+    while((cqe = CO_uring_peekCqe(&CANmodule->rxRing)) != NULL){
+        int32_t res = cqe->res;
+        uint32_t flags = cqe->flags;
+
+        if((flags & IORING_CQE_F_BUFFER) != 0){
+            unsigned bid = flags >> IORING_CQE_BUFFER_SHIFT;
+            struct can_frame *msg = CO_uring_bufRingGet(&CANmodule->rxBufRing, bid);
+
+            if(CANmodule->CANnormal){
+                if(res != sizeof(struct can_frame)){
+                    CO_errorReport((CO_EM_t*)CANmodule->em, CO_EM_CAN_RXB_OVERFLOW, CO_EMC_COMMUNICATION, res);
+                }
+                else{
+                    CO_CANrxDispatch(CANmodule, msg);
+                }
             }
+            CO_uring_bufRingRecycle(&CANmodule->rxBufRing, bid);
+        }
+        else if(res < 0 && res != -ENOBUFS && CANmodule->CANnormal){
+            /* ENOBUFS only means, that all buffers were in use. */
+            CO_errorReport((CO_EM_t*)CANmodule->em, CO_EM_CAN_RXB_OVERFLOW, CO_EMC_COMMUNICATION, res);
+        }
 
-#ifdef CO_LOG_CAN_MESSAGES
-            void CO_logMessage(const CanMsg *msg);
-            CO_logMessage((CanMsg*)&rcvMsg);
-#endif
+        if((flags & IORING_CQE_F_MORE) == 0){
+            rearm = true;
         }
+        CO_uring_cqeSeen(&CANmodule->rxRing);
+    }
+
+    /* Multishot recv terminated (error or out of buffers), start it again. */
+    if(rearm){
+        uringArmRecv(CANmodule);
     }
 }
+#endif /* CO_DRIVER_IO_URING */
@@ -58,6 +58,31 @@
 /* general configuration */
 //    #define CO_LOG_CAN_MESSAGES   /* Call external function for each received or transmitted CAN message. */
     #define CO_SDO_BUFFER_SIZE           889    /* Override default SDO buffer size. */
+//    #define CO_DRIVER_IO_URING    /* Use io_uring instead of read()/write() on CAN socket, requires Linux 6.0 or newer. */
+
+
+/* io_uring backend. CAN frames are received with one multishot recv into
+ * provided buffer ring and all available frames are processed by one
+ * CO_CANrxWait() call. Frames for transmission are queued and submitted in
+ * batches. Each batch is one linked chain of sends with a timeout at its
+ * end, and next batch is submitted after the chain has completed, so frames
+ * keep their order. See CO_uring.h. */
+#ifdef CO_DRIVER_IO_URING
+    #include "CO_uring.h"
+
+    #ifndef CO_URING_RX_BUFFERS
+    #define CO_URING_RX_BUFFERS         64      /* Number of receive buffers, power of 2. */
+    #endif
+    #ifndef CO_URING_TX_SIZE
+    #define CO_URING_TX_SIZE            32      /* Maximum number of frames in flight. */
+    #endif
+    #ifndef CO_URING_TX_BATCH
+    #define CO_URING_TX_BATCH           8       /* Queued frames are submitted, when this number is reached, or by CO_CANsendFlush(). */
+    #endif
+    #ifndef CO_URING_TX_TIMEOUT_US
+    #define CO_URING_TX_TIMEOUT_US      100000  /* Last send of the chain, which waits longer for space in socket buffer, is canceled. */
+    #endif
+#endif
 
 
 /* Critical sections */
@@ -72,17 +97,30 @@
     #define CO_UNLOCK_OD()
 
     #define CANrxMemoryBarrier()
+#else
+#ifdef CO_DRIVER_IO_URING
+    /* protects submission queue of txRing */
+    extern pthread_mutex_t CO_CAN_SEND_mtx;
+    #define CO_LOCK_CAN_SEND()      {if(pthread_mutex_lock(&CO_CAN_SEND_mtx) != 0) CO_errExit("Mutex lock CO_CAN_SEND_mtx failed");}
+    #define CO_UNLOCK_CAN_SEND()    {if(pthread_mutex_unlock(&CO_CAN_SEND_mtx) != 0) CO_errExit("Mutex unlock CO_CAN_SEND_mtx failed");}
 #else
     #define CO_LOCK_CAN_SEND()      /* not needed */
     #define CO_UNLOCK_CAN_SEND()
+#endif
 
     extern pthread_mutex_t CO_EMCY_mtx;
     #define CO_LOCK_EMCY()          {if(pthread_mutex_lock(&CO_EMCY_mtx) != 0) CO_errExit("Mutex lock CO_EMCY_mtx failed");}
     #define CO_UNLOCK_EMCY()        {if(pthread_mutex_unlock(&CO_EMCY_mtx) != 0) CO_errExit("Mutex unlock CO_EMCY_mtx failed");}
 
+    /* OD lock is held by writers only. It increments CO_OD_seq on lock and
+     * unlock, so readers can copy OD data without lock, see CO_OD_readCopy(). */
     extern pthread_mutex_t CO_OD_mtx;
-    #define CO_LOCK_OD()            {if(pthread_mutex_lock(&CO_OD_mtx) != 0) CO_errExit("Mutex lock CO_OD_mtx failed");}
-    #define CO_UNLOCK_OD()          {if(pthread_mutex_unlock(&CO_OD_mtx) != 0) CO_errExit("Mutex unlock CO_OD_mtx failed");}
+    extern volatile uint32_t CO_OD_seq;
+    #define CO_OD_SEQLOCK
+    #define CO_LOCK_OD()            {if(pthread_mutex_lock(&CO_OD_mtx) != 0) CO_errExit("Mutex lock CO_OD_mtx failed"); \
+                                     CO_OD_seq++; CANrxMemoryBarrier();}
+    #define CO_UNLOCK_OD()          {CANrxMemoryBarrier(); CO_OD_seq++; \
+                                     if(pthread_mutex_unlock(&CO_OD_mtx) != 0) CO_errExit("Mutex unlock CO_OD_mtx failed");}
 
     #define CANrxMemoryBarrier()    {__sync_synchronize();}
 #endif /* CO_SINGLE_THREAD */
@@ -93,6 +131,14 @@
 #define CLEAR_CANrxNew(rxNew) {CANrxMemoryBarrier(); rxNew = (void*)0L;}
 
 
+/* GCC atomic builtins are used by lock-free emergency buffer, see CO_EM_t. */
+#define CO_USE_GCC_ATOMICS
+
+
+/* CLOCK_MONOTONIC is used as default time source, see CO_timebase_us(). */
+#define CO_TIMEBASE_US
+
+
 /* Data types */
 /* int8_t to uint64_t are defined in stdint.h */
 typedef _Bool                   bool_t;
@@ -142,7 +188,18 @@ typedef struct{
     uint16_t            txSize;
     uint16_t            wasConfigured;/* Zero only on first run of CO_CANmodule_init */
     int                 fd;         /* CAN_RAW socket file descriptor */
+    int                 fdRx;       /* Readable, when CO_CANrxWait() has data, for epoll */
     struct can_filter  *filter;     /* array of CAN filters of size rxSize */
+#ifdef CO_DRIVER_IO_URING
+    CO_uring_t          rxRing;     /* multishot recv on fd */
+    CO_uringBufRing_t   rxBufRing;  /* buffers for received frames */
+    CO_uring_t          txRing;     /* batched sends on fd, protected by CO_LOCK_CAN_SEND() */
+    struct can_frame    txFrame[CO_URING_TX_SIZE]; /* copies of frames in flight */
+    bool_t              txBusy[CO_URING_TX_SIZE];
+    uint16_t            txNext;
+    uint16_t            txChain;    /* sends of submitted chain, not completed yet */
+    struct __kernel_timespec txTimeout;
+#endif
     volatile bool_t     CANnormal;
     volatile bool_t     useCANrxFilters;
     volatile bool_t     bufferInhibitFlag;
@@ -158,10 +215,24 @@ void CO_errExit(char* msg);
 
 
 /* Functions receives CAN messages. It is blocking.
+ *
+ * With CO_DRIVER_IO_URING all received messages are processed, otherwise one.
+ * Use fdRx from CO_CANmodule_t to wait for messages with epoll.
  *
  * @param CANmodule This object.
  */
 void CO_CANrxWait(CO_CANmodule_t *CANmodule);
 
 
+/* Submit CAN messages, queued by CO_CANsend().
+ *
+ * With CO_DRIVER_IO_URING messages are submitted in batches. Function must be
+ * called after processing, which may send messages, for example after
+ * CO_process() and CO_process_TPDO(). Otherwise function does nothing.
+ *
+ * @param CANmodule This object.
+ */
+void CO_CANsendFlush(CO_CANmodule_t *CANmodule);
+
+
 #endif /* CO_DRIVER_TARGET_H */
@@ -0,0 +1,30 @@
+/*
+ * Compression of socketCAN receive filters.
+ *
+ * @file        CO_filter.c
+ * @copyright   2020
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "CO_filter.h"
+#include "CO_filter_compress.h"
+
+
+/******************************************************************************/
+CO_FILTER_COMPRESS_FUNCTION(CO_filter_compress, struct can_filter, can_id, can_mask, canid_t)
@@ -0,0 +1,70 @@
+/**
+ * Compression of socketCAN receive filters.
+ *
+ * @file        CO_filter.h
+ * @ingroup     CO_driver
+ * @copyright   2020
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef CO_FILTER_H
+#define CO_FILTER_H
+
+/* Layout of struct can_filter is the same on Linux and on NuttX. */
+#ifdef __NuttX__
+#include <nuttx/can.h>
+#else
+#include <linux/can.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/**
+ * Compress socketCAN filters.
+ *
+ * Kernel evaluates CAN_RAW_FILTER list linearly for each received frame, so
+ * list should be as short as possible. Function reduces filters to a minimal
+ * set, which accepts exactly the same frames as original list:
+ *  - Duplicated filters and filters covered by another filter are removed.
+ *  - Two filters with the same mask, which differ in exactly one identifier bit
+ *    are merged into one filter with that bit masked out.
+ * Rules are repeated, until no further reduction is possible. Adjacent COB-IDs
+ * (0x184, 0x185, 0x186, 0x187 for example) are this way merged into single
+ * filter, but no unneeded CAN-ID is admitted.
+ *
+ * Function is shared by socketCAN and nxSocketCAN drivers. Algorithm is
+ * defined by CO_FILTER_COMPRESS_FUNCTION() in CO_filter_compress.h, which is
+ * also used by NuttX driver. It is verified by test/CO_filter_check.c.
+ *
+ * @param filters Array of filters, modified in place.
+ * @param n Number of filters in the array.
+ *
+ * @return Number of filters after compression.
+ */
+int CO_filter_compress(struct can_filter *filters, int n);
+
+
+#ifdef __cplusplus
+}
+#endif /*__cplusplus*/
+
+#endif
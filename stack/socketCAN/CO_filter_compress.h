@@ -0,0 +1,100 @@
+/*
+ * Compression of CAN receive filter lists, shared by CAN drivers.
+ *
+ * @file        CO_filter_compress.h
+ * @copyright   2020
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef CO_FILTER_COMPRESS_H
+#define CO_FILTER_COMPRESS_H
+
+
+/**
+ * Define function, which compresses list of identifier/mask filters.
+ *
+ * Drivers keep filters in different structures (struct can_filter for
+ * socketCAN, identifier and mask of hardware filter for NuttX), so algorithm
+ * is defined once here and instantiated for each structure. Filter accepts
+ * identifier, if ((identifier ^ id) & mask) == 0. Generated function reduces
+ * filters to a minimal set, which accepts exactly the same identifiers:
+ *  - Identifier bits outside mask are cleared.
+ *  - Duplicated filters and filters covered by another filter are removed.
+ *  - Two filters with the same mask, which differ in exactly one identifier bit
+ *    are merged into one filter with that bit masked out.
+ * Rules are repeated, until no further reduction is possible.
+ *
+ * Generated function has prototype `int name(filter_t *filters, int n)`. It
+ * modifies filters in place and returns number of filters after compression.
+ * Macro may be preceded by `static`.
+ *
+ * @param name Name of the generated function.
+ * @param filter_t Type of the filter structure.
+ * @param id Name of the identifier member of filter_t.
+ * @param mask Name of the mask member of filter_t.
+ * @param id_t Unsigned type of id and mask members.
+ */
+#define CO_FILTER_COMPRESS_FUNCTION(name, filter_t, id, mask, id_t)            \
+int name(filter_t *filters, int n){                                            \
+    int i, j;                                                                  \
+    int changed = 1;                                                           \
+                                                                               \
+    /* identifier bits outside mask are not relevant */                        \
+    for(i=0; i<n; i++){                                                        \
+        filters[i].id &= filters[i].mask;                                      \
+    }                                                                          \
+                                                                               \
+    while(changed){                                                            \
+        changed = 0;                                                           \
+        for(i=0; i<n && !changed; i++){                                        \
+            for(j=0; j<n; j++){                                                \
+                filter_t *fi = &filters[i];                                    \
+                filter_t *fj = &filters[j];                                    \
+                id_t diff;                                                     \
+                                                                               \
+                if(i == j){                                                    \
+                    continue;                                                  \
+                }                                                              \
+                diff = (id_t)(fi->id ^ fj->id);                                \
+                                                                               \
+                /* fj is covered by fi */                                      \
+                if((fj->mask & fi->mask) == fi->mask &&                        \
+                   (diff & fi->mask) == 0U)                                    \
+                {                                                              \
+                    *fj = filters[--n];                                        \
+                    changed = 1;                                               \
+                    break;                                                     \
+                }                                                              \
+                                                                               \
+                /* fi and fj differ in single identifier bit */                \
+                if(fi->mask == fj->mask && (diff & (id_t)(diff - 1U)) == 0U){  \
+                    fi->id &= (id_t)~diff;                                     \
+                    fi->mask &= (id_t)~diff;                                   \
+                    *fj = filters[--n];                                        \
+                    changed = 1;                                               \
+                    break;                                                     \
+                }                                                              \
+            }                                                                  \
+        }                                                                      \
+    }                                                                          \
+                                                                               \
+    return n;                                                                  \
+}
+
+#endif
@@ -0,0 +1,267 @@
+/*
+ * Minimal io_uring interface for socketCAN driver.
+ *
+ * @file        CO_uring.c
+ * @ingroup     CO_driver
+ * @copyright   2020
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "CO_uring.h"
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+
+/* Kernel and user space access shared ring indexes concurrently */
+#define CO_URING_LOAD_ACQUIRE(p)        __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define CO_URING_STORE_RELEASE(p, v)    __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+
+
+/******************************************************************************/
+int CO_uring_init(CO_uring_t *ring, unsigned entries){
+    struct io_uring_params p;
+    size_t sqSize, cqSize;
+    uint8_t *ptr;
+    unsigned i;
+
+    memset(ring, 0, sizeof(*ring));
+    memset(&p, 0, sizeof(p));
+
+    ring->fd = (int)syscall(__NR_io_uring_setup, entries, &p);
+    if(ring->fd < 0){
+        ring->fd = -1;
+        return -errno;
+    }
+    if((p.features & IORING_FEAT_SINGLE_MMAP) == 0){
+        close(ring->fd);
+        ring->fd = -1;
+        return -ENOSYS;
+    }
+
+    /* SQ and CQ rings share one mapping */
+    sqSize = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    cqSize = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    ring->ringSize = (sqSize > cqSize) ? sqSize : cqSize;
+    ring->ringPtr = mmap(NULL, ring->ringSize, PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+    if(ring->ringPtr == MAP_FAILED){
+        int err = -errno;
+        close(ring->fd);
+        ring->fd = -1;
+        return err;
+    }
+
+    ring->sqesSize = p.sq_entries * sizeof(struct io_uring_sqe);
+    ring->sqes = mmap(NULL, ring->sqesSize, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+    if(ring->sqes == MAP_FAILED){
+        int err = -errno;
+        munmap(ring->ringPtr, ring->ringSize);
+        close(ring->fd);
+        ring->fd = -1;
+        return err;
+    }
+
+    ptr = ring->ringPtr;
+    ring->sqHead = (unsigned *)(ptr + p.sq_off.head);
+    ring->sqTail = (unsigned *)(ptr + p.sq_off.tail);
+    ring->sqArray = (unsigned *)(ptr + p.sq_off.array);
+    ring->sqMask = *(unsigned *)(ptr + p.sq_off.ring_mask);
+    ring->sqEntries = p.sq_entries;
+    ring->sqLocal = *ring->sqTail;
+    ring->cqHead = (unsigned *)(ptr + p.cq_off.head);
+    ring->cqTail = (unsigned *)(ptr + p.cq_off.tail);
+    ring->cqMask = *(unsigned *)(ptr + p.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe *)(ptr + p.cq_off.cqes);
+
+    /* Use sqes in order, so array is identity mapping */
+    for(i = 0; i < p.sq_entries; i++){
+        ring->sqArray[i] = i;
+    }
+
+    return 0;
+}
+
+
+/******************************************************************************/
+void CO_uring_close(CO_uring_t *ring){
+    if(ring->fd >= 0){
+        munmap(ring->sqes, ring->sqesSize);
+        munmap(ring->ringPtr, ring->ringSize);
+        close(ring->fd);
+        ring->fd = -1;
+    }
+}
+
+
+/******************************************************************************/
+struct io_uring_sqe *CO_uring_getSqe(CO_uring_t *ring){
+    struct io_uring_sqe *sqe;
+
+    if(CO_uring_sqSpace(ring) == 0){
+        return NULL;
+    }
+    sqe = &ring->sqes[ring->sqLocal & ring->sqMask];
+    ring->sqLocal++;
+    memset(sqe, 0, sizeof(*sqe));
+
+    return sqe;
+}
+
+
+/******************************************************************************/
+unsigned CO_uring_sqSpace(const CO_uring_t *ring){
+    return ring->sqEntries - (ring->sqLocal - CO_URING_LOAD_ACQUIRE(ring->sqHead));
+}
+
+
+/******************************************************************************/
+unsigned CO_uring_pending(const CO_uring_t *ring){
+    return ring->sqLocal - *ring->sqTail;
+}
+
+
+/******************************************************************************/
+int CO_uring_submit(CO_uring_t *ring, unsigned waitNr){
+    unsigned flags = (waitNr > 0) ? IORING_ENTER_GETEVENTS : 0;
+    unsigned toSubmit;
+    int ret;
+
+    /* Publish prepared entries. Entries, which were published but not
+     * consumed by kernel (interrupted call), are submitted again. */
+    CO_URING_STORE_RELEASE(ring->sqTail, ring->sqLocal);
+    toSubmit = ring->sqLocal - CO_URING_LOAD_ACQUIRE(ring->sqHead);
+    if(toSubmit == 0 && waitNr == 0){
+        return 0;
+    }
+
+    do{
+        ret = (int)syscall(__NR_io_uring_enter, ring->fd, toSubmit, waitNr, flags, NULL, 0);
+    }while(ret < 0 && errno == EINTR);
+
+    return (ret < 0) ? -errno : ret;
+}
+
+
+/******************************************************************************/
+struct io_uring_cqe *CO_uring_peekCqe(CO_uring_t *ring){
+    unsigned head = *ring->cqHead;
+
+    if(head == CO_URING_LOAD_ACQUIRE(ring->cqTail)){
+        return NULL;
+    }
+    return &ring->cqes[head & ring->cqMask];
+}
+
+
+/******************************************************************************/
+void CO_uring_cqeSeen(CO_uring_t *ring){
+    CO_URING_STORE_RELEASE(ring->cqHead, *ring->cqHead + 1);
+}
+
+
+/******************************************************************************/
+int CO_uring_bufRingInit(CO_uring_t *ring, CO_uringBufRing_t *br,
+                         unsigned entries, unsigned bufSize, unsigned short bgid)
+{
+    struct io_uring_buf_reg reg;
+    size_t ringSize = entries * sizeof(struct io_uring_buf);
+    unsigned i;
+
+    memset(br, 0, sizeof(*br));
+
+    /* Ring must be page aligned, mmap is used for that */
+    br->br = mmap(NULL, ringSize, PROT_READ | PROT_WRITE,
+                  MAP_ANONYMOUS | MAP_PRIVATE, -1, 0);
+    if(br->br == MAP_FAILED){
+        br->br = NULL;
+        return -errno;
+    }
+    br->buf = mmap(NULL, (size_t)entries * bufSize, PROT_READ | PROT_WRITE,
+                   MAP_ANONYMOUS | MAP_PRIVATE, -1, 0);
+    if(br->buf == MAP_FAILED){
+        int err = -errno;
+        munmap(br->br, ringSize);
+        br->br = NULL;
+        br->buf = NULL;
+        return err;
+    }
+    br->entries = entries;
+    br->bufSize = bufSize;
+    br->mask = entries - 1;
+    br->bgid = bgid;
+
+    memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = (uintptr_t)br->br;
+    reg.ring_entries = entries;
+    reg.bgid = bgid;
+    if(syscall(__NR_io_uring_register, ring->fd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0){
+        int err = -errno;
+        munmap(br->buf, (size_t)entries * bufSize);
+        munmap(br->br, ringSize);
+        br->br = NULL;
+        br->buf = NULL;
+        return err;
+    }
+
+    for(i = 0; i < entries; i++){
+        CO_uring_bufRingRecycle(br, i);
+    }
+
+    return 0;
+}
+
+
+/******************************************************************************/
+void CO_uring_bufRingClose(CO_uring_t *ring, CO_uringBufRing_t *br){
+    struct io_uring_buf_reg reg;
+
+    if(br->br == NULL){
+        return;
+    }
+    memset(&reg, 0, sizeof(reg));
+    reg.bgid = br->bgid;
+    syscall(__NR_io_uring_register, ring->fd, IORING_UNREGISTER_PBUF_RING, &reg, 1);
+    munmap(br->buf, (size_t)br->entries * br->bufSize);
+    munmap(br->br, br->entries * sizeof(struct io_uring_buf));
+    br->br = NULL;
+    br->buf = NULL;
+}
+
+
+/******************************************************************************/
+void *CO_uring_bufRingGet(const CO_uringBufRing_t *br, unsigned bid){
+    return (uint8_t *)br->buf + (size_t)(bid & br->mask) * br->bufSize;
+}
+
+
+/******************************************************************************/
+void CO_uring_bufRingRecycle(CO_uringBufRing_t *br, unsigned bid){
+    struct io_uring_buf *buf = &br->br->bufs[br->tail & br->mask];
+
+    buf->addr = (uintptr_t)CO_uring_bufRingGet(br, bid);
+    buf->len = br->bufSize;
+    buf->bid = (unsigned short)bid;
+    br->tail++;
+    CO_URING_STORE_RELEASE(&br->br->tail, br->tail);
+}
@@ -0,0 +1,116 @@
+/**
+ * Minimal io_uring interface for socketCAN driver.
+ *
+ * @file        CO_uring.h
+ * @ingroup     CO_driver
+ * @copyright   2020
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef CO_URING_H
+#define CO_URING_H
+
+#include <stddef.h>
+#include <linux/io_uring.h>
+
+
+/*
+ * Thin wrapper around io_uring system calls, used by CO_driver.c, if
+ * CO_DRIVER_IO_URING is defined. It covers only what driver needs, so liburing
+ * is not required. Ring is not thread safe, each ring must be used by one
+ * thread at a time.
+ */
+
+
+/* io_uring instance with mapped submission and completion queues. */
+typedef struct {
+    int                 fd;         /* io_uring file descriptor, pollable for completions */
+    void               *ringPtr;    /* mapped SQ and CQ rings (IORING_FEAT_SINGLE_MMAP) */
+    size_t              ringSize;
+    struct io_uring_sqe *sqes;      /* mapped array of submission queue entries */
+    size_t              sqesSize;
+    unsigned           *sqHead;
+    unsigned           *sqTail;
+    unsigned           *sqArray;
+    unsigned            sqMask;
+    unsigned            sqEntries;
+    unsigned            sqLocal;    /* tail of prepared, not yet published entries */
+    unsigned           *cqHead;
+    unsigned           *cqTail;
+    unsigned            cqMask;
+    struct io_uring_cqe *cqes;
+} CO_uring_t;
+
+
+/* Provided buffer ring, from which kernel picks buffers for received data. */
+typedef struct {
+    struct io_uring_buf_ring *br;   /* mapped ring, shared with kernel */
+    void               *buf;        /* memory for buffers, entries * bufSize */
+    unsigned            entries;    /* power of 2 */
+    unsigned            bufSize;
+    unsigned            mask;
+    unsigned short      tail;
+    unsigned short      bgid;       /* buffer group id */
+} CO_uringBufRing_t;
+
+
+/* Create io_uring with at least 'entries' submission entries.
+ * Returns 0 or negative errno. */
+int CO_uring_init(CO_uring_t *ring, unsigned entries);
+
+/* Unmap and close io_uring. */
+void CO_uring_close(CO_uring_t *ring);
+
+/* Get next free submission entry, cleared. It is published with
+ * CO_uring_submit(). Returns NULL, if submission queue is full. */
+struct io_uring_sqe *CO_uring_getSqe(CO_uring_t *ring);
+
+/* Number of submission entries, which can be get with CO_uring_getSqe(). */
+unsigned CO_uring_sqSpace(const CO_uring_t *ring);
+
+/* Number of entries prepared with CO_uring_getSqe() and not yet submitted. */
+unsigned CO_uring_pending(const CO_uring_t *ring);
+
+/* Publish prepared entries and enter kernel. If waitNr is nonzero, function
+ * blocks until at least waitNr completions are available. Returns number of
+ * submitted entries or negative errno. */
+int CO_uring_submit(CO_uring_t *ring, unsigned waitNr);
+
+/* Get next completion or NULL, if there is none. Nonblocking. */
+struct io_uring_cqe *CO_uring_peekCqe(CO_uring_t *ring);
+
+/* Mark completion from CO_uring_peekCqe() as consumed. */
+void CO_uring_cqeSeen(CO_uring_t *ring);
+
+/* Register provided buffer ring with 'entries' (power of 2) buffers of
+ * 'bufSize' bytes in group 'bgid' and give all buffers to kernel.
+ * Returns 0 or negative errno. */
+int CO_uring_bufRingInit(CO_uring_t *ring, CO_uringBufRing_t *br,
+                         unsigned entries, unsigned bufSize, unsigned short bgid);
+
+/* Unregister and free provided buffer ring. */
+void CO_uring_bufRingClose(CO_uring_t *ring, CO_uringBufRing_t *br);
+
+/* Pointer to buffer with id 'bid', reported in cqe->flags. */
+void *CO_uring_bufRingGet(const CO_uringBufRing_t *br, unsigned bid);
+
+/* Give buffer with id 'bid' back to kernel. */
+void CO_uring_bufRingRecycle(CO_uringBufRing_t *br, unsigned bid);
+
+#endif
@@ -0,0 +1,296 @@
+/*
+ * Throughput benchmark of socketCAN driver: read()/write() with epoll versus
+ * io_uring backend.
+ *
+ * @file        CO_driver_bench.c
+ * @copyright   2020
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Standalone program, which runs CO_CANsend() and CO_CANrxWait() against a
+ * second CAN_RAW socket on the same (virtual) interface. It is built twice,
+ * once for each backend. Run both binaries on the same interface and compare
+ * results. Setup and build from stack/socketCAN directory:
+ *
+ *     sudo ip link add dev vcan0 type vcan && sudo ip link set up vcan0
+ *     gcc -O2 -Wall -I. -I.. -I../.. \
+ *         test/CO_driver_bench.c CO_driver.c CO_filter.c -o bench_epoll -lpthread
+ *     gcc -O2 -Wall -I. -I.. -I../.. -DCO_DRIVER_IO_URING \
+ *         test/CO_driver_bench.c CO_driver.c CO_filter.c CO_uring.c \
+ *         -o bench_uring -lpthread
+ *     ./bench_epoll vcan0 100000
+ *     ./bench_uring vcan0 100000
+ *
+ * TX: frames are sent in groups of CYCLE_FRAMES followed by CO_CANsendFlush(),
+ * as after one CO_process() cycle. Peer counts received, lost and reordered
+ * frames.
+ * RX: peer writes bursts of CYCLE_FRAMES frames. Driver waits with epoll on
+ * fdRx and calls CO_CANrxWait(), as CO_Linux_tasks does. Number of wakeups
+ * and CPU time of the receiving thread are reported.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <net/if.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include "CO_driver.h"
+#include "CO_Emergency.h"
+
+
+#define CYCLE_FRAMES    16
+#define BENCH_IDENT     0x181
+
+#ifdef CO_DRIVER_IO_URING
+#define BACKEND         "io_uring"
+#else
+#define BACKEND         "epoll + read()/write()"
+#endif
+
+
+static CO_CANmodule_t CANmodule;
+static CO_CANrx_t rxArray[1];
+static CO_CANtx_t txArray[1];
+static int peerFd;
+static int frames = 100000;
+static volatile int rxCount;
+static volatile int rxOrderErrors;
+static uint32_t rxExpected;
+static int emCount;
+
+
+/* Helper functions required by the driver. */
+void CO_errExit(char* msg){
+    perror(msg);
+    exit(EXIT_FAILURE);
+}
+
+void CO_errorReport(CO_EM_t *em, const uint8_t errorBit, const uint16_t errorCode, const uint32_t infoCode){
+    (void)em; (void)errorBit; (void)errorCode; (void)infoCode;
+    emCount++;
+}
+
+
+static double now(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static double threadCpu(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+
+/* Peer receives frames sent by the driver. */
+static void *peerRx(void *arg){
+    struct can_frame msg;
+    uint32_t expected = 0;
+    struct timeval tv = {1, 0};
+
+    (void)arg;
+    setsockopt(peerFd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    while(rxCount < frames){
+        uint32_t seq;
+
+        if(read(peerFd, &msg, sizeof(msg)) != sizeof(msg)){
+            break;
+        }
+        memcpy(&seq, msg.data, sizeof(seq));
+        if(seq != expected){
+            rxOrderErrors++;
+        }
+        expected = seq + 1;
+        rxCount++;
+    }
+    return NULL;
+}
+
+
+/* Peer sends frames to the driver. */
+static void *peerTx(void *arg){
+    struct can_frame msg;
+    uint32_t seq;
+
+    (void)arg;
+    memset(&msg, 0, sizeof(msg));
+    msg.can_id = BENCH_IDENT;
+    msg.can_dlc = 8;
+    for(seq=0; seq<(uint32_t)frames; seq++){
+        memcpy(msg.data, &seq, sizeof(seq));
+        if(write(peerFd, &msg, sizeof(msg)) != sizeof(msg)){
+            perror("peer write");
+            break;
+        }
+        if((seq % CYCLE_FRAMES) == (CYCLE_FRAMES - 1)){
+            usleep(50);
+        }
+    }
+    return NULL;
+}
+
+
+/* Receive callback of the driver. */
+static void rxCallback(void *object, const CO_CANrxMsg_t *message){
+    uint32_t seq;
+
+    (void)object;
+    memcpy(&seq, message->data, sizeof(seq));
+    if(seq != rxExpected){
+        rxOrderErrors++;
+    }
+    rxExpected = seq + 1;
+    rxCount++;
+}
+
+
+static void benchTx(void){
+    pthread_t th;
+    CO_CANtx_t *buffer;
+    double t, cpu;
+    int overflows = 0;
+    uint32_t seq;
+
+    rxCount = 0;
+    rxOrderErrors = 0;
+    buffer = CO_CANtxBufferInit(&CANmodule, 0, BENCH_IDENT, 0, 8, 0);
+    pthread_create(&th, NULL, peerRx, NULL);
+
+    t = now();
+    cpu = threadCpu();
+    for(seq=0; seq<(uint32_t)frames; seq++){
+        memcpy(buffer->data, &seq, sizeof(seq));
+        /* io_uring send does not block, all slots are in flight. */
+        while(CO_CANsend(&CANmodule, buffer) != CO_ERROR_NO && now() - t < 10.0){
+            overflows++;
+            CO_CANsendFlush(&CANmodule);
+            usleep(10);
+        }
+        if((seq % CYCLE_FRAMES) == (CYCLE_FRAMES - 1)){
+            CO_CANsendFlush(&CANmodule);
+        }
+    }
+    CO_CANsendFlush(&CANmodule);
+    cpu = threadCpu() - cpu;
+    pthread_join(th, NULL);
+    t = now() - t;
+
+    printf("TX: %d frames in %.3f s (%.0f frames/s), sender CPU %.2f us/frame\n",
+           rxCount, t, rxCount / t, cpu * 1e6 / frames);
+    printf("    lost %d, reordered %d, %d sends retried on overflow\n",
+           frames - rxCount, rxOrderErrors, overflows);
+}
+
+
+static void benchRx(void){
+    pthread_t th;
+    struct epoll_event ev;
+    int fdEpoll;
+    int wakeups = 0;
+    double t, cpu;
+
+    rxCount = 0;
+    rxOrderErrors = 0;
+    rxExpected = 0;
+    fdEpoll = epoll_create(1);
+    ev.events = EPOLLIN;
+    ev.data.fd = CANmodule.fdRx;
+    if(fdEpoll < 0 || epoll_ctl(fdEpoll, EPOLL_CTL_ADD, CANmodule.fdRx, &ev) != 0){
+        CO_errExit("epoll");
+    }
+    pthread_create(&th, NULL, peerTx, NULL);
+
+    t = now();
+    cpu = threadCpu();
+    while(rxCount < frames){
+        int ready = epoll_wait(fdEpoll, &ev, 1, 1000);
+
+        /* io_uring completions interrupt waiting thread */
+        if(ready < 0 && errno == EINTR){
+            continue;
+        }
+        if(ready <= 0){
+            break;
+        }
+        CO_CANrxWait(&CANmodule);
+        wakeups++;
+    }
+    cpu = threadCpu() - cpu;
+    t = now() - t;
+    pthread_join(th, NULL);
+    close(fdEpoll);
+
+    printf("RX: %d frames in %.3f s, receiver CPU %.2f us/frame\n",
+           rxCount, t, cpu * 1e6 / frames);
+    printf("    lost %d, reordered %d, %d wakeups (%.1f frames/wakeup)\n",
+           frames - rxCount, rxOrderErrors, wakeups,
+           wakeups ? (double)rxCount / wakeups : 0.0);
+}
+
+
+int main(int argc, char *argv[]){
+    const char *ifName = argc > 1 ? argv[1] : "vcan0";
+    struct sockaddr_can sockAddr;
+    int ifindex;
+    int obj;
+
+    if(argc > 2){
+        frames = atoi(argv[2]);
+    }
+    ifindex = (int)if_nametoindex(ifName);
+    if(ifindex == 0){
+        CO_errExit("if_nametoindex");
+    }
+
+    /* Peer socket */
+    peerFd = socket(AF_CAN, SOCK_RAW, CAN_RAW);
+    sockAddr.can_family = AF_CAN;
+    sockAddr.can_ifindex = ifindex;
+    if(peerFd < 0 || bind(peerFd, (struct sockaddr*)&sockAddr, sizeof(sockAddr)) != 0){
+        CO_errExit("peer socket");
+    }
+
+    /* Driver */
+    CANmodule.wasConfigured = 0;
+    if(CO_CANmodule_init(&CANmodule, &ifindex, rxArray, 1, txArray, 1, 0) != CO_ERROR_NO ||
+       CO_CANrxBufferInit(&CANmodule, 0, BENCH_IDENT, 0x7FF, 0, &obj, rxCallback) != CO_ERROR_NO){
+        CO_errExit("CO_CANmodule_init");
+    }
+    CO_CANsetNormalMode(&CANmodule);
+
+    printf("%s, %s, %d frames\n", BACKEND, ifName, frames);
+    benchTx();
+    benchRx();
+    if(emCount > 0){
+        printf("%d errors reported by driver\n", emCount);
+    }
+
+    CO_CANmodule_disable(&CANmodule);
+    close(peerFd);
+
+    return 0;
+}
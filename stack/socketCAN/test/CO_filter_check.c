@@ -0,0 +1,262 @@
+/*
+ * Check of socketCAN receive filter compression.
+ *
+ * @file        CO_filter_check.c
+ * @copyright   2020
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Standalone program, which verifies CO_filter_compress(), used by socketCAN
+ * and nxSocketCAN drivers. Filter lists are prepared the same way as in
+ * CO_CANrxBufferInit(). Each list is compressed and then all 2048 standard
+ * identifiers, with and without RTR bit, are matched against original and
+ * compressed list with the kernel rule. The same is done for 16-bit hardware
+ * filters of NuttX driver, which use the same CO_FILTER_COMPRESS_FUNCTION().
+ * Any difference is reported.
+ *
+ * Build and run from stack/socketCAN directory:
+ *
+ *     gcc -Wall -I. test/CO_filter_check.c CO_filter.c -o CO_filter_check
+ *     ./CO_filter_check
+ */
+
+
+#include <stdio.h>
+#include <stdint.h>
+#include "CO_filter.h"
+#include "CO_filter_compress.h"
+
+
+#define MAX_FILTERS     64
+#define RANDOM_LISTS    5000
+
+
+/* List of filters, same layout as CANmodule->filter. */
+typedef struct{
+    struct can_filter   f[MAX_FILTERS];
+    int                 n;
+}filterList_t;
+
+
+/* Hardware filter, as CO_CANfilter_t in NuttX driver. */
+typedef struct{
+    uint16_t            ident;
+    uint16_t            mask;
+}hwFilter_t;
+
+static CO_FILTER_COMPRESS_FUNCTION(hwCompress, hwFilter_t, ident, mask, uint16_t)
+
+
+/* Simple deterministic random generator, so results are repeatable. */
+static uint32_t rndState = 1;
+static uint32_t rnd(void){
+    rndState = rndState * 1103515245U + 12345U;
+    return (rndState >> 16) & 0x7FFFU;
+}
+
+
+/* Add filter as CO_CANrxBufferInit() does. */
+static void addFilter(filterList_t *l, uint16_t ident, uint16_t mask, int rtr){
+    struct can_filter *f = &l->f[l->n++];
+
+    f->can_id = ident & CAN_SFF_MASK;
+    if(rtr){
+        f->can_id |= CAN_RTR_FLAG;
+    }
+    f->can_mask = (mask & CAN_SFF_MASK) | CAN_EFF_FLAG | CAN_RTR_FLAG;
+}
+
+
+/* Add unused filter as CO_CANmodule_init() does. */
+static void addUnused(filterList_t *l){
+    struct can_filter *f = &l->f[l->n++];
+
+    f->can_id = 0;
+    f->can_mask = CAN_SFF_MASK | CAN_EFF_FLAG | CAN_RTR_FLAG;
+}
+
+
+/* Frame acceptance, as evaluated by the kernel for CAN_RAW_FILTER. */
+static int accepts(const struct can_filter *f, int n, canid_t id){
+    int i;
+
+    for(i=0; i<n; i++){
+        if(((id ^ f[i].can_id) & f[i].can_mask) == 0){
+            return 1;
+        }
+    }
+    return 0;
+}
+
+
+/* Compress a copy of the list and compare acceptance of all standard frames. */
+static int check(const char *name, const filterList_t *l){
+    filterList_t c = *l;
+    canid_t ident;
+    int rtr;
+    int err = 0;
+
+    c.n = CO_filter_compress(c.f, c.n);
+
+    if(c.n < 1 || c.n > l->n){
+        printf("%s: invalid number of filters after compression: %d -> %d\n",
+               name, l->n, c.n);
+        return 1;
+    }
+
+    for(rtr=0; rtr<2; rtr++){
+        for(ident=0; ident<=CAN_SFF_MASK; ident++){
+            canid_t id = ident | (rtr ? CAN_RTR_FLAG : 0);
+            int a = accepts(l->f, l->n, id);
+            int b = accepts(c.f, c.n, id);
+
+            if(a != b){
+                printf("%s: 0x%03X%s %s by original, %s by compressed list\n",
+                       name, (unsigned)ident, rtr ? " RTR" : "",
+                       a ? "accepted" : "rejected", b ? "accepted" : "rejected");
+                err++;
+            }
+        }
+    }
+
+    return err ? 1 : 0;
+}
+
+
+/* Same as check() for hardware filters, which don't see RTR bit. */
+static int checkHw(const char *name, const filterList_t *l){
+    hwFilter_t o[MAX_FILTERS], c[MAX_FILTERS];
+    int n, i;
+    uint16_t ident;
+    int err = 0;
+
+    for(i=0; i<l->n; i++){
+        o[i].mask = (uint16_t)(l->f[i].can_mask & CAN_SFF_MASK);
+        o[i].ident = (uint16_t)(l->f[i].can_id & o[i].mask);
+        c[i] = o[i];
+    }
+    n = hwCompress(c, l->n);
+
+    if(n < 1 || n > l->n){
+        printf("%s: invalid number of hardware filters after compression: %d -> %d\n",
+               name, l->n, n);
+        return 1;
+    }
+
+    for(ident=0; ident<=CAN_SFF_MASK; ident++){
+        int a = 0, b = 0;
+
+        for(i=0; i<l->n; i++){
+            a |= ((ident ^ o[i].ident) & o[i].mask) == 0;
+        }
+        for(i=0; i<n; i++){
+            b |= ((ident ^ c[i].ident) & c[i].mask) == 0;
+        }
+        if(a != b){
+            printf("%s: 0x%03X %s by original, %s by compressed hardware filters\n",
+                   name, (unsigned)ident,
+                   a ? "accepted" : "rejected", b ? "accepted" : "rejected");
+            err++;
+        }
+    }
+
+    return err ? 1 : 0;
+}
+
+
+/* Receive filters of CANopen device with given node-ID and heartbeat consumers. */
+static void deviceFilters(filterList_t *l, uint8_t nodeId, int nHBcons, int nUnused){
+    int i;
+
+    l->n = 0;
+    addFilter(l, 0x000, 0x7FF, 0);                      /* NMT */
+    addFilter(l, 0x080, 0x7FF, 0);                      /* SYNC */
+    addFilter(l, 0x100, 0x7FF, 0);                      /* TIME */
+    for(i=0; i<4; i++){
+        addFilter(l, 0x200 + i * 0x100 + nodeId, 0x7FF, 0); /* RPDO */
+    }
+    addFilter(l, 0x600 + nodeId, 0x7FF, 0);             /* SDO server */
+    addFilter(l, 0x700 + nodeId, 0x7FF, 1);             /* node guarding */
+    for(i=0; i<nHBcons; i++){
+        addFilter(l, 0x700 + ((nodeId + i) & 0x7F) + 1, 0x7FF, 0);
+    }
+    addFilter(l, 0x7E5, 0x7FF, 0);                      /* LSS */
+    for(i=0; i<nUnused; i++){
+        addUnused(l);
+    }
+}
+
+
+int main(void){
+    filterList_t l;
+    char name[48];
+    int i, j;
+    int lists = 0, failed = 0;
+
+    /* typical device configurations */
+    for(i=1; i<=127; i++){
+        for(j=0; j<=16; j+=4){
+            deviceFilters(&l, (uint8_t)i, j, j/4);
+            snprintf(name, sizeof(name), "node %d, %d HB consumers", i, j);
+            failed += check(name, &l) | checkHw(name, &l);
+            lists++;
+        }
+    }
+
+    /* consecutive COB-IDs, which merge into masked filters */
+    for(i=1; i<=MAX_FILTERS; i++){
+        l.n = 0;
+        for(j=0; j<i; j++){
+            addFilter(&l, (uint16_t)(0x181 + j), 0x7FF, 0);
+        }
+        snprintf(name, sizeof(name), "%d consecutive", i);
+        failed += check(name, &l) | checkHw(name, &l);
+        lists++;
+    }
+
+    /* random identifiers, masks and RTR bits */
+    for(i=0; i<RANDOM_LISTS; i++){
+        int n = 1 + (int)(rnd() % MAX_FILTERS);
+
+        l.n = 0;
+        for(j=0; j<n; j++){
+            uint16_t ident = (uint16_t)rnd();
+            uint16_t mask = 0x7FF;
+
+            switch(rnd() % 4){
+                case 0: mask &= ~(uint16_t)(1U << (rnd() % 11)); break;
+                case 1: mask = (uint16_t)rnd(); break;
+                case 2: ident &= 0x0F; ident |= 0x180; break;
+                default: break;
+            }
+            if(rnd() % 8 == 0){
+                addUnused(&l);
+            }else{
+                addFilter(&l, ident, mask, (rnd() % 4) == 0);
+            }
+        }
+        snprintf(name, sizeof(name), "random list %d", i);
+        failed += check(name, &l) | checkHw(name, &l);
+        lists++;
+    }
+
+    printf("%d filter lists checked, %d failed\n", lists, failed);
+
+    return failed ? 1 : 0;
+}
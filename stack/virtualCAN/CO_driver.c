@@ -0,0 +1,740 @@
+/*
+ * CAN module object for in-process virtual CAN bus.
+ *
+ * @file        CO_driver.c
+ * @ingroup     CO_driver
+ * @copyright   2020
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "CO_driver.h"
+#include "CO_Emergency.h"
+#include <string.h>         /* for memset, memcpy */
+
+
+/* Bits after CRC: CRC delimiter, ACK slot, ACK delimiter, EOF, interframe space */
+#define CO_VCAN_FRAME_TAIL_BITS     13U
+/* Bits of the frame after ACK slot, replaced by error frame */
+#define CO_VCAN_ERROR_TAIL_BITS     11U
+/* Error flag, error delimiter and interframe space */
+#define CO_VCAN_ERROR_FRAME_BITS    17U
+/* Bus off recovery: 128 occurrences of 11 recessive bits */
+#define CO_VCAN_BUS_OFF_BITS        (128U * 11U)
+
+
+/* Simulated time in nanoseconds, common for all buses. */
+static uint64_t CO_VCAN_time = 0U;
+
+
+/* Pseudo random generator (xorshift32), deterministic for the given seed. */
+static uint32_t CO_VCANrandom(CO_VCANbus_t *bus){
+    uint32_t x = bus->random;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    bus->random = x;
+
+    return x;
+}
+
+
+/* Returns true with probability ppm / 1000000. */
+static bool_t CO_VCANchance(CO_VCANbus_t *bus, uint32_t ppm){
+    return (ppm != 0U && (CO_VCANrandom(bus) % 1000000U) < ppm) ? true : false;
+}
+
+
+/*
+ * Calculate length of standard CAN frame in bits.
+ *
+ * Frame is built bit by bit from start of frame to the end of CRC, so exact
+ * number of stuff bits can be determined.
+ */
+static uint32_t CO_VCANframeBits(const CO_CANrxMsg_t *frame){
+    uint8_t bits[19U + 64U + 15U];
+    uint16_t n = 0U;
+    uint16_t i;
+    uint16_t crc = 0U;
+    uint16_t stuff = 0U;
+    uint8_t run, prev;
+    bool_t rtr = (frame->ident & 0x0800U) ? true : false;
+    uint8_t DLC = frame->DLC;
+
+    /* start of frame, identifier, RTR, IDE, r0, DLC */
+    bits[n++] = 0U;
+    for(i=0U; i<11U; i++){
+        bits[n++] = (uint8_t)((frame->ident >> (10U - i)) & 1U);
+    }
+    bits[n++] = rtr ? 1U : 0U;
+    bits[n++] = 0U;
+    bits[n++] = 0U;
+    for(i=0U; i<4U; i++){
+        bits[n++] = (uint8_t)((DLC >> (3U - i)) & 1U);
+    }
+
+    /* data field */
+    if(!rtr){
+        uint16_t len = (DLC > 8U) ? 8U : DLC;
+        for(i=0U; i<(len * 8U); i++){
+            bits[n++] = (uint8_t)((frame->data[i / 8U] >> (7U - (i % 8U))) & 1U);
+        }
+    }
+
+    /* CRC-15, polynomial 0x4599 */
+    for(i=0U; i<n; i++){
+        uint16_t crcNext = bits[i] ^ ((crc >> 14) & 1U);
+        crc = (crc << 1) & 0x7FFFU;
+        if(crcNext != 0U){
+            crc ^= 0x4599U;
+        }
+    }
+    for(i=0U; i<15U; i++){
+        bits[n++] = (uint8_t)((crc >> (14U - i)) & 1U);
+    }
+
+    /* After five equal bits complementary stuff bit is inserted, which also
+     * starts the next sequence. */
+    prev = bits[0];
+    run = 1U;
+    for(i=1U; i<n; i++){
+        if(bits[i] == prev){
+            if(++run == 5U){
+                stuff++;
+                prev ^= 1U;
+                run = 1U;
+            }
+        }
+        else{
+            prev = bits[i];
+            run = 1U;
+        }
+    }
+
+    return (uint32_t)n + stuff + CO_VCAN_FRAME_TAIL_BITS;
+}
+
+
+/* Module is able to transmit and receive at given time. Clears bus off state
+ * after recovery. */
+static bool_t CO_VCANisActive(CO_CANmodule_t *CANmodule, uint64_t time){
+    if(!CANmodule->CANnormal){
+        return false;
+    }
+    if(CANmodule->busOffRecovery != 0U){
+        if(time < CANmodule->busOffRecovery){
+            return false;
+        }
+        CANmodule->busOffRecovery = 0U;
+        CANmodule->txErrors = 0U;
+        CANmodule->rxErrors = 0U;
+    }
+    return true;
+}
+
+
+/*
+ * Find the earliest time, when any pending message may start on the bus.
+ * Returns false, if there are no pending messages.
+ */
+static bool_t CO_VCANnextReady(CO_VCANbus_t *bus, uint64_t *readyTime){
+    bool_t found = false;
+    uint16_t m;
+
+    for(m=0U; m<bus->modulesCount; m++){
+        CO_CANmodule_t *CANmodule = bus->modules[m];
+        uint16_t i;
+
+        if(!CANmodule->CANnormal || CANmodule->CANtxCount == 0U){
+            continue;
+        }
+        for(i=0U; i<CANmodule->txSize; i++){
+            CO_CANtx_t *buffer = &CANmodule->txArray[i];
+
+            if(buffer->bufferFull){
+                uint64_t t = buffer->readyTime;
+                if(t < CANmodule->busOffRecovery){
+                    t = CANmodule->busOffRecovery;
+                }
+                if(!found || t < *readyTime){
+                    *readyTime = t;
+                    found = true;
+                }
+            }
+        }
+    }
+
+    if(found && *readyTime < bus->idleTime){
+        *readyTime = bus->idleTime;
+    }
+
+    return found;
+}
+
+
+/* Arbitration priority of the transmit buffer, lower wins. 11-bit identifier
+ * decides first, RTR (bit 11 of ident) only breaks the tie, so data frame wins
+ * over remote frame with the same identifier. */
+static uint16_t CO_VCANpriority(const CO_CANtx_t *buffer){
+    return (uint16_t)(((buffer->ident & 0x07FFU) << 1) | ((buffer->ident >> 11) & 1U));
+}
+
+
+/* Arbitration between messages, which are ready at start time. Winner is put
+ * on the bus. */
+static void CO_VCANstartFrame(CO_VCANbus_t *bus, uint64_t start){
+    CO_CANmodule_t *txModule = NULL;
+    CO_CANtx_t *txBuffer = NULL;
+    uint16_t receivers = 0U;
+    uint32_t bits;
+    uint16_t m;
+
+    for(m=0U; m<bus->modulesCount; m++){
+        CO_CANmodule_t *CANmodule = bus->modules[m];
+        uint16_t i;
+
+        if(!CO_VCANisActive(CANmodule, start)){
+            continue;
+        }
+        receivers++;
+        if(CANmodule->CANtxCount == 0U){
+            continue;
+        }
+        for(i=0U; i<CANmodule->txSize; i++){
+            CO_CANtx_t *buffer = &CANmodule->txArray[i];
+
+            if(buffer->bufferFull && buffer->readyTime <= start &&
+               (txBuffer == NULL || CO_VCANpriority(buffer) < CO_VCANpriority(txBuffer)))
+            {
+                txModule = CANmodule;
+                txBuffer = buffer;
+            }
+        }
+    }
+
+    if(txBuffer == NULL){
+        /* messages were removed by CO_CANclearPendingSyncPDOs() */
+        bus->idleTime = start;
+        return;
+    }
+
+    bus->txModule = txModule;
+    bus->txBuffer = txBuffer;
+    txModule->bufferInhibitFlag = txBuffer->syncFlag;
+
+    bus->txFrame.ident = txBuffer->ident;
+    bus->txFrame.DLC = txBuffer->DLC;
+    memcpy(bus->txFrame.data, txBuffer->data, sizeof(bus->txFrame.data));
+    bits = CO_VCANframeBits(&bus->txFrame);
+
+    /* Frame must be acknowledged by at least one other module. */
+    if(receivers < 2U){
+        bus->txError = 2U;
+    }
+    else if(CO_VCANchance(bus, txModule->fault.errorFramePpm)){
+        bus->txError = 1U;
+    }
+    else{
+        bus->txError = 0U;
+    }
+    if(bus->txError != 0U){
+        bits = bits - CO_VCAN_ERROR_TAIL_BITS + CO_VCAN_ERROR_FRAME_BITS;
+    }
+
+    bus->idleTime = start + (uint64_t)bits * bus->bitTime;
+    bus->stats.busyTime += (uint64_t)bits * bus->bitTime;
+}
+
+
+/* End of frame on the bus. Update error counters and deliver the message. */
+static void CO_VCANfinishFrame(CO_VCANbus_t *bus){
+    CO_CANmodule_t *txModule = bus->txModule;
+    CO_CANtx_t *txBuffer = bus->txBuffer;
+    uint16_t m;
+
+    bus->txModule = NULL;
+    bus->txBuffer = NULL;
+    txModule->bufferInhibitFlag = false;
+
+    if(bus->txError != 0U){
+        /* Message stays in buffer and will be retransmitted. Acknowledgment
+         * error does not increment error counter of error passive node. */
+        bus->stats.errorFrames++;
+        if(bus->txError == 1U || txModule->txErrors < 128U){
+            txModule->txErrors += 8U;
+        }
+        if(bus->txError == 1U){
+            for(m=0U; m<bus->modulesCount; m++){
+                CO_CANmodule_t *CANmodule = bus->modules[m];
+                if(CANmodule != txModule && CO_VCANisActive(CANmodule, bus->idleTime)
+                   && CANmodule->rxErrors < 255U)
+                {
+                    CANmodule->rxErrors++;
+                }
+            }
+        }
+        if(txModule->txErrors > 255U){
+            txModule->busOffRecovery = bus->idleTime
+                                     + (uint64_t)CO_VCAN_BUS_OFF_BITS * bus->bitTime;
+        }
+        return;
+    }
+
+    /* Message was sent successfully */
+    bus->stats.frames++;
+    txBuffer->bufferFull = false;
+    if(txModule->CANtxCount > 0U){
+        txModule->CANtxCount--;
+    }
+    txModule->firstCANtxMessage = false;
+    if(txModule->txErrors > 0U){
+        txModule->txErrors--;
+    }
+
+    bus->txFrame.timestamp = (uint32_t)(bus->idleTime / 1000U);
+
+    for(m=0U; m<bus->modulesCount; m++){
+        CO_CANmodule_t *CANmodule = bus->modules[m];
+        CO_CANrx_t *buffer;
+        uint16_t index;
+
+        if(CANmodule == txModule || !CO_VCANisActive(CANmodule, bus->idleTime)){
+            continue;
+        }
+        if(CO_VCANchance(bus, CANmodule->fault.rxDropPpm)){
+            bus->stats.rxDropped++;
+            continue;
+        }
+        if(CANmodule->rxErrors > 0U){
+            CANmodule->rxErrors--;
+        }
+
+        /* Search rxArray form CANmodule for the same CAN-ID. */
+        buffer = &CANmodule->rxArray[0];
+        for(index = CANmodule->rxSize; index > 0U; index--){
+            if(((bus->txFrame.ident ^ buffer->ident) & buffer->mask) == 0U){
+                if(buffer->pFunct != NULL){
+                    buffer->pFunct(buffer->object, &bus->txFrame);
+                }
+                break;
+            }
+            buffer++;
+        }
+    }
+}
+
+
+/******************************************************************************/
+void CO_VCANbus_init(CO_VCANbus_t *bus, uint16_t CANbitRate, uint32_t seed){
+    memset(bus, 0, sizeof(*bus));
+
+    switch(CANbitRate){
+        case 10:   case 20:  case 50:  case 125:
+        case 250:  case 500: case 800: case 1000:
+            break;
+        default:
+            CANbitRate = 125;
+            break;
+    }
+    bus->bitTime = 1000000U / CANbitRate;
+    bus->random = (seed != 0U) ? seed : 1U;
+    bus->idleTime = CO_VCAN_time;
+}
+
+
+/******************************************************************************/
+void CO_VCANbus_process(CO_VCANbus_t *bus, uint64_t time_us){
+    uint64_t time = time_us * 1000U;
+
+    for(;;){
+        if(bus->txModule != NULL){
+            /* frame is on the bus */
+            if(bus->idleTime > time){
+                break;
+            }
+            if(bus->idleTime > CO_VCAN_time){
+                CO_VCAN_time = bus->idleTime;
+            }
+            CO_VCANfinishFrame(bus);
+        }
+        else{
+            uint64_t start;
+
+            if(!CO_VCANnextReady(bus, &start) || start > time){
+                break;
+            }
+            CO_VCANstartFrame(bus, start);
+        }
+    }
+
+    if(time > CO_VCAN_time){
+        CO_VCAN_time = time;
+    }
+    if(bus->txModule == NULL && bus->idleTime < time){
+        bus->idleTime = time;
+    }
+}
+
+
+/******************************************************************************/
+uint64_t CO_VCANbus_nextEvent(CO_VCANbus_t *bus){
+    uint64_t t;
+
+    if(bus->txModule != NULL){
+        t = bus->idleTime;
+    }
+    else if(!CO_VCANnextReady(bus, &t)){
+        return UINT64_MAX;
+    }
+
+    return (t + 999U) / 1000U;
+}
+
+
+/******************************************************************************/
+uint64_t CO_VCAN_now(void){
+    return CO_VCAN_time / 1000U;
+}
+
+
+/******************************************************************************/
+void CO_VCAN_setFault(CO_CANmodule_t *CANmodule, const CO_VCANfault_t *fault){
+    if(fault != NULL){
+        CANmodule->fault = *fault;
+    }
+    else{
+        memset(&CANmodule->fault, 0, sizeof(CANmodule->fault));
+    }
+}
+
+
+/******************************************************************************/
+void CO_CANsetConfigurationMode(void *CANdriverState){
+    /* Put CAN module in configuration mode */
+}
+
+
+/******************************************************************************/
+void CO_CANsetNormalMode(CO_CANmodule_t *CANmodule){
+    /* Put CAN module in normal mode */
+
+    CANmodule->CANnormal = true;
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_CANmodule_init(
+        CO_CANmodule_t         *CANmodule,
+        void                   *CANdriverState,
+        CO_CANrx_t              rxArray[],
+        uint16_t                rxSize,
+        CO_CANtx_t              txArray[],
+        uint16_t                txSize,
+        uint16_t                CANbitRate)
+{
+    CO_VCANbus_t *bus = (CO_VCANbus_t *)CANdriverState;
+    uint16_t i;
+
+    /* verify arguments */
+    if(CANmodule==NULL || bus==NULL || rxArray==NULL || txArray==NULL){
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    /* Attach to the bus, if not attached yet (communication reset). Bit rate
+     * is property of the bus, CANbitRate is not used. */
+    for(i=0U; i<bus->modulesCount; i++){
+        if(bus->modules[i] == CANmodule){
+            break;
+        }
+    }
+    if(i == bus->modulesCount){
+        if(bus->modulesCount >= CO_VCAN_MAX_MODULES){
+            return CO_ERROR_OUT_OF_MEMORY;
+        }
+        bus->modules[bus->modulesCount++] = CANmodule;
+    }
+    if(bus->txModule == CANmodule){
+        /* abort frame on the bus */
+        bus->txModule = NULL;
+        bus->txBuffer = NULL;
+    }
+
+    /* Configure object variables */
+    CANmodule->bus = bus;
+    CANmodule->rxArray = rxArray;
+    CANmodule->rxSize = rxSize;
+    CANmodule->txArray = txArray;
+    CANmodule->txSize = txSize;
+    CANmodule->CANnormal = false;
+    CANmodule->useCANrxFilters = false;
+    CANmodule->bufferInhibitFlag = false;
+    CANmodule->firstCANtxMessage = true;
+    CANmodule->CANtxCount = 0U;
+    CANmodule->errOld = 0U;
+    CANmodule->em = NULL;
+    CANmodule->txErrors = 0U;
+    CANmodule->rxErrors = 0U;
+    CANmodule->busOffRecovery = 0U;
+    memset(&CANmodule->fault, 0, sizeof(CANmodule->fault));
+
+    for(i=0U; i<rxSize; i++){
+        rxArray[i].ident = 0U;
+        rxArray[i].mask = (uint16_t)0xFFFFFFFFU;
+        rxArray[i].object = NULL;
+        rxArray[i].pFunct = NULL;
+    }
+    for(i=0U; i<txSize; i++){
+        txArray[i].bufferFull = false;
+    }
+
+    return CO_ERROR_NO;
+}
+
+
+/******************************************************************************/
+void CO_CANmodule_disable(CO_CANmodule_t *CANmodule){
+    CO_VCANbus_t *bus = CANmodule->bus;
+    uint16_t i;
+
+    if(bus == NULL){
+        return;
+    }
+
+    /* detach from the bus */
+    if(bus->txModule == CANmodule){
+        bus->txModule = NULL;
+        bus->txBuffer = NULL;
+    }
+    for(i=0U; i<bus->modulesCount; i++){
+        if(bus->modules[i] == CANmodule){
+            bus->modulesCount--;
+            memmove(&bus->modules[i], &bus->modules[i+1U],
+                    (bus->modulesCount - i) * sizeof(bus->modules[0]));
+            break;
+        }
+    }
+    CANmodule->CANnormal = false;
+    CANmodule->bus = NULL;
+}
+
+
+/******************************************************************************/
+uint16_t CO_CANrxMsg_readIdent(const CO_CANrxMsg_t *rxMsg){
+    return (uint16_t) (rxMsg->ident & 0x07FFU);
+}
+
+
+/******************************************************************************/
+uint32_t CO_CANrxMsg_readTimestamp(const CO_CANrxMsg_t *rxMsg){
+    return rxMsg->timestamp;
+}
+
+
+/******************************************************************************/
+uint32_t CO_CANtimestampNow(void){
+    return (uint32_t)(CO_VCAN_time / 1000U);
+}
+
+
+/******************************************************************************/
+CO_time_us_t CO_timebase_us(void *object){
+    (void)object;
+    return CO_VCAN_time / 1000U;
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_CANrxBufferInit(
+        CO_CANmodule_t         *CANmodule,
+        uint16_t                index,
+        uint16_t                ident,
+        uint16_t                mask,
+        bool_t                  rtr,
+        void                   *object,
+        void                  (*pFunct)(void *object, const CO_CANrxMsg_t *message))
+{
+    CO_ReturnError_t ret = CO_ERROR_NO;
+
+    if((CANmodule!=NULL) && (object!=NULL) && (pFunct!=NULL) && (index < CANmodule->rxSize)){
+        /* buffer, which will be configured */
+        CO_CANrx_t *buffer = &CANmodule->rxArray[index];
+
+        /* Configure object variables */
+        buffer->object = object;
+        buffer->pFunct = pFunct;
+
+        /* CAN identifier and CAN mask, RTR is bit 11. */
+        buffer->ident = ident & 0x07FFU;
+        if(rtr){
+            buffer->ident |= 0x0800U;
+        }
+        buffer->mask = (mask & 0x07FFU) | 0x0800U;
+    }
+    else{
+        ret = CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    return ret;
+}
+
+
+/******************************************************************************/
+CO_CANtx_t *CO_CANtxBufferInit(
+        CO_CANmodule_t         *CANmodule,
+        uint16_t                index,
+        uint16_t                ident,
+        bool_t                  rtr,
+        uint8_t                 noOfBytes,
+        bool_t                  syncFlag)
+{
+    CO_CANtx_t *buffer = NULL;
+
+    if((CANmodule != NULL) && (index < CANmodule->txSize)){
+        /* get specific buffer */
+        buffer = &CANmodule->txArray[index];
+
+        /* CAN identifier, DLC and rtr */
+        buffer->ident = ident & 0x07FFU;
+        if(rtr){
+            buffer->ident |= 0x0800U;
+        }
+        buffer->DLC = noOfBytes & 0xFU;
+
+        buffer->bufferFull = false;
+        buffer->syncFlag = syncFlag;
+    }
+
+    return buffer;
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_CANsend(CO_CANmodule_t *CANmodule, CO_CANtx_t *buffer){
+    CO_ReturnError_t err = CO_ERROR_NO;
+
+    /* Verify overflow */
+    if(buffer->bufferFull){
+        if(!CANmodule->firstCANtxMessage){
+            /* don't set error, if bootup message is still on buffers */
+            CO_errorReport((CO_EM_t*)CANmodule->em, CO_EM_CAN_TX_OVERFLOW, CO_EMC_CAN_OVERRUN, buffer->ident);
+        }
+        return CO_ERROR_TX_OVERFLOW;
+    }
+
+    CO_LOCK_CAN_SEND();
+    /* Message waits in buffer, until it wins arbitration on the bus. */
+    buffer->readyTime = CO_VCAN_time;
+    if(CANmodule->fault.txDelayMax_us != 0U && CANmodule->bus != NULL){
+        buffer->readyTime += (uint64_t)(CO_VCANrandom(CANmodule->bus)
+                           % CANmodule->fault.txDelayMax_us) * 1000U;
+    }
+    buffer->bufferFull = true;
+    CANmodule->CANtxCount++;
+    CO_UNLOCK_CAN_SEND();
+
+    return err;
+}
+
+
+/******************************************************************************/
+void CO_CANclearPendingSyncPDOs(CO_CANmodule_t *CANmodule){
+    uint32_t tpdoDeleted = 0U;
+
+    CO_LOCK_CAN_SEND();
+    /* Message on the bus can not be aborted. */
+    /* delete pending synchronous TPDOs in TX buffers */
+    if(CANmodule->CANtxCount != 0U){
+        uint16_t i;
+        CO_CANtx_t *buffer = &CANmodule->txArray[0];
+        for(i = CANmodule->txSize; i > 0U; i--){
+            if(buffer->bufferFull && buffer->syncFlag &&
+               (CANmodule->bus == NULL || buffer != CANmodule->bus->txBuffer))
+            {
+                buffer->bufferFull = false;
+                CANmodule->CANtxCount--;
+                tpdoDeleted = 2U;
+            }
+            buffer++;
+        }
+    }
+    CO_UNLOCK_CAN_SEND();
+
+
+    if(tpdoDeleted != 0U){
+        CO_errorReport((CO_EM_t*)CANmodule->em, CO_EM_TPDO_OUTSIDE_WINDOW, CO_EMC_COMMUNICATION, tpdoDeleted);
+    }
+}
+
+
+/******************************************************************************/
+void CO_CANverifyErrors(CO_CANmodule_t *CANmodule){
+    uint16_t rxErrors, txErrors, overflow;
+    CO_EM_t* em = (CO_EM_t*)CANmodule->em;
+    uint32_t err;
+
+    /* get error counters from virtual module */
+    rxErrors = CANmodule->rxErrors;
+    txErrors = CANmodule->txErrors;
+    overflow = 0U;
+
+    err = ((uint32_t)txErrors << 16) | ((uint32_t)rxErrors << 8) | overflow;
+
+    if(CANmodule->errOld != err){
+        CANmodule->errOld = err;
+
+        if(txErrors >= 256U){                               /* bus off */
+            CO_errorReport(em, CO_EM_CAN_TX_BUS_OFF, CO_EMC_BUS_OFF_RECOVERED, err);
+        }
+        else{                                               /* not bus off */
+            CO_errorReset(em, CO_EM_CAN_TX_BUS_OFF, err);
+
+            if((rxErrors >= 96U) || (txErrors >= 96U)){     /* bus warning */
+                CO_errorReport(em, CO_EM_CAN_BUS_WARNING, CO_EMC_NO_ERROR, err);
+            }
+
+            if(rxErrors >= 128U){                           /* RX bus passive */
+                CO_errorReport(em, CO_EM_CAN_RX_BUS_PASSIVE, CO_EMC_CAN_PASSIVE, err);
+            }
+            else{
+                CO_errorReset(em, CO_EM_CAN_RX_BUS_PASSIVE, err);
+            }
+
+            if(txErrors >= 128U){                           /* TX bus passive */
+                if(!CANmodule->firstCANtxMessage){
+                    CO_errorReport(em, CO_EM_CAN_TX_BUS_PASSIVE, CO_EMC_CAN_PASSIVE, err);
+                }
+            }
+            else{
+                bool_t isError = CO_isError(em, CO_EM_CAN_TX_BUS_PASSIVE);
+                if(isError){
+                    CO_errorReset(em, CO_EM_CAN_TX_BUS_PASSIVE, err);
+                    CO_errorReset(em, CO_EM_CAN_TX_OVERFLOW, err);
+                }
+            }
+
+            if((rxErrors < 96U) && (txErrors < 96U)){       /* no error */
+                CO_errorReset(em, CO_EM_CAN_BUS_WARNING, err);
+            }
+        }
+
+        if(overflow != 0U){                                 /* CAN RX bus overflow */
+            CO_errorReport(em, CO_EM_CAN_RXB_OVERFLOW, CO_EMC_CAN_OVERRUN, err);
+        }
+    }
+}
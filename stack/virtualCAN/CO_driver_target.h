@@ -0,0 +1,334 @@
+/**
+ * CAN module object for in-process virtual CAN bus.
+ *
+ * @file        CO_driver_target.h
+ * @ingroup     CO_driver
+ * @copyright   2020
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef CO_DRIVER_TARGET_H
+#define CO_DRIVER_TARGET_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Include processor header file */
+#include <stddef.h>         /* for 'NULL' */
+#include <stdint.h>         /* for 'int8_t' to 'uint64_t' */
+#include <stdbool.h>        /* for 'true', 'false' */
+#include <endian.h>
+
+
+/**
+ * Endianness.
+ *
+ * Depending on processor or compiler architecture, one of the two macros must
+ * be defined: CO_LITTLE_ENDIAN or CO_BIG_ENDIAN. CANopen itself is little endian.
+ */
+#ifdef __BYTE_ORDER
+#if __BYTE_ORDER == __LITTLE_ENDIAN
+    #define CO_LITTLE_ENDIAN
+#else
+    #define CO_BIG_ENDIAN
+#endif /* __BYTE_ORDER == __LITTLE_ENDIAN */
+#endif /* __BYTE_ORDER */
+
+
+/**
+ * @defgroup CO_driver Driver
+ * @ingroup CO_CANopen
+ * @{
+ *
+ * Virtual CAN bus, which connects multiple CAN modules inside single process.
+ *
+ * It is intended for simulation, benchmarking and regression testing of
+ * CANopen networks on a host computer, without CAN hardware, vcan or root
+ * privileges. Simulation is single threaded and deterministic:
+ *  - Any number (up to #CO_VCAN_MAX_MODULES) of CO_CANmodule_t objects is
+ *    attached to one CO_VCANbus_t object. CO_VCANbus_t is passed as
+ *    CANdriverState to CO_CANmodule_init().
+ *  - Messages sent with CO_CANsend() wait in CO_CANtx_t buffers. Simulated time
+ *    is advanced with CO_VCANbus_process(). Pending messages from all modules
+ *    then win the bus by CAN arbitration (lowest CAN identifier first, data
+ *    frame before remote frame with the same identifier).
+ *  - Each frame occupies the bus for its exact length in bits, including stuff
+ *    bits, CRC, ACK, EOF and interframe space, at configured bit rate. So bus
+ *    load and latencies are the same as on the real bus.
+ *  - Frame is delivered to all other modules in normal mode at the end of the
+ *    frame. Reception time is available with CO_CANrxMsg_readTimestamp().
+ *  - Each module has CAN error counters. Frame without any receiver is not
+ *    acknowledged and is retransmitted. Module goes bus off and recovers as
+ *    defined by CAN specification.
+ *  - Faults may be injected per module with CO_VCAN_setFault(): dropped
+ *    received frames, delayed transmission and destroyed (error) frames.
+ *
+ * Simulated time is common for all buses in the process. CANopen objects may
+ * be processed with any time differences, time of the simulation is defined
+ * only by CO_VCANbus_process() calls.
+ */
+
+
+/**
+ * @name Critical sections
+ * Virtual bus is processed in the same thread as CANopen objects, so critical
+ * sections are not necessary.
+ * @{
+ */
+#define CO_LOCK_CAN_SEND()  /**< Lock critical section in CO_CANsend() */
+#define CO_UNLOCK_CAN_SEND()/**< Unlock critical section in CO_CANsend() */
+
+#define CO_LOCK_EMCY()      /**< Lock critical section in CO_errorReport() or CO_errorReset() */
+#define CO_UNLOCK_EMCY()    /**< Unlock critical section in CO_errorReport() or CO_errorReset() */
+
+#define CO_LOCK_OD()        /**< Lock critical section when accessing Object Dictionary */
+#define CO_UNLOCK_OD()      /**< Unock critical section when accessing Object Dictionary */
+/** @} */
+
+/**
+ * @name Syncronisation functions
+ * syncronisation for message buffer for communication between CAN receive and
+ * message processing threads.
+ * @{
+ */
+/** Memory barrier */
+#define CANrxMemoryBarrier()
+/** Check if new message has arrived */
+#define IS_CANrxNew(rxNew) ((uintptr_t)rxNew)
+/** Set new message flag */
+#define SET_CANrxNew(rxNew) {CANrxMemoryBarrier(); rxNew = (void*)1L;}
+/** Clear new message flag */
+#define CLEAR_CANrxNew(rxNew) {CANrxMemoryBarrier(); rxNew = (void*)0L;}
+/** @} */
+
+/**
+ * @defgroup CO_dataTypes Data types
+ * @{
+ *
+ * According to Misra C
+ */
+/* int8_t to uint64_t are defined in stdint.h */
+typedef unsigned char           bool_t;     /**< bool_t */
+typedef float                   float32_t;  /**< float32_t */
+typedef long double             float64_t;  /**< float64_t */
+typedef char                    char_t;     /**< char_t */
+typedef unsigned char           oChar_t;    /**< oChar_t */
+typedef unsigned char           domain_t;   /**< domain_t */
+/** @} */
+
+
+/** Maximum number of CAN modules attached to one virtual bus */
+#ifndef CO_VCAN_MAX_MODULES
+#define CO_VCAN_MAX_MODULES     128
+#endif
+
+/** Received messages carry time of reception, see CO_CANrxMsg_readTimestamp(). */
+#define CO_CAN_RX_TIMESTAMP
+
+/** GCC atomic builtins are used by lock-free emergency buffer, see CO_EM_t. */
+#define CO_USE_GCC_ATOMICS
+
+
+/** Simulated time is used as default time source, see CO_timebase_us(). */
+#define CO_TIMEBASE_US
+
+
+/**
+ * CAN receive message structure.
+ */
+typedef struct{
+    /** CAN identifier. It must be read through CO_CANrxMsg_readIdent() function. */
+    uint32_t            ident;
+    uint8_t             DLC ;           /**< Length of CAN message */
+    uint8_t             data[8];        /**< 8 data bytes */
+    /** End of frame on the virtual bus in [microseconds] */
+    uint32_t            timestamp;
+}CO_CANrxMsg_t;
+
+
+/**
+ * Received message object
+ */
+typedef struct{
+    uint16_t            ident;          /**< Standard CAN Identifier (bits 0..10) + RTR (bit 11) */
+    uint16_t            mask;           /**< Standard Identifier mask with same alignment as ident */
+    void               *object;         /**< From CO_CANrxBufferInit() */
+    void              (*pFunct)(void *object, const CO_CANrxMsg_t *message);  /**< From CO_CANrxBufferInit() */
+}CO_CANrx_t;
+
+
+/**
+ * Transmit message object.
+ */
+typedef struct{
+    uint32_t            ident;          /**< Standard CAN Identifier (bits 0..10) + RTR (bit 11) */
+    uint8_t             DLC ;           /**< Length of CAN message. */
+    uint8_t             data[8];        /**< 8 data bytes */
+    volatile bool_t     bufferFull;     /**< True if previous message is still in buffer */
+    /** Synchronous PDO messages has this flag set. It prevents them to be sent outside the synchronous window */
+    volatile bool_t     syncFlag;
+    /** Simulated time in [nanoseconds], when message may enter arbitration */
+    uint64_t            readyTime;
+}CO_CANtx_t;
+
+
+/**
+ * Fault injection for one CAN module, see CO_VCAN_setFault(). Probabilities
+ * are in parts per million, zero disables the fault.
+ */
+typedef struct{
+    /** Probability, that frame from the bus is lost by this module's receiver */
+    uint32_t            rxDropPpm;
+    /** Probability, that frame transmitted by this module is destroyed by
+     * error frame. Frame is retransmitted, error counters are incremented. */
+    uint32_t            errorFramePpm;
+    /** Maximum random delay in [microseconds] between CO_CANsend() and the
+     * moment, when frame enters arbitration */
+    uint32_t            txDelayMax_us;
+}CO_VCANfault_t;
+
+
+struct CO_VCANbus;
+
+
+/**
+ * CAN module object.
+ */
+typedef struct{
+    struct CO_VCANbus  *bus;            /**< From CO_CANmodule_init() */
+    CO_CANrx_t         *rxArray;        /**< From CO_CANmodule_init() */
+    uint16_t            rxSize;         /**< From CO_CANmodule_init() */
+    CO_CANtx_t         *txArray;        /**< From CO_CANmodule_init() */
+    uint16_t            txSize;         /**< From CO_CANmodule_init() */
+    volatile bool_t     CANnormal;      /**< CAN module is in normal mode */
+    /** Always false, all received CAN messages are filtered by software. */
+    volatile bool_t     useCANrxFilters;
+    /** If flag is true, then message in transmitt buffer is synchronous PDO
+      * message, which will be aborted, if CO_clearPendingSyncPDOs() function
+      * will be called by application. This may be necessary if Synchronous
+      * window time was expired. */
+    volatile bool_t     bufferInhibitFlag;
+    /** Equal to 1, when the first transmitted message (bootup message) is in CAN TX buffers */
+    volatile bool_t     firstCANtxMessage;
+    /** Number of messages in transmit buffer, which are waiting to be copied to the CAN module */
+    volatile uint16_t   CANtxCount;
+    uint32_t            errOld;         /**< Previous state of CAN errors */
+    void               *em;             /**< Emergency object */
+    uint16_t            txErrors;       /**< Transmit error counter */
+    uint16_t            rxErrors;       /**< Receive error counter */
+    /** Simulated time in [nanoseconds] of bus off recovery, 0 if not bus off */
+    uint64_t            busOffRecovery;
+    CO_VCANfault_t      fault;          /**< From CO_VCAN_setFault() */
+}CO_CANmodule_t;
+
+
+/**
+ * Virtual CAN bus statistics.
+ */
+typedef struct{
+    uint32_t            frames;         /**< Number of successfully transmitted frames */
+    uint32_t            errorFrames;    /**< Number of destroyed frames */
+    uint32_t            rxDropped;      /**< Number of frames dropped by receivers */
+    uint64_t            busyTime;       /**< Time in [nanoseconds], when bus was not idle */
+}CO_VCANstats_t;
+
+
+/**
+ * Virtual CAN bus object.
+ */
+typedef struct CO_VCANbus{
+    /** Attached CAN modules, from CO_CANmodule_init() */
+    CO_CANmodule_t     *modules[CO_VCAN_MAX_MODULES];
+    uint16_t            modulesCount;   /**< Number of attached CAN modules */
+    uint32_t            bitTime;        /**< Duration of one bit in [nanoseconds] */
+    uint64_t            idleTime;       /**< Simulated time in [nanoseconds], when bus becomes idle */
+    CO_CANmodule_t     *txModule;       /**< Module, which is transmitting, NULL if none */
+    CO_CANtx_t         *txBuffer;       /**< Buffer inside txModule, which is transmitting */
+    CO_CANrxMsg_t       txFrame;        /**< Copy of the frame on the bus */
+    /** 1, if frame on the bus will be destroyed by error frame, 2, if it will
+     * not be acknowledged, 0 otherwise */
+    uint8_t             txError;
+    uint32_t            random;         /**< State of the pseudo random generator */
+    CO_VCANstats_t      stats;          /**< Bus statistics */
+}CO_VCANbus_t;
+
+
+/**
+ * Initialize virtual CAN bus.
+ *
+ * Must be called before CO_CANmodule_init() of any attached module.
+ *
+ * @param bus This object will be initialized.
+ * @param CANbitRate Bit rate in kbps: 10, 20, 50, 125, 250, 500, 800 or 1000.
+ * If value is illegal, bitrate defaults to 125.
+ * @param seed Seed for pseudo random generator used by fault injection. Same
+ * seed gives the same simulation.
+ */
+void CO_VCANbus_init(CO_VCANbus_t *bus, uint16_t CANbitRate, uint32_t seed);
+
+
+/**
+ * Advance simulated time of the virtual CAN bus.
+ *
+ * Function transmits pending messages from all attached modules in order of
+ * CAN arbitration and calls receive callbacks of other modules. Callbacks
+ * may send new messages, they are transmitted within the same call, if
+ * there is enough time.
+ *
+ * @param bus This object.
+ * @param time_us Simulated time in [microseconds]. It must not decrease.
+ */
+void CO_VCANbus_process(CO_VCANbus_t *bus, uint64_t time_us);
+
+
+/**
+ * Get time of the next event on the virtual CAN bus.
+ *
+ * @param bus This object.
+ *
+ * @return Simulated time in [microseconds], when frame on the bus will be
+ * finished or when pending message will enter arbitration. UINT64_MAX, if
+ * there is nothing to transmit.
+ */
+uint64_t CO_VCANbus_nextEvent(CO_VCANbus_t *bus);
+
+
+/**
+ * Get current simulated time.
+ *
+ * @return Simulated time in [microseconds], from last CO_VCANbus_process().
+ */
+uint64_t CO_VCAN_now(void);
+
+
+/**
+ * Configure fault injection for CAN module.
+ *
+ * @param CANmodule CAN module object, already initialized.
+ * @param fault Faults to inject, NULL disables fault injection.
+ */
+void CO_VCAN_setFault(CO_CANmodule_t *CANmodule, const CO_VCANfault_t *fault);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+/** @} */
+#endif /* CO_DRIVER_TARGET_H */